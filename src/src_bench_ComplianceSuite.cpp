@@ -0,0 +1,500 @@
+/**
+ * @file ComplianceSuite.cpp
+ * @brief Benchmark suite for the compliance hot paths
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * Cases:
+ * - checkCountry and checkCountryFast for one country per restriction tier
+ * - checkAccess end to end (caches disabled) against the in-process stub GeoIP
+ *   HTTP server from tests/compliance, answering after an injected delay
+ * - checkAccess failing over between two stub providers, the primary with a
+ *   slow tail (every 20th answer 50ms late), with and without hedging
+ * - IpAddress::parse on IPv4 and IPv6 text, and checkAccess answered from the
+ *   decision cache given text versus a binary IpAddress
+ * - RegionIndex::classify outside every region, deep inside one, next to a
+ *   boundary (exact polygon test) and by subdivision code
+ * - parseGeoIPResponse / parseGeoIPBatchResponse on canned ip-api bodies
+ * - logAccessAttempt into a temporary audit log, including the final flush
+ *
+ * Each case runs twice after a warm-up: an untimed pass for ops/sec and
+ * heap allocations per op (counted on the benchmark thread only, so audit
+ * and server threads don't skew it), then a pass timing every operation for
+ * p50/p99/p99.9 with the clock-read overhead subtracted. checkCountry logs
+ * each listed country, so redirect stderr when running the per-tier cases.
+ *
+ * Usage:
+ *   bench_compliance_suite [--iterations N] [--http-iterations N]
+ *                          [--latency-ms N] [--filter SUBSTRING] [--json PATH]
+ *                          [--regions PATH]
+ */
+
+#include "../compliance/GeoRestriction.hpp"
+#include "../compliance/GeoIPResponse.hpp"
+#include "../compliance/RegionIndex.hpp"
+#include "../../tests/compliance/StubGeoIPServer.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace SpectreMap::Compliance;
+using SpectreMap::Testing::StubGeoIPServer;
+using SpectreMap::Testing::stubResponseBody;
+using json = nlohmann::json;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Per-thread so only allocations made by the benchmark thread are counted
+thread_local uint64_t t_allocations = 0;
+
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// ============================================================================
+// Measurement
+// ============================================================================
+
+struct CaseResult {
+    std::string name;
+    uint64_t iterations = 0;
+    double ops_per_sec = 0.0;
+    double allocs_per_op = 0.0;
+    uint64_t p50_ns = 0;
+    uint64_t p99_ns = 0;
+    uint64_t p999_ns = 0;
+};
+
+uint64_t clockOverheadNs() {
+    constexpr int samples = 10000;
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < samples; ++i) {
+        const auto t0 = Clock::now();
+        const auto t1 = Clock::now();
+        best = std::min<uint64_t>(best, std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+    }
+    return best;
+}
+
+class Suite {
+public:
+    explicit Suite(std::string filter) : filter_(std::move(filter)), clock_overhead_ns_(clockOverheadNs()) {}
+
+    bool enabled(const std::string& name) const {
+        return filter_.empty() || name.find(filter_) != std::string::npos;
+    }
+
+    /**
+     * @brief Measure fn(i) for i in [0, iterations)
+     * @param finish Run after the throughput pass and counted in it (e.g. a flush)
+     */
+    template <typename Fn>
+    void run(const std::string& name, uint64_t iterations, Fn&& fn,
+             const std::function<void()>& finish = {}) {
+        if (!enabled(name) || iterations == 0) return;
+
+        for (uint64_t i = 0; i < std::max<uint64_t>(1, iterations / 10); ++i) {
+            fn(i);
+        }
+        if (finish) finish();
+
+        CaseResult result{.name = name, .iterations = iterations};
+
+        const uint64_t allocations_before = t_allocations;
+        const auto start = Clock::now();
+        for (uint64_t i = 0; i < iterations; ++i) {
+            fn(i);
+        }
+        if (finish) finish();
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        result.ops_per_sec = static_cast<double>(iterations) / seconds;
+        result.allocs_per_op = static_cast<double>(t_allocations - allocations_before) /
+                               static_cast<double>(iterations);
+
+        std::vector<uint64_t> samples(iterations);
+        for (uint64_t i = 0; i < iterations; ++i) {
+            const auto t0 = Clock::now();
+            fn(i);
+            const auto t1 = Clock::now();
+            const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+            samples[i] = ns > clock_overhead_ns_ ? ns - clock_overhead_ns_ : 0;
+        }
+        if (finish) finish();
+
+        std::sort(samples.begin(), samples.end());
+        auto percentile = [&samples](double q) {
+            return samples[std::min(samples.size() - 1, static_cast<size_t>(q * samples.size()))];
+        };
+        result.p50_ns = percentile(0.50);
+        result.p99_ns = percentile(0.99);
+        result.p999_ns = percentile(0.999);
+
+        std::printf("%-40s %10llu %14.0f %10.2f %10llu %10llu %10llu\n", result.name.c_str(),
+                    static_cast<unsigned long long>(result.iterations), result.ops_per_sec,
+                    result.allocs_per_op, static_cast<unsigned long long>(result.p50_ns),
+                    static_cast<unsigned long long>(result.p99_ns),
+                    static_cast<unsigned long long>(result.p999_ns));
+        std::fflush(stdout);
+        results_.push_back(std::move(result));
+    }
+
+    void printHeader() const {
+        std::printf("%-40s %10s %14s %10s %10s %10s %10s\n", "case", "iters", "ops/s", "allocs/op",
+                    "p50 ns", "p99 ns", "p99.9 ns");
+    }
+
+    json toJson(const json& parameters) const {
+        json cases = json::array();
+        for (const CaseResult& r : results_) {
+            cases.push_back({
+                {"name", r.name},
+                {"iterations", r.iterations},
+                {"ops_per_sec", r.ops_per_sec},
+                {"allocs_per_op", r.allocs_per_op},
+                {"p50_ns", r.p50_ns},
+                {"p99_ns", r.p99_ns},
+                {"p999_ns", r.p999_ns}
+            });
+        }
+        return {
+            {"suite", "compliance"},
+            {"parameters", parameters},
+            {"clock_overhead_ns", clock_overhead_ns_},
+            {"results", cases}
+        };
+    }
+
+private:
+    std::string filter_;
+    uint64_t clock_overhead_ns_;
+    std::vector<CaseResult> results_;
+};
+
+// ============================================================================
+// Cases
+// ============================================================================
+
+struct TierCase {
+    const char* label;
+    std::string code;
+};
+
+const std::array<TierCase, 5>& tierCases() {
+    static const std::array<TierCase, 5> cases = {{
+        {"comprehensive", "KP"}, {"sectoral", "RU"}, {"arms_embargo", "SO"},
+        {"high_risk", "CN"}, {"allowed", "US"}
+    }};
+    return cases;
+}
+
+void runCountryChecks(Suite& suite, uint64_t iterations) {
+    GeoRestriction geo;
+    for (const TierCase& tier : tierCases()) {
+        suite.run(std::string("checkCountry/") + tier.label, iterations, [&](uint64_t) {
+            const RestrictionResult result = geo.checkCountry(tier.code);
+            doNotOptimize(result);
+        });
+    }
+    for (const TierCase& tier : tierCases()) {
+        suite.run(std::string("checkCountryFast/") + tier.label, iterations, [&](uint64_t) {
+            const RestrictionDecision decision = GeoRestriction::checkCountryFast(tier.code);
+            doNotOptimize(decision);
+        });
+    }
+}
+
+void runAccessChecks(Suite& suite, uint64_t iterations, std::chrono::milliseconds latency) {
+    if (!suite.enabled("checkAccess/stub")) return;
+
+    // Declared first so it outlives the pooled connections of geo
+    StubGeoIPServer server(latency);
+    GeoRestriction geo;
+    geo.setGeoIPEndpoints(server.lookupUrl(), server.batchUrl());
+    geo.setCacheConfig({.enabled = false});
+    geo.setDecisionCacheConfig({.enabled = false});
+
+    std::vector<std::string> ips;
+    ips.reserve(256);
+    for (int octet = 0; octet < 256; ++octet) {
+        ips.push_back("198.51.100." + std::to_string(octet));
+    }
+    suite.run("checkAccess/stub", iterations, [&](uint64_t i) {
+        const RestrictionResult result = geo.checkAccess(ips[i % ips.size()]);
+        doNotOptimize(result);
+    });
+}
+
+void runFailover(Suite& suite, uint64_t iterations, std::chrono::milliseconds latency) {
+    for (const bool hedge : {true, false}) {
+        const std::string name = std::string("checkAccess/failover/") + (hedge ? "hedged" : "unhedged");
+        if (!suite.enabled(name)) continue;
+
+        // Declared first so they outlive the pooled connections of geo
+        StubGeoIPServer primary(latency, 20, std::chrono::milliseconds(50));
+        StubGeoIPServer secondary(latency);
+        GeoRestriction geo;
+        geo.setGeoIPProviders({
+            {.name = "primary", .lookup_url = primary.lookupUrl(), .batch_url = primary.batchUrl()},
+            {.name = "secondary", .lookup_url = secondary.lookupUrl(), .batch_url = secondary.batchUrl()}
+        }, {.hedge = hedge});
+        geo.setCacheConfig({.enabled = false});
+        geo.setDecisionCacheConfig({.enabled = false});
+
+        // The warm-up pass fills the primary's latency window, so hedges
+        // fire at its measured p95 rather than the initial delay
+        suite.run(name, iterations, [&](uint64_t i) {
+            const RestrictionResult result = geo.checkAccess("198.51.100." + std::to_string(i % 256));
+            doNotOptimize(result);
+        });
+    }
+}
+
+void runAddresses(Suite& suite, uint64_t iterations) {
+    const std::array<std::string, 2> v4 = {"198.51.100.7", "203.0.113.254"};
+    suite.run("IpAddress::parse/v4", iterations, [&](uint64_t i) {
+        const std::optional<IpAddress> address = IpAddress::parse(v4[i & 1]);
+        doNotOptimize(address);
+    });
+    const std::array<std::string, 2> v6 = {"2001:db8::8a2e:370:7334", "2001:db8:85a3:0:0:8a2e:370:7334"};
+    suite.run("IpAddress::parse/v6", iterations, [&](uint64_t i) {
+        const std::optional<IpAddress> address = IpAddress::parse(v6[i & 1]);
+        doNotOptimize(address);
+    });
+
+    if (!suite.enabled("checkAccess/decision_hit")) return;
+    // One stub lookup during warm-up decides the whole /24; every timed
+    // check is then a decision cache hit
+    StubGeoIPServer server(std::chrono::milliseconds(0));
+    GeoRestriction geo;
+    geo.setGeoIPEndpoints(server.lookupUrl(), server.batchUrl());
+
+    std::vector<std::string> text;
+    std::vector<IpAddress> binary;
+    for (uint32_t octet = 0; octet < 256; ++octet) {
+        text.push_back("198.51.100." + std::to_string(octet));
+        binary.push_back(IpAddress::fromV4(0xC6336400 | octet));
+    }
+    suite.run("checkAccess/decision_hit/text", iterations, [&](uint64_t i) {
+        const RestrictionResult result = geo.checkAccess(text[i % text.size()]);
+        doNotOptimize(result);
+    });
+    suite.run("checkAccess/decision_hit/binary", iterations, [&](uint64_t i) {
+        const RestrictionResult result = geo.checkAccess(binary[i % binary.size()]);
+        doNotOptimize(result);
+    });
+}
+
+void runRegions(Suite& suite, uint64_t iterations, const std::string& path) {
+    struct Probe {
+        const char* label;
+        const char* country;
+        const char* subdivision;
+        double latitude, longitude;
+    };
+    static constexpr Probe PROBES[] = {
+        {"outside", "UA", "", 50.45, 30.52},      // Kyiv, outside the grid
+        {"inside", "UA", "", 48.00, 37.80},       // Donetsk, a fully covered cell
+        {"boundary", "UA", "", 46.09, 34.20},     // Just inside Crimea's northern edge
+        {"subdivision", "UA", "43", 0.0, 0.0}
+    };
+    if (std::none_of(std::begin(PROBES), std::end(PROBES), [&](const Probe& probe) {
+            return suite.enabled(std::string("RegionIndex::classify/") + probe.label);
+        })) {
+        return;
+    }
+    const std::shared_ptr<const RegionIndex> regions = RegionIndex::loadFile(path);
+    if (!regions) return;   // Logged; run from the repository root or pass --regions
+
+    for (const Probe& probe : PROBES) {
+        suite.run(std::string("RegionIndex::classify/") + probe.label, iterations, [&](uint64_t) {
+            const std::string_view code = regions->classify(probe.country, probe.subdivision,
+                                                            probe.latitude, probe.longitude);
+            doNotOptimize(code);
+        });
+    }
+}
+
+void runParsing(Suite& suite, uint64_t iterations) {
+    const std::string ip = "198.51.100.7";
+    const std::string body = stubResponseBody(ip);
+    suite.run("parseGeoIPResponse", iterations, [&](uint64_t) {
+        const std::optional<GeoLocation> location = parseGeoIPResponse(body, ip);
+        doNotOptimize(location);
+    });
+
+    std::vector<std::string> ips;
+    std::string batch_body = "[";
+    for (int octet = 0; octet < 100; ++octet) {
+        ips.push_back("198.51.100." + std::to_string(octet));
+        if (octet) batch_body += ',';
+        batch_body += stubResponseBody(ips.back());
+    }
+    batch_body += "]";
+    suite.run("parseGeoIPBatchResponse/100", std::max<uint64_t>(1, iterations / 100), [&](uint64_t) {
+        size_t parsed = 0;
+        parseGeoIPBatchResponse(batch_body, ips, [&parsed](size_t, std::optional<GeoLocation> location) {
+            parsed += location.has_value();
+        });
+        doNotOptimize(parsed);
+    });
+}
+
+void runAuditLogging(Suite& suite, uint64_t iterations) {
+    if (!suite.enabled("logAccessAttempt")) return;
+
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "spectremap_bench_audit";
+    std::filesystem::remove_all(directory);
+
+    {
+        GeoRestriction geo;
+        geo.setAuditLogConfig({.path = (directory / "audit.log").string()});
+        // An allowed result keeps the mirror to the main logger out of the measurement
+        const RestrictionResult result = GeoRestriction::checkCountryFast("US").toResult();
+        const std::string ip = "198.51.100.1";
+        suite.run("logAccessAttempt", iterations, [&](uint64_t) {
+            geo.logAccessAttempt(ip, result, "ALLOWED");
+        }, [&geo] { geo.flushAuditLog(); });
+    }
+    std::filesystem::remove_all(directory);
+}
+
+} // namespace
+
+// ============================================================================
+// Allocation counting
+// ============================================================================
+//
+// Every replaceable form is overridden so no allocation bypasses the counter
+// and every pointer is released by the matching family. Both ends go through
+// out-of-line helpers: with free() inlined into a sized delete, GCC pairs it
+// with the operator new call in the caller and warns (-Wmismatched-new-delete).
+
+namespace {
+
+[[gnu::noinline]] void* countedAllocate(std::size_t size, std::size_t alignment) noexcept {
+    ++t_allocations;
+    if (alignment <= alignof(std::max_align_t)) {
+        return std::malloc(size ? size : 1);
+    }
+    // aligned_alloc requires the size to be a multiple of the alignment
+    const std::size_t rounded = (size + alignment - 1) / alignment * alignment;
+    return std::aligned_alloc(alignment, rounded ? rounded : alignment);
+}
+
+[[gnu::noinline]] void countedRelease(void* p) noexcept {
+    std::free(p);
+}
+
+void* countedAllocateOrThrow(std::size_t size, std::size_t alignment) {
+    if (void* p = countedAllocate(size, alignment)) return p;
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    return countedAllocateOrThrow(size, alignof(std::max_align_t));
+}
+void* operator new[](std::size_t size) {
+    return countedAllocateOrThrow(size, alignof(std::max_align_t));
+}
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return countedAllocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return countedAllocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size, alignof(std::max_align_t));
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size, alignof(std::max_align_t));
+}
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept { countedRelease(p); }
+void operator delete[](void* p) noexcept { countedRelease(p); }
+void operator delete(void* p, std::size_t) noexcept { countedRelease(p); }
+void operator delete[](void* p, std::size_t) noexcept { countedRelease(p); }
+void operator delete(void* p, std::align_val_t) noexcept { countedRelease(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { countedRelease(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { countedRelease(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { countedRelease(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { countedRelease(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { countedRelease(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { countedRelease(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { countedRelease(p); }
+
+int main(int argc, char* argv[]) {
+    uint64_t iterations = 1'000'000;
+    uint64_t http_iterations = 2'000;
+    std::chrono::milliseconds latency(0);
+    std::string filter;
+    std::string json_path;
+    std::string regions_path = "config/sanctioned_regions.json";
+
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--iterations") == 0 && has_value) {
+            iterations = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--http-iterations") == 0 && has_value) {
+            http_iterations = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--latency-ms") == 0 && has_value) {
+            latency = std::chrono::milliseconds(std::strtoll(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--filter") == 0 && has_value) {
+            filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--json") == 0 && has_value) {
+            json_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--regions") == 0 && has_value) {
+            regions_path = argv[++i];
+        } else {
+            std::fprintf(stderr, "Usage: %s [--iterations N] [--http-iterations N] [--latency-ms N] "
+                                 "[--filter SUBSTRING] [--json PATH] [--regions PATH]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    Suite suite(filter);
+    suite.printHeader();
+    runCountryChecks(suite, iterations);
+    runAddresses(suite, iterations);
+    runRegions(suite, iterations, regions_path);
+    runParsing(suite, iterations / 10);
+    runAuditLogging(suite, iterations / 10);
+    runAccessChecks(suite, http_iterations, latency);
+    runFailover(suite, http_iterations, latency);
+
+    if (!json_path.empty()) {
+        const json report = suite.toJson({
+            {"iterations", iterations},
+            {"http_iterations", http_iterations},
+            {"latency_ms", latency.count()},
+            {"filter", filter}
+        });
+        std::ofstream out(json_path);
+        out << report.dump(2) << '\n';
+        if (!out) {
+            std::fprintf(stderr, "Cannot write %s\n", json_path.c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,240 @@
+/**
+ * @file ConcurrentChecks.cpp
+ * @brief Multicore scaling benchmark and stress run for a shared GeoRestriction
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * Scaling mode (default) runs checkCountry, checkCountryFast and checkAccess
+ * on 1, 2, 4 ... up to the hardware thread count (or --max-threads) against
+ * one shared instance and reports throughput and parallel efficiency. Rows
+ * with more threads than cores are marked: they time-share, so their
+ * efficiency says nothing about scaling. checkAccess is answered
+ * from cached failed lookups, so it measures the per-check path (snapshot
+ * reads, caches, classification) without the network.
+ *
+ * Stress mode runs checks, lookups and audit logging on every core while a
+ * separate thread keeps replacing the configuration. Run it under
+ * ThreadSanitizer to validate the concurrency model; it fails if a
+ * sanctioned country is ever allowed.
+ *
+ * Usage:
+ *   bench_concurrent_checks [--duration-ms N] [--max-threads N]
+ *   bench_concurrent_checks --stress [--duration-ms N]
+ */
+
+#include "../compliance/GeoRestriction.hpp"
+#include "../compliance/IpAddress.hpp"
+#include <array>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace SpectreMap::Compliance;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct alignas(64) Counter {
+    uint64_t ops = 0;
+};
+
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * @brief Run body(thread_index, iteration) on N threads for a fixed time
+ * @return Total operations per second
+ */
+template <typename Body>
+double runThreads(unsigned threads, std::chrono::milliseconds duration, Body&& body) {
+    std::vector<Counter> counters(threads);
+    std::atomic<bool> stop{false};
+    std::barrier start(threads + 1);
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            uint64_t ops = 0;
+            start.arrive_and_wait();
+            while (!stop.load(std::memory_order_relaxed)) {
+                // Check the stop flag every 256 operations
+                for (int i = 0; i < 256; ++i) {
+                    body(t, ops++);
+                }
+            }
+            counters[t].ops = ops;
+        });
+    }
+
+    start.arrive_and_wait();
+    const auto begin = Clock::now();
+    std::this_thread::sleep_for(duration);
+    stop.store(true);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    uint64_t total = 0;
+    for (const Counter& counter : counters) {
+        total += counter.ops;
+    }
+    return static_cast<double>(total) / seconds;
+}
+
+unsigned coreCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+std::vector<unsigned> threadCounts(unsigned max_threads) {
+    std::vector<unsigned> counts;
+    for (unsigned n = 1; n < max_threads; n *= 2) {
+        counts.push_back(n);
+    }
+    counts.push_back(max_threads);
+    return counts;
+}
+
+int runScaling(std::chrono::milliseconds duration, unsigned max_threads) {
+    GeoRestriction geo;
+
+    // checkCountry logs listed countries, so it is measured on unlisted codes
+    const std::array<std::string, 4> unlisted = {"US", "DE", "JP", "BR"};
+    const std::array<std::string, 8> mixed = {"KP", "XCR", "RU", "SO", "CN", "US", "DE", "JP"};
+
+    const unsigned cores = coreCount();
+    std::printf("%u hardware threads\n", cores);
+    std::printf("%-18s %8s %16s %10s %11s\n", "call", "threads", "ops/s", "speedup", "efficiency");
+    auto report = [&](const char* name, auto&& body) {
+        double baseline = 0.0;
+        for (unsigned threads : threadCounts(max_threads)) {
+            const double rate = runThreads(threads, duration, body);
+            if (threads == 1) baseline = rate;
+            const double speedup = rate / baseline;
+            std::printf("%-18s %8u %16.0f %9.2fx %10.0f%%%s\n", name, threads, rate, speedup,
+                        100.0 * speedup / threads, threads > cores ? "  (oversubscribed)" : "");
+        }
+    };
+
+    report("checkCountry", [&](unsigned t, uint64_t i) {
+        const RestrictionResult result = geo.checkCountry(unlisted[(i + t) % unlisted.size()]);
+        doNotOptimize(result);
+    });
+    report("checkCountryFast", [&](unsigned t, uint64_t i) {
+        const RestrictionDecision decision = GeoRestriction::checkCountryFast(mixed[(i + t) % mixed.size()]);
+        doNotOptimize(decision);
+    });
+
+    // Nothing listens here; each address fails once and is then a negative cache hit
+    geo.setGeoIPEndpoints("http://127.0.0.1:9/json/", "http://127.0.0.1:9/batch");
+    geo.setGeoIPClientConfig({.connect_timeout = std::chrono::milliseconds(50),
+                              .total_timeout = std::chrono::milliseconds(100)});
+    geo.setCacheConfig({.negative_ttl = std::chrono::hours(1)});
+    std::vector<IpAddress> addresses;
+    for (int i = 0; i < 256; ++i) {
+        addresses.push_back(*IpAddress::parse("10.1.0." + std::to_string(i)));
+    }
+    geo.checkAccessBatch(std::span<const IpAddress>(addresses));
+    report("checkAccess", [&](unsigned t, uint64_t i) {
+        const RestrictionResult result = geo.checkAccess(addresses[(i * 7 + t) % addresses.size()]);
+        doNotOptimize(result);
+    });
+    if (max_threads > cores) {
+        std::printf("Oversubscribed rows time-share %u hardware thread(s) and do not measure scaling\n", cores);
+    }
+    return 0;
+}
+
+int runStress(std::chrono::milliseconds duration) {
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "spectremap_stress";
+    std::filesystem::remove_all(directory);
+
+    GeoRestriction geo;
+    // Nothing listens here, so online lookups fail fast and resolve fail-closed
+    geo.setGeoIPEndpoints("http://127.0.0.1:9/json/", "http://127.0.0.1:9/batch");
+    geo.setGeoIPClientConfig({.connect_timeout = std::chrono::milliseconds(50),
+                              .total_timeout = std::chrono::milliseconds(100)});
+    geo.setAuditLogConfig({.path = (directory / "audit.log").string()});
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> violations{0};
+
+    std::thread reconfigure([&] {
+        for (uint64_t round = 0; !stop.load(); ++round) {
+            geo.setStrictMode(round % 2 == 0);
+            geo.setCacheConfig({.enabled = round % 3 != 0, .max_entries = 1024, .shard_count = 4});
+            geo.setDecisionCacheConfig({.enabled = round % 5 != 0, .max_entries = 256, .shard_count = 4});
+            geo.setGeoIPEndpoints("http://127.0.0.1:9/json/", "http://127.0.0.1:9/batch");
+            if (round % 8 == 0) {
+                geo.setAuditLogConfig({.path = (directory / ("audit-" + std::to_string(round) + ".log")).string()});
+                geo.setGeoIPClientConfig({.connect_timeout = std::chrono::milliseconds(50),
+                                          .total_timeout = std::chrono::milliseconds(100)});
+            }
+            doNotOptimize(geo.getCacheStats());
+            doNotOptimize(geo.getDecisionCacheStats());
+            doNotOptimize(geo.getAuditLogStats());
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    });
+
+    const std::array<std::string, 6> sanctioned = {"CU", "IR", "KP", "SY", "RU", "SO"};
+    const double rate = runThreads(std::max(2u, std::thread::hardware_concurrency()), duration,
+        [&](unsigned t, uint64_t i) {
+            switch (i % 64) {
+                case 0: {
+                    const std::string ip = "10." + std::to_string(t) + ".0." + std::to_string(i % 200);
+                    const RestrictionResult result = geo.checkAccess(ip);
+                    if (result.allowed) violations.fetch_add(1);
+                    geo.logAccessAttempt(ip, result, "BLOCKED");
+                    break;
+                }
+                case 1:
+                    if (geo.getSanctionedCountries().empty()) violations.fetch_add(1);
+                    break;
+                default: {
+                    const std::string& code = sanctioned[i % sanctioned.size()];
+                    if (geo.checkCountryFast(code).allowed) violations.fetch_add(1);
+                    break;
+                }
+            }
+        });
+
+    stop.store(true);
+    reconfigure.join();
+    geo.flushAuditLog();
+    std::filesystem::remove_all(directory);
+
+    std::printf("stress: %.0f ops/s, %llu violations\n", rate,
+                static_cast<unsigned long long>(violations.load()));
+    return violations.load() == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    bool stress = false;
+    std::chrono::milliseconds duration(500);
+    unsigned max_threads = coreCount();
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--stress") == 0) {
+            stress = true;
+        } else if (std::strcmp(argv[i], "--duration-ms") == 0 && i + 1 < argc) {
+            duration = std::chrono::milliseconds(std::strtoll(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--max-threads") == 0 && i + 1 < argc) {
+            max_threads = static_cast<unsigned>(std::max(1ul, std::strtoul(argv[++i], nullptr, 10)));
+        } else {
+            std::fprintf(stderr, "Usage: %s [--stress] [--duration-ms N] [--max-threads N]\n", argv[0]);
+            return 2;
+        }
+    }
+    return stress ? runStress(duration) : runScaling(duration, max_threads);
+}
@@ -0,0 +1,100 @@
+/**
+ * @file CountryCheck.cpp
+ * @brief Benchmark: heap allocations and latency of checkCountry vs checkCountryFast
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * Replaces the global operator new with a counting wrapper, then runs both
+ * country checks over a mix covering every decision shape (comprehensive,
+ * sectoral, embargo, high-risk, allowed, unknown). checkCountry logs each
+ * listed country, so it is measured on unlisted codes only.
+ *
+ * Usage: bench_country_check [iterations]
+ * Exits non-zero if checkCountryFast allocated.
+ */
+
+#include "../compliance/GeoRestriction.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+namespace {
+
+std::atomic<uint64_t> g_allocations{0};
+
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Measurement {
+    double ns_per_call;
+    double allocations_per_call;
+};
+
+template <typename Fn>
+Measurement measure(uint64_t iterations, Fn&& fn) {
+    const uint64_t allocations_before = g_allocations.load(std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        fn(i);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const uint64_t allocations = g_allocations.load(std::memory_order_relaxed) - allocations_before;
+    return Measurement{
+        .ns_per_call = std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iterations),
+        .allocations_per_call = static_cast<double>(allocations) / static_cast<double>(iterations)
+    };
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+int main(int argc, char* argv[]) {
+    using namespace SpectreMap::Compliance;
+
+    const uint64_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+
+    // One code per decision shape, plus unlisted codes of both lengths
+    const std::array<std::string, 8> mixed = {"KP", "XCR", "RU", "SO", "CN", "US", "DE", "UNKNOWN"};
+    const std::array<std::string, 4> unlisted = {"US", "DE", "JP", "UNKNOWN"};
+
+    // Warm up outside the measured loop, so one-time initialization (the
+    // builtin policy, lazily built tables) is not charged to the hot path
+    for (const std::string& country : mixed) {
+        doNotOptimize(GeoRestriction::checkCountryFast(country));
+    }
+
+    const Measurement fast = measure(iterations, [&](uint64_t i) {
+        const RestrictionDecision decision = GeoRestriction::checkCountryFast(mixed[i % mixed.size()]);
+        doNotOptimize(decision);
+    });
+
+    GeoRestriction geo;
+    const uint64_t legacy_iterations = iterations / 10 ? iterations / 10 : 1;
+    const Measurement legacy = measure(legacy_iterations, [&](uint64_t i) {
+        const RestrictionResult result = geo.checkCountry(unlisted[i % unlisted.size()]);
+        doNotOptimize(result);
+    });
+
+    std::printf("%-22s %12s %14s\n", "path", "ns/call", "allocs/call");
+    std::printf("%-22s %12.2f %14.3f\n", "checkCountryFast", fast.ns_per_call, fast.allocations_per_call);
+    std::printf("%-22s %12.2f %14.3f\n", "checkCountry", legacy.ns_per_call, legacy.allocations_per_call);
+
+    if (fast.allocations_per_call != 0.0) {
+        std::fprintf(stderr, "FAIL: checkCountryFast allocated\n");
+        return 1;
+    }
+    return 0;
+}
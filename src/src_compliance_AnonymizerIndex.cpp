@@ -0,0 +1,343 @@
+/**
+ * @file AnonymizerIndex.cpp
+ * @brief Implementation of anonymizer list loading, range flattening and lookup
+ */
+
+#include "AnonymizerIndex.hpp"
+#include "../core/Logger.hpp"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <type_traits>
+
+namespace SpectreMap::Compliance {
+
+namespace {
+
+constexpr Uint128 V6_MAX = Uint128::max();
+constexpr size_t V4_BUCKET_COUNT = 1u << 16;
+
+struct Range {
+    Uint128 start;
+    Uint128 end;    ///< Inclusive
+    uint8_t flag;
+};
+
+struct RangeLists {
+    std::vector<Range> v4;
+    std::vector<Range> v6;
+};
+
+std::string_view trim(std::string_view text) {
+    const size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string_view::npos) return {};
+    const size_t last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+/**
+ * @brief Parse "a.b.c.d", "a.b.c.d/n", "x::y" or "x::y/n" into a range
+ */
+bool parseRange(std::string_view token, uint8_t flag, RangeLists& out) {
+    const size_t slash = token.find('/');
+    const std::string_view text = token.substr(0, slash);
+    const auto address = IpAddress::parse(text);
+    if (!address) return false;
+
+    bool v6 = text.find(':') != std::string_view::npos;
+    unsigned bits = v6 ? 128 : 32;
+    unsigned prefix = bits;
+    if (slash != std::string_view::npos) {
+        const std::string_view length = token.substr(slash + 1);
+        const auto [end, ec] = std::from_chars(length.data(), length.data() + length.size(), prefix);
+        if (ec != std::errc() || end != length.data() + length.size() || prefix > bits) return false;
+    }
+
+    // An IPv4-mapped block is stored with the IPv4 ranges it aliases
+    if (v6 && address->isV4() && prefix >= 96) {
+        v6 = false;
+        bits = 32;
+        prefix -= 96;
+    }
+
+    if (v6) {
+        const Uint128 host_mask = prefix == 0 ? V6_MAX : (Uint128(1) << (128 - prefix)) - 1;
+        const Uint128 start = address->bits() & ~host_mask;
+        out.v6.push_back(Range{start, start | host_mask, flag});
+    } else {
+        const uint32_t host_mask = prefix == 0 ? UINT32_MAX : (uint32_t{1} << (32 - prefix)) - 1;
+        const uint32_t start = address->v4() & ~host_mask;
+        out.v4.push_back(Range{start, start | host_mask, flag});
+    }
+    return true;
+}
+
+/**
+ * @brief Call @p on_entry for each non-comment line of a list file
+ * @return False if the file cannot be opened
+ */
+template <typename OnEntry>
+bool forEachEntry(const std::string& path, OnEntry&& on_entry) {
+    std::ifstream in(path);
+    if (!in) {
+        Logger::error("Cannot open anonymizer list: " + path);
+        return false;
+    }
+
+    size_t malformed = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::string_view entry = line;
+        entry = trim(entry.substr(0, entry.find('#')));
+        // Tor's exit-addresses format: "ExitAddress <ip> <date> <time>",
+        // interleaved with ExitNode/Published/LastStatus lines
+        if (entry.starts_with("ExitAddress ")) {
+            entry = trim(entry.substr(12));
+            entry = entry.substr(0, entry.find(' '));
+        } else if (entry.starts_with("ExitNode ") || entry.starts_with("Published ") ||
+                   entry.starts_with("LastStatus ")) {
+            continue;
+        }
+        if (entry.empty()) continue;
+        if (!on_entry(entry)) ++malformed;
+    }
+    if (malformed > 0) {
+        Logger::warning("Skipped " + std::to_string(malformed) + " malformed lines in " + path);
+    }
+    return true;
+}
+
+bool loadRanges(const std::string& path, uint8_t flag, RangeLists& out, size_t& count) {
+    if (path.empty()) return true;
+    return forEachEntry(path, [&](std::string_view entry) {
+        if (!parseRange(entry, flag, out)) return false;
+        ++count;
+        return true;
+    });
+}
+
+std::optional<uint32_t> parseAsn(std::string_view text) {
+    text = trim(text);
+    if (text.size() >= 2 && (text[0] == 'A' || text[0] == 'a') && (text[1] == 'S' || text[1] == 's')) {
+        text.remove_prefix(2);
+    }
+    uint32_t asn = 0;
+    const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), asn);
+    if (ec != std::errc() || end == text.data()) return std::nullopt;
+    return asn;
+}
+
+/**
+ * @brief Narrow a range boundary to the segment element type
+ */
+template <typename T>
+constexpr T narrow(const Uint128& value) noexcept {
+    if constexpr (std::is_same_v<T, Uint128>) {
+        return value;
+    } else {
+        return static_cast<T>(value.lo);
+    }
+}
+
+/**
+ * @brief Flatten possibly overlapping ranges into sorted disjoint segments
+ *
+ * Sweeps range boundaries keeping a per-flag count of open ranges; a new
+ * segment starts wherever the union of open flags changes, so adjacent
+ * ranges with the same flags merge into one segment.
+ */
+template <typename T>
+void flatten(const std::vector<Range>& ranges, Uint128 max_address,
+             std::vector<T>& starts, std::vector<T>& ends, std::vector<uint8_t>& flags) {
+    struct Event {
+        Uint128 point;
+        uint8_t flag;
+        int delta;
+    };
+    std::vector<Event> events;
+    events.reserve(ranges.size() * 2);
+    for (const Range& range : ranges) {
+        events.push_back(Event{range.start, range.flag, +1});
+        if (range.end != max_address) {
+            events.push_back(Event{range.end + 1, range.flag, -1});
+        }
+    }
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return a.point < b.point; });
+
+    std::array<int, 8> open{};
+    uint8_t current = 0;
+    Uint128 segment_start;
+    for (size_t i = 0; i < events.size();) {
+        const Uint128 point = events[i].point;
+        for (; i < events.size() && events[i].point == point; ++i) {
+            for (int bit = 0; bit < 8; ++bit) {
+                if (events[i].flag & (1u << bit)) open[bit] += events[i].delta;
+            }
+        }
+        uint8_t next = 0;
+        for (int bit = 0; bit < 8; ++bit) {
+            if (open[bit] > 0) next |= static_cast<uint8_t>(1u << bit);
+        }
+        if (next == current) continue;
+        if (current != 0) {
+            starts.push_back(narrow<T>(segment_start));
+            ends.push_back(narrow<T>(point - 1));
+            flags.push_back(current);
+        }
+        segment_start = point;
+        current = next;
+    }
+    if (current != 0) {
+        starts.push_back(narrow<T>(segment_start));
+        ends.push_back(narrow<T>(max_address));
+        flags.push_back(current);
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// Index Construction
+// ============================================================================
+
+std::shared_ptr<const AnonymizerIndex> AnonymizerIndex::load(const AnonymizerListConfig& config) {
+    std::shared_ptr<AnonymizerIndex> index(new AnonymizerIndex());
+    Summary& summary = index->summary_;
+
+    RangeLists ranges;
+    if (!loadRanges(config.tor_exit_list, ANONYMIZER_TOR, ranges, summary.tor_entries) ||
+        !loadRanges(config.vpn_ranges, ANONYMIZER_VPN, ranges, summary.vpn_entries) ||
+        !loadRanges(config.datacenter_ranges, ANONYMIZER_HOSTING, ranges, summary.datacenter_entries)) {
+        return nullptr;
+    }
+    if (!config.hosting_asns.empty() &&
+        !forEachEntry(config.hosting_asns, [&index](std::string_view entry) {
+            const auto asn = parseAsn(entry);
+            if (asn) index->hosting_asns_.push_back(*asn);
+            return asn.has_value();
+        })) {
+        return nullptr;
+    }
+
+    flatten(ranges.v4, UINT32_MAX, index->v4_starts_, index->v4_ends_, index->v4_flags_);
+    flatten(ranges.v6, V6_MAX, index->v6_starts_, index->v6_ends_, index->v6_flags_);
+
+    index->v4_buckets_.resize(V4_BUCKET_COUNT + 1);
+    size_t segment = 0;
+    for (size_t bucket = 0; bucket < V4_BUCKET_COUNT; ++bucket) {
+        const uint32_t bucket_start = static_cast<uint32_t>(bucket << 16);
+        while (segment < index->v4_starts_.size() && index->v4_starts_[segment] < bucket_start) {
+            ++segment;
+        }
+        index->v4_buckets_[bucket] = static_cast<uint32_t>(segment);
+    }
+    index->v4_buckets_[V4_BUCKET_COUNT] = static_cast<uint32_t>(index->v4_starts_.size());
+
+    std::sort(index->hosting_asns_.begin(), index->hosting_asns_.end());
+    index->hosting_asns_.erase(std::unique(index->hosting_asns_.begin(), index->hosting_asns_.end()),
+                               index->hosting_asns_.end());
+
+    summary.hosting_asns = index->hosting_asns_.size();
+    summary.v4_segments = index->v4_starts_.size();
+    summary.v6_segments = index->v6_starts_.size();
+    return index;
+}
+
+// ============================================================================
+// Lookup
+// ============================================================================
+
+uint8_t AnonymizerIndex::lookup(std::string_view ip_address) const noexcept {
+    const auto address = IpAddress::parse(ip_address);
+    if (!address) return ANONYMIZER_NONE;
+    return lookup(*address);
+}
+
+uint8_t AnonymizerIndex::lookup(const IpAddress& address) const noexcept {
+    return address.isV4() ? lookupV4(address.v4()) : lookupV6(address.bits());
+}
+
+uint8_t AnonymizerIndex::lookupV4(uint32_t address) const noexcept {
+    if (v4_starts_.empty()) return ANONYMIZER_NONE;
+
+    // Segments starting in other /16s can't be the last one at or below
+    // address, except the one just before this bucket (which may span into it)
+    const size_t bucket = address >> 16;
+    const auto first = v4_starts_.begin() + v4_buckets_[bucket];
+    const auto last = v4_starts_.begin() + v4_buckets_[bucket + 1];
+    const size_t next = static_cast<size_t>(std::upper_bound(first, last, address) - v4_starts_.begin());
+    if (next == 0 || v4_ends_[next - 1] < address) return ANONYMIZER_NONE;
+    return v4_flags_[next - 1];
+}
+
+uint8_t AnonymizerIndex::lookupV6(Uint128 address) const noexcept {
+    const size_t next = static_cast<size_t>(
+        std::upper_bound(v6_starts_.begin(), v6_starts_.end(), address) - v6_starts_.begin());
+    if (next == 0 || v6_ends_[next - 1] < address) return ANONYMIZER_NONE;
+    return v6_flags_[next - 1];
+}
+
+bool AnonymizerIndex::isHostingAsn(std::string_view asn) const noexcept {
+    if (hosting_asns_.empty()) return false;
+    const auto number = parseAsn(asn);
+    return number && std::binary_search(hosting_asns_.begin(), hosting_asns_.end(), *number);
+}
+
+// ============================================================================
+// Background Refresh
+// ============================================================================
+
+AnonymizerRefresher::AnonymizerRefresher(const AnonymizerListConfig& config, PublishFn publish)
+    : config_(config), publish_(std::move(publish)), last_mtimes_(currentMtimes()) {
+    thread_ = std::thread(&AnonymizerRefresher::run, this);
+}
+
+AnonymizerRefresher::~AnonymizerRefresher() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+AnonymizerRefresher::Mtimes AnonymizerRefresher::currentMtimes() const {
+    Mtimes mtimes;
+    const std::array<const std::string*, 4> paths = {
+        &config_.tor_exit_list, &config_.vpn_ranges, &config_.datacenter_ranges, &config_.hosting_asns
+    };
+    for (size_t i = 0; i < paths.size(); ++i) {
+        std::error_code ec;
+        if (paths[i]->empty()) continue;
+        const auto mtime = std::filesystem::last_write_time(*paths[i], ec);
+        if (!ec) mtimes[i] = mtime;
+    }
+    return mtimes;
+}
+
+void AnonymizerRefresher::run() {
+    std::unique_lock lock(mutex_);
+    while (!cv_.wait_for(lock, config_.refresh_interval, [this] { return stopping_; })) {
+        const Mtimes mtimes = currentMtimes();
+        if (mtimes == last_mtimes_) continue;
+
+        // Build without the lock so shutdown isn't held up by a large list
+        lock.unlock();
+        auto index = AnonymizerIndex::load(config_);
+        lock.lock();
+        if (!index || stopping_) continue;   // Failed loads retry at the next interval
+
+        last_mtimes_ = mtimes;
+        const AnonymizerIndex::Summary& summary = index->summary();
+        Logger::info("Anonymizer lists reloaded: " + std::to_string(summary.tor_entries) + " Tor, " +
+                     std::to_string(summary.vpn_entries) + " VPN, " +
+                     std::to_string(summary.datacenter_entries) + " datacenter entries, " +
+                     std::to_string(summary.hosting_asns) + " hosting ASNs");
+        publish_(std::move(index));
+        rebuilds_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace SpectreMap::Compliance
@@ -0,0 +1,153 @@
+/**
+ * @file AnonymizerIndex.hpp
+ * @brief Local Tor exit, VPN and hosting detection over compact IP range sets
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * The detection lists (Tor exit addresses, VPN and datacenter CIDRs, hosting
+ * ASNs) are compiled into an immutable AnonymizerIndex. Overlapping ranges
+ * are flattened into sorted, disjoint segments, each tagged with the union
+ * of its sources' flags. IPv4 segment starts sit in a flat array with a
+ * 65,536-entry first-level index on the top 16 bits, so a lookup is one
+ * table read plus a short binary search; IPv6 uses a binary search over
+ * 128-bit starts. Lookups never allocate or lock.
+ *
+ * An AnonymizerRefresher rebuilds the index on its own thread whenever a
+ * list file changes and hands the replacement to a callback.
+ */
+
+#ifndef SPECTREMAP_ANONYMIZERINDEX_HPP
+#define SPECTREMAP_ANONYMIZERINDEX_HPP
+
+#include "GeoRestriction.hpp"
+#include "IpAddress.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace SpectreMap::Compliance {
+
+/**
+ * @brief Detection flags (bitmask)
+ */
+enum AnonymizerFlag : uint8_t {
+    ANONYMIZER_NONE = 0,
+    ANONYMIZER_TOR = 1 << 0,        ///< Tor exit node
+    ANONYMIZER_VPN = 1 << 1,        ///< Commercial VPN range
+    ANONYMIZER_HOSTING = 1 << 2     ///< Datacenter range or hosting ASN
+};
+
+/**
+ * @brief Immutable set of flagged IPv4/IPv6 ranges and hosting ASNs
+ */
+class AnonymizerIndex {
+public:
+    /**
+     * @brief Entry counts, for logging
+     */
+    struct Summary {
+        size_t tor_entries = 0;
+        size_t vpn_entries = 0;
+        size_t datacenter_entries = 0;
+        size_t hosting_asns = 0;
+        size_t v4_segments = 0;
+        size_t v6_segments = 0;
+    };
+
+    /**
+     * @brief Build an index from the configured list files
+     *
+     * Files with an empty path are skipped. Lines may hold an address or a
+     * CIDR block (the ASN list holds "AS13335" or "13335"); '#' starts a
+     * comment. Malformed lines are skipped and counted in the log.
+     *
+     * @return Index, or nullptr if a configured file cannot be read
+     */
+    static std::shared_ptr<const AnonymizerIndex> load(const AnonymizerListConfig& config);
+
+    /**
+     * @brief Flags for an address (IPv4-mapped IPv6 is treated as IPv4)
+     * @return ANONYMIZER_NONE for unlisted or unparseable addresses
+     */
+    uint8_t lookup(std::string_view ip_address) const noexcept;
+    uint8_t lookup(const IpAddress& address) const noexcept;
+
+    uint8_t lookupV4(uint32_t address) const noexcept;
+    uint8_t lookupV6(Uint128 address) const noexcept;
+
+    /**
+     * @brief Whether an ASN is listed as hosting
+     * @param asn Number, or provider text such as "AS13335 Cloudflare, Inc."
+     */
+    bool isHostingAsn(std::string_view asn) const noexcept;
+
+    const Summary& summary() const noexcept { return summary_; }
+
+private:
+    AnonymizerIndex() = default;
+
+    // IPv4: segment i covers [v4_starts_[i], v4_ends_[i]]
+    std::vector<uint32_t> v4_starts_;
+    std::vector<uint32_t> v4_ends_;
+    std::vector<uint8_t> v4_flags_;
+    std::vector<uint32_t> v4_buckets_;   ///< First segment with start >= (hi16 << 16); 65,537 entries
+
+    std::vector<Uint128> v6_starts_;
+    std::vector<Uint128> v6_ends_;
+    std::vector<uint8_t> v6_flags_;
+
+    std::vector<uint32_t> hosting_asns_;  ///< Sorted
+    Summary summary_;
+};
+
+/**
+ * @brief Rebuilds an AnonymizerIndex when any of its list files changes
+ *
+ * Files are polled by mtime every refresh_interval. The rebuild runs on the
+ * refresher's thread; the hot path only ever sees a finished index. A
+ * rebuild that fails keeps the current index.
+ */
+class AnonymizerRefresher {
+public:
+    using PublishFn = std::function<void(std::shared_ptr<const AnonymizerIndex>)>;
+
+    AnonymizerRefresher(const AnonymizerListConfig& config, PublishFn publish);
+    ~AnonymizerRefresher();
+
+    AnonymizerRefresher(const AnonymizerRefresher&) = delete;
+    AnonymizerRefresher& operator=(const AnonymizerRefresher&) = delete;
+
+    /**
+     * @brief Successful rebuilds since the refresher started
+     */
+    uint64_t rebuilds() const noexcept { return rebuilds_.load(std::memory_order_relaxed); }
+
+private:
+    using Mtimes = std::array<std::optional<std::filesystem::file_time_type>, 4>;
+
+    void run();
+    Mtimes currentMtimes() const;
+
+    AnonymizerListConfig config_;
+    PublishFn publish_;
+    Mtimes last_mtimes_;
+    std::atomic<uint64_t> rebuilds_{0};
+    bool stopping_ = false;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+};
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_ANONYMIZERINDEX_HPP
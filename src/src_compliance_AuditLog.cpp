@@ -0,0 +1,387 @@
+/**
+ * @file AuditLog.cpp
+ * @brief Implementation of the group-commit compliance audit log writer
+ */
+
+#include "AuditLog.hpp"
+#include "../core/Logger.hpp"
+#include <bit>
+#include <ctime>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace SpectreMap::Compliance {
+
+namespace {
+
+std::string formatTimestamp(std::chrono::system_clock::time_point time) {
+    const std::time_t t = std::chrono::system_clock::to_time_t(time);
+    std::tm local_time{};
+#ifdef _WIN32
+    localtime_s(&local_time, &t);
+#else
+    localtime_r(&t, &local_time);
+#endif
+    char buffer[32];
+    const size_t len = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local_time);
+    return std::string(buffer, len);
+}
+
+} // namespace
+
+struct AuditLogWriter::Cell {
+    std::atomic<size_t> sequence{0};
+    Entry entry;
+};
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+AuditLogWriter::AuditLogWriter(const AuditLogConfig& config) : config_(config) {
+    const size_t capacity = std::bit_ceil(std::max<size_t>(config_.queue_capacity, 2));
+    cells_ = std::make_unique<Cell[]>(capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    mask_ = capacity - 1;
+    last_sync_ = std::chrono::steady_clock::now();
+    if (config_.max_segment_bytes > 0) {
+        sealer_ = std::make_unique<AuditSegmentSealer>(config_.path, config_.compress_segments);
+    }
+    thread_ = std::thread(&AuditLogWriter::run, this);
+}
+
+AuditLogWriter::~AuditLogWriter() {
+    {
+        std::lock_guard lock(wake_mutex_);
+        stopping_.store(true);
+    }
+    wake_cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+// ============================================================================
+// Producer Side
+// ============================================================================
+
+bool AuditLogWriter::append(Entry&& entry) {
+    if (tryPush(entry)) {
+        accepted_.fetch_add(1, std::memory_order_relaxed);
+        wakeWriter();
+        return true;
+    }
+
+    if (config_.overflow_policy == AuditOverflowPolicy::DROP || stopping_.load()) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // BLOCK: hold the caller until the writer frees a slot
+    blocked_.fetch_add(1, std::memory_order_relaxed);
+    wakeWriter();
+    while (!tryPush(entry)) {
+        if (stopping_.load()) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    accepted_.fetch_add(1, std::memory_order_relaxed);
+    wakeWriter();
+    return true;
+}
+
+bool AuditLogWriter::tryPush(Entry& entry) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = cells_[pos & mask_];
+        const size_t seq = cell.sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0) {
+            if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.entry = std::move(entry);
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;  // Full
+        } else {
+            pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void AuditLogWriter::wakeWriter() {
+    if (writer_sleeping_.load()) {
+        std::lock_guard lock(wake_mutex_);
+        wake_cv_.notify_one();
+    }
+}
+
+bool AuditLogWriter::flush() {
+    const uint64_t target = accepted_.load();
+    const uint64_t lost = lost_.load();
+    std::unique_lock lock(wake_mutex_);
+    while (durable_.load() + lost_.load() < target) {
+        if (stopping_.load() || failing_.load()) {
+            return false;
+        }
+        flush_requested_.store(true);
+        wake_cv_.notify_one();
+        flushed_cv_.wait_for(lock, std::chrono::milliseconds(50));
+    }
+    return lost_.load() == lost;
+}
+
+AuditLogStats AuditLogWriter::stats() const {
+    AuditLogStats stats;
+    stats.accepted = accepted_.load(std::memory_order_relaxed);
+    stats.written = written_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.blocked = blocked_.load(std::memory_order_relaxed);
+    stats.commits = commits_.load(std::memory_order_relaxed);
+    stats.rotations = rotations_.load(std::memory_order_relaxed);
+    stats.lost = lost_.load(std::memory_order_relaxed);
+    stats.write_errors = write_errors_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// ============================================================================
+// Writer Thread
+// ============================================================================
+
+bool AuditLogWriter::tryPop(Entry& entry) {
+    Cell& cell = cells_[head_ & mask_];
+    if (cell.sequence.load(std::memory_order_acquire) != head_ + 1) {
+        return false;  // Empty
+    }
+    entry = std::move(cell.entry);
+    cell.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+    ++head_;
+    return true;
+}
+
+void AuditLogWriter::run() {
+    // Attempts at a refused batch once stopping, one commit interval apart
+    constexpr int FINAL_WRITE_ATTEMPTS = 3;
+
+    std::string buffer;
+    buffer.reserve(64 * 1024);
+    size_t held = 0;   // Entries in buffer
+    int final_attempts = 0;
+
+    for (;;) {
+        // A refused batch is retried before anything new is taken
+        const size_t drained = buffer.empty() ? drainBatch(buffer) : 0;
+        held += drained;
+        if (!buffer.empty() && writeBuffer(buffer, held)) {
+            held = 0;
+        }
+
+        const bool stopping = stopping_.load();
+        const auto now = std::chrono::steady_clock::now();
+        if (stopping || flush_requested_.load() ||
+            (unsynced_ && now - last_sync_ >= config_.commit_interval)) {
+            sync();
+        }
+
+        if (failing_.load()) {
+            if (stopping && ++final_attempts >= FINAL_WRITE_ATTEMPTS) {
+                abandon(buffer, held);
+                break;
+            }
+            // Meanwhile the queue fills and the overflow policy applies
+            std::unique_lock lock(wake_mutex_);
+            wake_cv_.wait_for(lock, config_.commit_interval);
+            continue;
+        }
+        if (drained > 0) {
+            continue;
+        }
+        if (stopping) {
+            break;
+        }
+
+        std::unique_lock lock(wake_mutex_);
+        writer_sleeping_.store(true);
+        // Re-check under the lock so a push that raced the sleeping flag isn't missed
+        const bool idle = cells_[head_ & mask_].sequence.load(std::memory_order_acquire) != head_ + 1;
+        if (idle && !stopping_.load() && !flush_requested_.load()) {
+            wake_cv_.wait_for(lock, config_.commit_interval);
+        }
+        writer_sleeping_.store(false);
+    }
+
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+size_t AuditLogWriter::drainBatch(std::string& buffer) {
+    // Record gaps so a dropped entry is visible in the trail itself
+    if (unconfirmed_ > 0) {
+        buffer += formatTimestamp(std::chrono::system_clock::now());
+        buffer += " | AUDIT GAP | ";
+        buffer += std::to_string(unconfirmed_);
+        buffer += " entries may be missing (fsync failed)\n";
+        unconfirmed_ = 0;
+    }
+    const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != reported_drops_) {
+        buffer += formatTimestamp(std::chrono::system_clock::now());
+        buffer += " | AUDIT GAP | ";
+        buffer += std::to_string(dropped - reported_drops_);
+        buffer += " entries dropped (audit queue full)\n";
+        reported_drops_ = dropped;
+    }
+
+    size_t count = 0;
+    Entry entry;
+    while (count < config_.max_batch && tryPop(entry)) {
+        buffer += formatEntry(entry);
+        ++count;
+    }
+    return count;
+}
+
+bool AuditLogWriter::ensureOpen() {
+    if (file_) return true;
+
+    const std::filesystem::path path(config_.path);
+    if (path.has_parent_path()) {
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+    }
+    file_ = std::fopen(config_.path.c_str(), "ab");
+    if (!file_) {
+        Logger::error("Failed to open compliance audit log: " + config_.path);
+        return false;
+    }
+    std::error_code ec;
+    const auto existing = std::filesystem::file_size(path, ec);
+    segment_bytes_ = ec ? 0 : existing;
+    segment_opened_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+void AuditLogWriter::rotateIfNeeded(size_t incoming_bytes) {
+    if (!sealer_ || !file_ || segment_bytes_ == 0) return;
+
+    const bool too_big = segment_bytes_ + incoming_bytes > config_.max_segment_bytes;
+    const bool too_old = std::chrono::steady_clock::now() - segment_opened_ >= config_.max_segment_age;
+    if (!too_big && !too_old) return;
+
+    // A segment is only handed over once it is durable. The incoming batch
+    // is not written yet, so this publishes only what the segment holds.
+    sync();
+    std::fclose(file_);
+    file_ = nullptr;
+    if (sealer_->rotate()) {
+        rotations_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool AuditLogWriter::writeBuffer(std::string& buffer, size_t entries) {
+    rotateIfNeeded(buffer.size());
+    if (ensureOpen() &&
+        std::fwrite(buffer.data(), 1, buffer.size(), file_) == buffer.size() &&
+        std::fflush(file_) == 0) {
+        // Counted only once in the file, so sync() never publishes an unwritten batch
+        segment_bytes_ += buffer.size();
+        unsynced_ = true;
+        written_.fetch_add(entries, std::memory_order_relaxed);
+        buffer.clear();
+        if (failing_.exchange(false)) {
+            Logger::info("Compliance audit log writes recovered: " + config_.path);
+        }
+        return true;
+    }
+
+    // Keep the whole batch: how much of it reached the file is unknown, and a
+    // repeated line is better than a missing one. Reopen on the next attempt.
+    write_errors_.fetch_add(1, std::memory_order_relaxed);
+    if (file_) {
+        sync();
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    if (!failing_.exchange(true)) {
+        Logger::error("Failed to write compliance audit log " + config_.path + "; holding " +
+                      std::to_string(entries) + " entries for retry");
+    }
+    return false;
+}
+
+void AuditLogWriter::abandon(std::string& buffer, size_t entries) {
+    Entry entry;
+    while (tryPop(entry)) {
+        ++entries;
+    }
+    buffer.clear();
+    lost_.fetch_add(entries, std::memory_order_relaxed);
+    Logger::error("Compliance audit log " + config_.path + " still unwritable at shutdown; " +
+                  std::to_string(entries) + " entries lost");
+}
+
+void AuditLogWriter::sync() {
+    if (unsynced_ && file_) {
+#ifdef _WIN32
+        const int rc = _commit(_fileno(file_));
+#else
+        const int rc = fsync(fileno(file_));
+#endif
+        commits_.fetch_add(1, std::memory_order_relaxed);
+        if (rc != 0) {
+            // The pages may already be gone; note the gap rather than trust a retry
+            const uint64_t unconfirmed = written_.load() - synced_;
+            write_errors_.fetch_add(1, std::memory_order_relaxed);
+            lost_.fetch_add(unconfirmed, std::memory_order_relaxed);
+            unconfirmed_ += unconfirmed;
+            synced_ += unconfirmed;
+            Logger::error("fsync of compliance audit log " + config_.path + " failed; " +
+                          std::to_string(unconfirmed) + " entries may not be durable");
+        }
+    }
+    unsynced_ = false;
+    last_sync_ = std::chrono::steady_clock::now();
+    const uint64_t written = written_.load();
+    durable_.fetch_add(written - synced_);
+    synced_ = written;
+
+    {
+        std::lock_guard lock(wake_mutex_);
+        flush_requested_.store(false);
+    }
+    flushed_cv_.notify_all();
+}
+
+std::string AuditLogWriter::formatEntry(const Entry& entry) {
+    std::string line;
+    line.reserve(128 + entry.reason.size() + entry.country_name.size());
+    line += formatTimestamp(entry.time);
+    line += " | IP: ";
+    line += entry.ip_address;
+    line += " | Country: ";
+    line += entry.country_code;
+    line += " (";
+    line += entry.country_name;
+    line += ") | Action: ";
+    line += entry.action;
+    line += " | Level: ";
+    line += std::to_string(static_cast<int>(entry.level));
+    line += " | Reason: ";
+    line += entry.reason;
+    line += '\n';
+    return line;
+}
+
+} // namespace SpectreMap::Compliance
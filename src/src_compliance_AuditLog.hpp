@@ -0,0 +1,142 @@
+/**
+ * @file AuditLog.hpp
+ * @brief Asynchronous group-commit writer for the compliance audit trail
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * Callers push entries into a bounded lock-free MPSC ring; a dedicated
+ * writer thread formats them, keeps the log file open, writes in batches
+ * and fsyncs once per commit interval. Entries are never interleaved, and
+ * destruction drains and syncs everything that was accepted - the audit
+ * trail is a legal record.
+ *
+ * A batch the file refuses is kept and retried every commit interval while
+ * new entries wait in the queue (so the overflow policy applies). A retried
+ * batch may repeat lines that reached the file before the failure; a failed
+ * fsync is recorded in the trail as an AUDIT GAP. Entries still unwritable
+ * at shutdown are counted as lost.
+ *
+ * The active log is rotated by size and age into segments that an
+ * AuditSegmentSealer compresses and indexes in the background
+ * (see AuditStore.hpp).
+ */
+
+#ifndef SPECTREMAP_AUDITLOG_HPP
+#define SPECTREMAP_AUDITLOG_HPP
+
+#include "GeoRestriction.hpp"
+#include "AuditStore.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace SpectreMap::Compliance {
+
+/**
+ * @brief Group-commit audit log writer
+ */
+class AuditLogWriter {
+public:
+    /**
+     * @brief One audit record; formatted on the writer thread
+     */
+    struct Entry {
+        std::chrono::system_clock::time_point time;
+        std::string ip_address;
+        std::string country_code;
+        std::string country_name;
+        std::string action;
+        RestrictionLevel level = RestrictionLevel::ALLOWED;
+        std::string reason;
+    };
+
+    explicit AuditLogWriter(const AuditLogConfig& config);
+
+    /**
+     * @brief Drains the queue, fsyncs and closes the log
+     */
+    ~AuditLogWriter();
+
+    AuditLogWriter(const AuditLogWriter&) = delete;
+    AuditLogWriter& operator=(const AuditLogWriter&) = delete;
+
+    /**
+     * @brief Queue an entry for writing
+     * @return False if the queue was full and the entry was dropped (DROP policy)
+     */
+    bool append(Entry&& entry);
+
+    /**
+     * @brief Block until every entry appended before this call is fsynced
+     * @return False if the log cannot be written or entries were lost while waiting
+     */
+    bool flush();
+
+    AuditLogStats stats() const;
+
+    /**
+     * @brief Format an entry as one pipe-delimited audit log line (with newline)
+     */
+    static std::string formatEntry(const Entry& entry);
+
+private:
+    struct Cell;
+
+    bool tryPush(Entry& entry);
+    bool tryPop(Entry& entry);
+    void run();
+    size_t drainBatch(std::string& buffer);
+    bool ensureOpen();
+    void rotateIfNeeded(size_t incoming_bytes);
+    bool writeBuffer(std::string& buffer, size_t entries);
+    void abandon(std::string& buffer, size_t entries);
+    void sync();
+    void wakeWriter();
+
+    AuditLogConfig config_;
+
+    // Vyukov bounded queue; producers CAS the tail, the writer owns the head
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) size_t head_ = 0;
+
+    std::FILE* file_ = nullptr;
+    uint64_t segment_bytes_ = 0;
+    std::chrono::steady_clock::time_point segment_opened_;
+    std::unique_ptr<AuditSegmentSealer> sealer_;
+    std::chrono::steady_clock::time_point last_sync_;
+    bool unsynced_ = false;
+    uint64_t synced_ = 0;          ///< written_ as of the last sync()
+    uint64_t unconfirmed_ = 0;     ///< Entries whose fsync failed, not yet reported in the trail
+    uint64_t reported_drops_ = 0;
+
+    // Sleep/wake only; the enqueue path takes the mutex only if the writer sleeps
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable flushed_cv_;
+    std::atomic<bool> writer_sleeping_{false};
+    std::atomic<bool> flush_requested_{false};
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> failing_{false};   ///< Holding a batch the file refused
+
+    std::atomic<uint64_t> accepted_{0};
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> durable_{0};
+    std::atomic<uint64_t> lost_{0};      ///< Unwritable at shutdown, or their fsync failed
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> blocked_{0};
+    std::atomic<uint64_t> commits_{0};
+    std::atomic<uint64_t> rotations_{0};
+    std::atomic<uint64_t> write_errors_{0};
+
+    std::thread thread_;
+};
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_AUDITLOG_HPP
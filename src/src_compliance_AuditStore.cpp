@@ -0,0 +1,521 @@
+/**
+ * @file AuditStore.cpp
+ * @brief Implementation of audit log segment sealing, indexing and querying
+ */
+
+#include "AuditStore.hpp"
+#include "../core/Logger.hpp"
+#include <nlohmann/json.hpp>
+#include <zlib.h>
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace SpectreMap::Compliance {
+
+namespace {
+
+constexpr int INDEX_FORMAT_VERSION = 1;
+constexpr size_t TIMESTAMP_LENGTH = 19;  // "YYYY-MM-DD HH:MM:SS"
+
+uint64_t fnv1a(std::string_view key) noexcept {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+std::string_view fieldAfter(std::string_view line, std::string_view label) {
+    const size_t start = line.find(label);
+    if (start == std::string_view::npos) return {};
+    const size_t value = start + label.size();
+    const size_t end = line.find(" | ", value);
+    return line.substr(value, end == std::string_view::npos ? std::string_view::npos : end - value);
+}
+
+/**
+ * @brief Segment base name: file name without .log/.log.gz/.idx
+ */
+std::string segmentBase(const std::filesystem::path& file) {
+    std::string name = file.filename().string();
+    for (std::string_view suffix : {".gz", ".log", ".idx", ".tmp"}) {
+        if (name.size() > suffix.size() &&
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            name.erase(name.size() - suffix.size());
+        }
+    }
+    return name;
+}
+
+/**
+ * @brief Flush a closed file, or a directory's entries, to stable storage
+ *
+ * Windows has no CRT handle for a directory; NTFS journals the rename
+ * itself, so directory syncs succeed trivially there.
+ */
+bool syncPath(const std::filesystem::path& path, bool directory = false) {
+#ifdef _WIN32
+    if (directory) return true;
+    const int fd = _wopen(path.c_str(), _O_RDWR | _O_BINARY);
+    if (fd < 0) return false;
+    const bool synced = _commit(fd) == 0;
+    _close(fd);
+#else
+    const int fd = open(path.c_str(), directory ? O_RDONLY | O_DIRECTORY : O_RDONLY);
+    if (fd < 0) return false;
+    const bool synced = fsync(fd) == 0;
+    close(fd);
+#endif
+    return synced;
+}
+
+struct SegmentFiles {
+    bool has_log = false;
+    bool has_gz = false;
+    bool has_idx = false;
+};
+
+std::map<std::string, SegmentFiles> listSegments(const std::filesystem::path& directory,
+                                                 const std::string& stem) {
+    std::map<std::string, SegmentFiles> segments;
+    std::error_code ec;
+    const std::string prefix = stem + "-";
+    for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+        const std::string name = entry.path().filename().string();
+        if (name.rfind(prefix, 0) != 0 || name.ends_with(".tmp")) continue;
+        SegmentFiles& files = segments[segmentBase(entry.path())];
+        if (name.ends_with(".log.gz")) files.has_gz = true;
+        else if (name.ends_with(".log")) files.has_log = true;
+        else if (name.ends_with(".idx")) files.has_idx = true;
+    }
+    return segments;
+}
+
+/**
+ * @brief Read a (possibly gzip-compressed) log line by line
+ */
+template <typename LineHandler>
+bool forEachLine(const std::filesystem::path& path, LineHandler&& handler) {
+    // gzopen reads uncompressed files transparently
+    gzFile in = gzopen(path.string().c_str(), "rb");
+    if (!in) return false;
+    gzbuffer(in, 128 * 1024);
+
+    std::string line;
+    char chunk[8192];
+    while (gzgets(in, chunk, sizeof(chunk))) {
+        line += chunk;
+        if (line.empty() || line.back() != '\n') continue;
+        line.pop_back();
+        handler(std::string_view(line));
+        line.clear();
+    }
+    if (!line.empty()) {
+        handler(std::string_view(line));
+    }
+    gzclose(in);
+    return true;
+}
+
+} // namespace
+
+// ============================================================================
+// Line Parsing
+// ============================================================================
+
+std::optional<AuditRecordView> parseAuditLine(std::string_view line) {
+    if (line.size() < TIMESTAMP_LENGTH + 3 || line.substr(TIMESTAMP_LENGTH, 3) != " | ") {
+        return std::nullopt;
+    }
+
+    AuditRecordView record;
+    record.timestamp = line.substr(0, TIMESTAMP_LENGTH);
+    if (line.substr(TIMESTAMP_LENGTH + 3).starts_with("AUDIT GAP")) {
+        record.is_gap = true;
+        return record;
+    }
+
+    record.ip_address = fieldAfter(line, "IP: ");
+    const std::string_view country = fieldAfter(line, "Country: ");
+    record.country_code = country.substr(0, country.find(" ("));
+    record.action = fieldAfter(line, "Action: ");
+
+    const std::string_view level = fieldAfter(line, "Level: ");
+    if (level.size() == 1 && level[0] >= '0' && level[0] <= '9') {
+        record.level = level[0] - '0';
+    }
+    return record;
+}
+
+// ============================================================================
+// Bloom Filter
+// ============================================================================
+
+void AuditBloomFilter::add(std::string_view key) noexcept {
+    const uint64_t hash = fnv1a(key);
+    const uint32_t h1 = static_cast<uint32_t>(hash);
+    const uint32_t h2 = static_cast<uint32_t>(hash >> 32) | 1;
+    for (int i = 0; i < HASHES; ++i) {
+        const size_t bit = (h1 + static_cast<uint32_t>(i) * h2) % BITS;
+        words_[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+}
+
+bool AuditBloomFilter::mayContain(std::string_view key) const noexcept {
+    const uint64_t hash = fnv1a(key);
+    const uint32_t h1 = static_cast<uint32_t>(hash);
+    const uint32_t h2 = static_cast<uint32_t>(hash >> 32) | 1;
+    for (int i = 0; i < HASHES; ++i) {
+        const size_t bit = (h1 + static_cast<uint32_t>(i) * h2) % BITS;
+        if (!(words_[bit / 64] & (uint64_t(1) << (bit % 64)))) return false;
+    }
+    return true;
+}
+
+std::string AuditBloomFilter::toHex() const {
+    static constexpr char DIGITS[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(words_.size() * 16);
+    for (uint64_t word : words_) {
+        for (int shift = 60; shift >= 0; shift -= 4) {
+            hex += DIGITS[(word >> shift) & 0xF];
+        }
+    }
+    return hex;
+}
+
+bool AuditBloomFilter::fromHex(std::string_view hex) {
+    if (hex.size() != words_.size() * 16) return false;
+    for (size_t w = 0; w < words_.size(); ++w) {
+        uint64_t word = 0;
+        for (size_t i = 0; i < 16; ++i) {
+            const char c = hex[w * 16 + i];
+            int nibble;
+            if (c >= '0' && c <= '9') nibble = c - '0';
+            else if (c >= 'a' && c <= 'f') nibble = c - 'a' + 10;
+            else return false;
+            word = (word << 4) | static_cast<uint64_t>(nibble);
+        }
+        words_[w] = word;
+    }
+    return true;
+}
+
+// ============================================================================
+// Segment Index
+// ============================================================================
+
+void AuditSegmentIndex::add(const AuditRecordView& record) {
+    ++records;
+    if (first_timestamp.empty() || record.timestamp < first_timestamp) {
+        first_timestamp = std::string(record.timestamp);
+    }
+    if (record.timestamp > last_timestamp) {
+        last_timestamp = std::string(record.timestamp);
+    }
+    if (record.is_gap) {
+        ++actions["AUDIT GAP"];
+        return;
+    }
+    ++countries[std::string(record.country_code)];
+    ++levels[record.level];
+    ++actions[std::string(record.action)];
+    ip_filter.add(record.ip_address);
+}
+
+bool AuditSegmentIndex::save(const std::filesystem::path& path) const {
+    json j;
+    j["version"] = INDEX_FORMAT_VERSION;
+    j["segment"] = segment_file;
+    j["records"] = records;
+    j["first"] = first_timestamp;
+    j["last"] = last_timestamp;
+    j["countries"] = countries;
+    json level_counts = json::object();
+    for (const auto& [level, count] : levels) {
+        level_counts[std::to_string(level)] = count;
+    }
+    j["levels"] = level_counts;
+    j["actions"] = actions;
+    j["bloom"] = {
+        {"bits", AuditBloomFilter::BITS},
+        {"hashes", AuditBloomFilter::HASHES},
+        {"data", ip_filter.toHex()}
+    };
+
+    // Write, sync, then rename so neither a reader nor a crash sees a partial index.
+    // The caller syncs the directory to make the rename itself durable
+    std::filesystem::path tmp = path;
+    tmp += ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (!out) return false;
+        out << j.dump();
+        if (!out.flush()) return false;
+    }
+    std::error_code ec;
+    if (!syncPath(tmp)) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    std::filesystem::rename(tmp, path, ec);
+    return !ec;
+}
+
+std::optional<AuditSegmentIndex> AuditSegmentIndex::load(const std::filesystem::path& path) {
+    std::ifstream in(path);
+    if (!in) return std::nullopt;
+
+    try {
+        json j = json::parse(in);
+        if (j.value("version", 0) != INDEX_FORMAT_VERSION) return std::nullopt;
+
+        AuditSegmentIndex index;
+        index.segment_file = j.at("segment").get<std::string>();
+        index.records = j.value("records", uint64_t{0});
+        index.first_timestamp = j.value("first", "");
+        index.last_timestamp = j.value("last", "");
+        index.countries = j.value("countries", std::map<std::string, uint64_t>{});
+        index.actions = j.value("actions", std::map<std::string, uint64_t>{});
+        const json level_counts = j.value("levels", json::object());
+        for (const auto& [level, count] : level_counts.items()) {
+            index.levels[std::stoi(level)] = count.get<uint64_t>();
+        }
+        const json& bloom = j.at("bloom");
+        if (bloom.value("bits", size_t{0}) != AuditBloomFilter::BITS ||
+            bloom.value("hashes", 0) != AuditBloomFilter::HASHES ||
+            !index.ip_filter.fromHex(bloom.value("data", ""))) {
+            return std::nullopt;
+        }
+        return index;
+    } catch (const std::exception& e) {
+        Logger::warning("Ignoring unreadable audit index " + path.string() + ": " + e.what());
+        return std::nullopt;
+    }
+}
+
+// ============================================================================
+// Query
+// ============================================================================
+
+bool AuditQuery::matches(const AuditRecordView& record) const {
+    if (!from.empty() && record.timestamp < std::string_view(from)) return false;
+    if (!to.empty() && record.timestamp >= std::string_view(to)) return false;
+    if (record.is_gap) {
+        // Gaps are reported unless the query filters on record fields
+        return country_code.empty() && action.empty() && !level && ip_address.empty();
+    }
+    if (!country_code.empty() && record.country_code != country_code) return false;
+    if (!action.empty() && record.action != action) return false;
+    if (level && record.level != *level) return false;
+    if (!ip_address.empty() && record.ip_address != ip_address) return false;
+    return true;
+}
+
+bool AuditQuery::mayMatch(const AuditSegmentIndex& index) const {
+    if (index.records == 0) return false;
+    // Timestamps are fixed-width, so string order is time order
+    if (!from.empty() && index.last_timestamp < from) return false;
+    if (!to.empty() && index.first_timestamp >= to) return false;
+    if (!country_code.empty() && !index.countries.contains(country_code)) return false;
+    if (!action.empty() && !index.actions.contains(action)) return false;
+    if (level && !index.levels.contains(*level)) return false;
+    if (!ip_address.empty() && !index.ip_filter.mayContain(ip_address)) return false;
+    return true;
+}
+
+AuditQueryStats queryAuditLog(const std::string& active_log_path, const AuditQuery& query,
+                              const std::function<void(std::string_view line)>& on_match) {
+    AuditQueryStats stats;
+    const std::filesystem::path active(active_log_path);
+    const std::filesystem::path directory = active.has_parent_path() ? active.parent_path() : ".";
+
+    auto scan = [&](const std::filesystem::path& file) {
+        forEachLine(file, [&](std::string_view line) {
+            ++stats.records_scanned;
+            auto record = parseAuditLine(line);
+            if (record && query.matches(*record)) {
+                ++stats.records_matched;
+                on_match(line);
+            }
+        });
+    };
+
+    // Segment names embed the rotation time, so map order is chronological
+    for (const auto& [base, files] : listSegments(directory, active.stem().string())) {
+        ++stats.segments_total;
+        if (files.has_idx) {
+            auto index = AuditSegmentIndex::load(directory / (base + ".idx"));
+            if (index) {
+                if (!query.mayMatch(*index)) {
+                    ++stats.segments_skipped;
+                    continue;
+                }
+                scan(directory / index->segment_file);
+                continue;
+            }
+        }
+        // Not sealed yet (or unreadable index): scan whatever data file exists
+        if (files.has_log) {
+            scan(directory / (base + ".log"));
+        } else if (files.has_gz) {
+            scan(directory / (base + ".log.gz"));
+        }
+    }
+
+    std::error_code ec;
+    if (std::filesystem::exists(active, ec)) {
+        ++stats.segments_total;
+        scan(active);
+    }
+    return stats;
+}
+
+// ============================================================================
+// Segment Sealer
+// ============================================================================
+
+AuditSegmentSealer::AuditSegmentSealer(const std::string& active_log_path, bool compress)
+    : active_path_(active_log_path),
+      directory_(active_path_.has_parent_path() ? active_path_.parent_path() : "."),
+      stem_(active_path_.stem().string()),
+      compress_(compress) {
+    recover();
+    thread_ = std::thread(&AuditSegmentSealer::run, this);
+}
+
+AuditSegmentSealer::~AuditSegmentSealer() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool AuditSegmentSealer::rotate() {
+    const std::time_t now = std::time(nullptr);
+    std::tm local_time{};
+#ifdef _WIN32
+    localtime_s(&local_time, &now);
+#else
+    localtime_r(&now, &local_time);
+#endif
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &local_time);
+
+    std::error_code ec;
+    std::filesystem::path segment;
+    do {
+        char name[64];
+        std::snprintf(name, sizeof(name), "-%s-%04llu.log", stamp,
+                      static_cast<unsigned long long>(++sequence_));
+        segment = directory_ / (stem_ + name);
+    } while (std::filesystem::exists(segment, ec));
+
+    std::filesystem::rename(active_path_, segment, ec);
+    if (ec) {
+        Logger::error("Failed to rotate audit log " + active_path_.string() + ": " + ec.message());
+        return false;
+    }
+
+    {
+        std::lock_guard lock(mutex_);
+        queue_.push_back(segment);
+    }
+    cv_.notify_one();
+    return true;
+}
+
+void AuditSegmentSealer::recover() {
+    for (const auto& [base, files] : listSegments(directory_, stem_)) {
+        std::error_code ec;
+        if (files.has_idx && files.has_gz && files.has_log) {
+            // Crashed after sealing but before removing the plain copy
+            std::filesystem::remove(directory_ / (base + ".log"), ec);
+        } else if (files.has_log && !files.has_idx) {
+            queue_.push_back(directory_ / (base + ".log"));
+        }
+    }
+    if (!queue_.empty()) {
+        Logger::info("Sealing " + std::to_string(queue_.size()) + " unsealed audit log segment(s)");
+    }
+}
+
+void AuditSegmentSealer::run() {
+    for (;;) {
+        std::filesystem::path segment;
+        {
+            std::unique_lock lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (stopping_ || queue_.empty()) return;
+            segment = queue_.front();
+            queue_.erase(queue_.begin());
+        }
+        if (!seal(segment)) {
+            Logger::error("Failed to seal audit log segment " + segment.string() +
+                          " - it will be retried on next start");
+        }
+    }
+}
+
+bool AuditSegmentSealer::seal(const std::filesystem::path& segment) {
+    const std::string base = segmentBase(segment);
+    AuditSegmentIndex index;
+    std::error_code ec;
+
+    if (!compress_) {
+        index.segment_file = segment.filename().string();
+        if (!forEachLine(segment, [&](std::string_view line) {
+                if (auto record = parseAuditLine(line)) index.add(*record);
+            })) {
+            return false;
+        }
+        return index.save(directory_ / (base + ".idx")) && syncPath(directory_, true);
+    }
+
+    const std::filesystem::path compressed = directory_ / (base + ".log.gz");
+    std::filesystem::path tmp = compressed;
+    tmp += ".tmp";
+
+    gzFile out = gzopen(tmp.string().c_str(), "wb6");
+    if (!out) return false;
+
+    bool written = true;
+    const bool read = forEachLine(segment, [&](std::string_view line) {
+        if (auto record = parseAuditLine(line)) index.add(*record);
+        if (gzwrite(out, line.data(), static_cast<unsigned>(line.size())) != static_cast<int>(line.size()) ||
+            gzputc(out, '\n') != '\n') {
+            written = false;
+        }
+    });
+    if (gzclose(out) != Z_OK || !read || !written || !syncPath(tmp)) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+
+    // Sealed once the index exists. Both renames must reach the disk before
+    // the plain copy goes, or a crash could leave neither form of the segment
+    std::filesystem::rename(tmp, compressed, ec);
+    if (ec) return false;
+    index.segment_file = compressed.filename().string();
+    if (!index.save(directory_ / (base + ".idx"))) return false;
+    if (!syncPath(directory_, true)) return false;
+    std::filesystem::remove(segment, ec);
+    return true;
+}
+
+} // namespace SpectreMap::Compliance
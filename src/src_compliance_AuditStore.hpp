@@ -0,0 +1,168 @@
+/**
+ * @file AuditStore.hpp
+ * @brief Segmented, compressed and indexed storage for the compliance audit trail
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * The audit writer appends to the active log (logs/compliance_audit.log) and
+ * rotates it by size and age into segments named
+ * `<stem>-YYYYMMDD-HHMMSS-<seq>.log`. A background sealer gzip-compresses
+ * each segment and writes a `<segment>.idx` sidecar with its time range,
+ * per-country/level/action counts and an IP bloom filter. A segment is
+ * sealed once its .idx exists; unsealed segments left by a crash are sealed
+ * on the next start.
+ *
+ * queryAuditLog() uses the sidecars to skip segments that cannot match and
+ * streams only the remaining records.
+ */
+
+#ifndef SPECTREMAP_AUDITSTORE_HPP
+#define SPECTREMAP_AUDITSTORE_HPP
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace SpectreMap::Compliance {
+
+/**
+ * @brief Fields of one audit log line (views into the line)
+ */
+struct AuditRecordView {
+    std::string_view timestamp;     ///< "YYYY-MM-DD HH:MM:SS" (local time)
+    std::string_view ip_address;
+    std::string_view country_code;
+    std::string_view action;
+    int level = -1;
+    bool is_gap = false;            ///< "AUDIT GAP" marker rather than an access record
+};
+
+/**
+ * @brief Parse a pipe-delimited audit line as written by AuditLogWriter
+ */
+std::optional<AuditRecordView> parseAuditLine(std::string_view line);
+
+/**
+ * @brief Fixed-size IP bloom filter stored in segment sidecars
+ */
+class AuditBloomFilter {
+public:
+    static constexpr size_t BITS = 65536;
+    static constexpr int HASHES = 4;
+
+    void add(std::string_view key) noexcept;
+    bool mayContain(std::string_view key) const noexcept;
+
+    std::string toHex() const;
+    bool fromHex(std::string_view hex);
+
+private:
+    std::array<uint64_t, BITS / 64> words_{};
+};
+
+/**
+ * @brief Summary of one sealed segment
+ */
+struct AuditSegmentIndex {
+    std::string segment_file;       ///< Data file name (relative to the log directory)
+    uint64_t records = 0;
+    std::string first_timestamp;
+    std::string last_timestamp;
+    std::map<std::string, uint64_t> countries;
+    std::map<int, uint64_t> levels;
+    std::map<std::string, uint64_t> actions;
+    AuditBloomFilter ip_filter;
+
+    void add(const AuditRecordView& record);
+
+    bool save(const std::filesystem::path& path) const;
+    static std::optional<AuditSegmentIndex> load(const std::filesystem::path& path);
+};
+
+/**
+ * @brief Audit query; empty fields match everything
+ */
+struct AuditQuery {
+    std::string from;           ///< Inclusive lower bound, "YYYY-MM-DD[ HH:MM:SS]"
+    std::string to;             ///< Exclusive upper bound, same format
+    std::string country_code;
+    std::string action;         ///< e.g. "BLOCKED"
+    std::optional<int> level;   ///< RestrictionLevel as int
+    std::string ip_address;
+
+    bool matches(const AuditRecordView& record) const;
+    bool mayMatch(const AuditSegmentIndex& index) const;
+};
+
+/**
+ * @brief Work done by a query
+ */
+struct AuditQueryStats {
+    uint64_t segments_total = 0;
+    uint64_t segments_skipped = 0;  ///< Ruled out by their sidecar index
+    uint64_t records_scanned = 0;
+    uint64_t records_matched = 0;
+};
+
+/**
+ * @brief Stream matching records from all segments and the active log, oldest first
+ * @param active_log_path Active audit log (segments live beside it)
+ * @param on_match Receives each matching line (without newline)
+ */
+AuditQueryStats queryAuditLog(const std::string& active_log_path, const AuditQuery& query,
+                              const std::function<void(std::string_view line)>& on_match);
+
+/**
+ * @brief Background thread that compresses and indexes rotated segments
+ */
+class AuditSegmentSealer {
+public:
+    /**
+     * @param active_log_path Active audit log; its stem names the segments
+     * @param compress gzip sealed segments (otherwise they are only indexed)
+     */
+    AuditSegmentSealer(const std::string& active_log_path, bool compress);
+
+    /**
+     * @brief Finishes the segment in progress; the rest are sealed on next start
+     */
+    ~AuditSegmentSealer();
+
+    AuditSegmentSealer(const AuditSegmentSealer&) = delete;
+    AuditSegmentSealer& operator=(const AuditSegmentSealer&) = delete;
+
+    /**
+     * @brief Rename the closed active log into a new segment and queue it for sealing
+     * @return False if the rename failed (the active log is left in place)
+     */
+    bool rotate();
+
+private:
+    void run();
+    void recover();
+    bool seal(const std::filesystem::path& segment);
+
+    std::filesystem::path active_path_;
+    std::filesystem::path directory_;
+    std::string stem_;
+    bool compress_;
+    uint64_t sequence_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::filesystem::path> queue_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_AUDITSTORE_HPP
@@ -0,0 +1,102 @@
+/**
+ * @file ComplianceGate.cpp
+ * @brief Implementation of the startup compliance gate
+ */
+
+#include "ComplianceGate.hpp"
+#include "../core/Logger.hpp"
+#include <exception>
+
+namespace SpectreMap::Compliance {
+
+ComplianceGate::ComplianceGate(GeoRestriction& geo, AddressSource address_source,
+                               std::chrono::milliseconds deadline)
+    : geo_(geo), started_(Clock::now()), deadline_(started_ + deadline) {
+    thread_ = std::thread(&ComplianceGate::run, this, std::move(address_source));
+}
+
+ComplianceGate::~ComplianceGate() {
+    stop_.request_stop();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void ComplianceGate::run(AddressSource address_source) {
+    std::string address;
+    try {
+        address = address_source();
+    } catch (const std::exception& e) {
+        Logger::error("Compliance address detection threw: " + std::string(e.what()));
+    }
+
+    if (address.empty()) {
+        std::lock_guard lock(mutex_);
+        resolveLocked(denied("Unable to determine public IP address - access denied for compliance"));
+        return;
+    }
+    {
+        std::lock_guard lock(mutex_);
+        address_ = address;
+        if (result_) return;   // Deadline passed while detecting
+    }
+
+    // The reactor resolves the check fail-closed at the deadline or on stop
+    const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline_ - Clock::now());
+    if (remaining <= std::chrono::milliseconds::zero()) return;   // wait() resolves it
+    RestrictionResult result = geo_.checkAccessAsync(address, remaining, stop_.get_token()).get();
+
+    std::lock_guard lock(mutex_);
+    resolveLocked(std::move(result));
+}
+
+const RestrictionResult& ComplianceGate::wait() {
+    std::unique_lock lock(mutex_);
+    if (!resolved_cv_.wait_until(lock, deadline_, [this] { return result_.has_value(); })) {
+        const auto budget = std::chrono::duration_cast<std::chrono::milliseconds>(deadline_ - started_);
+        resolveLocked(denied("Export compliance check did not complete within " +
+                             std::to_string(budget.count()) + "ms - access denied for compliance"));
+        stop_.request_stop();
+    }
+    return *result_;
+}
+
+bool ComplianceGate::resolved() const {
+    std::lock_guard lock(mutex_);
+    return result_.has_value();
+}
+
+std::string ComplianceGate::address() const {
+    std::lock_guard lock(mutex_);
+    return address_;
+}
+
+std::chrono::milliseconds ComplianceGate::resolvedAfter() const {
+    std::lock_guard lock(mutex_);
+    if (!result_) return std::chrono::milliseconds::zero();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(resolved_at_ - started_);
+}
+
+void ComplianceGate::resolveLocked(RestrictionResult result) {
+    if (result_) return;
+    result_ = std::move(result);
+    resolved_at_ = Clock::now();
+    Logger::info("Export compliance gate resolved in " +
+                 std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(resolved_at_ - started_).count()) +
+                 "ms: " + (result_->allowed ? "ALLOWED" : "DENIED") + " (" + result_->country_code + ")");
+    resolved_cv_.notify_all();
+}
+
+RestrictionResult ComplianceGate::denied(std::string reason) {
+    Logger::warning(reason);
+    return RestrictionResult{
+        .allowed = false,
+        .level = RestrictionLevel::RESTRICTED,
+        .country_code = "UNKNOWN",
+        .country_name = "Unknown",
+        .reason = std::move(reason),
+        .applicable_regulations = {"US EAR", "OFAC"}
+    };
+}
+
+} // namespace SpectreMap::Compliance
@@ -0,0 +1,111 @@
+/**
+ * @file ComplianceGate.hpp
+ * @brief Startup export compliance check that runs alongside initialization
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * The startup check needs the caller's public address and a GeoIP lookup,
+ * which is one or two network round trips. The gate starts both on its own
+ * thread as soon as it is constructed, so the rest of startup proceeds in
+ * parallel; every operational feature then calls wait() (or allowed())
+ * before doing anything. A check that has not finished by the deadline is
+ * resolved as denied, as is one whose address cannot be determined.
+ */
+
+#ifndef SPECTREMAP_COMPLIANCEGATE_HPP
+#define SPECTREMAP_COMPLIANCEGATE_HPP
+
+#include "GeoRestriction.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <thread>
+
+namespace SpectreMap::Compliance {
+
+/**
+ * @brief One-shot access decision shared by everything that starts up
+ */
+class ComplianceGate {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Returns the address to check (empty if it can't be determined)
+     *
+     * Runs on the gate's thread and may block; anything else that has to
+     * happen before the check (e.g. loading the sanctions list) belongs here.
+     */
+    using AddressSource = std::function<std::string()>;
+
+    /**
+     * @brief Start the check
+     * @param geo Must outlive the gate
+     * @param deadline Time from construction after which the gate resolves as denied
+     */
+    ComplianceGate(GeoRestriction& geo, AddressSource address_source, std::chrono::milliseconds deadline);
+
+    /**
+     * @brief Cancels a pending lookup; waits for a running address source to return
+     */
+    ~ComplianceGate();
+
+    ComplianceGate(const ComplianceGate&) = delete;
+    ComplianceGate& operator=(const ComplianceGate&) = delete;
+
+    /**
+     * @brief Block until the check resolves or the deadline passes
+     * @return The decision; stays valid for the gate's lifetime
+     */
+    const RestrictionResult& wait();
+
+    /**
+     * @brief wait().allowed
+     */
+    bool allowed() { return wait().allowed; }
+
+    /**
+     * @brief Whether the decision is already known (never blocks)
+     */
+    bool resolved() const;
+
+    /**
+     * @brief Address that was checked (empty until the address source returns)
+     */
+    std::string address() const;
+
+    /**
+     * @brief Time from construction until the gate resolved (zero while pending)
+     */
+    std::chrono::milliseconds resolvedAfter() const;
+
+private:
+    void run(AddressSource address_source);
+
+    /**
+     * @brief Record the decision unless one was recorded already (caller holds the mutex)
+     */
+    void resolveLocked(RestrictionResult result);
+
+    static RestrictionResult denied(std::string reason);
+
+    GeoRestriction& geo_;
+    const Clock::time_point started_;
+    const Clock::time_point deadline_;
+    std::stop_source stop_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable resolved_cv_;
+    std::optional<RestrictionResult> result_;
+    std::string address_;
+    Clock::time_point resolved_at_{};
+
+    std::thread thread_;   // Declared last: started once the members above exist
+};
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_COMPLIANCEGATE_HPP
@@ -0,0 +1,295 @@
+/**
+ * @file ComplianceLog.cpp
+ * @brief Implementation of access check event formatting and repeat aggregation
+ */
+
+#include "ComplianceLog.hpp"
+#include "CountryDatabase.hpp"
+#include "SanctionsPolicy.hpp"
+#include "../core/Logger.hpp"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace SpectreMap::Compliance {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// A window packs one event and country's current interval into a word:
+// suppressed count in bits 0-31, full lines in 32-43, interval number in 44-63
+constexpr uint64_t SUPPRESSED_MASK = 0xFFFF'FFFFull;
+constexpr int LINES_SHIFT = 32;
+constexpr uint64_t LINES_MASK = 0xFFFull;
+constexpr int INTERVAL_SHIFT = 44;
+constexpr uint64_t INTERVAL_MASK = 0xF'FFFFull;
+constexpr uint32_t MAX_LINES_PER_INTERVAL = static_cast<uint32_t>(LINES_MASK);
+
+constexpr size_t WINDOW_COUNT = COMPLIANCE_EVENT_COUNT * CountryTable::KEY_SPACE;
+
+inline uint64_t suppressedOf(uint64_t window) noexcept { return window & SUPPRESSED_MASK; }
+inline uint64_t linesOf(uint64_t window) noexcept { return (window >> LINES_SHIFT) & LINES_MASK; }
+inline uint64_t intervalOf(uint64_t window) noexcept { return window >> INTERVAL_SHIFT; }
+
+inline uint64_t packWindow(uint64_t interval, uint64_t lines, uint64_t suppressed) noexcept {
+    return interval << INTERVAL_SHIFT | lines << LINES_SHIFT | suppressed;
+}
+
+inline int64_t nowNs() noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+struct State {
+    std::mutex config_mutex;   ///< configure() and config() only
+    ComplianceLogConfig config;
+
+    // What write() reads; intervals are numbered from interval_origin
+    std::atomic<int64_t> interval_ns{std::chrono::nanoseconds(ComplianceLogConfig{}.summary_interval).count()};
+    std::atomic<uint32_t> lines_per_interval{ComplianceLogConfig{}.lines_per_interval};
+    std::atomic<int64_t> interval_origin{nowNs()};
+    std::atomic<int64_t> next_sweep{0};
+
+    /// Indexed by event, then CountryTable::packCode key (0 when the code is not 2-3 letters A-Z)
+    std::unique_ptr<std::atomic<uint64_t>[]> windows = std::make_unique<std::atomic<uint64_t>[]>(WINDOW_COUNT);
+
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> suppressed{0};
+    std::atomic<uint64_t> summaries{0};
+};
+
+State& state() {
+    // Never destroyed: checks may log during or after static destruction
+    static State* instance = new State();
+    return *instance;
+}
+
+void emit(ComplianceLogLevel level, const std::string& line) {
+    switch (level) {
+        case ComplianceLogLevel::VERBOSE: Logger::debug(line); break;
+        case ComplianceLogLevel::INFO:    Logger::info(line); break;
+        case ComplianceLogLevel::WARNING: Logger::warning(line); break;
+        case ComplianceLogLevel::SEVERE:  Logger::error(line); break;
+        case ComplianceLogLevel::OFF:     break;
+    }
+}
+
+/**
+ * @brief Client address for a log line; caller-supplied text is truncated and control characters replaced
+ */
+std::string addressText(const ComplianceLogRecord& record) {
+    if (record.address) {
+        return record.address->toString();
+    }
+    std::string shown(record.ip.substr(0, 64));
+    for (char& c : shown) {
+        if (static_cast<unsigned char>(c) < 0x20 || c == 0x7F) c = '?';
+    }
+    return shown;
+}
+
+std::string format(ComplianceEvent event, const ComplianceLogRecord& record) {
+    std::string line;
+    switch (event) {
+        case ComplianceEvent::SANCTIONED_COUNTRY:
+            line = "BLOCKED: Access attempt from OFAC sanctioned country: ";
+            line += record.country_name;
+            break;
+        case ComplianceEvent::SECTORAL_COUNTRY:
+            line = "BLOCKED: Access attempt from partially sanctioned country: ";
+            line += record.country_name;
+            break;
+        case ComplianceEvent::EMBARGOED_COUNTRY:
+            line = "BLOCKED: Access attempt from arms embargo country: ";
+            line += record.country_name;
+            break;
+        case ComplianceEvent::HIGH_RISK_COUNTRY:
+            line = "HIGH RISK: Access from ";
+            line += record.country_name;
+            line += " - monitoring required";
+            break;
+        case ComplianceEvent::ACCESS_BLOCKED:
+        case ComplianceEvent::ACCESS_MONITORED:
+            line = event == ComplianceEvent::ACCESS_BLOCKED ? "COMPLIANCE BLOCK: IP: " : "COMPLIANCE MONITOR: IP: ";
+            line += addressText(record);
+            line += " | Country: ";
+            line += record.country_code;
+            line += " (";
+            line += record.country_name;
+            line += ") | Action: ";
+            line += record.action;
+            line += " | Reason: ";
+            line += record.reason;
+            break;
+        case ComplianceEvent::ANONYMIZER_BLOCKED:
+            line = "Blocking VPN/Proxy/Tor access from " + addressText(record);
+            break;
+        case ComplianceEvent::LOCATION_UNKNOWN:
+            line = "Failed to determine geolocation for " + addressText(record) + " - BLOCKING";
+            break;
+        case ComplianceEvent::MALFORMED_ADDRESS:
+            line = "Rejected malformed IP address \"" + addressText(record) + "\" - BLOCKING";
+            break;
+        case ComplianceEvent::OFFLINE_MISS:
+            line = "Offline GeoIP lookup found no country for " + addressText(record);
+            break;
+        case ComplianceEvent::COUNT:
+            break;
+    }
+    return line;
+}
+
+std::string codeOf(uint32_t key) {
+    std::string code;
+    for (uint32_t place : {729u, 27u, 1u}) {
+        const uint32_t digit = key / place % 27;
+        if (digit != 0) code += static_cast<char>('A' + digit - 1);
+    }
+    return code;
+}
+
+void writeSummary(State& s, size_t window, uint64_t suppressed, Clock::duration elapsed) {
+    const auto event = static_cast<ComplianceEvent>(window / CountryTable::KEY_SPACE);
+    const auto key = static_cast<uint32_t>(window % CountryTable::KEY_SPACE);
+    std::string line = "COMPLIANCE SUMMARY: ";
+    line += ComplianceLog::eventName(event);
+    if (key != 0) {
+        const std::string code = codeOf(key);
+        line += " from " + code;
+        if (const CountryRecord* record = SanctionsPolicy::current().find(code)) {
+            line += " (" + std::string(record->name) + ")";
+        }
+    }
+    line += " repeated " + std::to_string(suppressed) + " more times in " +
+            std::to_string(std::chrono::duration_cast<std::chrono::seconds>(elapsed).count()) +
+            "s (not logged individually)";
+    emit(ComplianceLog::levelOf(event), line);
+    s.summaries.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Summarize every window whose interval is over (every window if flushing)
+ *
+ * Takes each count with a CAS, so a write racing the sweep either lands in
+ * this summary or in the next one.
+ */
+void sweep(State& s, int64_t now, bool all) {
+    const int64_t interval = s.interval_ns.load(std::memory_order_relaxed);
+    const int64_t since = now - s.interval_origin.load(std::memory_order_relaxed);
+    const uint64_t current = interval > 0 ? static_cast<uint64_t>(since / interval) & INTERVAL_MASK : 0;
+    for (size_t i = 0; i < WINDOW_COUNT; ++i) {
+        std::atomic<uint64_t>& window = s.windows[i];
+        uint64_t seen = window.load(std::memory_order_relaxed);
+        while (suppressedOf(seen) > 0 && (all || intervalOf(seen) != current)) {
+            if (window.compare_exchange_weak(seen, seen & ~SUPPRESSED_MASK, std::memory_order_relaxed)) {
+                const bool ended = intervalOf(seen) != current || interval <= 0;
+                writeSummary(s, i, suppressedOf(seen),
+                             std::chrono::nanoseconds(ended ? interval : since % interval));
+                break;
+            }
+        }
+    }
+}
+
+} // namespace
+
+void ComplianceLog::write(ComplianceEvent event, const ComplianceLogRecord& record) {
+    State& s = state();
+    bool suppress = false;
+    const int64_t interval = aggregated(event) ? s.interval_ns.load(std::memory_order_relaxed) : 0;
+    if (interval > 0) {
+        const int64_t now = nowNs();
+        const uint64_t current =
+            static_cast<uint64_t>((now - s.interval_origin.load(std::memory_order_relaxed)) / interval) &
+            INTERVAL_MASK;
+        const uint32_t limit = s.lines_per_interval.load(std::memory_order_relaxed);
+        const size_t index = static_cast<size_t>(event) * CountryTable::KEY_SPACE +
+                             CountryTable::packCode(record.country_code);
+        std::atomic<uint64_t>& window = s.windows[index];
+
+        uint64_t seen = window.load(std::memory_order_relaxed);
+        uint64_t next;
+        do {
+            if (intervalOf(seen) != current) {
+                suppress = limit == 0;
+                next = suppress ? packWindow(current, 0, 1) : packWindow(current, 1, 0);
+            } else if (linesOf(seen) < limit) {
+                suppress = false;
+                next = seen + (uint64_t{1} << LINES_SHIFT);
+            } else {
+                suppress = true;
+                // Saturated counts stay put; stats() still sees every event
+                next = suppressedOf(seen) < SUPPRESSED_MASK ? seen + 1 : seen;
+            }
+        } while (!window.compare_exchange_weak(seen, next, std::memory_order_relaxed));
+
+        if (intervalOf(seen) != current && suppressedOf(seen) > 0) {
+            // This event ended the window's interval, so it writes its summary
+            writeSummary(s, index, suppressedOf(seen), std::chrono::nanoseconds(interval));
+        }
+
+        // One writer per interval also summarizes windows nobody has logged to since
+        int64_t due = s.next_sweep.load(std::memory_order_relaxed);
+        if (now >= due && s.next_sweep.compare_exchange_strong(due, now + interval, std::memory_order_relaxed)) {
+            sweep(s, now, false);
+        }
+    }
+
+    if (suppress) {
+        s.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    emit(levelOf(event), format(event, record));
+    s.written.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ComplianceLog::configure(const ComplianceLogConfig& config) {
+    State& s = state();
+    std::lock_guard lock(s.config_mutex);
+    // Intervals counted under the old settings end now
+    const int64_t now = nowNs();
+    sweep(s, now, true);
+    s.config = config;
+    s.config.lines_per_interval = std::min(config.lines_per_interval, MAX_LINES_PER_INTERVAL);
+    const int64_t interval = std::chrono::nanoseconds(config.summary_interval).count();
+    s.interval_ns.store(interval, std::memory_order_relaxed);
+    s.lines_per_interval.store(s.config.lines_per_interval, std::memory_order_relaxed);
+    s.interval_origin.store(now, std::memory_order_relaxed);
+    s.next_sweep.store(now + interval, std::memory_order_relaxed);
+    for (size_t i = 0; i < WINDOW_COUNT; ++i) {
+        s.windows[i].store(0, std::memory_order_relaxed);
+    }
+    runtime_level_.store(config.level, std::memory_order_relaxed);
+}
+
+ComplianceLogConfig ComplianceLog::config() {
+    State& s = state();
+    std::lock_guard lock(s.config_mutex);
+    return s.config;
+}
+
+void ComplianceLog::flush() {
+    sweep(state(), nowNs(), true);
+}
+
+ComplianceLogStats ComplianceLog::stats() noexcept {
+    State& s = state();
+    return ComplianceLogStats{
+        .written = s.written.load(std::memory_order_relaxed),
+        .suppressed = s.suppressed.load(std::memory_order_relaxed),
+        .summaries = s.summaries.load(std::memory_order_relaxed)
+    };
+}
+
+const char* ComplianceLog::eventName(ComplianceEvent event) noexcept {
+    static constexpr const char* NAMES[COMPLIANCE_EVENT_COUNT] = {
+        "sanctioned_country", "sectoral_country", "embargoed_country", "high_risk_country",
+        "access_blocked", "access_monitored", "anonymizer_blocked", "location_unknown",
+        "malformed_address", "offline_miss"
+    };
+    const auto index = static_cast<size_t>(event);
+    return index < COMPLIANCE_EVENT_COUNT ? NAMES[index] : "unknown";
+}
+
+} // namespace SpectreMap::Compliance
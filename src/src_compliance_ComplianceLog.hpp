@@ -0,0 +1,164 @@
+/**
+ * @file ComplianceLog.hpp
+ * @brief Structured, level-gated logging for access check events
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * Access checks log through typed events instead of building message
+ * strings: the caller passes views of the country code, name, address and
+ * reason, and nothing is formatted unless the event's level is enabled.
+ * Levels below SPECTREMAP_COMPLIANCE_LOG_LEVEL are compiled out; above it,
+ * a disabled level costs one relaxed load and a branch.
+ *
+ * Block events repeat for as long as a blocked client retries. Each event
+ * and country gets lines_per_interval full lines per summary_interval; the
+ * rest are counted, and one summary line reports the count when the
+ * interval ends. Summaries are written by the next logged event after the
+ * interval, or by flush(). The counts live in a fixed table indexed by
+ * event and packed country code, one atomic word per entry, so counting a
+ * repeat takes no lock and allocates nothing.
+ *
+ * The log is process-wide and shared by every GeoRestriction instance.
+ * Lines are written through Logger.
+ */
+
+#ifndef SPECTREMAP_COMPLIANCELOG_HPP
+#define SPECTREMAP_COMPLIANCELOG_HPP
+
+#include "GeoRestriction.hpp"
+#include "IpAddress.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+/// Lowest level compiled in: 0 verbose, 1 info, 2 warning, 3 severe, 4 none
+#ifndef SPECTREMAP_COMPLIANCE_LOG_LEVEL
+#define SPECTREMAP_COMPLIANCE_LOG_LEVEL 0
+#endif
+
+namespace SpectreMap::Compliance {
+
+/**
+ * @brief Log level (named to stay clear of DEBUG/ERROR macros)
+ */
+enum class ComplianceLogLevel : uint8_t {
+    VERBOSE,   ///< Logger::debug
+    INFO,      ///< Logger::info
+    WARNING,   ///< Logger::warning
+    SEVERE,    ///< Logger::error
+    OFF
+};
+
+/**
+ * @brief What happened; each event has a fixed level (see levelOf)
+ */
+enum class ComplianceEvent : uint8_t {
+    SANCTIONED_COUNTRY,   ///< checkCountry: OFAC comprehensive sanctions
+    SECTORAL_COUNTRY,     ///< checkCountry: OFAC sectoral sanctions
+    EMBARGOED_COUNTRY,    ///< checkCountry: arms embargo
+    HIGH_RISK_COUNTRY,    ///< checkCountry: allowed, monitoring required
+    ACCESS_BLOCKED,       ///< logAccessAttempt mirror of a block
+    ACCESS_MONITORED,     ///< logAccessAttempt mirror of high-risk access
+    ANONYMIZER_BLOCKED,   ///< VPN/proxy/Tor blocked in strict mode
+    LOCATION_UNKNOWN,     ///< No geolocation; blocked
+    MALFORMED_ADDRESS,    ///< Input was not an IP address; blocked
+    OFFLINE_MISS,         ///< Offline database had no country for the address
+    COUNT
+};
+
+constexpr size_t COMPLIANCE_EVENT_COUNT = static_cast<size_t>(ComplianceEvent::COUNT);
+
+/**
+ * @brief Fields of one event; views must stay valid for the call only
+ */
+struct ComplianceLogRecord {
+    std::string_view country_code{};
+    std::string_view country_name{};
+    RestrictionLevel level = RestrictionLevel::ALLOWED;
+    const IpAddress* address = nullptr;   ///< Parsed client address, if any
+    std::string_view ip{};                ///< Client address as given, when address is null
+    std::string_view action{};
+    std::string_view reason{};
+};
+
+/**
+ * @brief Runtime settings
+ */
+struct ComplianceLogConfig {
+    ComplianceLogLevel level = ComplianceLogLevel::INFO;   ///< Lowest level written
+    std::chrono::seconds summary_interval{60};             ///< 0 writes every repeated event
+    uint32_t lines_per_interval = 10;                      ///< Full lines per event and country per interval (max 4095)
+};
+
+/**
+ * @brief Line counts since startup
+ */
+struct ComplianceLogStats {
+    uint64_t written = 0;      ///< Event lines written in full
+    uint64_t suppressed = 0;   ///< Repeated events counted instead of written
+    uint64_t summaries = 0;    ///< Summary lines written
+};
+
+/**
+ * @brief Process-wide access check event log
+ */
+class ComplianceLog {
+public:
+    static constexpr ComplianceLogLevel COMPILED_LEVEL =
+        static_cast<ComplianceLogLevel>(SPECTREMAP_COMPLIANCE_LOG_LEVEL);
+
+    static constexpr ComplianceLogLevel levelOf(ComplianceEvent event) noexcept {
+        switch (event) {
+            case ComplianceEvent::HIGH_RISK_COUNTRY:
+            case ComplianceEvent::ACCESS_MONITORED:
+                return ComplianceLogLevel::INFO;
+            default:
+                return ComplianceLogLevel::WARNING;
+        }
+    }
+
+    /**
+     * @brief Repeats of warning events (the blocks) are aggregated
+     */
+    static constexpr bool aggregated(ComplianceEvent event) noexcept {
+        return levelOf(event) >= ComplianceLogLevel::WARNING;
+    }
+
+    static bool enabled(ComplianceLogLevel level) noexcept {
+        return level >= COMPILED_LEVEL && level >= runtime_level_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Log an event; formats nothing when its level is disabled
+     */
+    template <ComplianceEvent Event>
+    static void log(const ComplianceLogRecord& record) {
+        constexpr ComplianceLogLevel level = levelOf(Event);
+        if constexpr (level >= COMPILED_LEVEL && level != ComplianceLogLevel::OFF) {
+            if (level >= runtime_level_.load(std::memory_order_relaxed)) {
+                write(Event, record);
+            }
+        }
+    }
+
+    static void configure(const ComplianceLogConfig& config);
+    static ComplianceLogConfig config();
+
+    /**
+     * @brief Write summaries for every interval with suppressed events, ended or not
+     */
+    static void flush();
+
+    static ComplianceLogStats stats() noexcept;
+
+    static const char* eventName(ComplianceEvent event) noexcept;
+
+private:
+    static void write(ComplianceEvent event, const ComplianceLogRecord& record);
+
+    static inline std::atomic<ComplianceLogLevel> runtime_level_{ComplianceLogLevel::INFO};
+};
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_COMPLIANCELOG_HPP
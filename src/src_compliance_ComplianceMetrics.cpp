@@ -0,0 +1,273 @@
+/**
+ * @file ComplianceMetrics.cpp
+ * @brief Implementation of per-thread access check metrics and Prometheus rendering
+ */
+
+#include "ComplianceMetrics.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+namespace SpectreMap::Compliance {
+
+namespace {
+
+using Counter = std::atomic<uint64_t>;
+
+/**
+ * @brief One thread's metrics; only the owning thread writes
+ */
+struct Shard {
+    std::array<std::array<Counter, LatencyBuckets::COUNT>, CHECK_STAGE_COUNT> buckets{};
+    std::array<Counter, CHECK_STAGE_COUNT> sums_ns{};
+    std::array<Counter, RESTRICTION_LEVEL_COUNT> decisions{};
+    std::array<Counter, LOOKUP_FAILURE_COUNT> failures{};
+    Counter anonymizer_blocks{0};
+
+    void addTo(MetricsSnapshot& out) const {
+        for (size_t stage = 0; stage < CHECK_STAGE_COUNT; ++stage) {
+            for (size_t i = 0; i < LatencyBuckets::COUNT; ++i) {
+                out.stages[stage].buckets[i] += buckets[stage][i].load(std::memory_order_relaxed);
+            }
+            out.stages[stage].sum_ns += sums_ns[stage].load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < RESTRICTION_LEVEL_COUNT; ++i) {
+            out.decisions[i] += decisions[i].load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < LOOKUP_FAILURE_COUNT; ++i) {
+            out.failures[i] += failures[i].load(std::memory_order_relaxed);
+        }
+        out.anonymizer_blocks += anonymizer_blocks.load(std::memory_order_relaxed);
+    }
+};
+
+// Single writer, so a plain load/store pair replaces a locked increment
+inline void bump(Counter& counter, uint64_t amount = 1) noexcept {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<Shard*> live;
+    MetricsSnapshot retired;   ///< Totals of threads that have exited
+};
+
+Registry& registry() {
+    // Never destroyed: threads may exit during or after static destruction
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+struct ShardOwner {
+    Shard* shard;
+
+    ShardOwner() : shard(new Shard()) {
+        Registry& r = registry();
+        std::lock_guard lock(r.mutex);
+        r.live.push_back(shard);
+    }
+
+    ~ShardOwner() {
+        Registry& r = registry();
+        std::lock_guard lock(r.mutex);
+        shard->addTo(r.retired);
+        std::erase(r.live, shard);
+        delete shard;
+    }
+};
+
+Shard& localShard() {
+    thread_local ShardOwner owner;
+    return *owner.shard;
+}
+
+// Prometheus histogram bounds in seconds (1 us .. 10 s)
+constexpr std::array<double, 21> PROMETHEUS_BOUNDS = {
+    1e-6, 5e-6, 1e-5, 2.5e-5, 5e-5, 1e-4, 2.5e-4, 5e-4, 1e-3, 2.5e-3, 5e-3,
+    0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0
+};
+
+constexpr std::array<double, 3> PROMETHEUS_QUANTILES = {0.5, 0.99, 0.999};
+
+constexpr std::array<const char*, RESTRICTION_LEVEL_COUNT> LEVEL_NAMES = {
+    "allowed", "high_risk", "restricted", "comprehensively_sanctioned"
+};
+
+std::string formatDouble(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    return buffer;
+}
+
+void appendHeader(std::string& out, const char* name, const char* type, const char* help) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+} // namespace
+
+// ============================================================================
+// Histogram Queries
+// ============================================================================
+
+uint64_t LatencyHistogram::quantile(double q) const noexcept {
+    if (count == 0) return 0;
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(q * static_cast<double>(count) + 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            const uint64_t lower = LatencyBuckets::lowerBound(i);
+            return lower + (LatencyBuckets::upperBound(i) - lower) / 2;
+        }
+    }
+    return LatencyBuckets::lowerBound(buckets.size() - 1);
+}
+
+uint64_t LatencyHistogram::countAtOrBelow(uint64_t ns) const noexcept {
+    uint64_t total = 0;
+    for (size_t i = 0; i < buckets.size() && LatencyBuckets::upperBound(i) <= ns + 1; ++i) {
+        total += buckets[i];
+    }
+    return total;
+}
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+void ComplianceMetrics::recordStage(CheckStage stage, std::chrono::nanoseconds elapsed) noexcept {
+    const uint64_t ns = elapsed.count() > 0 ? static_cast<uint64_t>(elapsed.count()) : 0;
+    Shard& shard = localShard();
+    const size_t s = static_cast<size_t>(stage);
+    bump(shard.buckets[s][LatencyBuckets::indexOf(ns)]);
+    bump(shard.sums_ns[s], ns);
+}
+
+void ComplianceMetrics::recordDecision(RestrictionLevel level) noexcept {
+    bump(localShard().decisions[static_cast<size_t>(level)]);
+}
+
+void ComplianceMetrics::recordFailure(LookupFailure cause) noexcept {
+    bump(localShard().failures[static_cast<size_t>(cause)]);
+}
+
+void ComplianceMetrics::recordAnonymizerBlock() noexcept {
+    bump(localShard().anonymizer_blocks);
+}
+
+// ============================================================================
+// Reporting
+// ============================================================================
+
+MetricsSnapshot ComplianceMetrics::snapshot() {
+    MetricsSnapshot result;
+    {
+        Registry& r = registry();
+        std::lock_guard lock(r.mutex);
+        result = r.retired;
+        for (const Shard* shard : r.live) {
+            shard->addTo(result);
+        }
+    }
+    for (LatencyHistogram& histogram : result.stages) {
+        histogram.count = 0;
+        for (uint64_t bucket : histogram.buckets) {
+            histogram.count += bucket;
+        }
+    }
+    return result;
+}
+
+const char* ComplianceMetrics::stageName(CheckStage stage) noexcept {
+    switch (stage) {
+        case CheckStage::CACHE: return "cache";
+        case CheckStage::LOOKUP: return "lookup";
+        case CheckStage::PARSE: return "parse";
+        case CheckStage::CLASSIFY: return "classify";
+        case CheckStage::AUDIT: return "audit";
+        case CheckStage::TOTAL: return "total";
+        case CheckStage::COUNT: break;
+    }
+    return "unknown";
+}
+
+const char* ComplianceMetrics::failureName(LookupFailure cause) noexcept {
+    switch (cause) {
+        case LookupFailure::CURL_ERROR: return "curl_error";
+        case LookupFailure::HTTP_STATUS: return "http_status";
+        case LookupFailure::PROVIDER_FAIL: return "provider_fail";
+        case LookupFailure::PARSE_ERROR: return "parse_error";
+        case LookupFailure::OFFLINE_MISS: return "offline_miss";
+        case LookupFailure::INVALID_ADDRESS: return "invalid_address";
+        case LookupFailure::RATE_LIMITED: return "rate_limited";
+        case LookupFailure::COUNT: break;
+    }
+    return "unknown";
+}
+
+std::string ComplianceMetrics::renderPrometheus() {
+    // Snapshot first: formatting happens without holding the registry lock
+    const MetricsSnapshot snap = snapshot();
+    std::string out;
+    out.reserve(16 * 1024);
+
+    constexpr const char* DURATION = "spectremap_compliance_stage_duration_seconds";
+    appendHeader(out, DURATION, "histogram", "Latency of each access check stage.");
+    for (size_t s = 0; s < CHECK_STAGE_COUNT; ++s) {
+        const LatencyHistogram& histogram = snap.stages[s];
+        const std::string stage = stageName(static_cast<CheckStage>(s));
+        for (double bound : PROMETHEUS_BOUNDS) {
+            const auto ns = static_cast<uint64_t>(bound * 1e9 + 0.5);
+            out += std::string(DURATION) + "_bucket{stage=\"" + stage + "\",le=\"" + formatDouble(bound) +
+                   "\"} " + std::to_string(histogram.countAtOrBelow(ns)) + '\n';
+        }
+        out += std::string(DURATION) + "_bucket{stage=\"" + stage + "\",le=\"+Inf\"} " +
+               std::to_string(histogram.count) + '\n';
+        out += std::string(DURATION) + "_sum{stage=\"" + stage + "\"} " +
+               formatDouble(static_cast<double>(histogram.sum_ns) / 1e9) + '\n';
+        out += std::string(DURATION) + "_count{stage=\"" + stage + "\"} " +
+               std::to_string(histogram.count) + '\n';
+    }
+
+    constexpr const char* QUANTILE = "spectremap_compliance_stage_duration_quantile_seconds";
+    appendHeader(out, QUANTILE, "gauge", "Stage latency quantiles since process start (HDR histogram).");
+    for (size_t s = 0; s < CHECK_STAGE_COUNT; ++s) {
+        const std::string stage = stageName(static_cast<CheckStage>(s));
+        for (double q : PROMETHEUS_QUANTILES) {
+            out += std::string(QUANTILE) + "{stage=\"" + stage + "\",quantile=\"" + formatDouble(q) + "\"} " +
+                   formatDouble(static_cast<double>(snap.stages[s].quantile(q)) / 1e9) + '\n';
+        }
+    }
+
+    constexpr const char* DECISIONS = "spectremap_compliance_decisions_total";
+    appendHeader(out, DECISIONS, "counter", "Access check decisions by restriction level.");
+    for (size_t i = 0; i < RESTRICTION_LEVEL_COUNT; ++i) {
+        out += std::string(DECISIONS) + "{level=\"" + LEVEL_NAMES[i] + "\"} " +
+               std::to_string(snap.decisions[i]) + '\n';
+    }
+
+    constexpr const char* FAILURES = "spectremap_compliance_lookup_failures_total";
+    appendHeader(out, FAILURES, "counter", "GeoIP lookups that produced no location, by cause.");
+    for (size_t i = 0; i < LOOKUP_FAILURE_COUNT; ++i) {
+        out += std::string(FAILURES) + "{cause=\"" + failureName(static_cast<LookupFailure>(i)) + "\"} " +
+               std::to_string(snap.failures[i]) + '\n';
+    }
+
+    constexpr const char* ANONYMIZERS = "spectremap_compliance_anonymizer_blocks_total";
+    appendHeader(out, ANONYMIZERS, "counter", "Accesses blocked in strict mode for VPN, proxy, Tor or hosting use.");
+    out += std::string(ANONYMIZERS) + ' ' + std::to_string(snap.anonymizer_blocks) + '\n';
+
+    return out;
+}
+
+} // namespace SpectreMap::Compliance
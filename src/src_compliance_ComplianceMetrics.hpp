@@ -0,0 +1,172 @@
+/**
+ * @file ComplianceMetrics.hpp
+ * @brief Per-stage latency histograms and counters for access checks
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * Every thread records into its own shard, so the recording path is a
+ * handful of uncontended relaxed stores with no locks or atomic
+ * read-modify-writes. A reader sums the shards. When a thread exits, its
+ * counts are folded into a retired shard, so totals never go backwards.
+ *
+ * Latencies go into log-linear (HDR-style) histograms: 16 linear
+ * sub-buckets per power of two, which bounds the relative error of any
+ * quantile to 1/16 from 1 ns up to about 36 minutes.
+ *
+ * Metrics are process-wide and shared by every GeoRestriction instance.
+ */
+
+#ifndef SPECTREMAP_COMPLIANCEMETRICS_HPP
+#define SPECTREMAP_COMPLIANCEMETRICS_HPP
+
+#include "GeoRestriction.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace SpectreMap::Compliance {
+
+/**
+ * @brief Timed stage of an access check
+ */
+enum class CheckStage : uint8_t {
+    CACHE,      ///< GeoCache probe
+    LOOKUP,     ///< HTTP request or offline database lookup
+    PARSE,      ///< Provider response parsing
+    CLASSIFY,   ///< VPN/proxy screening and country classification
+    AUDIT,      ///< logAccessAttempt (mirror logging and audit enqueue)
+    TOTAL,      ///< Whole checkAccess call
+    COUNT
+};
+
+/**
+ * @brief Why a GeoIP lookup produced no location
+ */
+enum class LookupFailure : uint8_t {
+    CURL_ERROR,       ///< Transport failure, timeout or no curl handle
+    HTTP_STATUS,      ///< Non-200 response to a batch request
+    PROVIDER_FAIL,    ///< Provider answered with status "fail"
+    PARSE_ERROR,      ///< Response was not valid JSON
+    OFFLINE_MISS,     ///< Offline database has no country for the address
+    INVALID_ADDRESS,  ///< Input was not an IP address; rejected before any lookup
+    RATE_LIMITED,     ///< No provider request budget became available in time
+    COUNT
+};
+
+constexpr size_t CHECK_STAGE_COUNT = static_cast<size_t>(CheckStage::COUNT);
+constexpr size_t LOOKUP_FAILURE_COUNT = static_cast<size_t>(LookupFailure::COUNT);
+constexpr size_t RESTRICTION_LEVEL_COUNT = 4;
+
+/**
+ * @brief Log-linear histogram bucket layout (values in nanoseconds)
+ */
+struct LatencyBuckets {
+    static constexpr unsigned SUB_BUCKET_BITS = 4;
+    static constexpr uint64_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+    static constexpr unsigned MAX_EXPONENT = 40;   ///< Values >= 2^41 ns share the top bucket
+    static constexpr size_t COUNT = SUB_BUCKETS + (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    static constexpr size_t indexOf(uint64_t ns) noexcept {
+        if (ns < SUB_BUCKETS) return static_cast<size_t>(ns);
+        unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(ns));
+        if (exponent > MAX_EXPONENT) return COUNT - 1;
+        const unsigned shift = exponent - SUB_BUCKET_BITS;
+        return SUB_BUCKETS + (exponent - SUB_BUCKET_BITS) * SUB_BUCKETS +
+               static_cast<size_t>((ns >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    /// Smallest value that lands in bucket @p index
+    static constexpr uint64_t lowerBound(size_t index) noexcept {
+        if (index < SUB_BUCKETS) return index;
+        const size_t group = (index - SUB_BUCKETS) / SUB_BUCKETS;
+        const uint64_t sub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+        return (SUB_BUCKETS + sub) << group;
+    }
+
+    /// Smallest value above bucket @p index
+    static constexpr uint64_t upperBound(size_t index) noexcept {
+        if (index < SUB_BUCKETS) return index + 1;
+        return lowerBound(index) + (uint64_t{1} << ((index - SUB_BUCKETS) / SUB_BUCKETS));
+    }
+};
+
+static_assert(LatencyBuckets::indexOf(15) == 15);
+static_assert(LatencyBuckets::indexOf(16) == 16);
+static_assert(LatencyBuckets::lowerBound(LatencyBuckets::indexOf(1000)) <= 1000);
+static_assert(LatencyBuckets::upperBound(LatencyBuckets::indexOf(1000)) > 1000);
+
+/**
+ * @brief Merged view of one stage's histogram
+ */
+struct LatencyHistogram {
+    std::array<uint64_t, LatencyBuckets::COUNT> buckets{};
+    uint64_t count = 0;
+    uint64_t sum_ns = 0;
+
+    /**
+     * @brief Value at quantile @p q (0..1), reported as its bucket's midpoint
+     * @return 0 if nothing was recorded
+     */
+    uint64_t quantile(double q) const noexcept;
+
+    /**
+     * @brief Samples in buckets lying entirely at or below @p ns
+     */
+    uint64_t countAtOrBelow(uint64_t ns) const noexcept;
+};
+
+/**
+ * @brief Point-in-time totals across all threads
+ */
+struct MetricsSnapshot {
+    std::array<LatencyHistogram, CHECK_STAGE_COUNT> stages{};
+    std::array<uint64_t, RESTRICTION_LEVEL_COUNT> decisions{};   ///< Indexed by RestrictionLevel
+    std::array<uint64_t, LOOKUP_FAILURE_COUNT> failures{};       ///< Indexed by LookupFailure
+    uint64_t anonymizer_blocks = 0;                              ///< VPN/proxy/Tor blocks in strict mode
+};
+
+/**
+ * @brief Process-wide access check metrics
+ */
+class ComplianceMetrics {
+public:
+    static void recordStage(CheckStage stage, std::chrono::nanoseconds elapsed) noexcept;
+    static void recordDecision(RestrictionLevel level) noexcept;
+    static void recordFailure(LookupFailure cause) noexcept;
+    static void recordAnonymizerBlock() noexcept;
+
+    static MetricsSnapshot snapshot();
+
+    /**
+     * @brief Render the metrics in Prometheus text exposition format (0.0.4)
+     */
+    static std::string renderPrometheus();
+
+    static const char* stageName(CheckStage stage) noexcept;
+    static const char* failureName(LookupFailure cause) noexcept;
+};
+
+/**
+ * @brief Records the time from construction to destruction against a stage
+ */
+class StageTimer {
+public:
+    explicit StageTimer(CheckStage stage) noexcept
+        : stage_(stage), start_(std::chrono::steady_clock::now()) {}
+
+    ~StageTimer() {
+        ComplianceMetrics::recordStage(stage_, std::chrono::steady_clock::now() - start_);
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    CheckStage stage_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_COMPLIANCEMETRICS_HPP
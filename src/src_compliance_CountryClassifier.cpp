@@ -0,0 +1,237 @@
+/**
+ * @file CountryClassifier.cpp
+ * @brief Implementation of the scalar, SSE4.1 and AVX2 country classification kernels
+ */
+
+#include "CountryClassifier.hpp"
+#include "SanctionsPolicy.hpp"
+#include <algorithm>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SPECTREMAP_CLASSIFIER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace SpectreMap::Compliance {
+
+namespace {
+
+static_assert(CountryTable::KEY_SPACE == 27 * 27 * 27, "kernels compute base-27 keys");
+
+/**
+ * @brief CountryTable::packCode key of a packed code, or 0 if it is not 2-3 letters A-Z
+ */
+inline uint32_t keyOf(uint32_t code) noexcept {
+    const uint32_t d0 = (code & 0xFF) - 'A';
+    const uint32_t d1 = ((code >> 8) & 0xFF) - 'A';
+    const uint32_t b2 = (code >> 16) & 0xFF;
+    const uint32_t d2 = b2 - 'A';
+    if (d0 >= 26 || d1 >= 26 || (b2 != 0 && d2 >= 26) || (code >> 24) != 0) {
+        return 0;
+    }
+    return (d0 + 1) * 729 + (d1 + 1) * 27 + (b2 != 0 ? d2 + 1 : 0);
+}
+
+template <typename Code>
+void classifyScalar(const uint8_t* table, const Code* codes, RestrictionLevel* levels, size_t count) noexcept {
+    for (size_t i = 0; i < count; ++i) {
+        levels[i] = static_cast<RestrictionLevel>(table[keyOf(codes[i])]);
+    }
+}
+
+#ifdef SPECTREMAP_CLASSIFIER_X86
+
+// The vector kernels hold RestrictionLevel in 32-bit lanes and store them directly
+static_assert(sizeof(RestrictionLevel) == sizeof(int32_t));
+
+// ---------------------------------------------------------------------------
+// SSE4.1: four keys per step, levels loaded one by one
+// ---------------------------------------------------------------------------
+
+__attribute__((target("sse4.1")))
+inline __m128i letterDigits128(__m128i bytes, __m128i& valid) {
+    // bytes - 'A' lies in [0, 26) for a letter; compared signed, as lanes hold 0..255
+    const __m128i digits = _mm_sub_epi32(bytes, _mm_set1_epi32('A'));
+    valid = _mm_and_si128(_mm_cmpgt_epi32(digits, _mm_set1_epi32(-1)),
+                          _mm_cmplt_epi32(digits, _mm_set1_epi32(26)));
+    return _mm_add_epi32(digits, _mm_set1_epi32(1));
+}
+
+__attribute__((target("sse4.1")))
+inline __m128i keys128(__m128i codes) {
+    const __m128i low_byte = _mm_set1_epi32(0xFF);
+    __m128i valid0, valid1, valid2;
+    const __m128i d0 = letterDigits128(_mm_and_si128(codes, low_byte), valid0);
+    const __m128i d1 = letterDigits128(_mm_and_si128(_mm_srli_epi32(codes, 8), low_byte), valid1);
+    const __m128i b2 = _mm_and_si128(_mm_srli_epi32(codes, 16), low_byte);
+    const __m128i d2 = letterDigits128(b2, valid2);
+    const __m128i no_third = _mm_cmpeq_epi32(b2, _mm_setzero_si128());
+    const __m128i valid = _mm_and_si128(
+        _mm_and_si128(valid0, valid1),
+        _mm_and_si128(_mm_or_si128(valid2, no_third),
+                      _mm_cmpeq_epi32(_mm_srli_epi32(codes, 24), _mm_setzero_si128())));
+    const __m128i key = _mm_add_epi32(
+        _mm_add_epi32(_mm_mullo_epi32(d0, _mm_set1_epi32(729)), _mm_mullo_epi32(d1, _mm_set1_epi32(27))),
+        _mm_andnot_si128(no_third, d2));
+    return _mm_and_si128(key, valid);
+}
+
+__attribute__((target("sse4.1")))
+inline void store128(const uint8_t* table, __m128i key, RestrictionLevel* levels) {
+    const __m128i found = _mm_setr_epi32(table[_mm_cvtsi128_si32(key)], table[_mm_extract_epi32(key, 1)],
+                                         table[_mm_extract_epi32(key, 2)], table[_mm_extract_epi32(key, 3)]);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(levels), found);
+}
+
+__attribute__((target("sse4.1")))
+void classifySse41(const uint8_t* table, const uint32_t* codes, RestrictionLevel* levels, size_t count) noexcept {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i));
+        store128(table, keys128(packed), levels + i);
+    }
+    classifyScalar(table, codes + i, levels + i, count - i);
+}
+
+__attribute__((target("sse4.1")))
+void classifySse41(const uint8_t* table, const uint16_t* codes, RestrictionLevel* levels, size_t count) noexcept {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i packed = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(codes + i)));
+        store128(table, keys128(packed), levels + i);
+    }
+    classifyScalar(table, codes + i, levels + i, count - i);
+}
+
+// ---------------------------------------------------------------------------
+// AVX2: eight keys per step, levels gathered as 32-bit loads from the padded table
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+inline __m256i letterDigits256(__m256i bytes, __m256i& valid) {
+    const __m256i digits = _mm256_sub_epi32(bytes, _mm256_set1_epi32('A'));
+    valid = _mm256_and_si256(_mm256_cmpgt_epi32(digits, _mm256_set1_epi32(-1)),
+                             _mm256_cmpgt_epi32(_mm256_set1_epi32(26), digits));
+    return _mm256_add_epi32(digits, _mm256_set1_epi32(1));
+}
+
+__attribute__((target("avx2")))
+inline __m256i keys256(__m256i codes) {
+    const __m256i low_byte = _mm256_set1_epi32(0xFF);
+    __m256i valid0, valid1, valid2;
+    const __m256i d0 = letterDigits256(_mm256_and_si256(codes, low_byte), valid0);
+    const __m256i d1 = letterDigits256(_mm256_and_si256(_mm256_srli_epi32(codes, 8), low_byte), valid1);
+    const __m256i b2 = _mm256_and_si256(_mm256_srli_epi32(codes, 16), low_byte);
+    const __m256i d2 = letterDigits256(b2, valid2);
+    const __m256i no_third = _mm256_cmpeq_epi32(b2, _mm256_setzero_si256());
+    const __m256i valid = _mm256_and_si256(
+        _mm256_and_si256(valid0, valid1),
+        _mm256_and_si256(_mm256_or_si256(valid2, no_third),
+                         _mm256_cmpeq_epi32(_mm256_srli_epi32(codes, 24), _mm256_setzero_si256())));
+    const __m256i key = _mm256_add_epi32(
+        _mm256_add_epi32(_mm256_mullo_epi32(d0, _mm256_set1_epi32(729)),
+                         _mm256_mullo_epi32(d1, _mm256_set1_epi32(27))),
+        _mm256_andnot_si256(no_third, d2));
+    return _mm256_and_si256(key, valid);
+}
+
+__attribute__((target("avx2")))
+inline void store256(const uint8_t* table, __m256i key, RestrictionLevel* levels) {
+    // Each lane loads four table bytes starting at its key; the padding keeps the last key in bounds
+    const __m256i words = _mm256_i32gather_epi32(reinterpret_cast<const int*>(table), key, 1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(levels), _mm256_and_si256(words, _mm256_set1_epi32(0xFF)));
+}
+
+__attribute__((target("avx2")))
+void classifyAvx2(const uint8_t* table, const uint32_t* codes, RestrictionLevel* levels, size_t count) noexcept {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i packed = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(codes + i));
+        store256(table, keys256(packed), levels + i);
+    }
+    classifyScalar(table, codes + i, levels + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void classifyAvx2(const uint8_t* table, const uint16_t* codes, RestrictionLevel* levels, size_t count) noexcept {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i packed = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i)));
+        store256(table, keys256(packed), levels + i);
+    }
+    classifyScalar(table, codes + i, levels + i, count - i);
+}
+
+#endif // SPECTREMAP_CLASSIFIER_X86
+
+ClassifierKernel detectKernel() noexcept {
+#ifdef SPECTREMAP_CLASSIFIER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return ClassifierKernel::AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return ClassifierKernel::SSE41;
+#endif
+    return ClassifierKernel::SCALAR;
+}
+
+template <typename Code>
+size_t run(ClassifierKernel kernel, const SanctionsPolicy& policy,
+           std::span<const Code> codes, std::span<RestrictionLevel> levels) noexcept {
+    const size_t count = std::min(codes.size(), levels.size());
+    const uint8_t* table = policy.levelTable();
+    if (!CountryClassifier::supported(kernel)) {
+        kernel = CountryClassifier::kernel();
+    }
+    switch (kernel) {
+#ifdef SPECTREMAP_CLASSIFIER_X86
+        case ClassifierKernel::AVX2:
+            classifyAvx2(table, codes.data(), levels.data(), count);
+            return count;
+        case ClassifierKernel::SSE41:
+            classifySse41(table, codes.data(), levels.data(), count);
+            return count;
+#endif
+        default:
+            classifyScalar(table, codes.data(), levels.data(), count);
+            return count;
+    }
+}
+
+} // namespace
+
+size_t CountryClassifier::classify(std::span<const uint16_t> codes, std::span<RestrictionLevel> levels) noexcept {
+    return run(kernel(), SanctionsPolicy::current(), codes, levels);
+}
+
+size_t CountryClassifier::classify(std::span<const uint32_t> codes, std::span<RestrictionLevel> levels) noexcept {
+    return run(kernel(), SanctionsPolicy::current(), codes, levels);
+}
+
+size_t CountryClassifier::classify(ClassifierKernel kernel, const SanctionsPolicy& policy,
+                                   std::span<const uint16_t> codes, std::span<RestrictionLevel> levels) noexcept {
+    return run(kernel, policy, codes, levels);
+}
+
+size_t CountryClassifier::classify(ClassifierKernel kernel, const SanctionsPolicy& policy,
+                                   std::span<const uint32_t> codes, std::span<RestrictionLevel> levels) noexcept {
+    return run(kernel, policy, codes, levels);
+}
+
+ClassifierKernel CountryClassifier::kernel() noexcept {
+    static const ClassifierKernel detected = detectKernel();
+    return detected;
+}
+
+bool CountryClassifier::supported(ClassifierKernel kernel) noexcept {
+    return kernel <= CountryClassifier::kernel();
+}
+
+const char* CountryClassifier::kernelName(ClassifierKernel kernel) noexcept {
+    switch (kernel) {
+        case ClassifierKernel::SCALAR: return "scalar";
+        case ClassifierKernel::SSE41:  return "sse4.1";
+        case ClassifierKernel::AVX2:   return "avx2";
+    }
+    return "unknown";
+}
+
+} // namespace SpectreMap::Compliance
@@ -0,0 +1,96 @@
+/**
+ * @file CountryClassifier.hpp
+ * @brief Batch restriction levels for packed country codes
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * Flow tagging already knows each endpoint's country and needs only its
+ * RestrictionLevel, for millions of flows a second. Codes arrive packed
+ * as integers holding their ASCII letters, first letter in the low byte
+ * (the code's bytes in memory order on a little-endian machine):
+ *
+ * - 16-bit: two letters, e.g. "IR" is 'I' | 'R' << 8
+ * - 24-bit, in a uint32_t: two or three letters, top byte zero; a two
+ *   letter code has a zero third byte, e.g. "XCR" is 'X' | 'C' << 8 | 'R' << 16
+ *
+ * A batch is classified against one snapshot of the sanctions policy. Each
+ * code is turned into its CountryTable::packCode key and looked up in the
+ * policy's per-key level table. The kernel is picked once for the CPU:
+ * AVX2 computes eight keys at a time and gathers their levels, SSE4.1
+ * computes four keys at a time with scalar loads, and the scalar loop
+ * covers other CPUs and the tail of every batch. Anything that is not an
+ * uppercase 2-3 letter code is ALLOWED, as it is for checkCountryFast.
+ */
+
+#ifndef SPECTREMAP_COUNTRYCLASSIFIER_HPP
+#define SPECTREMAP_COUNTRYCLASSIFIER_HPP
+
+#include "GeoRestriction.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace SpectreMap::Compliance {
+
+class SanctionsPolicy;
+
+/**
+ * @brief Instruction set used by a classification kernel
+ */
+enum class ClassifierKernel : uint8_t {
+    SCALAR,
+    SSE41,
+    AVX2
+};
+
+/**
+ * @brief Restriction levels for arrays of packed country codes
+ */
+class CountryClassifier {
+public:
+    /**
+     * @brief Pack a code into the 24-bit form (also the 16-bit form for two letters)
+     * @return Packed code, or 0 (classified ALLOWED) if longer than three characters
+     */
+    static constexpr uint32_t pack(std::string_view code) noexcept {
+        if (code.size() > 3) return 0;
+        uint32_t packed = 0;
+        for (size_t i = 0; i < code.size(); ++i) {
+            packed |= static_cast<uint32_t>(static_cast<unsigned char>(code[i])) << (8 * i);
+        }
+        return packed;
+    }
+
+    /**
+     * @brief Classify against the current policy with the best kernel for this CPU
+     * @return Codes classified: min(codes.size(), levels.size())
+     */
+    static size_t classify(std::span<const uint16_t> codes, std::span<RestrictionLevel> levels) noexcept;
+    static size_t classify(std::span<const uint32_t> codes, std::span<RestrictionLevel> levels) noexcept;
+
+    /**
+     * @brief Classify against a given policy with a given kernel (benchmarks and comparisons)
+     *
+     * A kernel this CPU does not support falls back to the best one it does.
+     */
+    static size_t classify(ClassifierKernel kernel, const SanctionsPolicy& policy,
+                           std::span<const uint16_t> codes, std::span<RestrictionLevel> levels) noexcept;
+    static size_t classify(ClassifierKernel kernel, const SanctionsPolicy& policy,
+                           std::span<const uint32_t> codes, std::span<RestrictionLevel> levels) noexcept;
+
+    /**
+     * @brief Kernel used by classify() on this CPU
+     */
+    static ClassifierKernel kernel() noexcept;
+
+    static bool supported(ClassifierKernel kernel) noexcept;
+
+    static const char* kernelName(ClassifierKernel kernel) noexcept;
+};
+
+static_assert(CountryClassifier::pack("IR") == ('I' | 'R' << 8));
+static_assert(CountryClassifier::pack("XCR") == ('X' | 'C' << 8 | 'R' << 16));
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_COUNTRYCLASSIFIER_HPP
@@ -0,0 +1,255 @@
+/**
+ * @file CountryDatabase.hpp
+ * @brief Compile-time country classification table
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * Country codes are 2-3 uppercase ASCII letters, so each one packs into a
+ * base-27 integer below 27^3. A constexpr-built direct index over that key
+ * space maps a code to its record - name, sanctions program and applicable
+ * regulations - in a single array probe, with no string hashing.
+ */
+
+#ifndef SPECTREMAP_COUNTRYDATABASE_HPP
+#define SPECTREMAP_COUNTRYDATABASE_HPP
+
+#include "GeoRestriction.hpp"
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace SpectreMap::Compliance {
+
+/**
+ * @brief Sanctions program a country falls under
+ */
+enum class SanctionsProgram : uint8_t {
+    NONE,
+    OFAC_COMPREHENSIVE,   ///< OFAC comprehensive sanctions (31 CFR) - complete block
+    OFAC_SECTORAL,        ///< OFAC partial/sectoral sanctions - blocked
+    ARMS_EMBARGO,         ///< UN/EU/US arms embargoes - blocked
+    HIGH_RISK             ///< BIS Entity List concentrations - allowed and logged
+};
+
+/**
+ * @brief Everything checkCountry needs about one country
+ */
+struct CountryRecord {
+    std::string_view code;
+    std::string_view name;
+    SanctionsProgram program = SanctionsProgram::NONE;
+    std::span<const std::string_view> regulations;
+
+    constexpr RestrictionLevel level() const noexcept {
+        switch (program) {
+            case SanctionsProgram::OFAC_COMPREHENSIVE: return RestrictionLevel::COMPREHENSIVELY_SANCTIONED;
+            case SanctionsProgram::OFAC_SECTORAL:
+            case SanctionsProgram::ARMS_EMBARGO:       return RestrictionLevel::RESTRICTED;
+            case SanctionsProgram::HIGH_RISK:          return RestrictionLevel::HIGH_RISK;
+            case SanctionsProgram::NONE:               break;
+        }
+        return RestrictionLevel::ALLOWED;
+    }
+
+    constexpr bool allowed() const noexcept {
+        return program == SanctionsProgram::NONE || program == SanctionsProgram::HIGH_RISK;
+    }
+
+    constexpr std::string_view reason() const noexcept {
+        switch (program) {
+            case SanctionsProgram::OFAC_COMPREHENSIVE:
+                return "Comprehensive OFAC sanctions - export prohibited under US law";
+            case SanctionsProgram::OFAC_SECTORAL:
+                return "Sectoral sanctions - technology exports restricted under US law";
+            case SanctionsProgram::ARMS_EMBARGO:
+                return "UN/US arms embargo - dual-use technology export restricted";
+            case SanctionsProgram::HIGH_RISK:
+                return "High-risk jurisdiction - access logged for compliance review";
+            case SanctionsProgram::NONE:
+                break;
+        }
+        return "No export restrictions";
+    }
+};
+
+namespace CountryTable {
+
+// ============================================================================
+// Applicable Regulations
+// ============================================================================
+inline constexpr std::string_view CUBA_REGULATIONS[] = {
+    "31 CFR Part 515 (Cuban Assets Control Regulations)", "US EAR"};
+inline constexpr std::string_view IRAN_REGULATIONS[] = {
+    "31 CFR Part 560 (Iranian Transactions and Sanctions Regulations)", "US EAR"};
+inline constexpr std::string_view DPRK_REGULATIONS[] = {
+    "31 CFR Part 510 (North Korea Sanctions Regulations)", "US EAR"};
+inline constexpr std::string_view SYRIA_REGULATIONS[] = {
+    "31 CFR Part 542 (Syrian Sanctions Regulations)", "US EAR"};
+inline constexpr std::string_view UKRAINE_RELATED_REGULATIONS[] = {
+    "31 CFR Part 589 (Ukraine-Related Sanctions)", "US EAR 15 CFR Part 746"};
+inline constexpr std::string_view BELARUS_REGULATIONS[] = {
+    "31 CFR Part 548 (Belarus Sanctions Regulations)", "US EAR"};
+inline constexpr std::string_view ARMS_EMBARGO_REGULATIONS[] = {
+    "US Arms Export Control Act", "22 CFR § 126.1", "UN Security Council Resolutions"};
+inline constexpr std::string_view HIGH_RISK_REGULATIONS[] = {
+    "BIS Entity List (15 CFR Part 744)", "EAR Country Groups"};
+
+// ============================================================================
+// Country Records
+// ============================================================================
+inline constexpr CountryRecord RECORDS[] = {
+    // OFAC Comprehensive Sanctions (31 CFR) - COMPLETE BLOCK
+    {"CU", "Cuba", SanctionsProgram::OFAC_COMPREHENSIVE, CUBA_REGULATIONS},                // 31 CFR Part 515
+    {"IR", "Iran", SanctionsProgram::OFAC_COMPREHENSIVE, IRAN_REGULATIONS},                // 31 CFR Part 560
+    {"KP", "North Korea (DPRK)", SanctionsProgram::OFAC_COMPREHENSIVE, DPRK_REGULATIONS},  // 31 CFR Part 510
+    {"SY", "Syria", SanctionsProgram::OFAC_COMPREHENSIVE, SYRIA_REGULATIONS},              // 31 CFR Part 542
+
+    // Crimea and specific regions of Ukraine (31 CFR Part 589)
+    {"XCR", "Crimea Region (Ukraine)", SanctionsProgram::OFAC_COMPREHENSIVE, UKRAINE_RELATED_REGULATIONS},
+    {"XDO", "Donetsk Region (Ukraine)", SanctionsProgram::OFAC_COMPREHENSIVE, UKRAINE_RELATED_REGULATIONS},
+    {"XLU", "Luhansk Region (Ukraine)", SanctionsProgram::OFAC_COMPREHENSIVE, UKRAINE_RELATED_REGULATIONS},
+
+    // OFAC Partial/Sectoral Sanctions
+    {"RU", "Russia", SanctionsProgram::OFAC_SECTORAL, UKRAINE_RELATED_REGULATIONS},  // 31 CFR Part 589
+    {"BY", "Belarus", SanctionsProgram::OFAC_SECTORAL, BELARUS_REGULATIONS},         // 31 CFR Part 548
+
+    // UN/EU Arms Embargoes and State Department Restrictions
+    {"SO", "Somalia", SanctionsProgram::ARMS_EMBARGO, ARMS_EMBARGO_REGULATIONS},
+    {"SS", "South Sudan", SanctionsProgram::ARMS_EMBARGO, ARMS_EMBARGO_REGULATIONS},
+    {"SD", "Sudan", SanctionsProgram::ARMS_EMBARGO, ARMS_EMBARGO_REGULATIONS},
+    {"LY", "Libya", SanctionsProgram::ARMS_EMBARGO, ARMS_EMBARGO_REGULATIONS},
+    {"CF", "Central African Republic", SanctionsProgram::ARMS_EMBARGO, ARMS_EMBARGO_REGULATIONS},
+    {"VE", "Venezuela", SanctionsProgram::ARMS_EMBARGO, ARMS_EMBARGO_REGULATIONS},
+    {"MM", "Myanmar (Burma)", SanctionsProgram::ARMS_EMBARGO, ARMS_EMBARGO_REGULATIONS},
+    {"YE", "Yemen", SanctionsProgram::ARMS_EMBARGO, ARMS_EMBARGO_REGULATIONS},
+    {"LB", "Lebanon", SanctionsProgram::ARMS_EMBARGO, ARMS_EMBARGO_REGULATIONS},
+    {"CD", "Democratic Republic of Congo", SanctionsProgram::ARMS_EMBARGO, ARMS_EMBARGO_REGULATIONS},
+    {"ER", "Eritrea", SanctionsProgram::ARMS_EMBARGO, ARMS_EMBARGO_REGULATIONS},
+
+    // High-Risk (BIS Entity List concentrations, export license likely needed)
+    {"CN", "China", SanctionsProgram::HIGH_RISK, HIGH_RISK_REGULATIONS},
+    {"HK", "Hong Kong", SanctionsProgram::HIGH_RISK, HIGH_RISK_REGULATIONS},
+    {"PK", "Pakistan", SanctionsProgram::HIGH_RISK, HIGH_RISK_REGULATIONS},
+    {"AF", "Afghanistan", SanctionsProgram::HIGH_RISK, HIGH_RISK_REGULATIONS},
+    {"IQ", "Iraq", SanctionsProgram::HIGH_RISK, HIGH_RISK_REGULATIONS},
+
+    // Countries with weak export control enforcement
+    {"AE", "United Arab Emirates", SanctionsProgram::HIGH_RISK, HIGH_RISK_REGULATIONS},  // Transshipment risk
+    {"TR", "Turkey", SanctionsProgram::HIGH_RISK, HIGH_RISK_REGULATIONS},                // Transshipment concerns
+    {"EG", "Egypt", SanctionsProgram::HIGH_RISK, HIGH_RISK_REGULATIONS},
+};
+
+// ============================================================================
+// Packed Key Index
+// ============================================================================
+
+/// Number of distinct packed keys (three base-27 digits; 0 means "no letter")
+inline constexpr uint32_t KEY_SPACE = 27 * 27 * 27;
+
+/**
+ * @brief Pack a 2-3 letter uppercase code into a base-27 key
+ * @return Key in [1, KEY_SPACE), or 0 if the code is not 2-3 letters A-Z
+ */
+constexpr uint32_t packCode(std::string_view code) noexcept {
+    if (code.size() < 2 || code.size() > 3) return 0;
+    uint32_t key = 0;
+    for (size_t i = 0; i < 3; ++i) {
+        uint32_t digit = 0;
+        if (i < code.size()) {
+            const char c = code[i];
+            if (c < 'A' || c > 'Z') return 0;
+            digit = static_cast<uint32_t>(c - 'A') + 1;
+        }
+        key = key * 27 + digit;
+    }
+    return key;
+}
+
+constexpr bool recordsAreValid() noexcept {
+    std::array<bool, KEY_SPACE> seen{};
+    for (const CountryRecord& record : RECORDS) {
+        const uint32_t key = packCode(record.code);
+        if (key == 0 || seen[key]) return false;
+        seen[key] = true;
+    }
+    return true;
+}
+
+static_assert(std::size(RECORDS) < 255, "record index must fit in uint8_t");
+static_assert(recordsAreValid(), "country codes must be unique 2-3 letter uppercase codes");
+
+/// Packed key -> record position + 1 (0 = not listed)
+inline constexpr std::array<uint8_t, KEY_SPACE> INDEX = [] {
+    std::array<uint8_t, KEY_SPACE> index{};
+    for (size_t i = 0; i < std::size(RECORDS); ++i) {
+        index[packCode(RECORDS[i].code)] = static_cast<uint8_t>(i + 1);
+    }
+    return index;
+}();
+
+} // namespace CountryTable
+
+/**
+ * @brief Country code to name, restriction level and regulations
+ *
+ * Every query is constexpr, so classifications can be checked at compile time:
+ * @code
+ * static_assert(CountryDatabase::getRestrictionLevel("KP") ==
+ *               RestrictionLevel::COMPREHENSIVELY_SANCTIONED);
+ * @endcode
+ */
+class CountryDatabase {
+public:
+    /**
+     * @brief Look up a listed country
+     * @return Record, or nullptr if the code carries no restrictions
+     */
+    static constexpr const CountryRecord* find(std::string_view code) noexcept {
+        const uint8_t slot = CountryTable::INDEX[CountryTable::packCode(code)];
+        return slot ? &CountryTable::RECORDS[slot - 1] : nullptr;
+    }
+
+    /**
+     * @brief Display name; unlisted codes are returned unchanged
+     */
+    static constexpr std::string_view getCountryName(std::string_view code) noexcept {
+        if (const CountryRecord* record = find(code)) return record->name;
+        if (code == "UNKNOWN") return "Unknown Country";
+        return code;
+    }
+
+    static constexpr RestrictionLevel getRestrictionLevel(std::string_view code) noexcept {
+        const CountryRecord* record = find(code);
+        return record ? record->level() : RestrictionLevel::ALLOWED;
+    }
+
+    static constexpr std::span<const std::string_view> getApplicableRegulations(std::string_view code) noexcept {
+        const CountryRecord* record = find(code);
+        return record ? record->regulations : std::span<const std::string_view>{};
+    }
+
+    /**
+     * @brief Every listed country, grouped by sanctions program
+     */
+    static constexpr std::span<const CountryRecord> records() noexcept {
+        return CountryTable::RECORDS;
+    }
+
+    static constexpr size_t countByProgram(SanctionsProgram program) noexcept {
+        size_t count = 0;
+        for (const CountryRecord& record : CountryTable::RECORDS) {
+            count += record.program == program;
+        }
+        return count;
+    }
+};
+
+static_assert(CountryDatabase::getRestrictionLevel("KP") == RestrictionLevel::COMPREHENSIVELY_SANCTIONED);
+static_assert(CountryDatabase::getRestrictionLevel("XCR") == RestrictionLevel::COMPREHENSIVELY_SANCTIONED);
+static_assert(CountryDatabase::getRestrictionLevel("RU") == RestrictionLevel::RESTRICTED);
+static_assert(CountryDatabase::getRestrictionLevel("US") == RestrictionLevel::ALLOWED);
+static_assert(CountryDatabase::getCountryName("de") == "de");
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_COUNTRYDATABASE_HPP
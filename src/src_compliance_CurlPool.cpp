@@ -0,0 +1,126 @@
+/**
+ * @file CurlPool.cpp
+ * @brief Implementation of the pooled libcurl handle manager
+ */
+
+#include "CurlPool.hpp"
+#include "../core/Logger.hpp"
+
+namespace SpectreMap::Compliance {
+
+// ============================================================================
+// Lease
+// ============================================================================
+
+CurlPool::Lease& CurlPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool_ = other.pool_;
+        handle_ = other.handle_;
+        other.handle_ = nullptr;
+    }
+    return *this;
+}
+
+void CurlPool::Lease::release() noexcept {
+    if (handle_ && pool_) {
+        pool_->release(handle_);
+    }
+    handle_ = nullptr;
+}
+
+// ============================================================================
+// CurlPool
+// ============================================================================
+
+CurlPool::CurlPool(const GeoIPClientConfig& config) : config_(config) {
+    static std::once_flag curl_global_once;
+    std::call_once(curl_global_once, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+    share_ = curl_share_init();
+    if (!share_) {
+        Logger::warning("curl_share_init failed - GeoIP handles will not share DNS/TLS caches");
+        return;
+    }
+    curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, lockShared);
+    curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, unlockShared);
+    curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    // Connections stay with their handle: libcurl does not support a shared
+    // connection cache across threads
+}
+
+CurlPool::~CurlPool() {
+    // Every lease must be returned before the pool goes away
+    for (CURL* handle : idle_) {
+        curl_easy_cleanup(handle);
+    }
+    idle_.clear();
+    if (share_) {
+        curl_share_cleanup(share_);
+    }
+}
+
+CurlPool::Lease CurlPool::acquire() {
+    CURL* handle = nullptr;
+    {
+        std::lock_guard lock(idle_mutex_);
+        if (!idle_.empty()) {
+            handle = idle_.back();
+            idle_.pop_back();
+        }
+    }
+
+    if (handle) {
+        // Reset clears per-request options but keeps live connections and caches
+        curl_easy_reset(handle);
+    } else {
+        handle = curl_easy_init();
+        if (!handle) {
+            return Lease();
+        }
+    }
+
+    applyDefaults(handle);
+    return Lease(this, handle);
+}
+
+void CurlPool::release(CURL* handle) noexcept {
+    {
+        std::lock_guard lock(idle_mutex_);
+        if (idle_.size() < config_.max_idle_handles) {
+            idle_.push_back(handle);
+            return;
+        }
+    }
+    curl_easy_cleanup(handle);
+}
+
+void CurlPool::applyDefaults(CURL* handle) const {
+    if (share_) {
+        curl_easy_setopt(handle, CURLOPT_SHARE, share_);
+    }
+    curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(config_.connect_timeout.count()));
+    curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, static_cast<long>(config_.total_timeout.count()));
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);  // Required for timeouts in multithreaded use
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(handle, CURLOPT_TCP_NODELAY, 1L);
+    curl_easy_setopt(handle, CURLOPT_DNS_CACHE_TIMEOUT, static_cast<long>(config_.dns_cache_ttl.count()));
+}
+
+void CurlPool::lockShared(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+    auto* pool = static_cast<CurlPool*>(userptr);
+    if (data >= 0 && data < CURL_LOCK_DATA_LAST) {
+        pool->share_locks_[data].lock();
+    }
+}
+
+void CurlPool::unlockShared(CURL*, curl_lock_data data, void* userptr) {
+    auto* pool = static_cast<CurlPool*>(userptr);
+    if (data >= 0 && data < CURL_LOCK_DATA_LAST) {
+        pool->share_locks_[data].unlock();
+    }
+}
+
+} // namespace SpectreMap::Compliance
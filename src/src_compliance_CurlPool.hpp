@@ -0,0 +1,86 @@
+/**
+ * @file CurlPool.hpp
+ * @brief Pool of reusable libcurl easy handles for GeoIP provider requests
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * Handles are returned to the pool after each request instead of being
+ * destroyed, so their keep-alive connections survive between lookups.
+ * All handles are attached to one CURLSH share object that holds the DNS
+ * cache and TLS session cache, so a handle opening a new connection can
+ * resume a session established by any other thread. Connections themselves
+ * are never shared between handles.
+ */
+
+#ifndef SPECTREMAP_CURLPOOL_HPP
+#define SPECTREMAP_CURLPOOL_HPP
+
+#include "GeoRestriction.hpp"
+#include <curl/curl.h>
+#include <mutex>
+#include <vector>
+
+namespace SpectreMap::Compliance {
+
+/**
+ * @brief Thread-safe pool of CURL easy handles sharing one CURLSH
+ */
+class CurlPool {
+public:
+    /**
+     * @brief Exclusive use of one pooled handle; returns it on destruction
+     */
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(CurlPool* pool, CURL* handle) : pool_(pool), handle_(handle) {}
+        ~Lease() { release(); }
+
+        Lease(Lease&& other) noexcept : pool_(other.pool_), handle_(other.handle_) {
+            other.handle_ = nullptr;
+        }
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        CURL* get() const noexcept { return handle_; }
+        explicit operator bool() const noexcept { return handle_ != nullptr; }
+
+    private:
+        void release() noexcept;
+
+        CurlPool* pool_ = nullptr;
+        CURL* handle_ = nullptr;
+    };
+
+    explicit CurlPool(const GeoIPClientConfig& config);
+    ~CurlPool();
+
+    CurlPool(const CurlPool&) = delete;
+    CurlPool& operator=(const CurlPool&) = delete;
+
+    /**
+     * @brief Check out a handle with the pool's defaults applied
+     * @return Empty lease if libcurl could not create a handle
+     */
+    Lease acquire();
+
+    const GeoIPClientConfig& config() const noexcept { return config_; }
+
+private:
+    void applyDefaults(CURL* handle) const;
+    void release(CURL* handle) noexcept;
+
+    static void lockShared(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr);
+    static void unlockShared(CURL* handle, curl_lock_data data, void* userptr);
+
+    GeoIPClientConfig config_;
+    CURLSH* share_ = nullptr;
+    std::mutex share_locks_[CURL_LOCK_DATA_LAST];
+
+    std::mutex idle_mutex_;
+    std::vector<CURL*> idle_;
+};
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_CURLPOOL_HPP
@@ -0,0 +1,262 @@
+/**
+ * @file DecisionCache.cpp
+ * @brief Implementation of the network-prefix decision cache
+ */
+
+#include "DecisionCache.hpp"
+#include "SanctionsPolicy.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace SpectreMap::Compliance {
+
+namespace {
+
+// Shortest stored prefixes; the bits above them pick the shard
+constexpr int MIN_V4_PREFIX = 16;
+constexpr int MIN_V6_PREFIX = 32;
+
+struct PrefixKey {
+    Uint128 network;
+    uint8_t length = 0;
+    bool is_v4 = false;
+
+    bool operator==(const PrefixKey&) const = default;
+};
+
+inline uint64_t mix(uint64_t value) noexcept {
+    // splitmix64 finalizer
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+struct PrefixKeyHash {
+    size_t operator()(const PrefixKey& key) const noexcept {
+        return static_cast<size_t>(mix(key.network.hi ^
+                                       mix(key.network.lo ^ (uint64_t{key.length} << 1 | key.is_v4))));
+    }
+};
+
+inline int addressWidth(bool is_v4) noexcept {
+    return is_v4 ? 32 : 128;
+}
+
+inline Uint128 networkOf(const DecisionCache::Address& address, int length) noexcept {
+    if (length <= 0) return Uint128();
+    const int width = addressWidth(address.is_v4);
+    const Uint128 mask = Uint128::max() << (width - length);
+    return address.bits & mask & (address.is_v4 ? Uint128(UINT32_MAX) : Uint128::max());
+}
+
+} // namespace
+
+// ============================================================================
+// Shard Layout
+// ============================================================================
+
+struct DecisionCache::Shard {
+    struct Slot {
+        PrefixKey key;
+        RestrictionResult result;
+        Clock::time_point expires{};
+        uint64_t generation = 0;
+        const SanctionsPolicy* policy = nullptr;   ///< Policy the decision was made under
+        std::atomic<bool> referenced{false};       ///< CLOCK reference bit, set by readers
+
+        bool current(Clock::time_point now, uint64_t gen, const SanctionsPolicy* active) const noexcept {
+            return expires > now && generation == gen && policy == active;
+        }
+    };
+
+    // Readers share the lock; only insert/evict take it exclusively
+    mutable std::shared_mutex mutex;
+    std::unordered_map<PrefixKey, size_t, PrefixKeyHash> index;
+    std::unique_ptr<Slot[]> slots;
+    size_t capacity = 0;
+    size_t hand = 0;
+    size_t used = 0;
+
+    // Entries per prefix length, so lookups skip lengths with nothing stored
+    std::array<uint32_t, 33> v4_lengths{};
+    std::array<uint32_t, 129> v6_lengths{};
+
+    alignas(64) std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> stale{0};
+    std::atomic<uint64_t> insertions{0};
+    std::atomic<uint64_t> evictions{0};
+
+    uint32_t& lengthCount(const PrefixKey& key) {
+        return key.is_v4 ? v4_lengths[key.length] : v6_lengths[key.length];
+    }
+
+    void release(size_t slot_index) {
+        const PrefixKey& key = slots[slot_index].key;
+        index.erase(key);
+        --lengthCount(key);
+    }
+
+    /**
+     * @brief Pick a slot for a new key (caller holds the exclusive lock)
+     */
+    size_t claimSlot(Clock::time_point now, uint64_t gen, const SanctionsPolicy* active) {
+        if (used < capacity) {
+            return used++;
+        }
+        // CLOCK sweep: stale slots are taken immediately, referenced ones get
+        // a second chance. Two full turns guarantee a victim.
+        for (size_t step = 0; step < capacity * 2; ++step) {
+            Slot& slot = slots[hand];
+            const size_t candidate = hand;
+            hand = (hand + 1) % capacity;
+            if (!slot.current(now, gen, active)) {
+                release(candidate);
+                return candidate;
+            }
+            if (!slot.referenced.exchange(false, std::memory_order_relaxed)) {
+                release(candidate);
+                evictions.fetch_add(1, std::memory_order_relaxed);
+                return candidate;
+            }
+        }
+        const size_t candidate = hand;
+        hand = (hand + 1) % capacity;
+        release(candidate);
+        evictions.fetch_add(1, std::memory_order_relaxed);
+        return candidate;
+    }
+};
+
+// ============================================================================
+// DecisionCache
+// ============================================================================
+
+DecisionCache::DecisionCache(const DecisionCacheConfig& config) : config_(config) {
+    const size_t shard_count = std::bit_ceil(std::max<size_t>(config_.shard_count, 1));
+    const size_t max_entries = std::max(config_.max_entries, shard_count);
+
+    shard_mask_ = shard_count - 1;
+    shards_ = std::make_unique<Shard[]>(shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_[i].capacity = (max_entries + shard_count - 1) / shard_count;
+        shards_[i].slots = std::make_unique<Shard::Slot[]>(shards_[i].capacity);
+        shards_[i].index.reserve(shards_[i].capacity);
+    }
+}
+
+DecisionCache::~DecisionCache() = default;
+
+DecisionCache::Shard& DecisionCache::shardFor(const Address& address) const {
+    const uint64_t top = address.is_v4 ? (address.bits >> (32 - MIN_V4_PREFIX)).lo
+                                       : (address.bits >> (128 - MIN_V6_PREFIX)).lo;
+    return shards_[mix(top << 1 | address.is_v4) & shard_mask_];
+}
+
+bool DecisionCache::lookup(const Address& address, RestrictionResult& result) {
+    Shard& shard = shardFor(address);
+    const auto now = Clock::now();
+    const uint64_t gen = generation_.load(std::memory_order_acquire);
+    const SanctionsPolicy* active = &SanctionsPolicy::current();
+
+    const int width = addressWidth(address.is_v4);
+    const int shortest = address.is_v4 ? MIN_V4_PREFIX : MIN_V6_PREFIX;
+    bool saw_stale = false;
+
+    std::shared_lock lock(shard.mutex);
+    const uint32_t* counts = address.is_v4 ? shard.v4_lengths.data() : shard.v6_lengths.data();
+    for (int length = width; length >= shortest; --length) {
+        if (counts[length] == 0) continue;
+        auto it = shard.index.find(PrefixKey{networkOf(address, length), static_cast<uint8_t>(length),
+                                             address.is_v4});
+        if (it == shard.index.end()) continue;
+
+        Shard::Slot& slot = shard.slots[it->second];
+        if (!slot.current(now, gen, active)) {
+            // A shorter, current network may still cover the address
+            saw_stale = true;
+            continue;
+        }
+        slot.referenced.store(true, std::memory_order_relaxed);
+        shard.hits.fetch_add(1, std::memory_order_relaxed);
+        result = slot.result;
+        return true;
+    }
+
+    shard.misses.fetch_add(1, std::memory_order_relaxed);
+    if (saw_stale) shard.stale.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+DecisionCache::Epoch DecisionCache::epoch() const noexcept {
+    return Epoch{generation_.load(std::memory_order_acquire), &SanctionsPolicy::current()};
+}
+
+void DecisionCache::insert(const Address& address, std::optional<uint8_t> prefix_length,
+                           const RestrictionResult& result, const Epoch& decided) {
+    const int width = addressWidth(address.is_v4);
+    const int shortest = address.is_v4 ? MIN_V4_PREFIX : MIN_V6_PREFIX;
+    const int fallback = address.is_v4 ? config_.default_ipv4_prefix : config_.default_ipv6_prefix;
+    // Storing a shorter network at a longer length only narrows what it covers
+    const int length = std::clamp<int>(prefix_length.value_or(fallback), shortest, width);
+    const PrefixKey key{networkOf(address, length), static_cast<uint8_t>(length), address.is_v4};
+
+    Shard& shard = shardFor(address);
+    const auto now = Clock::now();
+    const uint64_t gen = generation_.load(std::memory_order_acquire);
+    const SanctionsPolicy* active = &SanctionsPolicy::current();
+    if (decided.generation != gen || decided.policy != active) {
+        return;   // Decided under settings that have since changed
+    }
+    std::unique_lock lock(shard.mutex);
+
+    size_t slot_index;
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        slot_index = it->second;
+    } else {
+        slot_index = shard.claimSlot(now, gen, active);
+        shard.index.emplace(key, slot_index);
+        ++shard.lengthCount(key);
+    }
+
+    Shard::Slot& slot = shard.slots[slot_index];
+    slot.key = key;
+    slot.result = result;
+    slot.expires = now + config_.ttl;
+    // A change racing this insert still leaves the entry stale
+    slot.generation = decided.generation;
+    slot.policy = decided.policy;
+    slot.referenced.store(false, std::memory_order_relaxed);
+    shard.insertions.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DecisionCache::invalidate() noexcept {
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    invalidations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+DecisionCacheStats DecisionCache::stats() const {
+    DecisionCacheStats total;
+    for (size_t i = 0; i <= shard_mask_; ++i) {
+        const Shard& shard = shards_[i];
+        total.hits += shard.hits.load(std::memory_order_relaxed);
+        total.misses += shard.misses.load(std::memory_order_relaxed);
+        total.stale += shard.stale.load(std::memory_order_relaxed);
+        total.insertions += shard.insertions.load(std::memory_order_relaxed);
+        total.evictions += shard.evictions.load(std::memory_order_relaxed);
+
+        std::shared_lock lock(shard.mutex);
+        total.entries += shard.index.size();
+    }
+    total.invalidations = invalidations_.load(std::memory_order_relaxed);
+    return total;
+}
+
+} // namespace SpectreMap::Compliance
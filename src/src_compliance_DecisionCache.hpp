@@ -0,0 +1,111 @@
+/**
+ * @file DecisionCache.hpp
+ * @brief Access decisions cached per network prefix with longest-prefix match
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * Scans and flow captures hit many neighbouring addresses in one allocated
+ * block. Keying decisions on the containing network lets every address in
+ * the block reuse a single lookup. Each shard keeps one hash table keyed by
+ * (network, prefix length) plus a count of entries per length, so a lookup
+ * probes only the lengths actually present, longest first.
+ *
+ * Shards are chosen by the address bits above the shortest stored prefix
+ * (/16 for IPv4, /32 for IPv6; shorter networks are stored at that length),
+ * so every candidate prefix of an address lives in one shard and a lookup
+ * takes a single shared lock.
+ *
+ * Entries record the sanctions policy and cache generation they were
+ * decided under. A policy reload (from any source) or invalidate() makes
+ * them stale without touching the tables. Callers take an epoch() before
+ * deciding and pass it to insert(), so a decision made while either changed
+ * is dropped rather than stored as current.
+ */
+
+#ifndef SPECTREMAP_DECISIONCACHE_HPP
+#define SPECTREMAP_DECISIONCACHE_HPP
+
+#include "GeoRestriction.hpp"
+#include "IpAddress.hpp"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+
+namespace SpectreMap::Compliance {
+
+class SanctionsPolicy;
+
+/**
+ * @brief Concurrent longest-prefix-match cache of restriction results
+ */
+class DecisionCache {
+public:
+    /**
+     * @brief Parsed address; IPv4-mapped IPv6 is treated as IPv4
+     */
+    struct Address {
+        Uint128 bits;   ///< IPv4 in the low 32 bits
+        bool is_v4 = false;
+    };
+
+    /**
+     * @brief Policy and generation a decision is made under
+     */
+    struct Epoch {
+        uint64_t generation = 0;
+        const SanctionsPolicy* policy = nullptr;
+    };
+
+    explicit DecisionCache(const DecisionCacheConfig& config);
+    ~DecisionCache();
+
+    DecisionCache(const DecisionCache&) = delete;
+    DecisionCache& operator=(const DecisionCache&) = delete;
+
+    static Address from(const IpAddress& address) noexcept {
+        return address.isV4() ? Address{.bits = address.v4(), .is_v4 = true}
+                              : Address{.bits = address.bits(), .is_v4 = false};
+    }
+
+    /**
+     * @brief Find the decision for the longest cached network containing an address
+     * @param result Receives the cached decision on a hit
+     */
+    bool lookup(const Address& address, RestrictionResult& result);
+
+    /**
+     * @brief Epoch to pass to insert(); take it before deciding
+     */
+    Epoch epoch() const noexcept;
+
+    /**
+     * @brief Cache a decision for the network containing an address
+     * @param prefix_length Network length from the lookup source; nullopt uses the configured default
+     * @param decided Epoch taken before the decision; ignored if no longer current
+     */
+    void insert(const Address& address, std::optional<uint8_t> prefix_length, const RestrictionResult& result,
+                const Epoch& decided);
+
+    /**
+     * @brief Make every cached decision stale (strict mode or lookup source changed)
+     */
+    void invalidate() noexcept;
+
+    DecisionCacheStats stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    struct Shard;
+
+    Shard& shardFor(const Address& address) const;
+
+    DecisionCacheConfig config_;
+    size_t shard_mask_ = 0;
+    std::unique_ptr<Shard[]> shards_;
+    std::atomic<uint64_t> generation_{0};
+    std::atomic<uint64_t> invalidations_{0};
+};
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_DECISIONCACHE_HPP
@@ -0,0 +1,227 @@
+/**
+ * @file GeoCache.cpp
+ * @brief Implementation of the sharded GeoIP result cache
+ */
+
+#include "GeoCache.hpp"
+#include "PersistentGeoCache.hpp"
+#include <algorithm>
+#include <bit>
+#include <mutex>
+#include <optional>
+
+namespace SpectreMap::Compliance {
+
+// ============================================================================
+// Shard Layout
+// ============================================================================
+
+struct GeoCache::Shard {
+    struct Slot {
+        std::string key;
+        std::optional<GeoLocation> location;   ///< nullopt marks a negative entry
+        Clock::time_point expires{};
+        std::atomic<bool> referenced{false};   ///< CLOCK reference bit, set by readers
+    };
+
+    // Readers share the lock; only insert/evict/clear take it exclusively
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, size_t> index;
+    std::unique_ptr<Slot[]> slots;
+    size_t capacity = 0;
+    size_t hand = 0;
+    size_t used = 0;
+
+    // Counters are per shard so hits on different shards don't share a cache line
+    alignas(64) std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> negative_hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> persistent_hits{0};
+    std::atomic<uint64_t> expirations{0};
+    std::atomic<uint64_t> insertions{0};
+    std::atomic<uint64_t> evictions{0};
+
+    /**
+     * @brief Pick a slot for a new key (caller holds the exclusive lock)
+     */
+    size_t claimSlot(Clock::time_point now) {
+        if (used < capacity) {
+            return used++;
+        }
+        // CLOCK sweep: expired slots are taken immediately, referenced ones get
+        // a second chance. Two full turns guarantee a victim.
+        for (size_t step = 0; step < capacity * 2; ++step) {
+            Slot& slot = slots[hand];
+            const size_t candidate = hand;
+            hand = (hand + 1) % capacity;
+            if (slot.expires <= now) {
+                index.erase(slot.key);
+                return candidate;
+            }
+            if (!slot.referenced.exchange(false, std::memory_order_relaxed)) {
+                index.erase(slot.key);
+                evictions.fetch_add(1, std::memory_order_relaxed);
+                return candidate;
+            }
+        }
+        const size_t candidate = hand;
+        hand = (hand + 1) % capacity;
+        index.erase(slots[candidate].key);
+        evictions.fetch_add(1, std::memory_order_relaxed);
+        return candidate;
+    }
+};
+
+// ============================================================================
+// GeoCache
+// ============================================================================
+
+GeoCache::GeoCache(const GeoCacheConfig& config) : config_(config) {
+    const size_t shard_count = std::bit_ceil(std::max<size_t>(config_.shard_count, 1));
+    const size_t max_entries = std::max(config_.max_entries, shard_count);
+
+    shard_mask_ = shard_count - 1;
+    shards_ = std::make_unique<Shard[]>(shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_[i].capacity = (max_entries + shard_count - 1) / shard_count;
+        shards_[i].slots = std::make_unique<Shard::Slot[]>(shards_[i].capacity);
+        shards_[i].index.reserve(shards_[i].capacity);
+    }
+    if (!config_.persistent_path.empty()) {
+        persistent_ = PersistentGeoCache::open(config_.persistent_path, config_.persistent_entries);
+    }
+}
+
+GeoCache::~GeoCache() = default;
+
+GeoCache::Shard& GeoCache::shardFor(const std::string& key) const {
+    return shards_[std::hash<std::string>{}(key) & shard_mask_];
+}
+
+GeoCache::Status GeoCache::lookup(const std::string& key, GeoLocation& location) {
+    Shard& shard = shardFor(key);
+    bool expired = false;
+    {
+        std::shared_lock lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            Shard::Slot& slot = shard.slots[it->second];
+            // An expired slot is left in place; the CLOCK hand reclaims it on the next insert
+            expired = slot.expires <= Clock::now();
+            if (!expired) {
+                slot.referenced.store(true, std::memory_order_relaxed);
+                if (!slot.location) {
+                    shard.negative_hits.fetch_add(1, std::memory_order_relaxed);
+                    return Status::NEGATIVE_HIT;
+                }
+                shard.hits.fetch_add(1, std::memory_order_relaxed);
+                location = *slot.location;
+                return Status::HIT;
+            }
+        }
+    }
+
+    // Another process (or an earlier run) may have resolved it; promote the
+    // entry into memory for the rest of its lifetime
+    if (persistent_) {
+        if (auto entry = persistent_->lookup(key)) {
+            const auto remaining = std::chrono::duration_cast<Clock::duration>(
+                entry->expires - PersistentGeoCache::WallClock::now());
+            if (remaining > Clock::duration::zero()) {
+                store(key, entry->location ? &*entry->location : nullptr, remaining);
+            }
+            shard.persistent_hits.fetch_add(1, std::memory_order_relaxed);
+            if (!entry->location) {
+                shard.negative_hits.fetch_add(1, std::memory_order_relaxed);
+                return Status::NEGATIVE_HIT;
+            }
+            shard.hits.fetch_add(1, std::memory_order_relaxed);
+            location = std::move(*entry->location);
+            return Status::HIT;
+        }
+    }
+
+    shard.misses.fetch_add(1, std::memory_order_relaxed);
+    if (expired) {
+        shard.expirations.fetch_add(1, std::memory_order_relaxed);
+    }
+    return Status::MISS;
+}
+
+void GeoCache::insert(const std::string& key, const GeoLocation& location) {
+    store(key, &location, config_.ttl);
+    if (persistent_) {
+        persistent_->insert(key, &location, config_.ttl);
+    }
+}
+
+void GeoCache::insertNegative(const std::string& key) {
+    if (config_.negative_ttl.count() <= 0) return;
+    store(key, nullptr, config_.negative_ttl);
+    if (persistent_) {
+        persistent_->insert(key, nullptr, config_.negative_ttl);
+    }
+}
+
+void GeoCache::store(const std::string& key, const GeoLocation* location, Clock::duration ttl) {
+    Shard& shard = shardFor(key);
+    const auto now = Clock::now();
+    std::unique_lock lock(shard.mutex);
+
+    size_t slot_index;
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        slot_index = it->second;
+    } else {
+        slot_index = shard.claimSlot(now);
+        shard.index.emplace(key, slot_index);
+    }
+
+    Shard::Slot& slot = shard.slots[slot_index];
+    slot.key = key;
+    if (location) {
+        slot.location = *location;
+    } else {
+        slot.location.reset();
+    }
+    slot.expires = now + ttl;
+    slot.referenced.store(false, std::memory_order_relaxed);
+    shard.insertions.fetch_add(1, std::memory_order_relaxed);
+}
+
+void GeoCache::clear() {
+    for (size_t i = 0; i <= shard_mask_; ++i) {
+        Shard& shard = shards_[i];
+        std::unique_lock lock(shard.mutex);
+        shard.index.clear();
+        for (size_t s = 0; s < shard.used; ++s) {
+            shard.slots[s].key.clear();
+            shard.slots[s].location.reset();
+        }
+        shard.used = 0;
+        shard.hand = 0;
+    }
+    if (persistent_) {
+        persistent_->clear();
+    }
+}
+
+GeoCacheStats GeoCache::stats() const {
+    GeoCacheStats total;
+    for (size_t i = 0; i <= shard_mask_; ++i) {
+        const Shard& shard = shards_[i];
+        total.hits += shard.hits.load(std::memory_order_relaxed);
+        total.negative_hits += shard.negative_hits.load(std::memory_order_relaxed);
+        total.misses += shard.misses.load(std::memory_order_relaxed);
+        total.persistent_hits += shard.persistent_hits.load(std::memory_order_relaxed);
+        total.expirations += shard.expirations.load(std::memory_order_relaxed);
+        total.insertions += shard.insertions.load(std::memory_order_relaxed);
+        total.evictions += shard.evictions.load(std::memory_order_relaxed);
+
+        std::shared_lock lock(shard.mutex);
+        total.entries += shard.index.size();
+    }
+    return total;
+}
+
+} // namespace SpectreMap::Compliance
@@ -0,0 +1,78 @@
+/**
+ * @file GeoCache.hpp
+ * @brief Sharded, TTL-bounded cache of GeoIP lookup results
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * Keys are normalized IP addresses. Each shard owns a fixed slot array
+ * evicted with the CLOCK algorithm, so memory stays bounded and readers
+ * of different shards never contend. Failed lookups are cached as
+ * short-lived negative entries to keep a bad address from hammering the
+ * GeoIP provider.
+ *
+ * With GeoCacheConfig::persistent_path set, the in-memory shards sit in
+ * front of a PersistentGeoCache file: misses fall through to it, hits from
+ * it are promoted into memory, and every insert is written through, so
+ * other processes and later runs start warm.
+ */
+
+#ifndef SPECTREMAP_GEOCACHE_HPP
+#define SPECTREMAP_GEOCACHE_HPP
+
+#include "GeoRestriction.hpp"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace SpectreMap::Compliance {
+
+class PersistentGeoCache;
+
+/**
+ * @brief Concurrent GeoLocation cache with positive and negative entries
+ */
+class GeoCache {
+public:
+    enum class Status {
+        MISS,           ///< Not cached (or expired) - caller must query
+        HIT,            ///< Cached location copied to the output
+        NEGATIVE_HIT    ///< Lookup recently failed - caller should not retry yet
+    };
+
+    explicit GeoCache(const GeoCacheConfig& config);
+    ~GeoCache();
+
+    GeoCache(const GeoCache&) = delete;
+    GeoCache& operator=(const GeoCache&) = delete;
+
+    /**
+     * @brief Look up an address
+     * @param key Canonical address text (IpAddress::toString)
+     * @param location Receives the cached location on HIT
+     */
+    Status lookup(const std::string& key, GeoLocation& location);
+
+    void insert(const std::string& key, const GeoLocation& location);
+    void insertNegative(const std::string& key);
+    void clear();
+
+    GeoCacheStats stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    struct Shard;
+
+    Shard& shardFor(const std::string& key) const;
+    void store(const std::string& key, const GeoLocation* location, Clock::duration ttl);
+
+    GeoCacheConfig config_;
+    size_t shard_mask_ = 0;
+    std::unique_ptr<Shard[]> shards_;
+    std::unique_ptr<PersistentGeoCache> persistent_;   ///< nullptr: memory only
+};
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_GEOCACHE_HPP
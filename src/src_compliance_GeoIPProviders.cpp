@@ -0,0 +1,780 @@
+/**
+ * @file GeoIPProviders.cpp
+ * @brief Implementation of GeoIP provider failover, hedging and circuit breaking
+ */
+
+#include "GeoIPProviders.hpp"
+#include "CurlPool.hpp"
+#include "GeoIPReactor.hpp"
+#include "GeoIPResponse.hpp"
+#include "ComplianceMetrics.hpp"
+#include "../core/Logger.hpp"
+#include <curl/curl.h>
+#include <algorithm>
+#include <climits>
+#include <utility>
+
+namespace SpectreMap::Compliance {
+
+namespace {
+
+// A hedge is only started while fewer requests than this are outstanding
+constexpr size_t MAX_IN_FLIGHT = 2;
+
+size_t appendBody(void* contents, size_t size, size_t nmemb, std::string* body) {
+    body->append(static_cast<char*>(contents), size * nmemb);
+    return size * nmemb;
+}
+
+/**
+ * @brief Per-thread multi handle for racing blocking lookups
+ */
+CURLM* threadMulti() {
+    struct Holder {
+        CURLM* multi = curl_multi_init();
+        ~Holder() {
+            if (multi) curl_multi_cleanup(multi);
+        }
+    };
+    thread_local Holder holder;
+    return holder.multi;
+}
+
+/**
+ * @brief Whether a request still outstanding at the race deadline counts as a failure
+ *
+ * One that has run past its provider's hedge delay was slow; a hedge started
+ * just before the deadline merely ran out of time and is abandoned instead.
+ */
+bool timedOut(const ProviderHealth& health, ProviderHealth::Clock::duration running) {
+    return running >= health.hedgeDelay();
+}
+
+} // namespace
+
+// ============================================================================
+// Provider Health
+// ============================================================================
+
+bool ProviderHealth::tryAcquire(Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    switch (state_) {
+        case State::CLOSED:
+            break;
+        case State::OPEN:
+            if (now < open_until_) return false;
+            state_ = State::HALF_OPEN;   // This request is the probe
+            break;
+        case State::HALF_OPEN:
+            return false;                // Probe still outstanding
+    }
+    ++requests_;
+    return true;
+}
+
+void ProviderHealth::recordSuccess(Clock::duration latency, bool sample_latency) {
+    std::lock_guard lock(mutex_);
+    ++successes_;
+    consecutive_failures_ = 0;
+    state_ = State::CLOSED;
+    if (!sample_latency) return;
+
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+    latencies_us_[samples_ % LATENCY_WINDOW] = static_cast<uint32_t>(std::clamp<int64_t>(us, 0, UINT32_MAX));
+    ++samples_;
+
+    const size_t count = std::min(samples_, LATENCY_WINDOW);
+    if (count < MIN_SAMPLES) return;
+    std::array<uint32_t, LATENCY_WINDOW> sorted;
+    std::copy_n(latencies_us_.begin(), count, sorted.begin());
+    const size_t rank = (count * 95 + 99) / 100 - 1;
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.begin() + count);
+    p95_ = std::chrono::microseconds(sorted[rank]);
+}
+
+void ProviderHealth::recordFailure(Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    ++failures_;
+    ++consecutive_failures_;
+    if (state_ == State::HALF_OPEN ||
+        (state_ == State::CLOSED && consecutive_failures_ >= config_.breaker_failure_threshold)) {
+        open(now);
+    }
+}
+
+void ProviderHealth::recordAbandoned(Clock::time_point now, bool sent) {
+    std::lock_guard lock(mutex_);
+    if (!sent && requests_ > 0) --requests_;
+    if (state_ == State::HALF_OPEN) {
+        // The probe told us nothing; let the next request probe again
+        state_ = State::OPEN;
+        open_until_ = now;
+    }
+}
+
+void ProviderHealth::recordHedge() {
+    std::lock_guard lock(mutex_);
+    ++hedges_;
+}
+
+void ProviderHealth::recordHedgeWin() {
+    std::lock_guard lock(mutex_);
+    ++hedge_wins_;
+}
+
+ProviderHealth::Clock::duration ProviderHealth::hedgeDelay() const {
+    std::lock_guard lock(mutex_);
+    if (samples_ < MIN_SAMPLES) return config_.initial_hedge_delay;
+    return std::max<Clock::duration>(p95_, config_.min_hedge_delay);
+}
+
+void ProviderHealth::addTo(GeoIPProviderStats& stats) const {
+    std::lock_guard lock(mutex_);
+    stats.requests = requests_;
+    stats.successes = successes_;
+    stats.failures = failures_;
+    stats.hedges = hedges_;
+    stats.hedge_wins = hedge_wins_;
+    stats.circuit_opens = circuit_opens_;
+    stats.circuit_open = state_ != State::CLOSED;
+    stats.p95_latency = std::chrono::duration_cast<std::chrono::microseconds>(p95_);
+}
+
+void ProviderHealth::open(Clock::time_point now) {
+    state_ = State::OPEN;
+    open_until_ = now + config_.breaker_open_time;
+    ++circuit_opens_;
+}
+
+// ============================================================================
+// Provider Set
+// ============================================================================
+
+GeoIPProviderSet::GeoIPProviderSet(std::vector<GeoIPProvider> providers, const GeoIPFailoverConfig& config)
+    : providers_(std::move(providers)), config_(config), queue_(config.max_queued_lookups) {
+    health_.reserve(providers_.size());
+    rates_.reserve(providers_.size());
+    batch_rates_.reserve(providers_.size());
+    for (const GeoIPProvider& provider : providers_) {
+        health_.push_back(std::make_unique<ProviderHealth>(config_));
+        rates_.push_back(std::make_unique<ProviderRateLimit>(provider.requests_per_minute));
+        batch_rates_.push_back(std::make_unique<ProviderRateLimit>(provider.batch_requests_per_minute));
+        has_offline_ = has_offline_ || provider.type == GeoIPProviderType::OFFLINE_DATABASE;
+    }
+}
+
+GeoIPProviderSet::~GeoIPProviderSet() = default;
+
+std::string GeoIPProviderSet::lookupUrl(size_t index, const std::string& ip_address) const {
+    return providers_[index].lookup_url + ip_address + "?fields=" + GEOIP_FIELDS;
+}
+
+std::vector<RateLimitQueue::Candidate> GeoIPProviderSet::candidates(const std::vector<size_t>& indices) const {
+    std::vector<RateLimitQueue::Candidate> result;
+    result.reserve(indices.size());
+    for (size_t index : indices) {
+        result.push_back({index, rates_[index].get()});
+    }
+    return result;
+}
+
+void GeoIPProviderSet::observe(ProviderRateLimit& limit, const GeoIPRateHeaders& rate) {
+    if (limit.observe(rate, Clock::now())) {
+        queue_.wake();
+    }
+}
+
+std::optional<GeoLocation> GeoIPProviderSet::lookup(const std::string& ip_address, CurlPool& pool,
+                                                    const OfflineLookup& offline, LookupPriority priority) {
+    struct Attempt {
+        size_t provider = 0;
+        bool hedge = false;
+        Clock::time_point started;
+        CurlPool::Lease lease;
+    };
+    // Reused per thread, so steady-state lookups don't allocate body buffers
+    thread_local std::array<std::string, MAX_IN_FLIGHT> bodies;
+    thread_local std::array<GeoIPRateHeaders, MAX_IN_FLIGHT> rate_headers;
+    std::array<std::optional<Attempt>, MAX_IN_FLIGHT> slots;
+
+    CURLM* multi = threadMulti();
+    const auto start = Clock::now();
+    const auto deadline = start + pool.config().total_timeout;
+    size_t cursor = 0;
+    size_t active = 0;
+    auto hedge_at = Clock::time_point::max();
+    std::optional<GeoLocation> answer;
+    bool decided = false;
+    std::vector<size_t> limited;       // Admitted, but out of tokens
+    std::optional<size_t> granted;     // Provider whose token the queue took for us
+
+    // Start the next admitted provider; an offline entry answers inline
+    auto launchNext = [&](Clock::time_point now, bool hedge) {
+        while (cursor < providers_.size()) {
+            const size_t index = cursor;
+            if (providers_[index].type == GeoIPProviderType::OFFLINE_DATABASE) {
+                if (hedge) return;   // Reached by failover only
+                ++cursor;
+                if ((answer = offline(ip_address))) {
+                    decided = true;
+                    return;
+                }
+                continue;
+            }
+            ++cursor;
+            const bool has_token = std::exchange(granted, std::nullopt) == index;
+            ProviderHealth& health = *health_[index];
+            if (!health.tryAcquire(now)) continue;
+            if (!has_token && !rates_[index]->tryTake(now)) {
+                health.recordAbandoned(now, false);
+                limited.push_back(index);
+                continue;
+            }
+
+            auto lease = multi ? pool.acquire() : CurlPool::Lease();
+            if (!lease) {
+                health.recordAbandoned(now, false);
+                ComplianceMetrics::recordFailure(LookupFailure::CURL_ERROR);
+                continue;
+            }
+            const size_t slot = slots[0] ? 1 : 0;
+            std::string& body = bodies[slot];
+            body.clear();
+            body.reserve(GEOIP_RESPONSE_RESERVE);
+            rate_headers[slot].clear();
+            const std::string url = lookupUrl(index, ip_address);
+
+            CURL* curl = lease.get();
+            curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, appendBody);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body);
+            curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, captureRateHeaders);
+            curl_easy_setopt(curl, CURLOPT_HEADERDATA, &rate_headers[slot]);
+            curl_multi_add_handle(multi, curl);
+            slots[slot] = Attempt{index, hedge, now, std::move(lease)};
+            ++active;
+
+            if (hedge) health.recordHedge();
+            hedge_at = config_.hedge ? now + health.hedgeDelay() : Clock::time_point::max();
+            return;
+        }
+    };
+
+    auto release = [&](size_t slot) {
+        curl_multi_remove_handle(multi, slots[slot]->lease.get());
+        slots[slot].reset();   // Returns the handle to the pool
+        --active;
+    };
+
+    launchNext(start, false);
+    while (!decided) {
+        auto now = Clock::now();
+        if (active == 0) {
+            if (cursor < providers_.size()) {
+                launchNext(now, false);
+                continue;
+            }
+            if (limited.empty()) break;
+            // Every admitted provider's budget is spent: wait for a token rather than fail
+            granted = queue_.waitFor(candidates(limited), priority, deadline);
+            limited.clear();
+            if (!granted) {
+                ComplianceMetrics::recordFailure(LookupFailure::RATE_LIMITED);
+                Logger::warning("GeoIP rate limit reached for " + ip_address + " - no provider budget in time");
+                break;
+            }
+            cursor = *granted;
+            continue;
+        }
+        if (now >= deadline) break;
+        if (active < MAX_IN_FLIGHT && now >= hedge_at) {
+            hedge_at = Clock::time_point::max();
+            launchNext(now, true);
+            continue;
+        }
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+        int remaining = 0;
+        while (!decided) {
+            CURLMsg* msg = curl_multi_info_read(multi, &remaining);
+            if (!msg) break;
+            if (msg->msg != CURLMSG_DONE) continue;
+            const size_t slot = (slots[0] && slots[0]->lease.get() == msg->easy_handle) ? 0 : 1;
+            if (!slots[slot] || slots[slot]->lease.get() != msg->easy_handle) continue;
+
+            const CURLcode result = msg->data.result;
+            long http_status = 0;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &http_status);
+            const size_t index = slots[slot]->provider;
+            const bool hedge = slots[slot]->hedge;
+            now = Clock::now();
+            const auto latency = now - slots[slot]->started;
+            release(slot);
+            ComplianceMetrics::recordStage(CheckStage::LOOKUP, latency);
+            rate_headers[slot].throttled = http_status == 429;
+            observe(*rates_[index], rate_headers[slot]);
+
+            ProviderHealth& health = *health_[index];
+            if (result == CURLE_OK && http_status == 200) {
+                bool malformed = false;
+                {
+                    StageTimer timer(CheckStage::PARSE);
+                    answer = parseGeoIPResponse(bodies[slot], ip_address, &malformed);
+                }
+                if (!malformed) {
+                    // A provider-reported failure is an answer too, and final
+                    health.recordSuccess(latency);
+                    if (hedge) health.recordHedgeWin();
+                    decided = true;
+                    break;
+                }
+            } else {
+                ComplianceMetrics::recordFailure(result != CURLE_OK ? LookupFailure::CURL_ERROR
+                                                                    : LookupFailure::HTTP_STATUS);
+                Logger::warning("GeoIP query to " + providers_[index].name + " failed for " + ip_address);
+            }
+            health.recordFailure(now);
+            // Fail over now rather than at the hedge delay
+            launchNext(now, false);
+        }
+        if (decided || active == 0) continue;
+
+        now = Clock::now();
+        const auto wake = (active < MAX_IN_FLIGHT) ? std::min(deadline, hedge_at) : deadline;
+        const auto wait = std::chrono::ceil<std::chrono::milliseconds>(wake - now).count();
+        curl_multi_poll(multi, nullptr, 0, static_cast<int>(std::clamp<int64_t>(wait, 0, INT_MAX)), nullptr);
+    }
+
+    // Whatever is still outstanding lost the race or ran out of time
+    const auto now = Clock::now();
+    bool timed_out = false;
+    for (size_t slot = 0; slot < MAX_IN_FLIGHT; ++slot) {
+        if (!slots[slot]) continue;
+        ProviderHealth& health = *health_[slots[slot]->provider];
+        if (!decided && timedOut(health, now - slots[slot]->started)) {
+            health.recordFailure(now);
+            timed_out = true;
+        } else {
+            health.recordAbandoned(now, true);
+        }
+        release(slot);
+    }
+    if (!decided) {
+        if (timed_out) {
+            ComplianceMetrics::recordFailure(LookupFailure::CURL_ERROR);
+            Logger::warning("GeoIP query timed out for " + ip_address);
+        }
+        return std::nullopt;
+    }
+    return answer;
+}
+
+// ============================================================================
+// Asynchronous Race
+// ============================================================================
+
+/**
+ * @brief State of one asynchronous lookup, shared by its requests' completions
+ *
+ * Decisions are made under the mutex, but requests are submitted and the
+ * caller is completed after releasing it: the reactor may complete a
+ * request inline from submit().
+ *
+ * A race out of tokens waits in the rate limit queue with no request
+ * outstanding. The queue's grant submits from another thread, so the
+ * reactor's shutdown token (forwarded to abandon) fails the wait, and
+ * reactor_mutex keeps the shutdown from overtaking a grant's submit.
+ */
+struct GeoIPProviderSet::AsyncRace : std::enable_shared_from_this<AsyncRace> {
+    struct Attempt {
+        size_t provider = 0;
+        bool hedge = false;
+        bool settled = false;              ///< Completed, or given up
+        Clock::time_point start_at;
+        std::stop_source cancel;
+    };
+
+    struct Submission {
+        std::shared_ptr<Attempt> attempt;
+        std::string url;
+    };
+
+    /**
+     * @brief Forwards the caller's stop request to every outstanding request
+     */
+    struct StopForwarder {
+        std::weak_ptr<AsyncRace> race;
+
+        void operator()() const {
+            if (auto self = race.lock()) {
+                {
+                    std::lock_guard lock(self->mutex);
+                    for (auto& attempt : self->attempts) {
+                        if (!attempt->settled) attempt->cancel.request_stop();
+                    }
+                }
+                // Completes a queued race on this thread, so not under the mutex
+                self->abandon.request_stop();
+            }
+        }
+    };
+
+    /**
+     * @brief Fails a queued race once the reactor starts shutting down
+     */
+    struct ShutdownForwarder {
+        std::weak_ptr<AsyncRace> race;
+
+        void operator()() const {
+            if (auto self = race.lock()) {
+                {
+                    std::lock_guard lock(self->reactor_mutex);
+                    self->reactor_gone = true;
+                }
+                self->abandon.request_stop();
+            }
+        }
+    };
+
+    std::shared_ptr<GeoIPProviderSet> set;
+    // Not owned: later requests are submitted from this reactor's own
+    // completions, which all run before it is destroyed. Holding a reference
+    // could make the reactor thread release the last one and join itself.
+    GeoIPReactor* reactor = nullptr;
+    std::string ip;
+    Clock::time_point deadline;
+    std::stop_token stop;
+    OfflineLookup offline;
+    Completion on_complete;
+
+    std::mutex mutex;
+    size_t cursor = 0;
+    std::vector<std::shared_ptr<Attempt>> attempts;
+    std::vector<size_t> limited;               ///< Admitted, but out of tokens
+    std::optional<size_t> granted;             ///< Provider whose token the queue took for us
+    bool wait_for_token = false;               ///< advance() found only providers out of tokens
+    std::stop_source abandon;                  ///< Caller stop or reactor shutdown; fails a queued wait
+    std::mutex reactor_mutex;
+    bool reactor_gone = false;
+    std::optional<std::stop_callback<StopForwarder>> stop_forwarder;
+    std::optional<std::stop_callback<ShutdownForwarder>> shutdown_forwarder;
+
+    /**
+     * @brief Queue a request to the next admitted provider (caller holds the mutex)
+     * @return True if an offline entry answered instead
+     */
+    bool next(Clock::time_point start_at, bool hedge, std::vector<Submission>& out,
+              std::optional<GeoLocation>& answer) {
+        const auto now = Clock::now();
+        while (cursor < set->providers_.size()) {
+            const size_t index = cursor;
+            if (set->providers_[index].type == GeoIPProviderType::OFFLINE_DATABASE) {
+                if (hedge) return false;
+                ++cursor;
+                if ((answer = offline(ip))) return true;
+                continue;
+            }
+            ++cursor;
+            const bool has_token = std::exchange(granted, std::nullopt) == index;
+            ProviderHealth& health = *set->health_[index];
+            if (!health.tryAcquire(now)) continue;
+            if (!has_token && !set->rates_[index]->tryTake(now)) {
+                health.recordAbandoned(now, false);
+                limited.push_back(index);
+                continue;
+            }
+
+            auto attempt = std::make_shared<Attempt>();
+            attempt->provider = index;
+            attempt->hedge = hedge;
+            attempt->start_at = start_at;
+            attempts.push_back(attempt);
+            out.push_back(Submission{attempt, set->lookupUrl(index, ip)});
+            return false;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Start the next provider now and schedule its hedge (caller holds the mutex)
+     * @return True if the race is over (offline answer, or no provider left);
+     *         false with wait_for_token set if it must wait for a token
+     */
+    bool advance(std::vector<Submission>& out, std::optional<GeoLocation>& answer) {
+        const auto now = Clock::now();
+        const size_t queued = out.size();
+        if (next(now, false, out, answer)) return true;
+        if (out.size() == queued) {
+            if (limited.empty()) return true;
+            wait_for_token = true;
+            return false;
+        }
+
+        const size_t primary = out.back().attempt->provider;
+        const auto hedge_at = now + set->health_[primary]->hedgeDelay();
+        if (set->config_.hedge && hedge_at < deadline) {
+            next(hedge_at, true, out, answer);
+        }
+        return false;
+    }
+
+    /**
+     * @brief Mark a request finished or given up (caller holds the mutex)
+     * @return Whether it had been sent
+     */
+    bool settle(Attempt& attempt, Clock::time_point now) {
+        attempt.settled = true;
+        const bool sent = attempt.start_at <= now;
+        // Hedges are counted once sent: most are cancelled while still waiting
+        if (attempt.hedge && sent) set->health_[attempt.provider]->recordHedge();
+        return sent;
+    }
+
+    /**
+     * @brief Give up on every outstanding request (caller holds the mutex)
+     */
+    void abandonOthers(Clock::time_point now) {
+        for (auto& attempt : attempts) {
+            if (attempt->settled) continue;
+            set->health_[attempt->provider]->recordAbandoned(now, settle(*attempt, now));
+            attempt->cancel.request_stop();
+        }
+    }
+
+    void submit(std::vector<Submission>& submissions) {
+        for (Submission& submission : submissions) {
+            auto attempt = submission.attempt;
+            reactor->submit(std::move(submission.url), deadline, attempt->cancel.get_token(),
+                [self = shared_from_this(), attempt](std::optional<std::string> body,
+                                                     const GeoIPRateHeaders& rate) {
+                    self->complete(*attempt, std::move(body), rate);
+                },
+                attempt->start_at);
+        }
+    }
+
+    /**
+     * @brief Queue for a token from the providers passed over (caller doesn't hold the mutex)
+     */
+    void awaitToken() {
+        std::vector<RateLimitQueue::Candidate> candidates;
+        {
+            std::lock_guard lock(mutex);
+            candidates = set->candidates(limited);
+            limited.clear();
+        }
+        set->queue_.wait(std::move(candidates), LookupPriority::INTERACTIVE, deadline, abandon.get_token(),
+                         [self = shared_from_this()](std::optional<size_t> provider) {
+                             self->onGrant(provider);
+                         });
+    }
+
+    void onGrant(std::optional<size_t> provider) {
+        std::vector<Submission> out;
+        std::optional<GeoLocation> answer;
+        bool finished = false;
+        bool wait = false;
+        {
+            std::lock_guard lock(mutex);
+            if (!provider || abandon.stop_requested()) {
+                if (!provider && !abandon.stop_requested()) {
+                    ComplianceMetrics::recordFailure(LookupFailure::RATE_LIMITED);
+                    Logger::warning("GeoIP rate limit reached for " + ip + " - no provider budget in time");
+                }
+                finished = true;
+            } else {
+                cursor = *provider;
+                granted = provider;
+                finished = advance(out, answer);
+                wait = std::exchange(wait_for_token, false);
+            }
+        }
+
+        if (!out.empty()) {
+            std::unique_lock reactor_lock(reactor_mutex);
+            if (reactor_gone) {
+                reactor_lock.unlock();
+                std::lock_guard lock(mutex);
+                const auto now = Clock::now();
+                for (Submission& submission : out) {
+                    submission.attempt->settled = true;
+                    set->health_[submission.attempt->provider]->recordAbandoned(now, false);
+                }
+                finished = true;
+                wait = false;
+            } else {
+                submit(out);
+            }
+        }
+        if (finished) {
+            on_complete(std::move(answer));
+        } else if (wait) {
+            awaitToken();
+        }
+    }
+
+    void complete(Attempt& attempt, std::optional<std::string> body, const GeoIPRateHeaders& rate) {
+        std::vector<Submission> out;
+        std::optional<GeoLocation> answer;
+        bool finished = false;
+        bool wait = false;
+        {
+            std::lock_guard lock(mutex);
+            if (attempt.settled) return;
+            const auto now = Clock::now();
+            const bool sent = settle(attempt, now);
+
+            const auto latency = now - attempt.start_at;
+            ProviderHealth& health = *set->health_[attempt.provider];
+            set->observe(*set->rates_[attempt.provider], rate);
+
+            if (stop.stop_requested()) {
+                health.recordAbandoned(now, true);
+                abandonOthers(now);
+                finished = true;
+            } else if (body) {
+                ComplianceMetrics::recordStage(CheckStage::LOOKUP, latency);
+                bool malformed = false;
+                {
+                    StageTimer timer(CheckStage::PARSE);
+                    answer = parseGeoIPResponse(*body, ip, &malformed);
+                }
+                if (!malformed) {
+                    health.recordSuccess(latency);
+                    if (attempt.hedge) health.recordHedgeWin();
+                    abandonOthers(now);
+                    finished = true;
+                }
+            } else {
+                ComplianceMetrics::recordFailure(LookupFailure::CURL_ERROR);
+            }
+
+            if (!finished) {
+                if (!body && (!sent || (now >= deadline && !timedOut(health, latency)))) {
+                    health.recordAbandoned(now, sent);
+                } else {
+                    health.recordFailure(now);
+                }
+
+                // A hedge still waiting to start is replaced by an immediate request
+                std::shared_ptr<Attempt> waiting;
+                bool in_flight = false;
+                for (auto& other : attempts) {
+                    if (other->settled) continue;
+                    if (other->start_at > now) waiting = other;
+                    else in_flight = true;
+                }
+                if (waiting) {
+                    set->health_[waiting->provider]->recordAbandoned(now, settle(*waiting, now));
+                    waiting->cancel.request_stop();
+                    cursor = waiting->provider;
+                }
+                if (!in_flight && now < deadline) {
+                    finished = advance(out, answer);
+                    wait = std::exchange(wait_for_token, false);
+                } else if (!in_flight) {
+                    finished = true;
+                }
+                if (finished) {
+                    abandonOthers(now);
+                }
+            }
+        }
+
+        submit(out);
+        if (finished) {
+            on_complete(std::move(answer));
+        } else if (wait) {
+            awaitToken();
+        }
+    }
+};
+
+void GeoIPProviderSet::lookupAsync(const std::string& ip_address, std::shared_ptr<GeoIPReactor> reactor,
+                                   Clock::time_point deadline, std::stop_token stop, OfflineLookup offline,
+                                   Completion on_complete) {
+    auto race = std::make_shared<AsyncRace>();
+    race->set = shared_from_this();
+    race->reactor = reactor.get();
+    race->ip = ip_address;
+    race->deadline = deadline;
+    race->stop = stop;
+    race->offline = std::move(offline);
+    race->on_complete = std::move(on_complete);
+    if (stop.stop_possible()) {
+        race->stop_forwarder.emplace(stop, AsyncRace::StopForwarder{race});
+    }
+    race->shutdown_forwarder.emplace(reactor->shutdownToken(), AsyncRace::ShutdownForwarder{race});
+
+    std::vector<AsyncRace::Submission> out;
+    std::optional<GeoLocation> answer;
+    bool finished;
+    bool wait = false;
+    {
+        std::lock_guard lock(race->mutex);
+        finished = stop.stop_requested() || race->advance(out, answer);
+        wait = std::exchange(race->wait_for_token, false);
+        if (finished) {
+            race->abandonOthers(Clock::now());
+            out.clear();
+        }
+    }
+    race->submit(out);
+    if (finished) {
+        race->on_complete(std::move(answer));
+    } else if (wait) {
+        race->awaitToken();
+    }
+}
+
+// ============================================================================
+// Batches and Stats
+// ============================================================================
+
+std::optional<size_t> GeoIPProviderSet::acquireBatchProvider(Clock::time_point deadline, bool& rate_limited) {
+    rate_limited = false;
+    const auto now = Clock::now();
+    for (size_t index = 0; index < providers_.size(); ++index) {
+        const GeoIPProvider& provider = providers_[index];
+        // Keep the configured order: a preferred provider without a batch
+        // endpoint (or the offline database) means single lookups
+        if (provider.type == GeoIPProviderType::OFFLINE_DATABASE || provider.batch_url.empty()) {
+            return std::nullopt;
+        }
+        if (!health_[index]->tryAcquire(now)) {
+            continue;
+        }
+        if (batch_rates_[index]->tryTake(now) ||
+            queue_.waitFor({{index, batch_rates_[index].get()}}, LookupPriority::BULK, deadline)) {
+            return index;
+        }
+        health_[index]->recordAbandoned(Clock::now(), false);
+        ComplianceMetrics::recordFailure(LookupFailure::RATE_LIMITED);
+        rate_limited = true;
+        return std::nullopt;
+    }
+    return std::nullopt;
+}
+
+void GeoIPProviderSet::recordBatch(size_t index, bool answered, const GeoIPRateHeaders& rate) {
+    observe(*batch_rates_[index], rate);
+    if (answered) {
+        health_[index]->recordSuccess(Clock::duration::zero(), false);
+    } else {
+        health_[index]->recordFailure(Clock::now());
+    }
+}
+
+std::vector<GeoIPProviderStats> GeoIPProviderSet::stats() const {
+    std::vector<GeoIPProviderStats> result(providers_.size());
+    for (size_t index = 0; index < providers_.size(); ++index) {
+        result[index].name = providers_[index].name;
+        health_[index]->addTo(result[index]);
+        rates_[index]->addTo(result[index]);
+        batch_rates_[index]->addTo(result[index]);
+    }
+    return result;
+}
+
+} // namespace SpectreMap::Compliance
@@ -0,0 +1,195 @@
+/**
+ * @file GeoIPProviders.hpp
+ * @brief Ordered GeoIP providers with hedged requests and circuit breakers
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * A lookup asks the first provider whose circuit is closed. If no answer
+ * has arrived once that provider's recent p95 latency has passed, the next
+ * provider is asked too and the first answer wins; the loser is cancelled.
+ * A failed request fails over to the next provider immediately. Each
+ * provider keeps a circuit breaker: after a run of consecutive failures it
+ * is skipped for a while, then admitted again through a single probe.
+ *
+ * Blocking lookups race their requests on a per-thread curl_multi handle
+ * using pooled easy handles; asynchronous lookups run the same race on the
+ * GeoIPReactor, with hedges submitted as delayed requests.
+ *
+ * Every request spends a token from its provider's rate limit (see
+ * GeoIPRateLimit.hpp). A provider without one is passed over like an open
+ * circuit; when no provider is left, the lookup waits in the set's queue
+ * for the first token instead of failing.
+ */
+
+#ifndef SPECTREMAP_GEOIPPROVIDERS_HPP
+#define SPECTREMAP_GEOIPPROVIDERS_HPP
+
+#include "GeoRestriction.hpp"
+#include "GeoIPRateLimit.hpp"
+#include <array>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+namespace SpectreMap::Compliance {
+
+class CurlPool;
+class GeoIPReactor;
+
+/**
+ * @brief Circuit breaker and recent latency window of one provider
+ */
+class ProviderHealth {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ProviderHealth(const GeoIPFailoverConfig& config) : config_(config) {}
+
+    /**
+     * @brief Admit a request
+     *
+     * A closed circuit admits every request. An open one admits a single
+     * probe once breaker_open_time has passed; the probe's outcome closes
+     * or reopens it.
+     */
+    bool tryAcquire(Clock::time_point now);
+
+    /**
+     * @brief The provider answered
+     * @param sample_latency False for requests not comparable to single lookups (batches)
+     */
+    void recordSuccess(Clock::duration latency, bool sample_latency = true);
+    void recordFailure(Clock::time_point now);
+
+    /**
+     * @brief An admitted request was given up without an outcome (it lost a race)
+     * @param sent False if it was cancelled before being sent
+     */
+    void recordAbandoned(Clock::time_point now, bool sent);
+
+    void recordHedge();
+    void recordHedgeWin();
+
+    /**
+     * @brief How long to wait for this provider before hedging
+     */
+    Clock::duration hedgeDelay() const;
+
+    void addTo(GeoIPProviderStats& stats) const;
+
+private:
+    enum class State { CLOSED, OPEN, HALF_OPEN };
+
+    static constexpr size_t LATENCY_WINDOW = 128;
+    static constexpr size_t MIN_SAMPLES = 20;    ///< Below this the configured initial delay is used
+
+    void open(Clock::time_point now);
+
+    GeoIPFailoverConfig config_;
+    mutable std::mutex mutex_;
+    State state_ = State::CLOSED;
+    size_t consecutive_failures_ = 0;
+    Clock::time_point open_until_{};
+
+    std::array<uint32_t, LATENCY_WINDOW> latencies_us_{};   ///< Ring buffer of recent answers
+    size_t samples_ = 0;
+    Clock::duration p95_{};
+
+    uint64_t requests_ = 0;
+    uint64_t successes_ = 0;
+    uint64_t failures_ = 0;
+    uint64_t hedges_ = 0;
+    uint64_t hedge_wins_ = 0;
+    uint64_t circuit_opens_ = 0;
+};
+
+/**
+ * @brief Immutable provider list plus the mutable health of each provider
+ */
+class GeoIPProviderSet : public std::enable_shared_from_this<GeoIPProviderSet> {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Answers for an OFFLINE_DATABASE entry (nullopt: no database or no record)
+     */
+    using OfflineLookup = std::function<std::optional<GeoLocation>(const std::string& ip_address)>;
+    using Completion = std::function<void(std::optional<GeoLocation>)>;
+
+    GeoIPProviderSet(std::vector<GeoIPProvider> providers, const GeoIPFailoverConfig& config);
+    ~GeoIPProviderSet();
+
+    GeoIPProviderSet(const GeoIPProviderSet&) = delete;
+    GeoIPProviderSet& operator=(const GeoIPProviderSet&) = delete;
+
+    /**
+     * @brief Blocking lookup racing providers as described above
+     * @param pool Handles and timeouts for the HTTP requests (total_timeout bounds the whole race)
+     * @param priority Place in the rate limit queue if every provider's budget is spent
+     * @return Location, or nullopt if no provider answered with one
+     */
+    std::optional<GeoLocation> lookup(const std::string& ip_address, CurlPool& pool,
+                                      const OfflineLookup& offline,
+                                      LookupPriority priority = LookupPriority::INTERACTIVE);
+
+    /**
+     * @brief Asynchronous lookup on a reactor (queued as an interactive check)
+     * @param on_complete Invoked exactly once, on the reactor thread, the rate
+     *        limit queue's thread or (if the race is decided without a
+     *        request) the calling thread
+     */
+    void lookupAsync(const std::string& ip_address, std::shared_ptr<GeoIPReactor> reactor,
+                     Clock::time_point deadline, std::stop_token stop, OfflineLookup offline,
+                     Completion on_complete);
+
+    /**
+     * @brief Provider for a batch request: the first admitted one, if it has a batch endpoint
+     *
+     * Waits as a bulk lookup, until deadline, for the provider's batch budget.
+     *
+     * @param rate_limited Set if the wait failed; the batch must then not be
+     *        replaced by single lookups, which share the same budget problem
+     * @return Provider index for recordBatch, or nullopt to use single lookups
+     */
+    std::optional<size_t> acquireBatchProvider(Clock::time_point deadline, bool& rate_limited);
+    void recordBatch(size_t index, bool answered, const GeoIPRateHeaders& rate);
+
+    const GeoIPProvider& provider(size_t index) const { return providers_[index]; }
+    const std::vector<GeoIPProvider>& providers() const noexcept { return providers_; }
+    const GeoIPFailoverConfig& config() const noexcept { return config_; }
+
+    /**
+     * @brief Whether the list contains an OFFLINE_DATABASE entry
+     */
+    bool hasOfflineDatabase() const noexcept { return has_offline_; }
+
+    std::vector<GeoIPProviderStats> stats() const;
+
+    /**
+     * @brief Lookups currently waiting for a rate limit token
+     */
+    size_t queuedLookups() const { return queue_.queued(); }
+
+private:
+    struct AsyncRace;
+
+    std::string lookupUrl(size_t index, const std::string& ip_address) const;
+    std::vector<RateLimitQueue::Candidate> candidates(const std::vector<size_t>& indices) const;
+    void observe(ProviderRateLimit& limit, const GeoIPRateHeaders& rate);
+
+    std::vector<GeoIPProvider> providers_;
+    std::vector<std::unique_ptr<ProviderHealth>> health_;
+    std::vector<std::unique_ptr<ProviderRateLimit>> rates_;         ///< Single lookups
+    std::vector<std::unique_ptr<ProviderRateLimit>> batch_rates_;   ///< Batch requests
+    GeoIPFailoverConfig config_;
+    bool has_offline_ = false;
+    RateLimitQueue queue_;   ///< Declared last: its waiters point into rates_
+};
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_GEOIPPROVIDERS_HPP
@@ -0,0 +1,353 @@
+/**
+ * @file GeoIPRateLimit.cpp
+ * @brief Implementation of provider token buckets and the rate limit wait queue
+ */
+
+#include "GeoIPRateLimit.hpp"
+#include "../core/Logger.hpp"
+#include <algorithm>
+#include <cctype>
+#include <future>
+#include <string_view>
+
+namespace SpectreMap::Compliance {
+
+namespace {
+
+// Assumed window when a provider reports X-Rl without X-Ttl, or throttles without either
+constexpr std::chrono::seconds DEFAULT_RATE_WINDOW{60};
+
+bool headerIs(std::string_view line, std::string_view name) {
+    if (line.size() <= name.size() || line[name.size()] != ':') return false;
+    for (size_t i = 0; i < name.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(line[i])) != name[i]) return false;
+    }
+    return true;
+}
+
+std::optional<uint32_t> headerNumber(std::string_view line) {
+    size_t i = line.find(':') + 1;
+    while (i < line.size() && (line[i] == ' ' || line[i] == '\t')) ++i;
+    uint64_t value = 0;
+    const size_t start = i;
+    for (; i < line.size() && line[i] >= '0' && line[i] <= '9'; ++i) {
+        value = value * 10 + static_cast<uint64_t>(line[i] - '0');
+        if (value >= UINT32_MAX) return std::nullopt;
+    }
+    if (i == start) return std::nullopt;
+    return static_cast<uint32_t>(value);
+}
+
+} // namespace
+
+size_t captureRateHeaders(char* buffer, size_t size, size_t nitems, void* userdata) {
+    auto* headers = static_cast<GeoIPRateHeaders*>(userdata);
+    const std::string_view line(buffer, size * nitems);
+    if (line.starts_with("HTTP/")) {
+        headers->clear();   // A new response (after a redirect or 100 Continue)
+    } else if (headerIs(line, "x-rl")) {
+        headers->remaining = headerNumber(line);
+    } else if (headerIs(line, "x-ttl")) {
+        if (const auto seconds = headerNumber(line)) {
+            headers->reset = std::chrono::seconds(*seconds);
+        }
+    }
+    return size * nitems;
+}
+
+// ============================================================================
+// Provider Rate Limit
+// ============================================================================
+
+ProviderRateLimit::ProviderRateLimit(uint32_t requests_per_minute)
+    : capacity_(requests_per_minute),
+      per_second_(requests_per_minute / 60.0),
+      tokens_(requests_per_minute),
+      refilled_(Clock::now()) {}
+
+void ProviderRateLimit::refill(Clock::time_point now) {
+    if (now > refilled_) {
+        if (per_second_ > 0) {
+            tokens_ = std::min(capacity_, tokens_ + std::chrono::duration<double>(now - refilled_).count() * per_second_);
+        }
+        refilled_ = now;
+    }
+    if (window_remaining_ != UINT32_MAX && now >= window_reset_) {
+        // Until a response reports on the new window, assume it is as large as
+        // the last; waiters released together would otherwise all be sent
+        if (window_limit_ > 0) {
+            window_remaining_ = window_limit_;
+            window_reset_ = now + DEFAULT_RATE_WINDOW;
+        } else {
+            window_remaining_ = UINT32_MAX;
+        }
+    }
+}
+
+bool ProviderRateLimit::take(Clock::time_point now) {
+    refill(now);
+    if ((per_second_ > 0 && tokens_ < 1.0) || window_remaining_ == 0) {
+        return false;
+    }
+    if (per_second_ > 0) tokens_ -= 1.0;
+    if (window_remaining_ != UINT32_MAX) --window_remaining_;
+    return true;
+}
+
+bool ProviderRateLimit::tryTake(Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    if (waiters_ == 0 && take(now)) {
+        return true;
+    }
+    ++rate_limited_;
+    return false;
+}
+
+bool ProviderRateLimit::takeQueued(Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    return take(now);
+}
+
+ProviderRateLimit::Clock::time_point ProviderRateLimit::nextToken(Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    refill(now);
+    auto at = now;
+    if (window_remaining_ == 0) {
+        at = std::max(at, window_reset_);
+    }
+    if (per_second_ > 0 && tokens_ < 1.0) {
+        at = std::max(at, now + std::chrono::duration_cast<Clock::duration>(
+                                    std::chrono::duration<double>((1.0 - tokens_) / per_second_)));
+    }
+    return at;
+}
+
+bool ProviderRateLimit::observe(const GeoIPRateHeaders& headers, Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    refill(now);
+    if (headers.throttled) {
+        ++throttled_;
+        window_remaining_ = 0;
+        window_reset_ = now + headers.reset.value_or(DEFAULT_RATE_WINDOW);
+        return waiters_ > 0;
+    }
+    if (!headers.remaining) {
+        return false;
+    }
+    // The provider counts every client behind this address, so it has the final say
+    window_remaining_ = std::min(*headers.remaining, UINT32_MAX - 2);
+    window_limit_ = std::max(window_limit_, window_remaining_ + 1);
+    window_reset_ = now + headers.reset.value_or(DEFAULT_RATE_WINDOW);
+    return waiters_ > 0;
+}
+
+void ProviderRateLimit::addTo(GeoIPProviderStats& stats) const {
+    std::lock_guard lock(mutex_);
+    stats.rate_limited += rate_limited_;
+    stats.throttled += throttled_;
+}
+
+void ProviderRateLimit::addWaiter() {
+    std::lock_guard lock(mutex_);
+    ++waiters_;
+}
+
+void ProviderRateLimit::removeWaiter() {
+    std::lock_guard lock(mutex_);
+    --waiters_;
+}
+
+// ============================================================================
+// Wait Queue
+// ============================================================================
+
+RateLimitQueue::RateLimitQueue(size_t capacity) : capacity_(capacity) {}
+
+RateLimitQueue::~RateLimitQueue() {
+    std::vector<Waiter> abandoned;
+    {
+        std::lock_guard lock(state_->mutex);
+        state_->stopping = true;
+        abandoned.swap(state_->waiters);
+    }
+    state_->changed.notify_all();
+    for (Waiter& waiter : abandoned) {
+        release(waiter);
+        waiter.grant(std::nullopt);
+    }
+    if (thread_.joinable()) {
+        if (thread_.get_id() == std::this_thread::get_id()) {
+            // Destroyed from inside a grant; run() sees stopping and returns
+            thread_.detach();
+        } else {
+            thread_.join();
+        }
+    }
+}
+
+void RateLimitQueue::wait(std::vector<Candidate> candidates, LookupPriority priority,
+                          Clock::time_point deadline, std::stop_token stop, Grant grant) {
+    if (candidates.empty() || stop.stop_requested()) {
+        grant(std::nullopt);
+        return;
+    }
+
+    uint64_t id;
+    {
+        std::lock_guard lock(state_->mutex);
+        id = state_->next_id++;
+    }
+    Waiter waiter{id, priority, deadline, std::move(candidates), std::move(grant), nullptr};
+    // Registered before the waiter is queued; a stop in between is caught below
+    if (stop.stop_possible()) {
+        waiter.on_stop = std::make_unique<std::stop_callback<Canceller>>(stop, Canceller{state_, id});
+    }
+
+    std::optional<Waiter> displaced;
+    std::optional<Waiter> rejected;
+    bool full = false;
+    {
+        std::lock_guard lock(state_->mutex);
+        auto& waiters = state_->waiters;
+        if (!state_->stopping && waiters.size() >= capacity_) {
+            full = true;
+            // An interactive check takes the place of the newest bulk one
+            if (priority == LookupPriority::INTERACTIVE && !waiters.empty() &&
+                waiters.back().priority == LookupPriority::BULK) {
+                displaced = std::move(waiters.back());
+                waiters.pop_back();
+            }
+        }
+        if (state_->stopping || (full && !displaced)) {
+            rejected = std::move(waiter);
+        } else {
+            for (const Candidate& candidate : waiter.candidates) {
+                candidate.limit->addWaiter();
+            }
+            const auto position = std::upper_bound(waiters.begin(), waiters.end(), priority,
+                [](LookupPriority p, const Waiter& queued) { return p < queued.priority; });
+            waiters.insert(position, std::move(waiter));
+            if (!thread_.joinable()) {
+                thread_ = std::thread(&RateLimitQueue::run, state_);
+            }
+        }
+    }
+
+    if (rejected) {
+        if (full) {
+            Logger::warning("GeoIP rate limit queue full - lookup fails closed");
+        }
+        rejected->grant(std::nullopt);
+        return;
+    }
+    state_->changed.notify_one();
+    if (displaced) {
+        Logger::warning("GeoIP rate limit queue full - bulk lookup displaced by an interactive check");
+        release(*displaced);
+        displaced->grant(std::nullopt);
+    }
+    if (stop.stop_requested()) {
+        cancel(state_, id);
+    }
+}
+
+std::optional<size_t> RateLimitQueue::waitFor(std::vector<Candidate> candidates, LookupPriority priority,
+                                              Clock::time_point deadline) {
+    auto granted = std::make_shared<std::promise<std::optional<size_t>>>();
+    auto result = granted->get_future();
+    wait(std::move(candidates), priority, deadline, {}, [granted](std::optional<size_t> provider) {
+        granted->set_value(provider);
+    });
+    return result.get();
+}
+
+void RateLimitQueue::Canceller::operator()() const {
+    if (auto shared = state.lock()) {
+        cancel(shared, id);
+    }
+}
+
+void RateLimitQueue::cancel(const std::shared_ptr<State>& state, uint64_t id) {
+    std::optional<Waiter> cancelled;
+    {
+        std::lock_guard lock(state->mutex);
+        auto& waiters = state->waiters;
+        const auto it = std::find_if(waiters.begin(), waiters.end(),
+                                     [id](const Waiter& waiter) { return waiter.id == id; });
+        if (it == waiters.end()) {
+            return;   // Already granted, expired or displaced
+        }
+        cancelled = std::move(*it);
+        waiters.erase(it);
+    }
+    release(*cancelled);
+    cancelled->grant(std::nullopt);
+}
+
+void RateLimitQueue::wake() {
+    {
+        // Pairs with the dispatcher's check-then-wait so the wakeup can't be lost
+        std::lock_guard lock(state_->mutex);
+    }
+    state_->changed.notify_all();
+}
+
+size_t RateLimitQueue::queued() const {
+    std::lock_guard lock(state_->mutex);
+    return state_->waiters.size();
+}
+
+void RateLimitQueue::release(Waiter& waiter) {
+    for (const Candidate& candidate : waiter.candidates) {
+        candidate.limit->removeWaiter();
+    }
+}
+
+void RateLimitQueue::run(std::shared_ptr<State> state) {
+    std::unique_lock lock(state->mutex);
+    while (!state->stopping) {
+        const auto now = Clock::now();
+        auto wake_at = Clock::time_point::max();
+        std::vector<std::pair<Waiter, std::optional<size_t>>> ready;
+
+        // In priority order, so a token goes to the most urgent waiter able to use it
+        for (auto it = state->waiters.begin(); it != state->waiters.end();) {
+            std::optional<size_t> provider;
+            bool done = it->deadline <= now;
+            for (size_t c = 0; !done && c < it->candidates.size(); ++c) {
+                const Candidate& candidate = it->candidates[c];
+                if (candidate.limit->takeQueued(now)) {
+                    provider = candidate.provider;
+                    done = true;
+                } else {
+                    wake_at = std::min(wake_at, candidate.limit->nextToken(now));
+                }
+            }
+            if (done) {
+                ready.emplace_back(std::move(*it), provider);
+                it = state->waiters.erase(it);
+                continue;
+            }
+            wake_at = std::min(wake_at, it->deadline);
+            ++it;
+        }
+
+        if (!ready.empty()) {
+            lock.unlock();
+            for (auto& [waiter, provider] : ready) {
+                release(waiter);
+                waiter.grant(provider);
+            }
+            ready.clear();   // Grants may own the last reference to the queue's owner
+            lock.lock();
+            continue;
+        }
+        if (wake_at == Clock::time_point::max()) {
+            state->changed.wait(lock);
+        } else {
+            state->changed.wait_until(lock, wake_at);
+        }
+    }
+}
+
+} // namespace SpectreMap::Compliance
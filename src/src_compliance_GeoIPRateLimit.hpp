@@ -0,0 +1,216 @@
+/**
+ * @file GeoIPRateLimit.hpp
+ * @brief Per-provider request budgets and the queue of lookups waiting on them
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * ip-api's free tier answers about 45 single lookups and 15 batches a
+ * minute per client address, and throttles (HTTP 429) past that. Each
+ * provider endpoint therefore has a token bucket sized from its configured
+ * budget, corrected by what the provider reports: X-Rl (requests left in
+ * the current window) and X-Ttl (seconds until the window resets). Other
+ * processes sharing the address spend the same budget, so the headers win
+ * whenever they are stricter than the local bucket.
+ *
+ * A request is only sent with a token. When every provider a lookup could
+ * use is out of tokens, the lookup waits in a bounded queue instead of
+ * being throttled into a fail-closed answer. Interactive checks are served
+ * before bulk ones; when the queue is full, an interactive check displaces
+ * the newest bulk waiter. A waiter whose deadline passes first fails.
+ */
+
+#ifndef SPECTREMAP_GEOIPRATELIMIT_HPP
+#define SPECTREMAP_GEOIPRATELIMIT_HPP
+
+#include "GeoRestriction.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace SpectreMap::Compliance {
+
+/**
+ * @brief Who is waiting for a lookup; decides the order of the wait queue
+ */
+enum class LookupPriority : uint8_t {
+    INTERACTIVE,   ///< A caller blocked on one answer (checkAccess, getGeoLocation, async checks)
+    BULK           ///< Batch classification
+};
+
+/**
+ * @brief Rate limit state reported in a provider response
+ */
+struct GeoIPRateHeaders {
+    std::optional<uint32_t> remaining;            ///< X-Rl: requests left in the current window
+    std::optional<std::chrono::seconds> reset;    ///< X-Ttl: time until the window resets
+    bool throttled = false;                       ///< HTTP 429 (set by the caller from the status)
+
+    void clear() noexcept { *this = GeoIPRateHeaders{}; }
+};
+
+/**
+ * @brief CURLOPT_HEADERFUNCTION callback; CURLOPT_HEADERDATA is a GeoIPRateHeaders*
+ */
+size_t captureRateHeaders(char* buffer, size_t size, size_t nitems, void* userdata);
+
+/**
+ * @brief Token bucket for one provider endpoint
+ */
+class ProviderRateLimit {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @param requests_per_minute Refill rate and burst size; 0 leaves only the provider's headers
+     */
+    explicit ProviderRateLimit(uint32_t requests_per_minute);
+
+    /**
+     * @brief Spend a token, unless none is left or queued lookups are waiting for one
+     */
+    bool tryTake(Clock::time_point now);
+
+    /**
+     * @brief Earliest time a token may be available (now if one is)
+     */
+    Clock::time_point nextToken(Clock::time_point now);
+
+    /**
+     * @brief Correct the bucket from a response's headers
+     * @return Whether lookups are queued for this endpoint (the queue should look again)
+     */
+    bool observe(const GeoIPRateHeaders& headers, Clock::time_point now);
+
+    /**
+     * @brief Adds this endpoint's rate_limited and throttled counts
+     */
+    void addTo(GeoIPProviderStats& stats) const;
+
+private:
+    friend class RateLimitQueue;
+
+    void refill(Clock::time_point now);     // Caller holds mutex_
+    bool take(Clock::time_point now);       // Caller holds mutex_
+    bool takeQueued(Clock::time_point now); // For the queue, which goes before new requests
+    void addWaiter();
+    void removeWaiter();
+
+    mutable std::mutex mutex_;
+    double capacity_ = 0;                   ///< 0: no local budget
+    double per_second_ = 0;
+    double tokens_ = 0;
+    Clock::time_point refilled_;
+
+    // The provider's own window, from its headers (UINT32_MAX: not reported)
+    uint32_t window_remaining_ = UINT32_MAX;
+    uint32_t window_limit_ = 0;             ///< Largest budget seen (X-Rl + 1); a new window starts with it
+    Clock::time_point window_reset_{};
+
+    size_t waiters_ = 0;                    ///< Queued lookups that may use this endpoint
+    uint64_t rate_limited_ = 0;
+    uint64_t throttled_ = 0;
+};
+
+/**
+ * @brief Bounded priority queue of lookups waiting for a token
+ *
+ * Tokens are handed out by a dispatcher thread, started on first use, so
+ * blocking and asynchronous lookups wait in the same queue.
+ */
+class RateLimitQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief An endpoint a waiter can use
+     */
+    struct Candidate {
+        size_t provider;            ///< Reported back on a grant
+        ProviderRateLimit* limit;   ///< Must outlive the queue
+    };
+
+    /**
+     * @brief Receives the provider whose token was taken, or nullopt if the wait failed
+     *
+     * Runs on the dispatcher thread, on the calling thread if the queue is
+     * full, or on the thread requesting a stop. Must not block.
+     */
+    using Grant = std::function<void(std::optional<size_t> provider)>;
+
+    explicit RateLimitQueue(size_t capacity);
+    ~RateLimitQueue();
+
+    RateLimitQueue(const RateLimitQueue&) = delete;
+    RateLimitQueue& operator=(const RateLimitQueue&) = delete;
+
+    /**
+     * @brief Wait for a token from the first candidate (in order) that has one
+     * @param stop Fails the wait; the grant runs inside request_stop()
+     */
+    void wait(std::vector<Candidate> candidates, LookupPriority priority, Clock::time_point deadline,
+              std::stop_token stop, Grant grant);
+
+    /**
+     * @brief Blocking form of wait()
+     */
+    std::optional<size_t> waitFor(std::vector<Candidate> candidates, LookupPriority priority,
+                                  Clock::time_point deadline);
+
+    /**
+     * @brief Make the dispatcher look again (a response moved a provider's window)
+     */
+    void wake();
+
+    size_t queued() const;
+
+private:
+    struct State;
+
+    /**
+     * @brief Fails a waiter when its stop token is triggered
+     */
+    struct Canceller {
+        std::weak_ptr<State> state;
+        uint64_t id;
+
+        void operator()() const;
+    };
+
+    struct Waiter {
+        uint64_t id;
+        LookupPriority priority;
+        Clock::time_point deadline;
+        std::vector<Candidate> candidates;
+        Grant grant;
+        std::unique_ptr<std::stop_callback<Canceller>> on_stop;
+    };
+
+    // Shared with the dispatcher thread, which may outlive the queue if the
+    // last reference to the queue's owner is dropped inside a grant
+    struct State {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::vector<Waiter> waiters;        ///< Ordered by priority, then arrival
+        uint64_t next_id = 0;
+        bool stopping = false;
+    };
+
+    static void run(std::shared_ptr<State> state);
+    static void cancel(const std::shared_ptr<State>& state, uint64_t id);
+    static void release(Waiter& waiter);
+
+    std::shared_ptr<State> state_ = std::make_shared<State>();
+    size_t capacity_;
+    std::thread thread_;   ///< Started by the first wait()
+};
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_GEOIPRATELIMIT_HPP
@@ -0,0 +1,297 @@
+/**
+ * @file GeoIPReactor.cpp
+ * @brief Implementation of the curl_multi GeoIP reactor
+ */
+
+#include "GeoIPReactor.hpp"
+#include "../core/Logger.hpp"
+#include <algorithm>
+#include <optional>
+
+namespace SpectreMap::Compliance {
+
+namespace {
+
+// Upper bound on a single poll; wakeups normally end the wait much sooner
+constexpr int REACTOR_POLL_TIMEOUT_MS = 1000;
+
+size_t appendBody(void* contents, size_t size, size_t nmemb, std::string* body) {
+    body->append(static_cast<char*>(contents), size * nmemb);
+    return size * nmemb;
+}
+
+/**
+ * @brief Wakes the reactor to drop a request whose stop_token fired
+ */
+struct CancelRequest {
+    uint64_t id;
+    std::mutex* queue_mutex;
+    std::vector<uint64_t>* cancelled;
+    CURLM* multi;
+
+    void operator()() const {
+        {
+            std::lock_guard lock(*queue_mutex);
+            cancelled->push_back(id);
+        }
+        curl_multi_wakeup(multi);
+    }
+};
+
+} // namespace
+
+struct GeoIPReactor::Transfer {
+    uint64_t id = 0;
+    std::string url;
+    std::string body;
+    GeoIPRateHeaders rate;
+    Clock::time_point deadline;
+    Clock::time_point start_at;
+    Completion on_complete;
+    CURL* easy = nullptr;
+    std::stop_token stop;
+    std::optional<std::stop_callback<CancelRequest>> stop_callback;
+};
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+GeoIPReactor::GeoIPReactor(const GeoIPClientConfig& config) : config_(config) {
+    multi_ = curl_multi_init();
+    if (!multi_) {
+        Logger::error("curl_multi_init failed - asynchronous GeoIP lookups unavailable");
+        return;
+    }
+#ifdef CURLPIPE_MULTIPLEX
+    curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+    thread_ = std::thread(&GeoIPReactor::run, this);
+}
+
+GeoIPReactor::~GeoIPReactor() {
+    // Runs its callbacks here, so waiters give up while the reactor is whole
+    shutdown_.request_stop();
+    stopping_.store(true);
+    if (multi_) {
+        curl_multi_wakeup(multi_);
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    for (CURL* handle : idle_handles_) {
+        curl_easy_cleanup(handle);
+    }
+    if (multi_) {
+        curl_multi_cleanup(multi_);
+    }
+}
+
+void GeoIPReactor::submit(std::string url, Clock::time_point deadline, std::stop_token stop,
+                          Completion on_complete, Clock::time_point start_at) {
+    if (!multi_ || stopping_.load() || stop.stop_requested()) {
+        on_complete(std::nullopt, GeoIPRateHeaders{});
+        return;
+    }
+
+    auto transfer = std::make_unique<Transfer>();
+    transfer->id = next_id_.fetch_add(1, std::memory_order_relaxed);
+    transfer->url = std::move(url);
+    transfer->deadline = deadline;
+    transfer->start_at = start_at;
+    transfer->on_complete = std::move(on_complete);
+    if (stop.stop_possible()) {
+        // May fire immediately; it only touches the queue, so register before locking
+        transfer->stop = stop;
+        transfer->stop_callback.emplace(
+            stop, CancelRequest{transfer->id, &queue_mutex_, &cancelled_, multi_});
+    }
+
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard lock(queue_mutex_);
+        queued_.push_back(std::move(transfer));
+    }
+    curl_multi_wakeup(multi_);
+}
+
+// ============================================================================
+// Reactor Thread
+// ============================================================================
+
+void GeoIPReactor::run() {
+    while (!stopping_.load()) {
+        startQueued();
+        startDelayed();
+        processCancellations();
+
+        int running = 0;
+        curl_multi_perform(multi_, &running);
+
+        int remaining = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi_, &remaining)) {
+            if (msg->msg != CURLMSG_DONE) continue;
+
+            Transfer* transfer = nullptr;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &transfer);
+            long http_status = 0;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &http_status);
+            const CURLcode result = msg->data.result;
+
+            if (result != CURLE_OK) {
+                Logger::warning("Async GeoIP request failed: " + std::string(curl_easy_strerror(result)));
+            }
+            if (transfer) {
+                transfer->rate.throttled = http_status == 429;
+                finish(transfer, (result == CURLE_OK && http_status == 200)
+                                     ? std::optional<std::string>(std::move(transfer->body))
+                                     : std::nullopt);
+            }
+        }
+
+        curl_multi_poll(multi_, nullptr, 0, pollTimeoutMs(), nullptr);
+    }
+    failAll();
+}
+
+void GeoIPReactor::startQueued() {
+    std::vector<std::unique_ptr<Transfer>> batch;
+    {
+        std::lock_guard lock(queue_mutex_);
+        batch.swap(queued_);
+    }
+
+    const auto now = Clock::now();
+    for (auto& transfer : batch) {
+        Transfer* raw = transfer.get();
+        active_.emplace(raw->id, std::move(transfer));
+        if (raw->start_at > now) {
+            // Still cancellable through active_ while it waits
+            delayed_.push_back(raw->id);
+            continue;
+        }
+        start(raw, now);
+    }
+}
+
+void GeoIPReactor::startDelayed() {
+    if (delayed_.empty()) return;
+    const auto now = Clock::now();
+    std::erase_if(delayed_, [&](uint64_t id) {
+        auto it = active_.find(id);
+        if (it == active_.end()) return true;   // Cancelled while waiting
+        if (it->second->start_at > now) return false;
+        start(it->second.get(), now);
+        return true;
+    });
+}
+
+void GeoIPReactor::start(Transfer* transfer, Clock::time_point now) {
+    // A stop that fired before the transfer was queued is caught here
+    if (transfer->deadline <= now || transfer->stop.stop_requested()) {
+        finish(transfer, std::nullopt);
+        return;
+    }
+
+    CURL* easy = takeHandle();
+    if (!easy) {
+        finish(transfer, std::nullopt);
+        return;
+    }
+
+    // The per-request deadline caps the configured total timeout
+    const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        transfer->deadline - now);
+    const long timeout_ms = static_cast<long>(
+        std::max<int64_t>(1, std::min(remaining.count(), config_.total_timeout.count())));
+
+    transfer->easy = easy;
+    curl_easy_setopt(easy, CURLOPT_URL, transfer->url.c_str());
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, appendBody);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, &transfer->body);
+    curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, captureRateHeaders);
+    curl_easy_setopt(easy, CURLOPT_HEADERDATA, &transfer->rate);
+    curl_easy_setopt(easy, CURLOPT_PRIVATE, transfer);
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(config_.connect_timeout.count()));
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, timeout_ms);
+    curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(easy, CURLOPT_DNS_CACHE_TIMEOUT, static_cast<long>(config_.dns_cache_ttl.count()));
+
+    curl_multi_add_handle(multi_, easy);
+}
+
+int GeoIPReactor::pollTimeoutMs() const {
+    int timeout_ms = REACTOR_POLL_TIMEOUT_MS;
+    const auto now = Clock::now();
+    for (uint64_t id : delayed_) {
+        auto it = active_.find(id);
+        if (it == active_.end()) continue;
+        const auto wait = std::chrono::ceil<std::chrono::milliseconds>(it->second->start_at - now);
+        timeout_ms = std::clamp<int>(static_cast<int>(wait.count()), 0, timeout_ms);
+    }
+    return timeout_ms;
+}
+
+void GeoIPReactor::processCancellations() {
+    std::vector<uint64_t> ids;
+    {
+        std::lock_guard lock(queue_mutex_);
+        ids.swap(cancelled_);
+    }
+    for (uint64_t id : ids) {
+        auto it = active_.find(id);
+        if (it != active_.end()) {
+            finish(it->second.get(), std::nullopt);
+        }
+    }
+}
+
+void GeoIPReactor::finish(Transfer* transfer, std::optional<std::string> body) {
+    auto it = active_.find(transfer->id);
+    if (it == active_.end()) return;
+    std::unique_ptr<Transfer> owned = std::move(it->second);
+    active_.erase(it);
+
+    if (owned->easy) {
+        curl_multi_remove_handle(multi_, owned->easy);
+        idle_handles_.push_back(owned->easy);
+        owned->easy = nullptr;
+    }
+
+    // Unregister before completing so a late stop request can't race the callback
+    owned->stop_callback.reset();
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+
+    try {
+        owned->on_complete(std::move(body), owned->rate);
+    } catch (const std::exception& e) {
+        Logger::error("Async GeoIP completion threw: " + std::string(e.what()));
+    }
+}
+
+void GeoIPReactor::failAll() {
+    {
+        std::lock_guard lock(queue_mutex_);
+        for (auto& transfer : queued_) {
+            const uint64_t id = transfer->id;
+            active_.emplace(id, std::move(transfer));
+        }
+        queued_.clear();
+    }
+    while (!active_.empty()) {
+        finish(active_.begin()->second.get(), std::nullopt);
+    }
+}
+
+CURL* GeoIPReactor::takeHandle() {
+    if (!idle_handles_.empty()) {
+        CURL* handle = idle_handles_.back();
+        idle_handles_.pop_back();
+        curl_easy_reset(handle);
+        return handle;
+    }
+    return curl_easy_init();
+}
+
+} // namespace SpectreMap::Compliance
@@ -0,0 +1,112 @@
+/**
+ * @file GeoIPReactor.hpp
+ * @brief Single-threaded curl_multi event loop for asynchronous GeoIP requests
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * One reactor thread drives every in-flight HTTP request, so hundreds of
+ * lookups can be pending without tying up a thread each. Requests carry
+ * their own deadline and can be cancelled through a std::stop_token. A
+ * request may also be scheduled to start later (used to hedge a slow
+ * provider with the next one).
+ */
+
+#ifndef SPECTREMAP_GEOIPREACTOR_HPP
+#define SPECTREMAP_GEOIPREACTOR_HPP
+
+#include "GeoRestriction.hpp"
+#include "GeoIPRateLimit.hpp"
+#include <curl/curl.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace SpectreMap::Compliance {
+
+/**
+ * @brief curl_multi reactor running on a dedicated thread
+ */
+class GeoIPReactor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Completion callback, invoked exactly once
+     *
+     * Runs on the reactor thread, or on the submitting thread if the request
+     * was already cancelled or the reactor is shutting down at submit time.
+     * Receives the response body on HTTP 200, or nullopt on transport error,
+     * non-200 status, deadline expiry, cancellation or reactor shutdown,
+     * plus whatever rate limit headers arrived (empty if none did).
+     * Must not block: it delays every other in-flight request.
+     */
+    using Completion = std::function<void(std::optional<std::string> body, const GeoIPRateHeaders& rate)>;
+
+    explicit GeoIPReactor(const GeoIPClientConfig& config);
+    ~GeoIPReactor();
+
+    GeoIPReactor(const GeoIPReactor&) = delete;
+    GeoIPReactor& operator=(const GeoIPReactor&) = delete;
+
+    /**
+     * @brief Queue a GET request
+     * @param url Fully formed request URL
+     * @param deadline Absolute time after which the request fails
+     * @param stop Cancels the request when stop is requested
+     * @param on_complete Result callback
+     * @param start_at Earliest time the request is sent (default: now)
+     */
+    void submit(std::string url, Clock::time_point deadline, std::stop_token stop,
+                Completion on_complete, Clock::time_point start_at = {});
+
+    /**
+     * @brief Requests queued or in flight
+     */
+    size_t pending() const noexcept { return pending_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Stopped when the reactor starts shutting down, before pending
+     *        requests are failed; work that would submit later gives up on it
+     */
+    std::stop_token shutdownToken() const noexcept { return shutdown_.get_token(); }
+
+private:
+    struct Transfer;
+
+    void run();
+    void startQueued();
+    void startDelayed();
+    void start(Transfer* transfer, Clock::time_point now);
+    int pollTimeoutMs() const;
+    void processCancellations();
+    void finish(Transfer* transfer, std::optional<std::string> body);
+    void failAll();
+    CURL* takeHandle();
+
+    GeoIPClientConfig config_;
+    CURLM* multi_ = nullptr;
+
+    std::mutex queue_mutex_;
+    std::vector<std::unique_ptr<Transfer>> queued_;
+    std::vector<uint64_t> cancelled_;
+
+    // Owned by the reactor thread only
+    std::unordered_map<uint64_t, std::unique_ptr<Transfer>> active_;
+    std::vector<uint64_t> delayed_;   ///< Entries of active_ waiting for their start time
+    std::vector<CURL*> idle_handles_;
+
+    std::atomic<uint64_t> next_id_{1};
+    std::atomic<size_t> pending_{0};
+    std::atomic<bool> stopping_{false};
+    std::stop_source shutdown_;
+    std::thread thread_;
+};
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_GEOIPREACTOR_HPP
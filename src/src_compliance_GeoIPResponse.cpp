@@ -0,0 +1,462 @@
+/**
+ * @file GeoIPResponse.cpp
+ * @brief Implementation of ip-api response parsing
+ *
+ * ip-api answers with a flat object of known fields, so instead of building
+ * a JSON DOM the body is scanned once: wanted values are read straight from
+ * the buffer and everything else is skipped. Strings are views into the body
+ * until they are copied into the GeoLocation (one allocation per field at
+ * most, none for short values); escapes are decoded only when present.
+ */
+
+#include "GeoIPResponse.hpp"
+#include "ComplianceMetrics.hpp"
+#include "../core/Logger.hpp"
+#include <charconv>
+
+namespace SpectreMap::Compliance {
+
+namespace {
+
+// Nesting limit for skipped values; ip-api responses are one level deep
+constexpr int MAX_SKIP_DEPTH = 32;
+
+/**
+ * @brief Forward-only JSON tokenizer over a borrowed buffer
+ */
+class JsonScanner {
+public:
+    explicit JsonScanner(std::string_view text)
+        : begin_(text.data()), p_(text.data()), end_(text.data() + text.size()) {}
+
+    size_t offset() const { return static_cast<size_t>(p_ - begin_); }
+
+    bool atEnd() {
+        skipWhitespace();
+        return p_ == end_;
+    }
+
+    bool peek(char c) {
+        skipWhitespace();
+        return p_ < end_ && *p_ == c;
+    }
+
+    bool consume(char c) {
+        if (!peek(c)) return false;
+        ++p_;
+        return true;
+    }
+
+    /**
+     * @brief Read a string token, validating escapes and UTF-8
+     * @param raw Contents between the quotes, escapes left undecoded
+     * @param escaped Set if raw contains a backslash escape
+     */
+    bool string(std::string_view& raw, bool& escaped) {
+        if (!consume('"')) return false;
+        const char* start = p_;
+        escaped = false;
+        while (p_ < end_) {
+            const auto c = static_cast<unsigned char>(*p_);
+            if (c == '"') {
+                raw = std::string_view(start, static_cast<size_t>(p_ - start));
+                ++p_;
+                return true;
+            }
+            if (c == '\\') {
+                escaped = true;
+                if (!skipEscape()) return false;
+            } else if (c >= 0x80) {
+                if (!skipUtf8()) return false;
+            } else if (c < 0x20) {
+                return false;
+            } else {
+                ++p_;
+            }
+        }
+        return false;
+    }
+
+    bool number(double& value) {
+        skipWhitespace();
+        // Check the JSON grammar first: from_chars also accepts "inf", "nan",
+        // leading zeros and a bare trailing '.'
+        const char* q = p_;
+        if (q < end_ && *q == '-') ++q;
+        if (q == end_ || !isDigit(*q)) return false;
+        if (*q == '0') {
+            ++q;
+        } else {
+            while (q < end_ && isDigit(*q)) ++q;
+        }
+        if (q < end_ && *q == '.') {
+            if (++q == end_ || !isDigit(*q)) return false;
+            while (q < end_ && isDigit(*q)) ++q;
+        }
+        if (q < end_ && (*q == 'e' || *q == 'E')) {
+            ++q;
+            if (q < end_ && (*q == '+' || *q == '-')) ++q;
+            if (q == end_ || !isDigit(*q)) return false;
+            while (q < end_ && isDigit(*q)) ++q;
+        }
+        const auto [next, ec] = std::from_chars(p_, q, value);
+        if (ec != std::errc() || next != q) return false;
+        p_ = q;
+        return true;
+    }
+
+    bool boolean(bool& value) {
+        if (literal("true")) {
+            value = true;
+            return true;
+        }
+        if (literal("false")) {
+            value = false;
+            return true;
+        }
+        return false;
+    }
+
+    bool skipValue(int depth = 0) {
+        if (depth > MAX_SKIP_DEPTH) return false;
+        skipWhitespace();
+        if (p_ == end_) return false;
+
+        std::string_view raw;
+        bool escaped;
+        double number_value;
+        switch (*p_) {
+            case '"':
+                return string(raw, escaped);
+            case '{':
+                ++p_;
+                if (consume('}')) return true;
+                do {
+                    if (!string(raw, escaped) || !consume(':') || !skipValue(depth + 1)) return false;
+                } while (consume(','));
+                return consume('}');
+            case '[':
+                ++p_;
+                if (consume(']')) return true;
+                do {
+                    if (!skipValue(depth + 1)) return false;
+                } while (consume(','));
+                return consume(']');
+            case 't':
+                return literal("true");
+            case 'f':
+                return literal("false");
+            case 'n':
+                return literal("null");
+            default:
+                return number(number_value);
+        }
+    }
+
+private:
+    static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    static bool isHex(char c) {
+        return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+    }
+
+    // p_ is at a backslash
+    bool skipEscape() {
+        if (++p_ == end_) return false;
+        switch (*p_) {
+            case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                ++p_;
+                return true;
+            case 'u':
+                if (end_ - p_ < 5) return false;
+                for (int i = 1; i <= 4; ++i) {
+                    if (!isHex(p_[i])) return false;
+                }
+                p_ += 5;
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // p_ is at a non-ASCII lead byte; rejects overlong forms and surrogates
+    bool skipUtf8() {
+        const auto lead = static_cast<unsigned char>(*p_);
+        int length;
+        unsigned char min = 0x80, max = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            length = 2;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            length = 3;
+            if (lead == 0xE0) min = 0xA0;
+            if (lead == 0xED) max = 0x9F;
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            length = 4;
+            if (lead == 0xF0) min = 0x90;
+            if (lead == 0xF4) max = 0x8F;
+        } else {
+            return false;
+        }
+        if (end_ - p_ < length) return false;
+        for (int i = 1; i < length; ++i) {
+            const auto c = static_cast<unsigned char>(p_[i]);
+            if (c < (i == 1 ? min : 0x80) || c > (i == 1 ? max : 0xBF)) return false;
+        }
+        p_ += length;
+        return true;
+    }
+
+    void skipWhitespace() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) {
+            ++p_;
+        }
+    }
+
+    bool literal(std::string_view word) {
+        skipWhitespace();
+        if (static_cast<size_t>(end_ - p_) < word.size() || std::string_view(p_, word.size()) != word) {
+            return false;
+        }
+        p_ += word.size();
+        return true;
+    }
+
+    const char* begin_;
+    const char* p_;
+    const char* end_;
+};
+
+void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+bool readHex4(std::string_view raw, size_t pos, uint32_t& value) {
+    if (pos + 4 > raw.size()) return false;
+    const auto [next, ec] = std::from_chars(raw.data() + pos, raw.data() + pos + 4, value, 16);
+    return ec == std::errc() && next == raw.data() + pos + 4;
+}
+
+/**
+ * @brief Copy a raw string token into @p out, decoding escapes if present
+ */
+bool decodeString(std::string_view raw, bool escaped, std::string& out) {
+    if (!escaped) {
+        out.assign(raw);
+        return true;
+    }
+
+    out.clear();
+    out.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); ++i) {
+        if (raw[i] != '\\') {
+            out += raw[i];
+            continue;
+        }
+        if (++i == raw.size()) return false;
+        switch (raw[i]) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                uint32_t cp;
+                if (!readHex4(raw, i + 1, cp)) return false;
+                i += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    // High surrogate: a low surrogate escape must follow
+                    uint32_t low;
+                    if (i + 2 >= raw.size() || raw[i + 1] != '\\' || raw[i + 2] != 'u' ||
+                        !readHex4(raw, i + 3, low) || low < 0xDC00 || low > 0xDFFF) {
+                        return false;
+                    }
+                    i += 6;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    return false;
+                }
+                appendUtf8(out, cp);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Response fields that don't go into GeoLocation
+ */
+struct EntryFields {
+    bool provider_failed = false;      ///< "status" was "fail"
+    std::string_view message;
+    bool message_escaped = false;
+    std::string_view query;
+    bool query_escaped = false;
+};
+
+GeoLocation emptyLocation(const std::string& ip_address) {
+    GeoLocation loc;
+    loc.ip_address = ip_address;
+    loc.latitude = 0.0;
+    loc.longitude = 0.0;
+    loc.is_proxy = false;
+    loc.is_vpn = false;    // Would need enhanced API
+    loc.is_tor = false;    // Would need Tor exit node list
+    loc.is_hosting = false;
+    return loc;
+}
+
+/**
+ * @brief Scan one response object into @p loc and @p fields
+ *
+ * A known field with the wrong JSON type fails the whole entry.
+ */
+bool scanEntry(JsonScanner& scanner, GeoLocation& loc, EntryFields& fields) {
+    if (!scanner.consume('{')) return false;
+    if (scanner.consume('}')) return true;
+
+    do {
+        std::string_view key;
+        bool key_escaped;
+        if (!scanner.string(key, key_escaped) || !scanner.consume(':')) return false;
+        if (key_escaped) {
+            // ip-api's keys are plain ASCII, so an escaped key is not one we want
+            if (!scanner.skipValue()) return false;
+            continue;
+        }
+
+        std::string* target = nullptr;
+        if (key == "countryCode") target = &loc.country_code;
+        else if (key == "country") target = &loc.country_name;
+        else if (key == "region") target = &loc.region_code;
+        else if (key == "regionName") target = &loc.region;
+        else if (key == "city") target = &loc.city;
+        else if (key == "as") target = &loc.asn;
+        else if (key == "isp") target = &loc.org;
+
+        std::string_view raw;
+        bool escaped;
+        bool ok;
+        if (target) {
+            ok = scanner.string(raw, escaped) && decodeString(raw, escaped, *target);
+        } else if (key == "lat") {
+            ok = scanner.number(loc.latitude);
+        } else if (key == "lon") {
+            ok = scanner.number(loc.longitude);
+        } else if (key == "proxy") {
+            ok = scanner.boolean(loc.is_proxy);
+        } else if (key == "hosting") {
+            ok = scanner.boolean(loc.is_hosting);
+        } else if (key == "status") {
+            ok = scanner.string(raw, escaped);
+            fields.provider_failed = raw == "fail";
+        } else if (key == "message") {
+            ok = scanner.string(fields.message, fields.message_escaped);
+        } else if (key == "query") {
+            ok = scanner.string(fields.query, fields.query_escaped);
+        } else {
+            ok = scanner.skipValue();
+        }
+        if (!ok) return false;
+    } while (scanner.consume(','));
+
+    return scanner.consume('}');
+}
+
+std::optional<GeoLocation> finishEntry(GeoLocation&& loc, const EntryFields& fields) {
+    if (fields.provider_failed) {
+        std::string message = "Unknown error";
+        if (!fields.message.empty() || fields.message_escaped) {
+            decodeString(fields.message, fields.message_escaped, message);
+        }
+        ComplianceMetrics::recordFailure(LookupFailure::PROVIDER_FAIL);
+        Logger::warning("GeoIP lookup failed: " + message);
+        return std::nullopt;
+    }
+    return std::move(loc);
+}
+
+bool queryMatches(const EntryFields& fields, const std::string& ip_address) {
+    if (!fields.query_escaped) {
+        return fields.query == ip_address;
+    }
+    std::string decoded;
+    return decodeString(fields.query, true, decoded) && decoded == ip_address;
+}
+
+} // namespace
+
+std::optional<GeoLocation> parseGeoIPResponse(std::string_view body, const std::string& ip_address,
+                                              bool* malformed) {
+    JsonScanner scanner(body);
+    GeoLocation loc = emptyLocation(ip_address);
+    EntryFields fields;
+    if (malformed) *malformed = false;
+    if (!scanEntry(scanner, loc, fields) || !scanner.atEnd()) {
+        if (malformed) *malformed = true;
+        ComplianceMetrics::recordFailure(LookupFailure::PARSE_ERROR);
+        Logger::error("Failed to parse GeoIP response: malformed JSON at offset " +
+                      std::to_string(scanner.offset()));
+        return std::nullopt;
+    }
+    return finishEntry(std::move(loc), fields);
+}
+
+bool parseGeoIPBatchResponse(std::string_view body, std::span<const std::string> ip_addresses,
+                             const std::function<void(size_t, std::optional<GeoLocation>)>& on_result) {
+    JsonScanner scanner(body);
+    if (!scanner.consume('[')) {
+        ComplianceMetrics::recordFailure(LookupFailure::PARSE_ERROR);
+        Logger::error("GeoIP batch response is not an array");
+        return false;
+    }
+
+    bool ok = true;
+    if (!scanner.consume(']')) {
+        // ip-api answers in request order
+        size_t i = 0;
+        do {
+            if (!scanner.peek('{')) {
+                ok = scanner.skipValue();
+            } else {
+                GeoLocation loc = emptyLocation(i < ip_addresses.size() ? ip_addresses[i] : std::string());
+                EntryFields fields;
+                ok = scanEntry(scanner, loc, fields);
+                if (ok && i < ip_addresses.size() && queryMatches(fields, ip_addresses[i])) {
+                    on_result(i, finishEntry(std::move(loc), fields));
+                }
+            }
+            ++i;
+        } while (ok && scanner.consume(','));
+        ok = ok && scanner.consume(']');
+    }
+
+    if (!ok || !scanner.atEnd()) {
+        ComplianceMetrics::recordFailure(LookupFailure::PARSE_ERROR);
+        Logger::error("Failed to parse GeoIP batch response: malformed JSON at offset " +
+                      std::to_string(scanner.offset()));
+        return false;
+    }
+    return true;
+}
+
+} // namespace SpectreMap::Compliance
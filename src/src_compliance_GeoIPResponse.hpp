@@ -0,0 +1,63 @@
+/**
+ * @file GeoIPResponse.hpp
+ * @brief Parsing of ip-api GeoIP responses into GeoLocation records
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * Shared by the blocking, batch and async lookup paths, and exposed on its
+ * own so the parser can be benchmarked without a network round trip.
+ *
+ * Responses are scanned in place rather than parsed into a DOM: only the
+ * fields GeoLocation needs are extracted, and each string field costs at
+ * most one allocation.
+ */
+
+#ifndef SPECTREMAP_GEOIPRESPONSE_HPP
+#define SPECTREMAP_GEOIPRESPONSE_HPP
+
+#include "GeoRestriction.hpp"
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace SpectreMap::Compliance {
+
+// Fields requested from ip-api for both single and batch lookups
+inline constexpr const char* GEOIP_FIELDS =
+    "status,message,query,country,countryCode,region,regionName,city,lat,lon,isp,as,proxy,hosting";
+
+// Initial capacity of response buffers (a single ip-api response is ~300 bytes)
+inline constexpr size_t GEOIP_RESPONSE_RESERVE = 1024;
+
+/**
+ * @brief Parse a single-lookup response body
+ * @param ip_address Address the lookup was made for
+ * @param malformed Set to true if the body is not a well-formed response, as
+ *        opposed to one reporting a failure (optional)
+ * @return Location, or nullopt if the body is malformed or reports a failure (details are logged)
+ */
+std::optional<GeoLocation> parseGeoIPResponse(std::string_view body, const std::string& ip_address,
+                                              bool* malformed = nullptr);
+
+/**
+ * @brief Parse a /batch response body
+ *
+ * Entries are matched to requests by position and must echo the requested
+ * address in "query"; anything else is skipped so a reordered or short
+ * response can't misattribute a location. Entries are delivered as they
+ * are scanned, so those before a syntax error have already been reported
+ * when false is returned.
+ *
+ * @param ip_addresses Addresses in the order they were requested
+ * @param on_result Called with the request index of every address the
+ *        provider answered (nullopt if it answered with a failure)
+ * @return False if the body is not a well-formed JSON array
+ */
+bool parseGeoIPBatchResponse(std::string_view body, std::span<const std::string> ip_addresses,
+                             const std::function<void(size_t, std::optional<GeoLocation>)>& on_result);
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_GEOIPRESPONSE_HPP
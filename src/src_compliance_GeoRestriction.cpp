@@ -4,149 +4,695 @@
  */
 
 #include "GeoRestriction.hpp"
+#include "MmdbReader.hpp"
+#include "GeoCache.hpp"
+#include "CurlPool.hpp"
+#include "GeoIPReactor.hpp"
+#include "GeoIPResponse.hpp"
+#include "GeoIPProviders.hpp"
+#include "AuditLog.hpp"
+#include "AnonymizerIndex.hpp"
+#include "DecisionCache.hpp"
+#include "CountryDatabase.hpp"
+#include "CountryClassifier.hpp"
+#include "ComplianceMetrics.hpp"
+#include "ComplianceLog.hpp"
+#include "SanctionsPolicy.hpp"
+#include "RegionIndex.hpp"
+#include "LookupCoalescer.hpp"
 #include "../core/Logger.hpp"
 #include <curl/curl.h>
 #include <nlohmann/json.hpp>
-#include <fstream>
-#include <sstream>
-#include <ctime>
-#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <unordered_map>
 
 using json = nlohmann::json;
 
 namespace SpectreMap::Compliance {
 
-// ============================================================================
-// OFAC Comprehensive Sanctions (31 CFR) - COMPLETE BLOCK
-// ============================================================================
-const std::unordered_set<std::string> GeoRestriction::OFAC_SANCTIONED_COUNTRIES = {
-    "CU",  // Cuba - 31 CFR Part 515
-    "IR",  // Iran - 31 CFR Part 560
-    "KP",  // North Korea (DPRK) - 31 CFR Part 510
-    "SY",  // Syria - 31 CFR Part 542
-    
-    // Crimea and specific regions of Ukraine (31 CFR Part 589)
-    "XCR", // Crimea region (special code)
-    "XDO", // Donetsk region (special code)
-    "XLU", // Luhansk region (special code)
-};
+namespace {
 
-// ============================================================================
-// OFAC Partial/Sectoral Sanctions - HIGH RISK (Manual Review Required)
-// ============================================================================
-const std::unordered_set<std::string> GeoRestriction::OFAC_PARTIAL_SANCTIONS = {
-    "RU",  // Russia - 31 CFR Part 589 (Sectoral sanctions, especially tech sector)
-    "BY",  // Belarus - 31 CFR Part 548 (Sectoral sanctions)
-};
+// ip-api's /batch endpoint accepts at most 100 queries per POST
+constexpr size_t GEOIP_MAX_BATCH_SIZE = 100;
 
-// ============================================================================
-// UN/EU Arms Embargoes and State Department Restrictions
-// ============================================================================
-const std::unordered_set<std::string> GeoRestriction::ARMS_EMBARGO_COUNTRIES = {
-    "SO",  // Somalia - UN arms embargo
-    "SS",  // South Sudan - UN arms embargo
-    "SD",  // Sudan - UN/US arms embargo
-    "LY",  // Libya - UN arms embargo
-    "CF",  // Central African Republic - UN arms embargo
-    "VE",  // Venezuela - US arms embargo
-    "MM",  // Myanmar (Burma) - US/EU restrictions
-    "YE",  // Yemen - UN arms embargo (partial)
-    "LB",  // Lebanon - Arms embargo (Hezbollah)
-    "CD",  // Democratic Republic of Congo - UN arms embargo (partial)
-    "ER",  // Eritrea - UN arms embargo
+/**
+ * @brief Readers of every SharedSnapshot, counted in two phases over per-thread shards
+ *
+ * A reader enters the current phase on its own cache line; a writer that
+ * has unpublished a value flips the phase and waits for the old one to
+ * empty, twice, after which no reader can still see that value.
+ */
+class SnapshotReaders {
+public:
+    static SnapshotReaders& instance() {
+        // Never destroyed: instances may be torn down during static destruction
+        static SnapshotReaders* readers = new SnapshotReaders();
+        return *readers;
+    }
+    
+    std::atomic<int64_t>& enter() noexcept {
+        static std::atomic<size_t> next_shard{0};
+        thread_local const size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+        const size_t phase = phase_.load(std::memory_order_seq_cst) & 1;
+        std::atomic<int64_t>& count = counts_[phase][shard].value;
+        count.fetch_add(1, std::memory_order_seq_cst);
+        return count;
+    }
+    
+    static void leave(std::atomic<int64_t>& count) noexcept {
+        count.fetch_sub(1, std::memory_order_release);
+    }
+    
+    /**
+     * @brief Wait until every read that started before the call has ended
+     */
+    void synchronize() {
+        std::lock_guard lock(mutex_);
+        for (int flip = 0; flip < 2; ++flip) {
+            const size_t phase = phase_.fetch_add(1, std::memory_order_seq_cst) & 1;
+            for (const Shard& shard : counts_[phase]) {
+                while (shard.value.load(std::memory_order_seq_cst) != 0) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+    
+private:
+    static constexpr size_t SHARDS = 32;
+    
+    struct alignas(64) Shard {
+        std::atomic<int64_t> value{0};
+    };
+    
+    std::mutex mutex_;
+    std::atomic<size_t> phase_{0};
+    Shard counts_[2][SHARDS];
 };
 
-// ============================================================================
-// High-Risk Countries (BIS Entity List concentrations, export license likely needed)
-// ============================================================================
-const std::unordered_set<std::string> GeoRestriction::HIGH_RISK_COUNTRIES = {
-    "CN",  // China - Many entities on BIS Entity List (tech sector)
-    "HK",  // Hong Kong - Export control concerns
-    "PK",  // Pakistan - Proliferation concerns
-    "AF",  // Afghanistan - Security concerns
-    "IQ",  // Iraq - Security and proliferation concerns
-    
-    // Countries with weak export control enforcement
-    "AE",  // UAE - Transshipment risk
-    "TR",  // Turkey - Transshipment concerns
-    "EG",  // Egypt - Some restrictions
+/**
+ * @brief shared_ptr slot that many threads read while a setter replaces it
+ *
+ * The value is published through an atomic raw pointer. borrow() reads it
+ * with no lock and no reference count, valid until the borrow ends; load()
+ * copies the shared_ptr for callers that keep the object past a short,
+ * non-blocking use. A replaced value is released only after every borrow
+ * that could see it has ended, by whoever drops it last (store() releases
+ * its own reference on return; exchange() hands it back). A borrow must not
+ * block or replace a snapshot value, since replacing one waits for borrows.
+ * (libstdc++ 12's std::atomic<std::shared_ptr> unlocks its internal spin
+ * bit with relaxed ordering after a load, which is not safe on
+ * weakly-ordered CPUs.)
+ */
+template <typename T>
+class SharedSnapshot {
+    struct Node {
+        std::shared_ptr<T> value;
+    };
+    
+public:
+    class Borrowed {
+    public:
+        Borrowed(const Borrowed&) = delete;
+        Borrowed& operator=(const Borrowed&) = delete;
+        ~Borrowed() { SnapshotReaders::leave(count_); }
+        
+        T* get() const noexcept { return node_ ? node_->value.get() : nullptr; }
+        T* operator->() const noexcept { return get(); }
+        T& operator*() const noexcept { return *get(); }
+        explicit operator bool() const noexcept { return get() != nullptr; }
+        
+    private:
+        friend class SharedSnapshot;
+        Borrowed(std::atomic<int64_t>& count, const Node* node) noexcept : count_(count), node_(node) {}
+        
+        std::atomic<int64_t>& count_;
+        const Node* node_;
+    };
+    
+    SharedSnapshot() = default;
+    explicit SharedSnapshot(std::shared_ptr<T> value) : node_(value ? new Node{std::move(value)} : nullptr) {}
+    ~SharedSnapshot() { delete node_.load(std::memory_order_relaxed); }
+    
+    SharedSnapshot(const SharedSnapshot&) = delete;
+    SharedSnapshot& operator=(const SharedSnapshot&) = delete;
+    
+    Borrowed borrow() const noexcept {
+        std::atomic<int64_t>& count = SnapshotReaders::instance().enter();
+        return Borrowed(count, node_.load(std::memory_order_seq_cst));
+    }
+    
+    std::shared_ptr<T> load() const {
+        const Borrowed borrowed = borrow();
+        return borrowed.node_ ? borrowed.node_->value : nullptr;
+    }
+    
+    void store(std::shared_ptr<T> value) {
+        exchange(std::move(value));
+        // The previous value is released here, once no borrow can reach it
+    }
+    
+    /**
+     * @brief store() that hands the previous value back, for callers that must choose where it dies
+     */
+    std::shared_ptr<T> exchange(std::shared_ptr<T> value) {
+        std::unique_ptr<Node> retired(node_.exchange(value ? new Node{std::move(value)} : nullptr,
+                                                     std::memory_order_seq_cst));
+        SnapshotReaders::instance().synchronize();
+        return retired ? std::move(retired->value) : nullptr;
+    }
+    
+private:
+    std::atomic<Node*> node_{nullptr};
 };
 
+RestrictionDecision makeDecision(const CountryRecord* record, std::string_view country_code) noexcept {
+    // Default: ALLOWED
+    if (!record) {
+        return RestrictionDecision{
+            .allowed = true,
+            .level = RestrictionLevel::ALLOWED,
+            .country_code = country_code,
+            .country_name = CountryDatabase::getCountryName(country_code),
+            .reason = "No export restrictions",
+            .applicable_regulations = {}
+        };
+    }
+    
+    return RestrictionDecision{
+        .allowed = record->allowed(),
+        .level = record->level(),
+        .country_code = record->code,
+        .country_name = record->name,
+        .reason = record->reason(),
+        .applicable_regulations = record->regulations
+    };
+}
+
+} // namespace
+
 // ============================================================================
 // Implementation Class
 // ============================================================================
 class GeoRestriction::Impl {
 public:
-    bool strict_mode = true;
-    std::string audit_log_path = "logs/compliance_audit.log";
+    /**
+     * @brief Online provider settings, replaced as a whole by the setters
+     */
+    struct ClientState {
+        // ip-api's free tier: 45 single lookups and 15 batches a minute
+        std::shared_ptr<GeoIPProviderSet> providers = std::make_shared<GeoIPProviderSet>(
+            std::vector<GeoIPProvider>{{.name = "ip-api",
+                                        .lookup_url = "http://ip-api.com/json/",
+                                        .batch_url = "http://ip-api.com/batch",
+                                        .requests_per_minute = 45,
+                                        .batch_requests_per_minute = 15}},
+            GeoIPFailoverConfig{});
+        GeoIPClientConfig config;
+        std::shared_ptr<CurlPool> pool;
+    };
+    
+    // Readers borrow or load these snapshots lock-free; setters swap in replacements
+    // under config_mutex, and a replaced object lives until its last reader drops it
+    std::atomic<bool> strict_mode{true};
+    SharedSnapshot<const ClientState> client{makeClientState({})};
+    SharedSnapshot<AuditLogWriter> audit_log{std::make_shared<AuditLogWriter>(AuditLogConfig{})};
+    SharedSnapshot<const MmdbReader> offline_db;     // nullptr: online lookups
+    SharedSnapshot<GeoCache> cache{std::make_shared<GeoCache>(GeoCacheConfig{})};  // nullptr: disabled
+    SharedSnapshot<DecisionCache> decisions{std::make_shared<DecisionCache>(DecisionCacheConfig{})};  // nullptr: disabled
+    SharedSnapshot<GeoIPReactor> reactor;            // Started on first asynchronous lookup
+    SharedSnapshot<const AnonymizerIndex> anonymizers;  // nullptr: provider flags only
+    SharedSnapshot<const RegionIndex> regions;       // nullptr: country codes only
+    std::atomic<bool> block_hosting{false};
+    LookupCoalescer inflight;                        // Online lookups shared by concurrent checks
     
-    // GeoIP service configuration
-    std::string geoip_api_url = "http://ip-api.com/json/";
-    bool use_offline_db = false;
+    std::mutex config_mutex;
+    std::unique_ptr<SanctionsWatcher> sanctions_watcher;
+    std::unique_ptr<AnonymizerRefresher> anonymizer_refresher;  // Publishes into anonymizers
     
-    std::optional<GeoLocation> queryGeoIP(const std::string& ip_address) {
-        if (use_offline_db) {
-            return queryOfflineDatabase(ip_address);
+    static std::shared_ptr<const ClientState> makeClientState(ClientState state) {
+        if (!state.pool) {
+            state.pool = std::make_shared<CurlPool>(state.config);
         }
-        return queryOnlineService(ip_address);
+        return std::make_shared<const ClientState>(std::move(state));
     }
     
-    std::optional<GeoLocation> queryOnlineService(const std::string& ip) {
-        CURL* curl = curl_easy_init();
-        if (!curl) return std::nullopt;
-        
-        std::string response_data;
-        std::string url = geoip_api_url + ip + "?fields=status,message,country,countryCode,region,city,lat,lon,isp,as,proxy,hosting";
+    std::shared_ptr<GeoIPReactor> asyncReactor() {
+        if (auto running = reactor.load()) {
+            return running;
+        }
+        std::lock_guard lock(config_mutex);
+        auto running = reactor.load();
+        if (!running) {
+            running = std::make_shared<GeoIPReactor>(client.load()->config);
+            reactor.store(running);
+        }
+        return running;
+    }
+    
+    /**
+     * @brief Provider flags for a location combined with the local lists
+     */
+    uint8_t anonymizerFlags(const IpAddress& address, const GeoLocation& loc) const {
+        uint8_t flags = ANONYMIZER_NONE;
+        if (loc.is_tor) flags |= ANONYMIZER_TOR;
+        if (loc.is_vpn || loc.is_proxy) flags |= ANONYMIZER_VPN;
+        if (loc.is_hosting) flags |= ANONYMIZER_HOSTING;
+        if (auto index = anonymizers.borrow()) {
+            flags |= index->lookup(address);
+            if (index->isHostingAsn(loc.asn)) flags |= ANONYMIZER_HOSTING;
+        }
+        return flags;
+    }
+    
+    uint8_t blockedAnonymizerFlags() const {
+        uint8_t blocked = ANONYMIZER_TOR | ANONYMIZER_VPN;
+        if (block_hosting.load(std::memory_order_relaxed)) blocked |= ANONYMIZER_HOSTING;
+        return blocked;
+    }
+    
+    static RestrictionResult anonymizerBlock(const IpAddress& address, const std::string& country_code,
+                                             const std::string& country_name) {
+        ComplianceLog::log<ComplianceEvent::ANONYMIZER_BLOCKED>({
+            .country_code = country_code, .country_name = country_name, .address = &address});
+        ComplianceMetrics::recordAnonymizerBlock();
+        ComplianceMetrics::recordDecision(RestrictionLevel::RESTRICTED);
+        return RestrictionResult{
+            .allowed = false,
+            .level = RestrictionLevel::RESTRICTED,
+            .country_code = country_code,
+            .country_name = country_name,
+            .reason = "VPN/Proxy/Tor access blocked for export compliance verification",
+            .applicable_regulations = {"Export Compliance Policy"}
+        };
+    }
+    
+    /**
+     * @brief Decision cached for the network containing an address
+     */
+    std::optional<RestrictionResult> cachedDecision(DecisionCache& decisions, const DecisionCache::Address& key,
+                                                    const IpAddress& address) {
+        RestrictionResult result;
+        {
+            StageTimer timer(CheckStage::CACHE);
+            if (!decisions.lookup(key, result)) return std::nullopt;
+        }
+        // The local lists are finer-grained than the cached network
+        if (result.allowed && strict_mode.load(std::memory_order_relaxed)) {
+            auto index = anonymizers.borrow();
+            if (index && (index->lookup(address) & blockedAnonymizerFlags())) {
+                return anonymizerBlock(address, result.country_code, result.country_name);
+            }
+        }
+        ComplianceMetrics::recordDecision(result.level);
+        return result;
+    }
+    
+    /**
+     * @brief cachedDecision() under a borrow of the current decision cache
+     */
+    std::optional<RestrictionResult> borrowedDecision(const IpAddress& address) {
+        auto borrowed = decisions.borrow();
+        if (!borrowed) return std::nullopt;
+        return cachedDecision(*borrowed, DecisionCache::from(address), address);
+    }
+    
+    /**
+     * @brief Cache a decision for the network it applies to
+     * @param decided Taken from decisions before the lookup
+     */
+    void rememberDecision(DecisionCache& decisions, const DecisionCache::Address& key,
+                          const IpAddress& address, std::optional<uint8_t> prefix_length,
+                          const std::optional<GeoLocation>& loc, const RestrictionResult& result,
+                          const DecisionCache::Epoch& decided) const {
+        // Failures are retried per address (GeoCache keeps the negative entry)
+        if (!loc) return;
+        // An individually listed address must not decide for its neighbours
+        if (auto index = anonymizers.borrow(); index && index->lookup(address) != ANONYMIZER_NONE) return;
+        // Nor may one the provider flags: those flags describe the address, not its network
+        if (loc->is_tor || loc->is_vpn || loc->is_proxy || loc->is_hosting) {
+            prefix_length = static_cast<uint8_t>(key.is_v4 ? 32 : 128);
+        }
+        decisions.insert(key, prefix_length, result, decided);
+    }
+    
+    /**
+     * @brief Fill is_tor/is_vpn/is_hosting from the local lists
+     */
+    void annotate(std::optional<GeoLocation>& loc, const IpAddress& address) const {
+        auto index = anonymizers.borrow();
+        if (!loc || !index) return;
+        const uint8_t flags = index->lookup(address);
+        loc->is_tor = loc->is_tor || (flags & ANONYMIZER_TOR);
+        loc->is_vpn = loc->is_vpn || (flags & ANONYMIZER_VPN);
+        loc->is_hosting = loc->is_hosting || (flags & ANONYMIZER_HOSTING) || index->isHostingAsn(loc->asn);
+    }
+    
+    /**
+     * @brief Log and count text that is not an IP address (never sent to a provider)
+     */
+    static void reportMalformed(std::string_view text) {
+        ComplianceMetrics::recordFailure(LookupFailure::INVALID_ADDRESS);
+        ComplianceLog::log<ComplianceEvent::MALFORMED_ADDRESS>({.ip = text});
+    }
+    
+    static RestrictionResult malformedResult(std::string_view text) {
+        reportMalformed(text);
+        ComplianceMetrics::recordDecision(RestrictionLevel::RESTRICTED);
+        return RestrictionResult{
+            .allowed = false,
+            .level = RestrictionLevel::RESTRICTED,
+            .country_code = "UNKNOWN",
+            .country_name = "Unknown",
+            .reason = "Malformed IP address - access denied for compliance",
+            .applicable_regulations = {"US EAR", "OFAC"}
+        };
+    }
+    
+    /**
+     * @brief Answers for the provider list's OFFLINE_DATABASE entry
+     * @param prefix_length Receives the network length of an answer (optional)
+     */
+    GeoIPProviderSet::OfflineLookup offlineLookup(std::optional<uint8_t>* prefix_length) const {
+        return [this, prefix_length](const std::string& ip) -> std::optional<GeoLocation> {
+            auto db = offline_db.load();
+            const auto address = IpAddress::parse(ip);
+            if (!db || !address) return std::nullopt;
+            return queryOfflineDatabase(*db, *address, prefix_length);
+        };
+    }
+    
+    /**
+     * @brief Whether a loaded offline database answers every lookup
+     *
+     * True unless the provider list places the database itself, in which
+     * case it is consulted in list order.
+     */
+    std::shared_ptr<const MmdbReader> exclusiveOfflineDatabase() const {
+        if (client.borrow()->providers->hasOfflineDatabase()) {
+            return nullptr;
+        }
+        return offline_db.load();
+    }
+    
+    /**
+     * @param prefix_length Receives the network length for offline lookups
+     */
+    std::optional<GeoLocation> queryGeoIP(const IpAddress& address,
+                                          std::optional<uint8_t>* prefix_length = nullptr) {
+        if (auto db = exclusiveOfflineDatabase()) {
+            // Local lookups are cheaper than a cache probe
+            return queryOfflineDatabase(*db, address, prefix_length);
+        }
+        // The canonical text is both the cache key and what the provider is sent
+        const std::string key = address.toString();
+        if (auto borrowed = this->cache.borrow()) {
+            GeoLocation cached;
+            GeoCache::Status status;
+            {
+                StageTimer timer(CheckStage::CACHE);
+                status = borrowed->lookup(key, cached);
+            }
+            switch (status) {
+                case GeoCache::Status::HIT:
+                    cached.ip_address = key;
+                    return cached;
+                case GeoCache::Status::NEGATIVE_HIT:
+                    return std::nullopt;
+                case GeoCache::Status::MISS:
+                    break;
+            }
+        }
         
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_data);
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 5L);
+        // The online lookup blocks, so it holds a reference rather than a borrow
+        auto cache = this->cache.load();
+        return querySharedOnline(key, cache.get(), prefix_length);
+    }
+    
+    /**
+     * @brief Online lookup that concurrent checks of the same address wait on
+     * @param cache Receives the leader's answer (optional)
+     */
+    std::optional<GeoLocation> querySharedOnline(const std::string& key, GeoCache* cache,
+                                                 std::optional<uint8_t>* prefix_length) {
+        const auto deadline = LookupCoalescer::Clock::now() + client.load()->config.total_timeout;
+        LookupCoalescer::Result shared;
+        LookupCoalescer::Lead lead;   // Fails the followers if the lookup throws
+        const auto role = inflight.join(key, LookupPriority::INTERACTIVE, deadline, shared, lead);
+        if (role != LookupCoalescer::Role::FOLLOW) {
+            shared.location = queryOnlineService(key, &shared.prefix_length);
+            if (cache) {
+                if (shared.location) cache->insert(key, *shared.location);
+                else cache->insertNegative(key);
+            }
+            lead.finish(shared);
+        }
+        if (prefix_length) {
+            *prefix_length = shared.prefix_length;
+        }
+        return shared.location;
+    }
+    
+    /**
+     * @param prefix_lengths Resized to addresses.size(); receives network lengths for offline lookups
+     */
+    std::vector<std::optional<GeoLocation>> queryGeoIPBatch(
+        std::span<const IpAddress> addresses, std::vector<std::optional<uint8_t>>* prefix_lengths = nullptr) {
+        std::vector<std::optional<GeoLocation>> results(addresses.size());
+        if (prefix_lengths) {
+            prefix_lengths->assign(addresses.size(), std::nullopt);
+        }
         
-        CURLcode res = curl_easy_perform(curl);
-        curl_easy_cleanup(curl);
+        if (auto db = exclusiveOfflineDatabase()) {
+            for (size_t i = 0; i < addresses.size(); ++i) {
+                results[i] = queryOfflineDatabase(*db, addresses[i], prefix_lengths ? &(*prefix_lengths)[i] : nullptr);
+            }
+            return results;
+        }
+        auto cache = this->cache.load();
         
-        if (res != CURLE_OK) {
-            Logger::warning("GeoIP query failed for " + ip);
-            return std::nullopt;
+        // Serve what we can from cache and collapse duplicates so each
+        // distinct address is sent to the provider once
+        std::vector<std::string> pending;
+        std::unordered_map<std::string, std::vector<size_t>> waiters;
+        for (size_t i = 0; i < addresses.size(); ++i) {
+            std::string key = addresses[i].toString();
+            if (cache) {
+                GeoLocation cached;
+                auto status = cache->lookup(key, cached);
+                if (status == GeoCache::Status::HIT) {
+                    cached.ip_address = std::move(key);
+                    results[i] = std::move(cached);
+                    continue;
+                }
+                if (status == GeoCache::Status::NEGATIVE_HIT) {
+                    continue;
+                }
+            }
+            auto& indices = waiters[key];
+            if (indices.empty()) {
+                pending.push_back(std::move(key));
+            }
+            indices.push_back(i);
         }
         
-        try {
-            json j = json::parse(response_data);
-            
-            if (j["status"] == "fail") {
-                Logger::warning("GeoIP lookup failed: " + j.value("message", "Unknown error"));
-                return std::nullopt;
+        auto fill = [&](const std::string& key, const std::optional<GeoLocation>& loc) {
+            if (!loc) return;
+            for (size_t index : waiters[key]) {
+                results[index] = *loc;
+                results[index]->ip_address = key;
             }
+        };
+        
+        const auto timeout = client.load()->config.total_timeout;
+        for (size_t start = 0; start < pending.size(); start += GEOIP_MAX_BATCH_SIZE) {
+            const size_t count = std::min(GEOIP_MAX_BATCH_SIZE, pending.size() - start);
             
-            GeoLocation loc;
-            loc.ip_address = ip;
-            loc.country_code = j.value("countryCode", "");
-            loc.country_name = j.value("country", "");
-            loc.region = j.value("region", "");
-            loc.city = j.value("city", "");
-            loc.latitude = j.value("lat", 0.0);
-            loc.longitude = j.value("lon", 0.0);
-            loc.asn = j.value("as", "");
-            loc.org = j.value("isp", "");
-            loc.is_proxy = j.value("proxy", false);
-            loc.is_vpn = false; // Would need enhanced API
-            loc.is_tor = false;  // Would need Tor exit node list
-            loc.is_hosting = j.value("hosting", false);
+            // Addresses another check is already looking up are waited on, not sent again.
+            // A chunk may wait for the batch budget, then send: two timeouts at most.
+            const auto deadline = LookupCoalescer::Clock::now() + 2 * timeout;
+            std::vector<std::string> sent;
+            std::vector<LookupCoalescer::Lead> leads;   // Unfinished leads fail their followers on unwind
+            std::vector<std::pair<size_t, std::future<LookupCoalescer::Result>>> followed;
+            for (size_t p = start; p < start + count; ++p) {
+                auto answered = std::make_shared<std::promise<LookupCoalescer::Result>>();
+                auto future = answered->get_future();
+                LookupCoalescer::Lead lead;
+                const auto role = inflight.join(pending[p], LookupPriority::BULK, deadline,
+                    [answered](const LookupCoalescer::Result& found) { answered->set_value(found); }, lead);
+                if (role == LookupCoalescer::Role::FOLLOW) {
+                    followed.emplace_back(p, std::move(future));
+                } else {
+                    sent.push_back(pending[p]);
+                    leads.push_back(std::move(lead));
+                }
+            }
             
-            return loc;
+            std::span<const std::string> chunk(sent);
+            std::vector<std::optional<GeoLocation>> found(chunk.size());
+            std::vector<bool> answered(chunk.size(), false);
+            const bool rate_limited = !chunk.empty() &&
+                queryOnlineBatch(chunk, [&](size_t index, const std::optional<GeoLocation>& loc) {
+                    answered[index] = true;
+                    found[index] = loc;
+                });
             
-        } catch (const json::exception& e) {
-            Logger::error("Failed to parse GeoIP response: " + std::string(e.what()));
-            return std::nullopt;
+            for (size_t i = 0; i < chunk.size(); ++i) {
+                // Transport failures and entries missing from the response are
+                // retried one at a time; explicit provider failures are not. A
+                // chunk refused for want of budget fails closed.
+                if (!answered[i] && !rate_limited) {
+                    found[i] = queryOnlineService(chunk[i], nullptr, LookupPriority::BULK);
+                }
+                if (cache) {
+                    if (found[i]) cache->insert(chunk[i], *found[i]);
+                    else cache->insertNegative(chunk[i]);
+                }
+                leads[i].finish({found[i], std::nullopt});
+                fill(chunk[i], found[i]);
+            }
+            // Only after finishing our own leads, which other batches may be following.
+            // A leader that misses the shared deadline leaves its followers unresolved.
+            for (auto& [p, future] : followed) {
+                if (future.wait_until(deadline) == std::future_status::ready) {
+                    fill(pending[p], future.get().location);
+                }
+            }
         }
+        
+        return results;
     }
     
-    std::optional<GeoLocation> queryOfflineDatabase(const std::string& ip) {
-        // TODO: Implement MaxMind GeoIP2 or similar offline database
-        // For production use, integrate GeoLite2 database
-        Logger::warning("Offline GeoIP database not yet implemented");
-        return std::nullopt;
+    /**
+     * @brief Ask the providers in order, hedging and failing over between them
+     * @param prefix_length Receives the network length if the offline entry answered
+     */
+    std::optional<GeoLocation> queryOnlineService(const std::string& ip,
+                                                  std::optional<uint8_t>* prefix_length = nullptr,
+                                                  LookupPriority priority = LookupPriority::INTERACTIVE) {
+        const auto state = client.load();
+        return state->providers->lookup(ip, *state->pool, offlineLookup(prefix_length), priority);
+    }
+    
+    /**
+     * @brief POST up to GEOIP_MAX_BATCH_SIZE addresses to the batch endpoint
+     * @param on_result Called with the chunk index of every address the
+     *        provider answered (nullopt if it answered with a failure)
+     * @return True if the batch budget ran out or the provider throttled the batch
+     */
+    template <typename Callback>
+    bool queryOnlineBatch(std::span<const std::string> ips, Callback&& on_result) {
+        const auto state = client.load();
+        // Without an admitted batch provider every address is looked up singly
+        bool rate_limited = false;
+        const auto provider = state->providers->acquireBatchProvider(
+            GeoIPProviderSet::Clock::now() + state->config.total_timeout, rate_limited);
+        if (!provider) {
+            if (rate_limited) {
+                Logger::warning("GeoIP batch rate limit reached - " + std::to_string(ips.size()) +
+                                " addresses fail closed");
+            }
+            return rate_limited;
+        }
+        auto handle = state->pool->acquire();
+        if (!handle) {
+            ComplianceMetrics::recordFailure(LookupFailure::CURL_ERROR);
+            state->providers->recordBatch(*provider, false, GeoIPRateHeaders{});
+            return false;
+        }
+        CURL* curl = handle.get();
+        
+        json request = json::array();
+        for (const auto& ip : ips) {
+            request.push_back(ip);
+        }
+        const std::string body = request.dump();
+        const std::string url = state->providers->provider(*provider).batch_url + "?fields=" + GEOIP_FIELDS;
+        
+        thread_local std::string response_data;
+        response_data.clear();
+        response_data.reserve(GEOIP_MAX_BATCH_SIZE * GEOIP_RESPONSE_RESERVE / 2);
+        GeoIPRateHeaders rate;
+        struct curl_slist* headers = curl_slist_append(nullptr, "Content-Type: application/json");
+        
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(body.size()));
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_data);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, captureRateHeaders);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &rate);
+        
+        CURLcode res;
+        {
+            StageTimer timer(CheckStage::LOOKUP);
+            res = curl_easy_perform(curl);
+        }
+        long http_status = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_status);
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, nullptr);
+        curl_slist_free_all(headers);
+        rate.throttled = http_status == 429;
+        
+        if (res != CURLE_OK || http_status != 200) {
+            ComplianceMetrics::recordFailure(res != CURLE_OK ? LookupFailure::CURL_ERROR
+                                                             : LookupFailure::HTTP_STATUS);
+            state->providers->recordBatch(*provider, false, rate);
+            if (rate.throttled) {
+                Logger::warning("GeoIP batch throttled by " + state->providers->provider(*provider).name +
+                                " - " + std::to_string(ips.size()) + " addresses fail closed");
+                return true;
+            }
+            Logger::warning("GeoIP batch query failed for " + std::to_string(ips.size()) +
+                            " addresses - falling back to single lookups");
+            return false;
+        }
+        
+        StageTimer timer(CheckStage::PARSE);
+        state->providers->recordBatch(*provider, parseGeoIPBatchResponse(response_data, ips, on_result), rate);
+        return false;
+    }
+    
+    static std::optional<GeoLocation> queryOfflineDatabase(const MmdbReader& db, const IpAddress& address,
+                                                           std::optional<uint8_t>* prefix_length = nullptr) {
+        StageTimer timer(CheckStage::LOOKUP);
+        auto record = db.lookup(address);
+        if (!record || record->country_code.empty()) {
+            ComplianceMetrics::recordFailure(LookupFailure::OFFLINE_MISS);
+            ComplianceLog::log<ComplianceEvent::OFFLINE_MISS>({.address = &address});
+            return std::nullopt;
+        }
+        if (prefix_length) {
+            *prefix_length = record->prefix_length;
+        }
+        
+        GeoLocation loc;
+        loc.ip_address = address.toString();
+        loc.country_code = std::string(record->country_code);
+        loc.country_name = std::string(record->country_name);
+        loc.region = std::string(record->region);
+        loc.region_code = std::string(record->region_code);
+        loc.city = std::string(record->city);
+        loc.latitude = record->latitude;
+        loc.longitude = record->longitude;
+        if (record->asn != 0) {
+            // Same "AS<number> <org>" shape ip-api returns
+            loc.asn = "AS" + std::to_string(record->asn);
+            if (!record->as_org.empty()) {
+                loc.asn += " " + std::string(record->as_org);
+            }
+        }
+        loc.org = std::string(record->as_org);
+        loc.is_proxy = record->is_anonymous_proxy;
+        loc.is_vpn = record->is_anonymous_vpn;
+        loc.is_tor = record->is_tor_exit_node;
+        loc.is_hosting = record->is_hosting_provider;
+        
+        return loc;
     }
     
     static size_t writeCallback(void* contents, size_t size, size_t nmemb, std::string* userp) {
@@ -161,23 +707,263 @@ public:
 
 GeoRestriction::GeoRestriction() : pImpl(std::make_unique<Impl>()) {
     Logger::info("Export Compliance: Geographic restriction engine initialized");
-    Logger::info("OFAC Sanctioned Countries: " + std::to_string(OFAC_SANCTIONED_COUNTRIES.size()));
-    Logger::info("Partial Sanctions (High Risk): " + std::to_string(OFAC_PARTIAL_SANCTIONS.size()));
-    Logger::info("Total Restricted Countries: " + std::to_string(
-        OFAC_SANCTIONED_COUNTRIES.size() + 
-        OFAC_PARTIAL_SANCTIONS.size() + 
-        ARMS_EMBARGO_COUNTRIES.size()
-    ));
+    const SanctionsPolicy& policy = SanctionsPolicy::current();
+    const size_t sanctioned = policy.countByProgram(SanctionsProgram::OFAC_COMPREHENSIVE);
+    const size_t partial = policy.countByProgram(SanctionsProgram::OFAC_SECTORAL);
+    const size_t embargoed = policy.countByProgram(SanctionsProgram::ARMS_EMBARGO);
+    Logger::info("OFAC Sanctioned Countries: " + std::to_string(sanctioned));
+    Logger::info("Partial Sanctions (High Risk): " + std::to_string(partial));
+    Logger::info("Total Restricted Countries: " + std::to_string(sanctioned + partial + embargoed));
 }
 
-GeoRestriction::~GeoRestriction() = default;
+GeoRestriction::~GeoRestriction() {
+    // Stop the reactor first: its shutdown completes pending async checks,
+    // which still need the rest of Impl
+    pImpl->reactor.store(nullptr);
+    ComplianceLog::flush();
+}
 
 RestrictionResult GeoRestriction::checkAccess(const std::string& ip_address) {
-    auto geo_opt = pImpl->queryGeoIP(ip_address);
+    const auto address = IpAddress::parse(ip_address);
+    if (!address) {
+        return Impl::malformedResult(ip_address);
+    }
+    return checkAccess(*address);
+}
+
+RestrictionResult GeoRestriction::checkAccess(const IpAddress& address) {
+    StageTimer timer(CheckStage::TOTAL);
+    if (auto cached = pImpl->borrowedDecision(address)) {
+        return std::move(*cached);
+    }
+    
+    // A miss looks up, which may block, so it holds a reference to the cache
+    auto decisions = pImpl->decisions.load();
+    const auto key = decisions ? std::optional(DecisionCache::from(address)) : std::nullopt;
+    DecisionCache::Epoch epoch;
+    if (key) {
+        epoch = decisions->epoch();
+    }
+    
+    std::optional<uint8_t> prefix_length;
+    auto loc = pImpl->queryGeoIP(address, &prefix_length);
+    RestrictionResult result = evaluateLocation(address, loc);
+    if (key) {
+        pImpl->rememberDecision(*decisions, *key, address, prefix_length, loc, result, epoch);
+    }
+    return result;
+}
+
+std::vector<RestrictionResult> GeoRestriction::checkAccessBatch(std::span<const std::string> ip_addresses,
+                                                                std::vector<std::optional<GeoLocation>>* locations) {
+    std::vector<IpAddress> parsed;
+    std::vector<size_t> parsed_index;
+    parsed.reserve(ip_addresses.size());
+    parsed_index.reserve(ip_addresses.size());
+    for (size_t i = 0; i < ip_addresses.size(); ++i) {
+        if (const auto address = IpAddress::parse(ip_addresses[i])) {
+            parsed.push_back(*address);
+            parsed_index.push_back(i);
+        }
+    }
+    if (parsed.size() == ip_addresses.size()) {
+        return checkAccessBatch(std::span<const IpAddress>(parsed), locations);
+    }
+    
+    // Malformed entries are answered in place without a lookup
+    std::vector<std::optional<GeoLocation>> found;
+    auto checked = checkAccessBatch(std::span<const IpAddress>(parsed), locations ? &found : nullptr);
+    if (locations) {
+        locations->assign(ip_addresses.size(), std::nullopt);
+    }
+    std::vector<RestrictionResult> results;
+    results.reserve(ip_addresses.size());
+    for (size_t i = 0, next = 0; i < ip_addresses.size(); ++i) {
+        if (next < parsed_index.size() && parsed_index[next] == i) {
+            if (locations) {
+                (*locations)[i] = std::move(found[next]);
+            }
+            results.push_back(std::move(checked[next++]));
+        } else {
+            results.push_back(Impl::malformedResult(ip_addresses[i]));
+        }
+    }
+    return results;
+}
+
+std::vector<RestrictionResult> GeoRestriction::checkAccessBatch(std::span<const IpAddress> addresses,
+                                                                std::vector<std::optional<GeoLocation>>* locations) {
+    auto decisions = pImpl->decisions.load();
+    const auto epoch = decisions ? decisions->epoch() : DecisionCache::Epoch{};
+    std::vector<std::optional<RestrictionResult>> cached(addresses.size());
+    std::vector<std::optional<DecisionCache::Address>> keys(addresses.size());
+    std::vector<IpAddress> pending;
+    std::vector<size_t> pending_index;
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        if (decisions) {
+            keys[i] = DecisionCache::from(addresses[i]);
+            if (!locations) {
+                cached[i] = pImpl->cachedDecision(*decisions, *keys[i], addresses[i]);
+            }
+        }
+        if (!cached[i]) {
+            pending.push_back(addresses[i]);
+            pending_index.push_back(i);
+        }
+    }
+    
+    std::vector<std::optional<uint8_t>> prefix_lengths;
+    auto found = pImpl->queryGeoIPBatch(pending, &prefix_lengths);
+    if (locations) {
+        locations->assign(addresses.size(), std::nullopt);
+    }
+    for (size_t p = 0; p < pending.size(); ++p) {
+        const size_t i = pending_index[p];
+        cached[i] = evaluateLocation(pending[p], found[p]);
+        if (keys[i]) {
+            pImpl->rememberDecision(*decisions, *keys[i], pending[p], prefix_lengths[p], found[p], *cached[i],
+                                    epoch);
+        }
+        if (locations) {
+            pImpl->annotate(found[p], pending[p]);
+            (*locations)[i] = std::move(found[p]);
+        }
+    }
     
+    std::vector<RestrictionResult> results;
+    results.reserve(addresses.size());
+    for (auto& result : cached) {
+        results.push_back(std::move(*result));
+    }
+    return results;
+}
+
+std::future<RestrictionResult> GeoRestriction::checkAccessAsync(const std::string& ip_address,
+                                                                std::chrono::milliseconds timeout,
+                                                                std::stop_token stop) {
+    auto promise = std::make_shared<std::promise<RestrictionResult>>();
+    auto future = promise->get_future();
+    checkAccessAsync(ip_address, [promise](RestrictionResult result) {
+        promise->set_value(std::move(result));
+    }, timeout, std::move(stop));
+    return future;
+}
+
+std::future<RestrictionResult> GeoRestriction::checkAccessAsync(const IpAddress& address,
+                                                                std::chrono::milliseconds timeout,
+                                                                std::stop_token stop) {
+    auto promise = std::make_shared<std::promise<RestrictionResult>>();
+    auto future = promise->get_future();
+    checkAccessAsync(address, [promise](RestrictionResult result) {
+        promise->set_value(std::move(result));
+    }, timeout, std::move(stop));
+    return future;
+}
+
+void GeoRestriction::checkAccessAsync(const std::string& ip_address,
+                                      std::function<void(RestrictionResult)> callback,
+                                      std::chrono::milliseconds timeout,
+                                      std::stop_token stop) {
+    const auto address = IpAddress::parse(ip_address);
+    if (!address) {
+        callback(Impl::malformedResult(ip_address));
+        return;
+    }
+    checkAccessAsync(*address, std::move(callback), timeout, std::move(stop));
+}
+
+void GeoRestriction::checkAccessAsync(const IpAddress& address,
+                                      std::function<void(RestrictionResult)> callback,
+                                      std::chrono::milliseconds timeout,
+                                      std::stop_token stop) {
+    if (auto cached = pImpl->borrowedDecision(address)) {
+        callback(std::move(*cached));
+        return;
+    }
+    
+    auto decisions = pImpl->decisions.load();
+    const auto decision_key = decisions ? std::optional(DecisionCache::from(address)) : std::nullopt;
+    DecisionCache::Epoch epoch;
+    if (decision_key) {
+        epoch = decisions->epoch();
+    }
+    
+    if (auto db = pImpl->exclusiveOfflineDatabase()) {
+        std::optional<uint8_t> prefix_length;
+        auto loc = Impl::queryOfflineDatabase(*db, address, &prefix_length);
+        RestrictionResult result = evaluateLocation(address, loc);
+        if (decision_key) {
+            pImpl->rememberDecision(*decisions, *decision_key, address, prefix_length, loc, result, epoch);
+        }
+        callback(std::move(result));
+        return;
+    }
+    
+    std::string key = address.toString();
+    if (auto cache = pImpl->cache.load()) {
+        GeoLocation cached;
+        switch (cache->lookup(key, cached)) {
+            case GeoCache::Status::HIT:
+                cached.ip_address = key;
+                callback(evaluateLocation(address, cached));
+                return;
+            case GeoCache::Status::NEGATIVE_HIT:
+                callback(evaluateLocation(address, std::nullopt));
+                return;
+            case GeoCache::Status::MISS:
+                break;
+        }
+    }
+    
+    const auto state = pImpl->client.load();
+    if (timeout <= std::chrono::milliseconds::zero()) {
+        timeout = state->config.total_timeout;
+    }
+    const auto deadline = GeoIPReactor::Clock::now() + timeout;
+    
+    auto conclude = [this, address, decisions, decision_key, epoch, callback = std::move(callback)](
+                        const std::optional<GeoLocation>& loc, std::optional<uint8_t> prefix_length) {
+        RestrictionResult result = evaluateLocation(address, loc);
+        if (decision_key) {
+            pImpl->rememberDecision(*decisions, *decision_key, address, prefix_length, loc, result, epoch);
+        }
+        callback(std::move(result));
+    };
+    
+    // A stoppable check neither leads (its stop would fail the followers) nor follows.
+    // The lead is shared by the completion's copies; dropping it unrun fails the followers.
+    auto lead = std::make_shared<LookupCoalescer::Lead>();
+    if (!stop.stop_possible()) {
+        const auto role = pImpl->inflight.join(key, LookupPriority::INTERACTIVE, deadline,
+            [conclude](const LookupCoalescer::Result& found) { conclude(found.location, found.prefix_length); },
+            *lead);
+        if (role == LookupCoalescer::Role::FOLLOW) {
+            return;
+        }
+    }
+    
+    // Written by the offline entry, if the race fails over to it
+    auto prefix_length = std::make_shared<std::optional<uint8_t>>();
+    state->providers->lookupAsync(key, pImpl->asyncReactor(), deadline, std::move(stop),
+        pImpl->offlineLookup(prefix_length.get()),
+        [this, key, lead, prefix_length, conclude = std::move(conclude)](std::optional<GeoLocation> loc) {
+            if (auto cache = pImpl->cache.load()) {
+                if (loc) cache->insert(key, *loc);
+                else cache->insertNegative(key);
+            }
+            // Followers first, so a throwing callback cannot strand them
+            lead->finish({loc, *prefix_length});
+            conclude(loc, *prefix_length);
+        });
+}
+
+RestrictionResult GeoRestriction::evaluateLocation(const IpAddress& address,
+                                                   const std::optional<GeoLocation>& geo_opt) {
+    StageTimer timer(CheckStage::CLASSIFY);
     if (!geo_opt) {
         // Failed to determine location - DENY by default (fail-secure)
-        Logger::warning("Failed to determine geolocation for " + ip_address + " - BLOCKING");
+        ComplianceLog::log<ComplianceEvent::LOCATION_UNKNOWN>({.address = &address});
+        ComplianceMetrics::recordDecision(RestrictionLevel::RESTRICTED);
         return RestrictionResult{
             .allowed = false,
             .level = RestrictionLevel::RESTRICTED,
@@ -188,253 +974,480 @@ RestrictionResult GeoRestriction::checkAccess(const std::string& ip_address) {
         };
     }
     
-    GeoLocation geo = geo_opt.value();
+    const GeoLocation& geo = *geo_opt;
     
     // Check VPN/Proxy/Tor in strict mode
-    if (pImpl->strict_mode) {
-        if (geo.is_proxy || geo.is_vpn || geo.is_tor) {
-            Logger::warning("Blocking VPN/Proxy/Tor access from " + ip_address);
-            return RestrictionResult{
-                .allowed = false,
-                .level = RestrictionLevel::RESTRICTED,
-                .country_code = geo.country_code,
-                .country_name = geo.country_name,
-                .reason = "VPN/Proxy/Tor access blocked for export compliance verification",
-                .applicable_regulations = {"Export Compliance Policy"}
-            };
+    if (pImpl->strict_mode.load(std::memory_order_relaxed)) {
+        if (pImpl->anonymizerFlags(address, geo) & pImpl->blockedAnonymizerFlags()) {
+            return Impl::anonymizerBlock(address, geo.country_code, geo.country_name);
         }
     }
     
-    return checkCountry(geo.country_code);
+    // Sanctioned regions are reported under their parent country's code
+    std::string region_code;
+    if (auto regions = pImpl->regions.borrow()) {
+        region_code = regions->classify(geo.country_code, geo.region_code, geo.latitude, geo.longitude);
+    }
+    
+    RestrictionResult result = checkCountry(region_code.empty() ? geo.country_code : region_code);
+    ComplianceMetrics::recordDecision(result.level);
+    return result;
 }
 
 RestrictionResult GeoRestriction::checkCountry(const std::string& country_code) {
-    // Check OFAC Comprehensive Sanctions - IMMEDIATE BLOCK
-    if (OFAC_SANCTIONED_COUNTRIES.count(country_code)) {
-        std::string country_name = CountryDatabase::getCountryName(country_code);
-        Logger::warning("BLOCKED: Access attempt from OFAC sanctioned country: " + country_name);
-        
-        return RestrictionResult{
-            .allowed = false,
-            .level = RestrictionLevel::COMPREHENSIVELY_SANCTIONED,
-            .country_code = country_code,
-            .country_name = country_name,
-            .reason = "Comprehensive OFAC sanctions - export prohibited under US law",
-            .applicable_regulations = CountryDatabase::getApplicableRegulations(country_code)
-        };
-    }
+    // Read the policy once so the decision and its log line agree across a reload
+    const CountryRecord* record = SanctionsPolicy::current().find(country_code);
     
-    // Check Partial Sanctions - HIGH RISK (could allow with manual review)
-    if (OFAC_PARTIAL_SANCTIONS.count(country_code)) {
-        std::string country_name = CountryDatabase::getCountryName(country_code);
-        Logger::warning("BLOCKED: Access attempt from partially sanctioned country: " + country_name);
-        
-        return RestrictionResult{
-            .allowed = false,  // BLOCKING Russia and Belarus as requested
-            .level = RestrictionLevel::RESTRICTED,
-            .country_code = country_code,
-            .country_name = country_name,
-            .reason = "Sectoral sanctions - technology exports restricted under US law",
-            .applicable_regulations = CountryDatabase::getApplicableRegulations(country_code)
-        };
-    }
-    
-    // Check Arms Embargo Countries - BLOCK
-    if (ARMS_EMBARGO_COUNTRIES.count(country_code)) {
-        std::string country_name = CountryDatabase::getCountryName(country_code);
-        Logger::warning("BLOCKED: Access attempt from arms embargo country: " + country_name);
-        
-        return RestrictionResult{
-            .allowed = false,
-            .level = RestrictionLevel::RESTRICTED,
-            .country_code = country_code,
-            .country_name = country_name,
-            .reason = "UN/US arms embargo - dual-use technology export restricted",
-            .applicable_regulations = {"US Arms Export Control Act", "UN Security Council Resolutions"}
-        };
-    }
-    
-    // Check High-Risk Countries - ALLOW but LOG
-    if (HIGH_RISK_COUNTRIES.count(country_code)) {
-        std::string country_name = CountryDatabase::getCountryName(country_code);
-        Logger::info("HIGH RISK: Access from " + country_name + " - monitoring required");
-        
-        return RestrictionResult{
-            .allowed = true,  // Allow but flag for review
-            .level = RestrictionLevel::HIGH_RISK,
-            .country_code = country_code,
-            .country_name = country_name,
-            .reason = "High-risk jurisdiction - access logged for compliance review",
-            .applicable_regulations = {"BIS Entity List Review"}
-        };
+    if (record) {
+        const ComplianceLogRecord fields{
+            .country_code = record->code, .country_name = record->name, .level = record->level()};
+        switch (record->program) {
+            case SanctionsProgram::OFAC_COMPREHENSIVE:
+                ComplianceLog::log<ComplianceEvent::SANCTIONED_COUNTRY>(fields);
+                break;
+            case SanctionsProgram::OFAC_SECTORAL:
+                // BLOCKING Russia and Belarus as requested
+                ComplianceLog::log<ComplianceEvent::SECTORAL_COUNTRY>(fields);
+                break;
+            case SanctionsProgram::ARMS_EMBARGO:
+                ComplianceLog::log<ComplianceEvent::EMBARGOED_COUNTRY>(fields);
+                break;
+            case SanctionsProgram::HIGH_RISK:
+                // Allow but flag for review
+                ComplianceLog::log<ComplianceEvent::HIGH_RISK_COUNTRY>(fields);
+                break;
+            case SanctionsProgram::NONE:
+                break;
+        }
     }
     
-    // Default: ALLOWED
+    return makeDecision(record, country_code).toResult();
+}
+
+RestrictionDecision GeoRestriction::checkCountryFast(std::string_view country_code) noexcept {
+    // One probe of the current policy yields level, name and regulations
+    return makeDecision(SanctionsPolicy::current().find(country_code), country_code);
+}
+
+size_t GeoRestriction::checkCountryBatch(std::span<const uint16_t> codes,
+                                         std::span<RestrictionLevel> levels) noexcept {
+    return CountryClassifier::classify(codes, levels);
+}
+
+size_t GeoRestriction::checkCountryBatch(std::span<const uint32_t> codes,
+                                         std::span<RestrictionLevel> levels) noexcept {
+    return CountryClassifier::classify(codes, levels);
+}
+
+RestrictionResult RestrictionDecision::toResult() const {
     return RestrictionResult{
-        .allowed = true,
-        .level = RestrictionLevel::ALLOWED,
-        .country_code = country_code,
-        .country_name = CountryDatabase::getCountryName(country_code),
-        .reason = "No export restrictions",
-        .applicable_regulations = {}
+        .allowed = allowed,
+        .level = level,
+        .country_code = std::string(country_code),
+        .country_name = std::string(country_name),
+        .reason = std::string(reason),
+        .applicable_regulations = std::vector<std::string>(applicable_regulations.begin(),
+                                                           applicable_regulations.end())
     };
 }
 
 std::optional<GeoLocation> GeoRestriction::getGeoLocation(const std::string& ip_address) {
-    return pImpl->queryGeoIP(ip_address);
+    const auto address = IpAddress::parse(ip_address);
+    if (!address) {
+        Impl::reportMalformed(ip_address);
+        return std::nullopt;
+    }
+    return getGeoLocation(*address);
+}
+
+std::optional<GeoLocation> GeoRestriction::getGeoLocation(const IpAddress& address) {
+    auto loc = pImpl->queryGeoIP(address);
+    pImpl->annotate(loc, address);
+    return loc;
+}
+
+std::vector<std::optional<GeoLocation>> GeoRestriction::getGeoLocationBatch(
+    std::span<const std::string> ip_addresses) {
+    std::vector<IpAddress> parsed;
+    std::vector<size_t> parsed_index;
+    parsed.reserve(ip_addresses.size());
+    parsed_index.reserve(ip_addresses.size());
+    for (size_t i = 0; i < ip_addresses.size(); ++i) {
+        if (const auto address = IpAddress::parse(ip_addresses[i])) {
+            parsed.push_back(*address);
+            parsed_index.push_back(i);
+        } else {
+            Impl::reportMalformed(ip_addresses[i]);
+        }
+    }
+    auto found = getGeoLocationBatch(std::span<const IpAddress>(parsed));
+    if (parsed.size() == ip_addresses.size()) {
+        return found;
+    }
+    std::vector<std::optional<GeoLocation>> locations(ip_addresses.size());
+    for (size_t p = 0; p < parsed_index.size(); ++p) {
+        locations[parsed_index[p]] = std::move(found[p]);
+    }
+    return locations;
+}
+
+std::vector<std::optional<GeoLocation>> GeoRestriction::getGeoLocationBatch(std::span<const IpAddress> addresses) {
+    auto locations = pImpl->queryGeoIPBatch(addresses);
+    for (size_t i = 0; i < locations.size(); ++i) {
+        pImpl->annotate(locations[i], addresses[i]);
+    }
+    return locations;
 }
 
 std::vector<std::string> GeoRestriction::getSanctionedCountries() const {
     std::vector<std::string> result;
-    
-    result.insert(result.end(), 
-                  OFAC_SANCTIONED_COUNTRIES.begin(), 
-                  OFAC_SANCTIONED_COUNTRIES.end());
-    
-    result.insert(result.end(), 
-                  OFAC_PARTIAL_SANCTIONS.begin(), 
-                  OFAC_PARTIAL_SANCTIONS.end());
-    
-    result.insert(result.end(), 
-                  ARMS_EMBARGO_COUNTRIES.begin(), 
-                  ARMS_EMBARGO_COUNTRIES.end());
-    
+    for (const CountryRecord& record : SanctionsPolicy::current().records()) {
+        if (!record.allowed()) {
+            result.emplace_back(record.code);
+        }
+    }
     return result;
 }
 
 std::vector<std::string> GeoRestriction::getHighRiskCountries() const {
-    return std::vector<std::string>(HIGH_RISK_COUNTRIES.begin(), 
-                                   HIGH_RISK_COUNTRIES.end());
+    std::vector<std::string> result;
+    for (const CountryRecord& record : SanctionsPolicy::current().records()) {
+        if (record.program == SanctionsProgram::HIGH_RISK) {
+            result.emplace_back(record.code);
+        }
+    }
+    return result;
 }
 
 void GeoRestriction::logAccessAttempt(const std::string& ip_address,
                                       const RestrictionResult& result,
                                       const std::string& action_taken) {
-    // Create audit log entry
-    std::time_t now = std::time(nullptr);
-    std::tm* local_time = std::localtime(&now);
+    StageTimer timer(CheckStage::AUDIT);
     
-    std::ostringstream log_entry;
-    log_entry << std::put_time(local_time, "%Y-%m-%d %H:%M:%S") << " | "
-              << "IP: " << ip_address << " | "
-              << "Country: " << result.country_code << " (" << result.country_name << ") | "
-              << "Action: " << action_taken << " | "
-              << "Level: " << static_cast<int>(result.level) << " | "
-              << "Reason: " << result.reason << "\n";
-    
-    // Write to audit log file
-    std::ofstream audit_log(pImpl->audit_log_path, std::ios::app);
-    if (audit_log.is_open()) {
-        audit_log << log_entry.str();
-        audit_log.close();
+    // Mirror blocks and high-risk access to the main logger
+    if (!result.allowed || result.level == RestrictionLevel::HIGH_RISK) {
+        const ComplianceLogRecord fields{
+            .country_code = result.country_code,
+            .country_name = result.country_name,
+            .level = result.level,
+            .ip = ip_address,
+            .action = action_taken,
+            .reason = result.reason
+        };
+        if (!result.allowed) {
+            ComplianceLog::log<ComplianceEvent::ACCESS_BLOCKED>(fields);
+        } else {
+            ComplianceLog::log<ComplianceEvent::ACCESS_MONITORED>(fields);
+        }
     }
     
-    // Also log to main logger
-    if (!result.allowed) {
-        Logger::warning("COMPLIANCE BLOCK: " + log_entry.str());
-    } else if (result.level == RestrictionLevel::HIGH_RISK) {
-        Logger::info("COMPLIANCE MONITOR: " + log_entry.str());
+    // Formatting, file I/O and fsync happen on the audit writer thread
+    pImpl->audit_log.load()->append(AuditLogWriter::Entry{
+        .time = std::chrono::system_clock::now(),
+        .ip_address = ip_address,
+        .country_code = result.country_code,
+        .country_name = result.country_name,
+        .action = action_taken,
+        .level = result.level,
+        .reason = result.reason
+    });
+}
+
+void GeoRestriction::logAccessAttempt(const IpAddress& address,
+                                      const RestrictionResult& result,
+                                      const std::string& action_taken) {
+    logAccessAttempt(address.toString(), result, action_taken);
+}
+
+void GeoRestriction::setAuditLogConfig(const AuditLogConfig& config) {
+    {
+        // The old writer drains and closes once in-flight appends release it
+        std::lock_guard lock(pImpl->config_mutex);
+        pImpl->audit_log.store(std::make_shared<AuditLogWriter>(config));
     }
+    Logger::info("Compliance audit log: " + config.path + " (group commit every " +
+                 std::to_string(config.commit_interval.count()) + "ms)");
+}
+
+bool GeoRestriction::flushAuditLog() {
+    return pImpl->audit_log.load()->flush();
+}
+
+AuditLogStats GeoRestriction::getAuditLogStats() const {
+    return pImpl->audit_log.load()->stats();
 }
 
 void GeoRestriction::setStrictMode(bool strict) {
-    pImpl->strict_mode = strict;
+    pImpl->strict_mode.store(strict, std::memory_order_relaxed);
+    if (auto decisions = pImpl->decisions.load()) {
+        decisions->invalidate();
+    }
     Logger::info("Geographic restriction strict mode: " + std::string(strict ? "ENABLED" : "DISABLED"));
 }
 
-bool GeoRestriction::loadSanctionsList(const std::string& filepath) {
-    // TODO: Load custom sanctions from JSON file
-    // Allows for dynamic updates without recompilation
-    Logger::info("Loading custom sanctions list from: " + filepath);
-    return true;
+void GeoRestriction::setGeoIPEndpoints(const std::string& lookup_url, const std::string& batch_url) {
+    setGeoIPProviders({{.name = "ip-api", .lookup_url = lookup_url, .batch_url = batch_url}},
+                      pImpl->client.load()->providers->config());
+    Logger::info("GeoIP endpoints set: " + lookup_url + " / " + batch_url);
 }
 
-// ============================================================================
-// CountryDatabase Implementation
-// ============================================================================
+void GeoRestriction::setGeoIPProviders(const std::vector<GeoIPProvider>& providers,
+                                       const GeoIPFailoverConfig& config) {
+    if (providers.empty()) {
+        Logger::error("GeoIP provider list is empty - keeping current providers");
+        return;
+    }
+    {
+        std::lock_guard lock(pImpl->config_mutex);
+        Impl::ClientState state = *pImpl->client.load();
+        state.providers = std::make_shared<GeoIPProviderSet>(providers, config);
+        pImpl->client.store(Impl::makeClientState(std::move(state)));
+    }
+    // Cached answers may come from a provider no longer in the list
+    clearCache();
+    
+    std::string names;
+    for (const GeoIPProvider& provider : providers) {
+        names += (names.empty() ? "" : ", ") + provider.name;
+    }
+    Logger::info("GeoIP providers: " + names + (config.hedge ? " (hedged)" : ""));
+}
 
-std::string CountryDatabase::getCountryName(const std::string& code) {
-    static const std::unordered_map<std::string, std::string> country_names = {
-        // OFAC Comprehensive Sanctions
-        {"CU", "Cuba"},
-        {"IR", "Iran"},
-        {"KP", "North Korea (DPRK)"},
-        {"SY", "Syria"},
-        {"XCR", "Crimea Region (Ukraine)"},
-        {"XDO", "Donetsk Region (Ukraine)"},
-        {"XLU", "Luhansk Region (Ukraine)"},
-        
-        // Partial Sanctions
-        {"RU", "Russia"},
-        {"BY", "Belarus"},
-        
-        // Arms Embargoes
-        {"SO", "Somalia"},
-        {"SS", "South Sudan"},
-        {"SD", "Sudan"},
-        {"LY", "Libya"},
-        {"CF", "Central African Republic"},
-        {"VE", "Venezuela"},
-        {"MM", "Myanmar (Burma)"},
-        {"YE", "Yemen"},
-        {"LB", "Lebanon"},
-        {"CD", "Democratic Republic of Congo"},
-        {"ER", "Eritrea"},
-        
-        // High Risk
-        {"CN", "China"},
-        {"HK", "Hong Kong"},
-        {"PK", "Pakistan"},
-        {"AF", "Afghanistan"},
-        {"IQ", "Iraq"},
-        {"AE", "United Arab Emirates"},
-        {"TR", "Turkey"},
-        {"EG", "Egypt"},
+std::vector<GeoIPProviderStats> GeoRestriction::getGeoIPProviderStats() const {
+    return pImpl->client.load()->providers->stats();
+}
+
+void GeoRestriction::setGeoIPClientConfig(const GeoIPClientConfig& config) {
+    std::shared_ptr<GeoIPReactor> retired;
+    {
+        std::lock_guard lock(pImpl->config_mutex);
+        Impl::ClientState state = *pImpl->client.load();
+        state.config = config;
+        state.pool = nullptr;
+        pImpl->client.store(Impl::makeClientState(std::move(state)));
         
-        // Fallback
-        {"UNKNOWN", "Unknown Country"}
-    };
+        // Pending async checks resolve fail-closed; the next one starts a new reactor
+        retired = pImpl->reactor.exchange(nullptr);
+    }
+    // Shut down outside config_mutex: failed callbacks may issue checks that start the new reactor
+    retired.reset();
+    Logger::info("GeoIP client: connect timeout " + std::to_string(config.connect_timeout.count()) +
+                 "ms, total timeout " + std::to_string(config.total_timeout.count()) + "ms");
+}
+
+bool GeoRestriction::loadOfflineDatabase(const std::string& filepath) {
+    auto db = std::make_shared<MmdbReader>();
+    if (!db->open(filepath)) {
+        return false;
+    }
+    pImpl->offline_db.store(std::move(db));
+    if (auto decisions = pImpl->decisions.load()) {
+        decisions->invalidate();
+    }
+    return true;
+}
+
+bool GeoRestriction::loadRegionBoundaries(const std::string& filepath) {
+    auto index = RegionIndex::loadFile(filepath);
+    if (!index) {
+        Logger::error("Region boundaries not loaded - keeping previous boundaries");
+        return false;
+    }
+    const SanctionsPolicy& policy = SanctionsPolicy::current();
+    for (std::string_view code : index->codes()) {
+        if (!policy.find(code)) {
+            Logger::warning("Region " + std::string(code) + " is not in sanctions policy " +
+                            policy.version() + " - lookups mapped to it will be allowed");
+        }
+    }
+    Logger::info("Region boundaries loaded: " + std::to_string(index->size()) + " regions (version " +
+                 index->version() + ") from " + filepath);
     
-    auto it = country_names.find(code);
-    return (it != country_names.end()) ? it->second : code;
+    pImpl->regions.store(std::move(index));
+    // Cached decisions were classified by country code alone
+    if (auto decisions = pImpl->decisions.load()) {
+        decisions->invalidate();
+    }
+    return true;
+}
+
+bool GeoRestriction::loadAnonymizerLists(const AnonymizerListConfig& config) {
+    auto index = AnonymizerIndex::load(config);
+    if (!index) {
+        Logger::error("Anonymizer lists not loaded - keeping previous lists");
+        return false;
+    }
+    const AnonymizerIndex::Summary& summary = index->summary();
+    Logger::info("Anonymizer lists loaded: " + std::to_string(summary.tor_entries) + " Tor, " +
+                 std::to_string(summary.vpn_entries) + " VPN, " +
+                 std::to_string(summary.datacenter_entries) + " datacenter entries, " +
+                 std::to_string(summary.hosting_asns) + " hosting ASNs (" +
+                 std::to_string(summary.v4_segments + summary.v6_segments) + " ranges)");
+    
+    std::lock_guard lock(pImpl->config_mutex);
+    // Stop the old refresher first so it can't publish over the new lists
+    pImpl->anonymizer_refresher.reset();
+    pImpl->block_hosting.store(config.block_hosting, std::memory_order_relaxed);
+    pImpl->anonymizers.store(std::move(index));
+    // Cached decisions may rest on the previous hosting ASN list
+    if (auto decisions = pImpl->decisions.load()) {
+        decisions->invalidate();
+    }
+    if (config.refresh_interval > std::chrono::seconds::zero()) {
+        Impl* impl = pImpl.get();
+        pImpl->anonymizer_refresher = std::make_unique<AnonymizerRefresher>(config,
+            [impl](std::shared_ptr<const AnonymizerIndex> refreshed) {
+                impl->anonymizers.store(std::move(refreshed));
+                if (auto decisions = impl->decisions.load()) {
+                    decisions->invalidate();
+                }
+            });
+    }
+    return true;
 }
 
-RestrictionLevel CountryDatabase::getRestrictionLevel(const std::string& code) {
-    if (GeoRestriction::OFAC_SANCTIONED_COUNTRIES.count(code)) {
-        return RestrictionLevel::COMPREHENSIVELY_SANCTIONED;
+void GeoRestriction::setCacheConfig(const GeoCacheConfig& config) {
+    pImpl->cache.store(config.enabled ? std::make_shared<GeoCache>(config) : nullptr);
+    Logger::info("GeoIP cache " + std::string(config.enabled ? "ENABLED" : "DISABLED") +
+                 " (max entries: " + std::to_string(config.max_entries) +
+                 ", TTL: " + std::to_string(config.ttl.count()) + "s" +
+                 (config.persistent_path.empty() ? std::string() : ", shared file: " + config.persistent_path) + ")");
+}
+
+GeoCacheStats GeoRestriction::getCacheStats() const {
+    auto cache = pImpl->cache.load();
+    return cache ? cache->stats() : GeoCacheStats{};
+}
+
+void GeoRestriction::clearCache() {
+    if (auto cache = pImpl->cache.load()) {
+        cache->clear();
     }
-    if (GeoRestriction::OFAC_PARTIAL_SANCTIONS.count(code) ||
-        GeoRestriction::ARMS_EMBARGO_COUNTRIES.count(code)) {
-        return RestrictionLevel::RESTRICTED;
+    if (auto decisions = pImpl->decisions.load()) {
+        decisions->invalidate();
     }
-    if (GeoRestriction::HIGH_RISK_COUNTRIES.count(code)) {
-        return RestrictionLevel::HIGH_RISK;
+}
+
+void GeoRestriction::setDecisionCacheConfig(const DecisionCacheConfig& config) {
+    pImpl->decisions.store(config.enabled ? std::make_shared<DecisionCache>(config) : nullptr);
+    Logger::info("Decision cache " + std::string(config.enabled ? "ENABLED" : "DISABLED") +
+                 " (max entries: " + std::to_string(config.max_entries) +
+                 ", default prefixes: /" + std::to_string(config.default_ipv4_prefix) +
+                 " and /" + std::to_string(config.default_ipv6_prefix) + ")");
+}
+
+DecisionCacheStats GeoRestriction::getDecisionCacheStats() const {
+    auto decisions = pImpl->decisions.load();
+    return decisions ? decisions->stats() : DecisionCacheStats{};
+}
+
+std::string GeoRestriction::renderMetrics() const {
+    std::string out = ComplianceMetrics::renderPrometheus();
+    auto family = [&out](const std::string& name, const char* type, const char* help,
+                         const std::vector<std::pair<std::string, uint64_t>>& samples) {
+        out += "# HELP " + name + " " + help + "\n# TYPE " + name + " " + type + "\n";
+        for (const auto& [labels, value] : samples) {
+            out += name + labels + " " + std::to_string(value) + "\n";
+        }
+    };
+    
+    const GeoCacheStats cache = getCacheStats();
+    family("spectremap_compliance_cache_lookups_total", "counter", "GeoIP cache probes by result.", {
+        {"{result=\"hit\"}", cache.hits},
+        {"{result=\"negative_hit\"}", cache.negative_hits},
+        {"{result=\"miss\"}", cache.misses}
+    });
+    family("spectremap_compliance_cache_persistent_hits_total", "counter",
+           "GeoIP cache hits served from the shared cache file.", {{"", cache.persistent_hits}});
+    family("spectremap_compliance_cache_evictions_total", "counter",
+           "Live cache entries displaced to stay within max_entries.", {{"", cache.evictions}});
+    family("spectremap_compliance_cache_entries", "gauge", "GeoIP results currently cached.",
+           {{"", cache.entries}});
+    
+    const DecisionCacheStats decisions = getDecisionCacheStats();
+    family("spectremap_compliance_decision_cache_lookups_total", "counter",
+           "Network-prefix decision cache probes by result.", {
+        {"{result=\"hit\"}", decisions.hits},
+        {"{result=\"miss\"}", decisions.misses}
+    });
+    family("spectremap_compliance_decision_cache_invalidations_total", "counter",
+           "Decision cache invalidations (strict mode, lookup source or list changes).",
+           {{"", decisions.invalidations}});
+    family("spectremap_compliance_decision_cache_entries", "gauge", "Network decisions currently cached.",
+           {{"", decisions.entries}});
+    
+    std::vector<std::pair<std::string, uint64_t>> requests, hedges, open, rate_limited, throttled;
+    for (const GeoIPProviderStats& provider : getGeoIPProviderStats()) {
+        std::string label = "provider=\"";
+        for (char c : provider.name) {
+            if (c == '"' || c == '\\') label += '\\';
+            label += c;
+        }
+        label += '"';
+        requests.emplace_back("{" + label + ",outcome=\"success\"}", provider.successes);
+        requests.emplace_back("{" + label + ",outcome=\"failure\"}", provider.failures);
+        hedges.emplace_back("{" + label + "}", provider.hedges);
+        open.emplace_back("{" + label + "}", provider.circuit_open ? 1 : 0);
+        rate_limited.emplace_back("{" + label + "}", provider.rate_limited);
+        throttled.emplace_back("{" + label + "}", provider.throttled);
     }
-    return RestrictionLevel::ALLOWED;
+    family("spectremap_compliance_geoip_provider_requests_total", "counter",
+           "Completed GeoIP provider requests by outcome.", requests);
+    family("spectremap_compliance_geoip_provider_hedges_total", "counter",
+           "Hedged requests sent to a provider while an earlier one was outstanding.", hedges);
+    family("spectremap_compliance_geoip_provider_circuit_open", "gauge",
+           "1 while a provider's circuit breaker is open or probing.", open);
+    family("spectremap_compliance_geoip_provider_rate_limited_total", "counter",
+           "Requests held back because the provider's request budget was spent.", rate_limited);
+    family("spectremap_compliance_geoip_provider_throttled_total", "counter",
+           "HTTP 429 responses from a provider.", throttled);
+    family("spectremap_compliance_geoip_queued_lookups", "gauge",
+           "Lookups waiting for a provider rate limit token.",
+           {{"", pImpl->client.load()->providers->queuedLookups()}});
+    family("spectremap_compliance_geoip_coalesced_lookups_total", "counter",
+           "Online lookups answered by waiting on a concurrent lookup of the same address.",
+           {{"", pImpl->inflight.coalesced()}});
+    
+    const ComplianceLogStats log = ComplianceLog::stats();
+    family("spectremap_compliance_log_events_total", "counter",
+           "Access check log events by outcome (suppressed repeats are reported in summary lines).", {
+        {"{outcome=\"written\"}", log.written},
+        {"{outcome=\"suppressed\"}", log.suppressed}
+    });
+    family("spectremap_compliance_log_summaries_total", "counter",
+           "Summary lines counting suppressed repeats.", {{"", log.summaries}});
+    
+    const AuditLogStats audit = getAuditLogStats();
+    family("spectremap_compliance_audit_entries_total", "counter", "Audit log entries by outcome.", {
+        {"{outcome=\"accepted\"}", audit.accepted},
+        {"{outcome=\"written\"}", audit.written},
+        {"{outcome=\"dropped\"}", audit.dropped},
+        {"{outcome=\"lost\"}", audit.lost}
+    });
+    family("spectremap_compliance_audit_write_errors_total", "counter", "Failed audit log writes.",
+           {{"", audit.write_errors}});
+    return out;
 }
 
-std::vector<std::string> CountryDatabase::getApplicableRegulations(const std::string& code) {
-    std::vector<std::string> regulations;
+bool GeoRestriction::loadSanctionsList(const std::string& filepath, bool watch) {
+    Logger::info("Loading custom sanctions list from: " + filepath);
     
-    if (code == "CU") {
-        regulations = {"31 CFR Part 515 (Cuban Assets Control Regulations)", "US EAR"};
-    } else if (code == "IR") {
-        regulations = {"31 CFR Part 560 (Iranian Transactions and Sanctions Regulations)", "US EAR"};
-    } else if (code == "KP") {
-        regulations = {"31 CFR Part 510 (North Korea Sanctions Regulations)", "US EAR"};
-    } else if (code == "SY") {
-        regulations = {"31 CFR Part 542 (Syrian Sanctions Regulations)", "US EAR"};
-    } else if (code == "RU" || code == "XCR" || code == "XDO" || code == "XLU") {
-        regulations = {"31 CFR Part 589 (Ukraine-Related Sanctions)", "US EAR 15 CFR Part 746"};
-    } else if (code == "BY") {
-        regulations = {"31 CFR Part 548 (Belarus Sanctions Regulations)", "US EAR"};
-    } else if (GeoRestriction::ARMS_EMBARGO_COUNTRIES.count(code)) {
-        regulations = {"US Arms Export Control Act", "22 CFR § 126.1", "UN Security Council Resolutions"};
-    } else if (GeoRestriction::HIGH_RISK_COUNTRIES.count(code)) {
-        regulations = {"BIS Entity List (15 CFR Part 744)", "EAR Country Groups"};
+    // Start watching before the initial load so an edit in between isn't missed
+    {
+        std::lock_guard lock(pImpl->config_mutex);
+        pImpl->sanctions_watcher.reset();
+        if (watch) {
+            pImpl->sanctions_watcher = std::make_unique<SanctionsWatcher>(filepath);
+        }
     }
     
-    return regulations;
+    // On failure the current policy (built-in table by default) stays active
+    auto policy = SanctionsPolicy::loadFile(filepath);
+    if (!policy) {
+        return false;
+    }
+    SanctionsPolicy::publish(std::move(policy));
+    return true;
 }
 
 } // namespace SpectreMap::Compliance
\ No newline at end of file
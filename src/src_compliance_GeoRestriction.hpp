@@ -13,10 +13,17 @@
 #define SPECTREMAP_GEORESTRICTION_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_set>
 #include <memory>
 #include <optional>
+#include <span>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <stop_token>
+#include "IpAddress.hpp"
 
 namespace SpectreMap::Compliance {
 
@@ -38,6 +45,7 @@ struct GeoLocation {
     std::string country_code;  ///< ISO 3166-1 alpha-2 code
     std::string country_name;
     std::string region;
+    std::string region_code;   ///< ISO 3166-2 subdivision suffix (e.g. "43" for UA-43)
     std::string city;
     double latitude;
     double longitude;
@@ -61,8 +69,219 @@ struct RestrictionResult {
     std::vector<std::string> applicable_regulations;
 };
 
+/**
+ * @brief Allocation-free form of RestrictionResult
+ *
+ * Name, reason and regulations view an immutable sanctions policy snapshot,
+ * which stays alive across reloads. For countries that are not listed,
+ * country_code and country_name view the code passed to checkCountryFast, so
+ * the decision must not outlive that string.
+ */
+struct RestrictionDecision {
+    bool allowed;
+    RestrictionLevel level;
+    std::string_view country_code;
+    std::string_view country_name;
+    std::string_view reason;
+    std::span<const std::string_view> applicable_regulations;
+
+    /**
+     * @brief Materialize an owning RestrictionResult
+     */
+    RestrictionResult toResult() const;
+};
+
+/**
+ * @brief GeoIP result cache configuration
+ */
+struct GeoCacheConfig {
+    bool enabled = true;
+    std::chrono::seconds ttl{3600};           ///< Lifetime of successful lookups
+    std::chrono::seconds negative_ttl{30};    ///< Lifetime of failed lookups
+    size_t max_entries = 65536;               ///< Upper bound across all shards
+    size_t shard_count = 16;                  ///< Independent locks; rounded up to a power of two
+    std::string persistent_path{};            ///< Shared on-disk cache file (empty disables)
+    size_t persistent_entries = 262144;       ///< Slots in the file; rounded up to a power of two
+};
+
+/**
+ * @brief GeoIP result cache counters
+ */
+struct GeoCacheStats {
+    uint64_t hits = 0;
+    uint64_t negative_hits = 0;   ///< Hits on a cached failure
+    uint64_t misses = 0;
+    uint64_t persistent_hits = 0; ///< Hits (either kind) served from the shared file
+    uint64_t expirations = 0;     ///< Misses caused by an expired entry
+    uint64_t insertions = 0;
+    uint64_t evictions = 0;       ///< Live entries displaced to stay within max_entries
+    size_t entries = 0;
+};
+
+/**
+ * @brief Network-prefix decision cache configuration
+ *
+ * A decision is stored against the network containing the address: the
+ * record's prefix for offline (MMDB) lookups, or the default prefix below
+ * for online lookups, since ip-api does not report one.
+ */
+struct DecisionCacheConfig {
+    bool enabled = true;
+    std::chrono::seconds ttl{3600};
+    size_t max_entries = 16384;               ///< Upper bound across all shards
+    size_t shard_count = 16;                  ///< Independent locks; rounded up to a power of two
+    uint8_t default_ipv4_prefix = 24;         ///< Network assumed for online IPv4 lookups (32 disables sharing)
+    uint8_t default_ipv6_prefix = 48;         ///< Network assumed for online IPv6 lookups (128 disables sharing)
+};
+
+/**
+ * @brief Decision cache counters
+ */
+struct DecisionCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t stale = 0;           ///< Entries skipped after a policy, mode or source change
+    uint64_t insertions = 0;
+    uint64_t evictions = 0;
+    uint64_t invalidations = 0;
+    size_t entries = 0;
+};
+
+/**
+ * @brief Local anonymizer detection lists consulted in strict mode
+ *
+ * Each list is a text file with one address or CIDR block per line (one
+ * ASN per line for hosting_asns); '#' starts a comment. An empty path
+ * skips that list.
+ */
+struct AnonymizerListConfig {
+    std::string tor_exit_list = "data/tor_exit_nodes.txt";
+    std::string vpn_ranges = "data/vpn_ranges.txt";
+    std::string datacenter_ranges = "data/datacenter_ranges.txt";
+    std::string hosting_asns = "data/hosting_asns.txt";
+    bool block_hosting = false;                   ///< Strict mode also blocks datacenter/hosting addresses
+    std::chrono::seconds refresh_interval{300};   ///< How often files are checked for changes (0 disables)
+};
+
+/**
+ * @brief HTTP client settings for online GeoIP lookups
+ */
+struct GeoIPClientConfig {
+    std::chrono::milliseconds connect_timeout{2000};
+    std::chrono::milliseconds total_timeout{5000};
+    std::chrono::seconds dns_cache_ttl{300};
+    size_t max_idle_handles = 16;   ///< Keep-alive handles retained between lookups
+};
+
+/**
+ * @brief Where a GeoIP provider's answers come from
+ */
+enum class GeoIPProviderType {
+    IP_API,              ///< ip-api compatible HTTP service
+    OFFLINE_DATABASE     ///< The database loaded with loadOfflineDatabase
+};
+
+/**
+ * @brief One entry in the ordered GeoIP provider list
+ */
+struct GeoIPProvider {
+    std::string name;                                   ///< Used in logs and metrics
+    GeoIPProviderType type = GeoIPProviderType::IP_API;
+    std::string lookup_url;                             ///< Single lookup prefix; the IP is appended
+    std::string batch_url;                              ///< Batch POST endpoint (empty: single lookups only)
+    uint32_t requests_per_minute = 0;                   ///< Single lookup budget (0: only what the provider reports)
+    uint32_t batch_requests_per_minute = 0;             ///< Batch request budget (0: only what the provider reports)
+};
+
+/**
+ * @brief Hedging and circuit breaker settings for the provider list
+ */
+struct GeoIPFailoverConfig {
+    bool hedge = true;                                  ///< Race the next provider once one is slower than its p95
+    std::chrono::milliseconds initial_hedge_delay{250}; ///< Hedge delay until a provider has enough samples
+    std::chrono::milliseconds min_hedge_delay{5};       ///< Floor under the observed p95
+    size_t breaker_failure_threshold = 5;               ///< Consecutive failures that open a provider's circuit
+    std::chrono::milliseconds breaker_open_time{30000}; ///< How long an open provider is skipped before a probe
+    size_t max_queued_lookups = 1024;                   ///< Lookups that may wait for a rate limit token
+};
+
+/**
+ * @brief Per-provider request counters and health
+ */
+struct GeoIPProviderStats {
+    std::string name;
+    uint64_t requests = 0;
+    uint64_t successes = 0;       ///< Answers, including provider-reported failures
+    uint64_t failures = 0;        ///< Transport errors, non-200 statuses, malformed bodies, timeouts
+    uint64_t hedges = 0;          ///< Requests started because an earlier provider was slow
+    uint64_t hedge_wins = 0;      ///< Hedged requests that answered first
+    uint64_t circuit_opens = 0;
+    uint64_t rate_limited = 0;    ///< Requests held back because the provider's budget was spent
+    uint64_t throttled = 0;       ///< HTTP 429 responses
+    bool circuit_open = false;
+    std::chrono::microseconds p95_latency{0};   ///< Over the recent latency window (0: no samples yet)
+};
+
+/**
+ * @brief What logAccessAttempt does when the audit queue is full
+ */
+enum class AuditOverflowPolicy {
+    BLOCK,    ///< Wait for the writer to catch up (no entry is lost)
+    DROP      ///< Drop the entry, count it and mark the gap in the log
+};
+
+/**
+ * @brief Compliance audit log writer configuration
+ */
+struct AuditLogConfig {
+    std::string path = "logs/compliance_audit.log";
+    size_t queue_capacity = 8192;                       ///< Rounded up to a power of two
+    size_t max_batch = 512;                             ///< Entries per write() call
+    std::chrono::milliseconds commit_interval{200};     ///< Group-commit fsync interval
+    AuditOverflowPolicy overflow_policy = AuditOverflowPolicy::BLOCK;
+    uint64_t max_segment_bytes = 64ull << 20;           ///< Rotate past this size (0 disables rotation)
+    std::chrono::hours max_segment_age{24};             ///< Rotate segments older than this
+    bool compress_segments = true;                      ///< gzip rotated segments
+};
+
+/**
+ * @brief Compliance audit log writer counters
+ */
+struct AuditLogStats {
+    uint64_t accepted = 0;       ///< Entries queued
+    uint64_t written = 0;        ///< Entries handed to the file
+    uint64_t dropped = 0;        ///< Entries lost to a full queue (DROP policy)
+    uint64_t blocked = 0;        ///< Callers that had to wait for queue space
+    uint64_t commits = 0;        ///< fsync calls
+    uint64_t rotations = 0;      ///< Segments handed to the sealer
+    uint64_t lost = 0;           ///< Entries unwritable at shutdown or whose fsync failed
+    uint64_t write_errors = 0;   ///< Failed write, flush and fsync calls
+};
+
 /**
  * @brief Geographic access restriction engine for export compliance
+ *
+ * Concurrency model: one instance is meant to be shared by a whole worker
+ * pool. Every public method may be called from any number of threads at
+ * once, except that construction and destruction must not race other calls.
+ *
+ * - Checks (checkCountry, checkCountryFast, checkCountryBatch, checkAccess*,
+ *   getGeoLocation*) take no lock of their own. They read the strict-mode
+ *   flag atomically and the sanctions policy, provider settings, cache,
+ *   offline database and audit writer as immutable or internally
+ *   synchronized snapshots. The GeoIP and decision caches are sharded and
+ *   the HTTP handle pool takes a short per-pool lock.
+ * - Setters (setStrictMode, setGeoIPEndpoints, setGeoIPProviders,
+ *   setGeoIPClientConfig, setCacheConfig, setDecisionCacheConfig,
+ *   setAuditLogConfig, loadOfflineDatabase, loadSanctionsList,
+ *   loadRegionBoundaries) publish a replacement snapshot.
+ *   Setters that change a decision also invalidate the decision cache.
+ *   Checks already in flight finish on the snapshot they started with; a
+ *   replaced object is destroyed when its last user releases it.
+ * - logAccessAttempt only enqueues; timestamps are formatted with
+ *   localtime_r on the audit writer thread.
+ * - Block and high-risk events are logged through ComplianceLog, which
+ *   formats nothing for disabled levels and aggregates repeated blocks.
  */
 class GeoRestriction {
 public:
@@ -71,11 +290,68 @@ public:
 
     /**
      * @brief Check if access from IP address is allowed
-     * @param ip_address IPv4 or IPv6 address
+     * @param ip_address IPv4 or IPv6 address; malformed text is denied
+     *        without a lookup
      * @return Restriction result with details
      */
     RestrictionResult checkAccess(const std::string& ip_address);
 
+    /**
+     * @brief checkAccess for an address already in binary form
+     *
+     * For callers holding an in_addr, in6_addr or sockaddr: nothing is
+     * parsed, and the address is formatted only if it has to be sent to a
+     * provider or logged. Lookups report it in canonical text form.
+     */
+    RestrictionResult checkAccess(const IpAddress& address);
+
+    /**
+     * @brief Check many IP addresses using the provider's batch endpoint
+     * @param ip_addresses IPv4 or IPv6 addresses (duplicates are looked up once)
+     * @param locations If set, resized to ip_addresses.size() and filled with
+     *        the location each result was decided from, with anonymizer flags
+     *        from the local lists (nullopt where the lookup failed). The
+     *        decision cache holds no locations, so it is not consulted.
+     * @return One restriction result per input, in input order
+     */
+    std::vector<RestrictionResult> checkAccessBatch(std::span<const std::string> ip_addresses,
+                                                    std::vector<std::optional<GeoLocation>>* locations = nullptr);
+    std::vector<RestrictionResult> checkAccessBatch(std::span<const IpAddress> addresses,
+                                                    std::vector<std::optional<GeoLocation>>* locations = nullptr);
+
+    /**
+     * @brief Check access without blocking the calling thread
+     *
+     * Online lookups run on a shared curl_multi reactor thread; cache hits and
+     * offline lookups complete immediately. A lookup that misses its deadline
+     * or is cancelled resolves fail-closed, exactly like a failed lookup.
+     *
+     * @param ip_address IPv4 or IPv6 address
+     * @param timeout Per-request deadline (zero uses the client total timeout)
+     * @param stop Cancels the lookup when stop is requested
+     * @return Future resolved with the restriction result
+     */
+    std::future<RestrictionResult> checkAccessAsync(const std::string& ip_address,
+                                                    std::chrono::milliseconds timeout = std::chrono::milliseconds::zero(),
+                                                    std::stop_token stop = {});
+    std::future<RestrictionResult> checkAccessAsync(const IpAddress& address,
+                                                    std::chrono::milliseconds timeout = std::chrono::milliseconds::zero(),
+                                                    std::stop_token stop = {});
+
+    /**
+     * @brief Callback form of checkAccessAsync
+     * @param callback Invoked once with the result, on the reactor thread or
+     *        (for cache hits/offline lookups) the calling thread; must not block
+     */
+    void checkAccessAsync(const std::string& ip_address,
+                          std::function<void(RestrictionResult)> callback,
+                          std::chrono::milliseconds timeout = std::chrono::milliseconds::zero(),
+                          std::stop_token stop = {});
+    void checkAccessAsync(const IpAddress& address,
+                          std::function<void(RestrictionResult)> callback,
+                          std::chrono::milliseconds timeout = std::chrono::milliseconds::zero(),
+                          std::stop_token stop = {});
+
     /**
      * @brief Check if country code is allowed
      * @param country_code ISO 3166-1 alpha-2 code (e.g., "US", "JP")
@@ -83,12 +359,47 @@ public:
      */
     RestrictionResult checkCountry(const std::string& country_code);
 
+    /**
+     * @brief Allocation-free country check for hot paths
+     *
+     * Same decision as checkCountry, but performs no heap allocation and no
+     * logging; call logAccessAttempt separately where an audit entry is needed.
+     *
+     * @param country_code ISO 3166-1 alpha-2 code (or XCR/XDO/XLU region code)
+     * @return Decision viewing static tables (see RestrictionDecision)
+     */
+    static RestrictionDecision checkCountryFast(std::string_view country_code) noexcept;
+
+    /**
+     * @brief Restriction levels for many packed country codes at once
+     *
+     * For flow tagging: codes are ASCII letters packed into integers, first
+     * letter in the low byte (see CountryClassifier.hpp). The whole batch is
+     * classified against one policy snapshot with SIMD kernels where the CPU
+     * has them. No allocation, no logging.
+     *
+     * @param codes Two-letter codes (uint16_t), or two/three-letter codes (uint32_t)
+     * @param levels Receives one level per code
+     * @return Codes classified: min(codes.size(), levels.size())
+     */
+    static size_t checkCountryBatch(std::span<const uint16_t> codes, std::span<RestrictionLevel> levels) noexcept;
+    static size_t checkCountryBatch(std::span<const uint32_t> codes, std::span<RestrictionLevel> levels) noexcept;
+
     /**
      * @brief Get geolocation information for IP address
      * @param ip_address IPv4 or IPv6 address
-     * @return Optional geolocation data
+     * @return Optional geolocation data (nullopt for malformed text)
      */
     std::optional<GeoLocation> getGeoLocation(const std::string& ip_address);
+    std::optional<GeoLocation> getGeoLocation(const IpAddress& address);
+
+    /**
+     * @brief Get geolocation for many IP addresses in as few requests as possible
+     * @param ip_addresses IPv4 or IPv6 addresses
+     * @return One entry per input, in input order (nullopt where lookup failed)
+     */
+    std::vector<std::optional<GeoLocation>> getGeoLocationBatch(std::span<const std::string> ip_addresses);
+    std::vector<std::optional<GeoLocation>> getGeoLocationBatch(std::span<const IpAddress> addresses);
 
     /**
      * @brief Get list of all sanctioned countries
@@ -111,45 +422,164 @@ public:
     void logAccessAttempt(const std::string& ip_address, 
                           const RestrictionResult& result,
                           const std::string& action_taken);
+    void logAccessAttempt(const IpAddress& address,
+                          const RestrictionResult& result,
+                          const std::string& action_taken);
+
+    /**
+     * @brief Replace the audit log writer (the previous one is drained and synced)
+     * @param config Log path, queue size, group-commit interval and overflow policy
+     */
+    void setAuditLogConfig(const AuditLogConfig& config);
+
+    /**
+     * @brief Block until every audit entry logged so far is fsynced
+     * @return False if the audit log cannot currently be written or entries were lost
+     */
+    bool flushAuditLog();
+
+    /**
+     * @brief Get audit log writer counters
+     */
+    AuditLogStats getAuditLogStats() const;
 
     /**
      * @brief Enable/disable strict compliance mode
      * @param strict If true, blocks VPN/proxy/Tor even from allowed countries
+     *        (see loadAnonymizerLists for local detection)
      */
     void setStrictMode(bool strict);
 
     /**
      * @brief Load custom sanctions list from file
+     *
+     * The list is published as the process-wide sanctions policy; in-flight
+     * checks keep using the snapshot they already read. A file that fails to
+     * parse leaves the previous policy active.
+     *
      * @param filepath Path to JSON sanctions configuration
+     * @param watch Reload automatically whenever the file changes
      * @return True if loaded successfully
      */
-    bool loadSanctionsList(const std::string& filepath);
+    bool loadSanctionsList(const std::string& filepath, bool watch = true);
+
+    /**
+     * @brief Load boundaries of sanctioned regions within a country
+     *
+     * Lookups inside a listed region (by ISO 3166-2 subdivision or by
+     * coordinates) are then classified under the region's code, e.g. XCR
+     * for Crimea instead of UA. Without boundaries only country codes are
+     * checked. A file that fails to load leaves the previous boundaries
+     * active.
+     *
+     * @param filepath Path to JSON region boundaries
+     * @return True if loaded successfully
+     */
+    bool loadRegionBoundaries(const std::string& filepath = "config/sanctioned_regions.json");
+
+    /**
+     * @brief Point online lookups at a different ip-api compatible service
+     *
+     * Replaces the provider list with this single provider.
+     *
+     * @param lookup_url Single lookup prefix; the IP is appended (e.g. "http://ip-api.com/json/")
+     * @param batch_url Batch POST endpoint (e.g. "http://ip-api.com/batch")
+     */
+    void setGeoIPEndpoints(const std::string& lookup_url, const std::string& batch_url);
+
+    /**
+     * @brief Use an ordered list of GeoIP providers with failover
+     *
+     * Lookups go to the first provider whose circuit is closed. Once it has
+     * been outstanding longer than its recent p95 latency, the next provider
+     * is asked as well (at most two requests in flight) and the first answer
+     * wins. A failed request moves straight on to the next provider. After
+     * breaker_failure_threshold consecutive failures a provider is skipped
+     * for breaker_open_time, then a single probe request decides whether it
+     * is used again. If every provider fails the check fails closed.
+     *
+     * An OFFLINE_DATABASE entry answers from the loadOfflineDatabase
+     * database at its place in the list (it is never hedged to; it is
+     * reached when an earlier provider fails). Without one, loading a
+     * database still switches all lookups to it.
+     *
+     * @param providers Providers in order of preference (must not be empty)
+     */
+    void setGeoIPProviders(const std::vector<GeoIPProvider>& providers, const GeoIPFailoverConfig& config = {});
+
+    /**
+     * @brief Get request counters, p95 latency and circuit state per provider
+     */
+    std::vector<GeoIPProviderStats> getGeoIPProviderStats() const;
+
+    /**
+     * @brief Replace the pooled HTTP client used for online lookups
+     * @param config Connect/total timeouts and keep-alive pool size
+     */
+    void setGeoIPClientConfig(const GeoIPClientConfig& config);
+
+    /**
+     * @brief Switch lookups to a local MaxMind database (no network access)
+     * @param filepath Path to GeoLite2/GeoIP2 Country or City .mmdb file
+     * @return True if the database was mapped and validated
+     */
+    bool loadOfflineDatabase(const std::string& filepath = "data/GeoLite2-Country.mmdb");
+
+    /**
+     * @brief Load local Tor exit, VPN, datacenter and hosting ASN lists
+     *
+     * Strict mode then detects anonymizers from these lists in addition to
+     * the provider's proxy flag, with no network access. The lists are
+     * rebuilt in the background when the files change. A list that fails
+     * to load leaves the previous lists active.
+     *
+     * @return True if every configured list was read
+     */
+    bool loadAnonymizerLists(const AnonymizerListConfig& config = {});
+
+    /**
+     * @brief Replace the GeoIP result cache (drops all cached entries)
+     * @param config TTLs, size bound and shard count; enabled=false disables caching
+     */
+    void setCacheConfig(const GeoCacheConfig& config);
+
+    /**
+     * @brief Get GeoIP result cache hit/miss/eviction counters
+     */
+    GeoCacheStats getCacheStats() const;
+
+    /**
+     * @brief Drop every cached GeoIP result and decision (e.g. after a provider change)
+     */
+    void clearCache();
+
+    /**
+     * @brief Replace the network-prefix decision cache (drops all cached decisions)
+     * @param config TTL, size bound and default prefixes; enabled=false disables it
+     */
+    void setDecisionCacheConfig(const DecisionCacheConfig& config);
+
+    /**
+     * @brief Get decision cache hit/miss/invalidation counters
+     */
+    DecisionCacheStats getDecisionCacheStats() const;
+
+    /**
+     * @brief Render metrics in Prometheus text exposition format
+     *
+     * Covers the process-wide per-stage latency histograms, decision and
+     * lookup-failure counters (see ComplianceMetrics.hpp), the event log
+     * counters (see ComplianceLog.hpp) plus this instance's cache and
+     * audit log counters.
+     */
+    std::string renderMetrics() const;
 
 private:
     class Impl;
     std::unique_ptr<Impl> pImpl;
 
-    // OFAC Comprehensive Sanctions (31 CFR)
-    static const std::unordered_set<std::string> OFAC_SANCTIONED_COUNTRIES;
-    
-    // Partial/Sectoral Sanctions (high risk)
-    static const std::unordered_set<std::string> OFAC_PARTIAL_SANCTIONS;
-    
-    // UN/EU Arms Embargoes
-    static const std::unordered_set<std::string> ARMS_EMBARGO_COUNTRIES;
-    
-    // High-risk for BIS Entity List
-    static const std::unordered_set<std::string> HIGH_RISK_COUNTRIES;
-};
-
-/**
- * @brief Country code to name mapping for sanctioned countries
- */
-class CountryDatabase {
-public:
-    static std::string getCountryName(const std::string& code);
-    static RestrictionLevel getRestrictionLevel(const std::string& code);
-    static std::vector<std::string> getApplicableRegulations(const std::string& code);
+    RestrictionResult evaluateLocation(const IpAddress& address,
+                                       const std::optional<GeoLocation>& geo);
 };
 
 } // namespace SpectreMap::Compliance
@@ -0,0 +1,205 @@
+/**
+ * @file IpAddress.cpp
+ * @brief Parsing and formatting of binary IP addresses
+ */
+
+#include "IpAddress.hpp"
+#include <cstring>
+
+namespace SpectreMap::Compliance {
+
+namespace {
+
+int hexValue(char c) noexcept {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * @brief Parse a complete dotted quad (inet_pton rules: no leading zeros)
+ */
+bool parseV4(const char* p, const char* end, uint32_t& out) noexcept {
+    uint32_t address = 0;
+    for (int octet = 0; octet < 4; ++octet) {
+        if (octet > 0) {
+            if (p == end || *p != '.') return false;
+            ++p;
+        }
+        const char* start = p;
+        unsigned value = 0;
+        while (p != end && *p >= '0' && *p <= '9' && p - start < 3) {
+            value = value * 10 + static_cast<unsigned>(*p - '0');
+            ++p;
+        }
+        if (p == start || value > 255 || (p - start > 1 && *start == '0')) return false;
+        address = address << 8 | value;
+    }
+    if (p != end) return false;
+    out = address;
+    return true;
+}
+
+/**
+ * @brief Parse a complete RFC 4291 text address
+ */
+bool parseV6(const char* p, const char* end, IpAddress::Bits& out) noexcept {
+    uint16_t groups[8] = {};
+    int count = 0;
+    int gap = -1;   // Group index where "::" stands
+
+    if (end - p >= 2 && p[0] == ':' && p[1] == ':') {
+        gap = 0;
+        p += 2;
+    } else if (p != end && *p == ':') {
+        return false;
+    }
+
+    while (p != end) {
+        const char* start = p;
+        unsigned value = 0;
+        int digits = 0;
+        for (int h; p != end && (h = hexValue(*p)) >= 0; ++p) {
+            if (++digits > 4) return false;
+            value = value << 4 | static_cast<unsigned>(h);
+        }
+        if (p != end && *p == '.') {
+            // Trailing dotted quad fills the last two groups
+            uint32_t v4;
+            if (count > 6 || !parseV4(start, end, v4)) return false;
+            groups[count++] = static_cast<uint16_t>(v4 >> 16);
+            groups[count++] = static_cast<uint16_t>(v4);
+            p = end;
+            break;
+        }
+        if (digits == 0 || count == 8) return false;
+        groups[count++] = static_cast<uint16_t>(value);
+        if (p == end) break;
+        if (*p != ':') return false;
+        ++p;
+        if (p != end && *p == ':') {
+            if (gap >= 0) return false;
+            gap = count;
+            ++p;
+        } else if (p == end) {
+            return false;   // Trailing single colon
+        }
+    }
+
+    if (gap < 0 ? count != 8 : count > 7) return false;
+    uint64_t halves[2] = {};
+    const int zeros = 8 - count;
+    for (int i = 0, group = 0; i < 8; ++i) {
+        const bool filler = gap >= 0 && i >= gap && i < gap + zeros;
+        halves[i / 4] = halves[i / 4] << 16 | (filler ? 0 : groups[group++]);
+    }
+    out = IpAddress::Bits(halves[0], halves[1]);
+    return true;
+}
+
+char* formatV4(char* out, uint32_t address) noexcept {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        const unsigned octet = (address >> shift) & 0xFF;
+        if (octet >= 100) *out++ = static_cast<char>('0' + octet / 100);
+        if (octet >= 10) *out++ = static_cast<char>('0' + octet / 10 % 10);
+        *out++ = static_cast<char>('0' + octet % 10);
+        if (shift) *out++ = '.';
+    }
+    return out;
+}
+
+} // namespace
+
+IpAddress::IpAddress(const in_addr& address) noexcept
+    : IpAddress(fromV4(ntohl(address.s_addr))) {}
+
+IpAddress::IpAddress(const in6_addr& address) noexcept
+    : IpAddress(fromBytes(reinterpret_cast<const uint8_t*>(&address))) {}
+
+std::optional<IpAddress> IpAddress::parse(std::string_view text) noexcept {
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    if (text.find(':') == std::string_view::npos) {
+        uint32_t v4;
+        if (!parseV4(begin, end, v4)) return std::nullopt;
+        return fromV4(v4);
+    }
+    Bits bits;
+    if (!parseV6(begin, end, bits)) return std::nullopt;
+    return IpAddress(bits);
+}
+
+std::optional<IpAddress> IpAddress::fromSockaddr(const sockaddr* address) noexcept {
+    if (!address) return std::nullopt;
+    switch (address->sa_family) {
+        case AF_INET:
+            return IpAddress(reinterpret_cast<const sockaddr_in*>(address)->sin_addr);
+        case AF_INET6:
+            return IpAddress(reinterpret_cast<const sockaddr_in6*>(address)->sin6_addr);
+        default:
+            return std::nullopt;
+    }
+}
+
+IpAddress IpAddress::fromBytes(const uint8_t* bytes) noexcept {
+    uint64_t halves[2] = {};
+    for (int i = 0; i < 16; ++i) halves[i / 8] = halves[i / 8] << 8 | bytes[i];
+    return IpAddress(Bits(halves[0], halves[1]));
+}
+
+void IpAddress::toBytes(uint8_t* bytes) const noexcept {
+    for (int i = 0; i < 16; ++i) {
+        bytes[i] = static_cast<uint8_t>((i < 8 ? bits_.hi : bits_.lo) >> (56 - 8 * (i % 8)));
+    }
+}
+
+size_t IpAddress::format(char* buffer) const noexcept {
+    if (isV4()) {
+        return static_cast<size_t>(formatV4(buffer, v4()) - buffer);
+    }
+
+    uint16_t groups[8];
+    for (int i = 0; i < 8; ++i) {
+        groups[i] = static_cast<uint16_t>((i < 4 ? bits_.hi : bits_.lo) >> (48 - 16 * (i % 4)));
+    }
+    // RFC 5952: compress the first longest run of two or more zero groups
+    int best = -1, best_length = 1;
+    for (int i = 0; i < 8;) {
+        if (groups[i] != 0) {
+            ++i;
+            continue;
+        }
+        int j = i;
+        while (j < 8 && groups[j] == 0) ++j;
+        if (j - i > best_length) {
+            best = i;
+            best_length = j - i;
+        }
+        i = j;
+    }
+
+    static constexpr char HEX[] = "0123456789abcdef";
+    char* out = buffer;
+    for (int i = 0; i < 8; ++i) {
+        if (i == best) {
+            *out++ = ':';
+            if (i == 0) *out++ = ':';
+            i += best_length - 1;
+            continue;
+        }
+        const unsigned group = groups[i];
+        for (int shift = 12; shift >= 0; shift -= 4) {
+            if (shift == 0 || group >> shift) *out++ = HEX[(group >> shift) & 0xF];
+        }
+        if (i < 7) *out++ = ':';
+    }
+    return static_cast<size_t>(out - buffer);
+}
+
+std::string IpAddress::toString() const {
+    char buffer[MAX_TEXT_LENGTH];
+    return std::string(buffer, format(buffer));
+}
+
+} // namespace SpectreMap::Compliance
@@ -0,0 +1,184 @@
+/**
+ * @file IpAddress.hpp
+ * @brief Compact binary IPv4/IPv6 address value
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * Every address is held as 128 bits, with IPv4 in its IPv4-mapped IPv6
+ * form (::ffff:a.b.c.d), so the two families share one representation and
+ * an IPv4 address compares equal to its mapped spelling. Callers that
+ * already hold an in_addr, in6_addr or sockaddr construct one directly and
+ * skip the text round trip; text is parsed once, strictly, with the same
+ * grammar as inet_pton (dotted quad without leading zeros, RFC 4291 IPv6
+ * with an optional trailing dotted quad, no zone index).
+ */
+
+#ifndef SPECTREMAP_IPADDRESS_HPP
+#define SPECTREMAP_IPADDRESS_HPP
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+namespace SpectreMap::Compliance {
+
+/**
+ * @brief Unsigned 128-bit integer as two 64-bit halves
+ *
+ * Portable stand-in for unsigned __int128 (which MSVC lacks), with the
+ * shift, mask, add/subtract and ordering operations address arithmetic
+ * needs. Shifts by 128 or more yield zero instead of being undefined.
+ */
+struct Uint128 {
+    uint64_t hi = 0;
+    uint64_t lo = 0;
+
+    constexpr Uint128() noexcept = default;
+    constexpr Uint128(uint64_t low) noexcept : lo(low) {}
+    constexpr Uint128(uint64_t high, uint64_t low) noexcept : hi(high), lo(low) {}
+
+    static constexpr Uint128 max() noexcept { return Uint128(UINT64_MAX, UINT64_MAX); }
+
+    friend constexpr Uint128 operator<<(const Uint128& value, int shift) noexcept {
+        if (shift <= 0) return value;
+        if (shift >= 128) return Uint128();
+        if (shift >= 64) return Uint128(value.lo << (shift - 64), 0);
+        return Uint128(value.hi << shift | value.lo >> (64 - shift), value.lo << shift);
+    }
+
+    friend constexpr Uint128 operator>>(const Uint128& value, int shift) noexcept {
+        if (shift <= 0) return value;
+        if (shift >= 128) return Uint128();
+        if (shift >= 64) return Uint128(value.hi >> (shift - 64));
+        return Uint128(value.hi >> shift, value.lo >> shift | value.hi << (64 - shift));
+    }
+
+    friend constexpr Uint128 operator&(const Uint128& a, const Uint128& b) noexcept {
+        return Uint128(a.hi & b.hi, a.lo & b.lo);
+    }
+    friend constexpr Uint128 operator|(const Uint128& a, const Uint128& b) noexcept {
+        return Uint128(a.hi | b.hi, a.lo | b.lo);
+    }
+    friend constexpr Uint128 operator^(const Uint128& a, const Uint128& b) noexcept {
+        return Uint128(a.hi ^ b.hi, a.lo ^ b.lo);
+    }
+    friend constexpr Uint128 operator~(const Uint128& value) noexcept {
+        return Uint128(~value.hi, ~value.lo);
+    }
+
+    /// Wraps modulo 2^128
+    friend constexpr Uint128 operator+(const Uint128& a, const Uint128& b) noexcept {
+        const uint64_t lo = a.lo + b.lo;
+        return Uint128(a.hi + b.hi + (lo < a.lo ? 1 : 0), lo);
+    }
+    friend constexpr Uint128 operator-(const Uint128& a, const Uint128& b) noexcept {
+        return Uint128(a.hi - b.hi - (a.lo < b.lo ? 1 : 0), a.lo - b.lo);
+    }
+
+    /// Numeric order: hi is compared first
+    constexpr auto operator<=>(const Uint128&) const noexcept = default;
+};
+
+/**
+ * @brief 128-bit IP address; IPv4 is stored IPv4-mapped
+ */
+class IpAddress {
+public:
+    using Bits = Uint128;
+
+    /// Longest canonical text form ("ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff")
+    static constexpr size_t MAX_TEXT_LENGTH = 39;
+
+    constexpr IpAddress() noexcept = default;   ///< "::"
+
+    explicit IpAddress(const in_addr& address) noexcept;
+    explicit IpAddress(const in6_addr& address) noexcept;
+
+    /**
+     * @brief Parse an IPv4, IPv6 or IPv4-mapped IPv6 address
+     * @return nullopt unless the whole text is one address
+     */
+    static std::optional<IpAddress> parse(std::string_view text) noexcept;
+
+    /**
+     * @brief Address of an AF_INET or AF_INET6 socket address
+     * @return nullopt for other families
+     */
+    static std::optional<IpAddress> fromSockaddr(const sockaddr* address) noexcept;
+
+    /**
+     * @param address Host byte order
+     */
+    static constexpr IpAddress fromV4(uint32_t address) noexcept {
+        return IpAddress(Bits(0, uint64_t{0xFFFF} << 32 | address));
+    }
+
+    /**
+     * @param bits Address as a big-endian 128-bit integer
+     */
+    static constexpr IpAddress fromBits(Bits bits) noexcept { return IpAddress(bits); }
+
+    /**
+     * @param bytes 16 bytes in network order
+     */
+    static IpAddress fromBytes(const uint8_t* bytes) noexcept;
+
+    /**
+     * @brief Whether this is an IPv4 (or IPv4-mapped) address
+     */
+    constexpr bool isV4() const noexcept { return bits_.hi == 0 && bits_.lo >> 32 == 0xFFFF; }
+
+    /**
+     * @brief IPv4 address in host byte order (meaningful only if isV4())
+     */
+    constexpr uint32_t v4() const noexcept { return static_cast<uint32_t>(bits_.lo); }
+
+    constexpr Bits bits() const noexcept { return bits_; }
+
+    /**
+     * @param bytes Receives 16 bytes in network order
+     */
+    void toBytes(uint8_t* bytes) const noexcept;
+
+    /**
+     * @brief Canonical text: dotted quad for IPv4, RFC 5952 for IPv6
+     * @param buffer At least MAX_TEXT_LENGTH bytes; not NUL-terminated
+     * @return Number of characters written
+     */
+    size_t format(char* buffer) const noexcept;
+
+    std::string toString() const;
+
+    constexpr bool operator==(const IpAddress&) const noexcept = default;
+
+private:
+    constexpr explicit IpAddress(Bits bits) noexcept : bits_(bits) {}
+
+    Bits bits_;
+};
+
+/**
+ * @brief Hash for unordered containers keyed by address
+ */
+struct IpAddressHash {
+    size_t operator()(const IpAddress& address) const noexcept {
+        uint64_t value = address.bits().hi * 0x9e3779b97f4a7c15ULL ^ address.bits().lo;
+        value ^= value >> 29;
+        value *= 0xbf58476d1ce4e5b9ULL;
+        return static_cast<size_t>(value ^ (value >> 32));
+    }
+};
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_IPADDRESS_HPP
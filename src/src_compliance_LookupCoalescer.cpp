@@ -0,0 +1,105 @@
+/**
+ * @file LookupCoalescer.cpp
+ * @brief Implementation of single-flight online lookups
+ */
+
+#include "LookupCoalescer.hpp"
+#include "../core/Logger.hpp"
+#include <exception>
+#include <future>
+#include <memory>
+#include <utility>
+
+namespace SpectreMap::Compliance {
+
+LookupCoalescer::Role LookupCoalescer::join(const std::string& key, LookupPriority priority,
+                                            Clock::time_point deadline, Waiter waiter, Lead& lead) {
+    std::lock_guard lock(mutex_);
+    auto [it, inserted] = flights_.try_emplace(key);
+    Flight& flight = it->second;
+    if (!inserted && flight.deadline < Clock::now()) {
+        // Its leader should have finished by now; lead in its place and answer its followers too
+        inserted = true;
+    }
+    if (inserted) {
+        flight.id = next_id_++;
+        flight.priority = priority;
+        flight.deadline = deadline;
+        lead = Lead(this, key, flight.id);
+        return Role::LEAD;
+    }
+    if (flight.deadline > deadline || flight.priority > priority) {
+        return Role::BYPASS;
+    }
+    flight.followers.push_back(std::move(waiter));
+    coalesced_.fetch_add(1, std::memory_order_relaxed);
+    return Role::FOLLOW;
+}
+
+LookupCoalescer::Role LookupCoalescer::join(const std::string& key, LookupPriority priority,
+                                            Clock::time_point deadline, Result& result, Lead& lead) {
+    auto answered = std::make_shared<std::promise<Result>>();
+    auto future = answered->get_future();
+    const Role role = join(key, priority, deadline, [answered](const Result& found) {
+        answered->set_value(found);
+    }, lead);
+    if (role == Role::FOLLOW) {
+        // The leader is bound by the same deadline; past it the check fails closed
+        result = future.wait_until(deadline) == std::future_status::ready ? future.get() : Result{};
+    }
+    return role;
+}
+
+void LookupCoalescer::finish(const std::string& key, uint64_t id, const Result& result) {
+    std::vector<Waiter> followers;
+    {
+        std::lock_guard lock(mutex_);
+        auto it = flights_.find(key);
+        if (it == flights_.end() || it->second.id != id) {
+            return;   // Replaced as stale; the new leader answers the followers
+        }
+        followers = std::move(it->second.followers);
+        flights_.erase(it);
+    }
+    for (const Waiter& follower : followers) {
+        // One follower's failure must not strand the rest
+        try {
+            follower(result);
+        } catch (const std::exception& e) {
+            Logger::error("Coalesced GeoIP lookup callback threw: " + std::string(e.what()));
+        } catch (...) {
+            Logger::error("Coalesced GeoIP lookup callback threw");
+        }
+    }
+}
+
+// ============================================================================
+// Lead
+// ============================================================================
+
+LookupCoalescer::Lead::Lead(Lead&& other) noexcept
+    : owner_(std::exchange(other.owner_, nullptr)), key_(std::move(other.key_)), id_(other.id_) {}
+
+LookupCoalescer::Lead& LookupCoalescer::Lead::operator=(Lead&& other) noexcept {
+    if (this != &other) {
+        if (owner_) finish(Result{});
+        owner_ = std::exchange(other.owner_, nullptr);
+        key_ = std::move(other.key_);
+        id_ = other.id_;
+    }
+    return *this;
+}
+
+LookupCoalescer::Lead::~Lead() {
+    if (owner_) {
+        finish(Result{});   // Unwound or dropped unfinished: followers fail closed
+    }
+}
+
+void LookupCoalescer::Lead::finish(const Result& result) {
+    if (LookupCoalescer* owner = std::exchange(owner_, nullptr)) {
+        owner->finish(key_, id_, result);
+    }
+}
+
+} // namespace SpectreMap::Compliance
@@ -0,0 +1,130 @@
+/**
+ * @file LookupCoalescer.hpp
+ * @brief Single-flight online lookups: one provider request per address at a time
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * A burst of checks for one address (a client reconnecting, a scan seen on
+ * several interfaces) all miss the GeoIP cache before the first answer
+ * arrives, and each would spend a provider request. The first check for an
+ * address leads the lookup; later ones follow it and receive its result
+ * when it finishes, as long as that cannot make them wait longer than they
+ * would on their own: the lead must end by the follower's deadline and
+ * queue ahead of it (an interactive lead serves anyone, a bulk lead only
+ * bulk followers). Otherwise the later check bypasses and looks up itself.
+ *
+ * A lead is held through a Lead guard, which ends the flight with a failed
+ * result if it is dropped unfinished (an exception, a completion that never
+ * runs), so followers are never left waiting on it. A flight still listed
+ * after its deadline is treated as abandoned: the next check replaces it
+ * and takes over its followers.
+ */
+
+#ifndef SPECTREMAP_LOOKUPCOALESCER_HPP
+#define SPECTREMAP_LOOKUPCOALESCER_HPP
+
+#include "GeoRestriction.hpp"
+#include "GeoIPRateLimit.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace SpectreMap::Compliance {
+
+/**
+ * @brief Table of online lookups in flight, keyed by canonical address text
+ */
+class LookupCoalescer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief What the leader found
+     */
+    struct Result {
+        std::optional<GeoLocation> location;
+        std::optional<uint8_t> prefix_length;   ///< Set when the offline entry answered
+    };
+
+    /**
+     * @brief Receives a followed lookup's result, on the leader's thread; must not block
+     */
+    using Waiter = std::function<void(const Result&)>;
+
+    enum class Role {
+        LEAD,     ///< Look up, then finish the Lead
+        FOLLOW,   ///< The waiter will receive the leader's result
+        BYPASS    ///< Look up alone
+    };
+
+    /**
+     * @brief A lead in flight; passes its result to the followers exactly once
+     */
+    class Lead {
+    public:
+        Lead() = default;
+        Lead(Lead&& other) noexcept;
+        Lead& operator=(Lead&& other) noexcept;
+        ~Lead();   ///< Finishes with a failed result if finish() was not called
+
+        /**
+         * @brief End the lead; call before running the leader's own callbacks
+         */
+        void finish(const Result& result);
+
+        explicit operator bool() const noexcept { return owner_ != nullptr; }
+
+    private:
+        friend class LookupCoalescer;
+        Lead(LookupCoalescer* owner, std::string key, uint64_t id)
+            : owner_(owner), key_(std::move(key)), id_(id) {}
+
+        LookupCoalescer* owner_ = nullptr;   ///< Must outlive the lead
+        std::string key_;
+        uint64_t id_ = 0;
+    };
+
+    /**
+     * @brief Lead a lookup, or follow the one in flight for the same address
+     * @param deadline When the caller gives up; also the lead's deadline if it leads
+     * @param lead Receives the guard when the role is LEAD
+     */
+    Role join(const std::string& key, LookupPriority priority, Clock::time_point deadline, Waiter waiter,
+              Lead& lead);
+
+    /**
+     * @brief Blocking form of join(): a follower returns once result holds the
+     *        leader's answer, or a failed result at the deadline
+     */
+    Role join(const std::string& key, LookupPriority priority, Clock::time_point deadline, Result& result,
+              Lead& lead);
+
+    /**
+     * @brief Lookups answered by following another
+     */
+    uint64_t coalesced() const noexcept { return coalesced_.load(std::memory_order_relaxed); }
+
+private:
+    struct Flight {
+        uint64_t id;
+        LookupPriority priority;
+        Clock::time_point deadline;
+        std::vector<Waiter> followers;
+    };
+
+    void finish(const std::string& key, uint64_t id, const Result& result);
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, Flight> flights_;
+    uint64_t next_id_ = 1;
+    std::atomic<uint64_t> coalesced_{0};
+};
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_LOOKUPCOALESCER_HPP
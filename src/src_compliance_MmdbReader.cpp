@@ -0,0 +1,526 @@
+/**
+ * @file MmdbReader.cpp
+ * @brief Implementation of the memory-mapped MaxMind DB reader
+ *
+ * Format reference: MaxMind DB File Format Specification v2.0
+ * (https://maxmind.github.io/MaxMind-DB/)
+ */
+
+#include "MmdbReader.hpp"
+#include "../core/Logger.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace SpectreMap::Compliance {
+
+namespace {
+
+// Metadata section marker: "\xAB\xCD\xEF" followed by "MaxMind.com"
+constexpr uint8_t METADATA_MARKER[] = {
+    0xAB, 0xCD, 0xEF, 'M', 'a', 'x', 'M', 'i', 'n', 'd', '.', 'c', 'o', 'm'
+};
+constexpr size_t METADATA_MAX_SIZE = 128 * 1024;
+constexpr size_t DATA_SECTION_SEPARATOR = 16;
+constexpr int MAX_NESTING_DEPTH = 32;
+
+// Data section field types
+enum FieldType : uint32_t {
+    TYPE_EXTENDED = 0,
+    TYPE_POINTER = 1,
+    TYPE_UTF8_STRING = 2,
+    TYPE_DOUBLE = 3,
+    TYPE_BYTES = 4,
+    TYPE_UINT16 = 5,
+    TYPE_UINT32 = 6,
+    TYPE_MAP = 7,
+    TYPE_INT32 = 8,
+    TYPE_UINT64 = 9,
+    TYPE_UINT128 = 10,
+    TYPE_ARRAY = 11,
+    TYPE_CONTAINER = 12,
+    TYPE_END_MARKER = 13,
+    TYPE_BOOLEAN = 14,
+    TYPE_FLOAT = 15,
+};
+
+inline uint32_t be24(const uint8_t* p) noexcept {
+    return (uint32_t(p[0]) << 16) | (uint32_t(p[1]) << 8) | uint32_t(p[2]);
+}
+
+inline uint32_t be32(const uint8_t* p) noexcept {
+    return (uint32_t(p[0]) << 24) | be24(p + 1);
+}
+
+} // namespace
+
+/**
+ * @brief Decoded control header of a data section value (pointers resolved)
+ */
+struct MmdbReader::Field {
+    uint32_t type = 0;
+    uint32_t size = 0;     ///< Byte length, or entry count for maps/arrays
+    size_t payload = 0;    ///< Offset of the value bytes within the data section
+};
+
+// ============================================================================
+// Mapping
+// ============================================================================
+
+MmdbReader::~MmdbReader() {
+    close();
+}
+
+bool MmdbReader::open(const std::string& filepath) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        Logger::warning("Offline GeoIP database not found: " + filepath);
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        Logger::warning("Offline GeoIP database is empty: " + filepath);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        Logger::error("Failed to map offline GeoIP database: " + filepath);
+        return false;
+    }
+    file_handle_ = file;
+    mapping_handle_ = mapping;
+    data_ = static_cast<const uint8_t*>(view);
+    size_ = static_cast<size_t>(file_size.QuadPart);
+#else
+    int fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        Logger::warning("Offline GeoIP database not found: " + filepath);
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        Logger::warning("Offline GeoIP database is empty: " + filepath);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);  // The mapping keeps the file referenced
+    if (view == MAP_FAILED) {
+        Logger::error("Failed to map offline GeoIP database: " + filepath);
+        return false;
+    }
+    // Tree walks touch pages in no predictable order
+    madvise(view, static_cast<size_t>(st.st_size), MADV_RANDOM);
+    data_ = static_cast<const uint8_t*>(view);
+    size_ = static_cast<size_t>(st.st_size);
+#endif
+
+    // The metadata marker is the last occurrence within the trailing 128KiB
+    const size_t search_from = size_ > METADATA_MAX_SIZE ? size_ - METADATA_MAX_SIZE : 0;
+    const uint8_t* begin = data_ + search_from;
+    const uint8_t* end = data_ + size_;
+    const uint8_t* marker = std::find_end(begin, end, std::begin(METADATA_MARKER),
+                                          std::end(METADATA_MARKER));
+    if (marker == end) {
+        Logger::error("Invalid MMDB file (metadata marker missing): " + filepath);
+        close();
+        return false;
+    }
+
+    const size_t marker_offset = static_cast<size_t>(marker - data_);
+    const size_t metadata_offset = marker_offset + sizeof(METADATA_MARKER);
+
+    // Metadata pointers are relative to the metadata section itself
+    data_section_ = data_ + metadata_offset;
+    data_section_size_ = size_ - metadata_offset;
+    if (!parseMetadata(0)) {
+        Logger::error("Invalid MMDB metadata in: " + filepath);
+        close();
+        return false;
+    }
+
+    const size_t tree_size = static_cast<size_t>(metadata_.node_count) * node_bytes_;
+    if (tree_size + DATA_SECTION_SEPARATOR > marker_offset) {
+        Logger::error("MMDB search tree exceeds file size: " + filepath);
+        close();
+        return false;
+    }
+    data_section_ = data_ + tree_size + DATA_SECTION_SEPARATOR;
+    data_section_size_ = marker_offset - tree_size - DATA_SECTION_SEPARATOR;
+
+    // IPv4 addresses in an IPv6 tree live under ::/96; resolve that subtree once
+    ipv4_start_node_ = 0;
+    if (metadata_.ip_version == 6) {
+        for (int i = 0; i < 96 && ipv4_start_node_ < metadata_.node_count; ++i) {
+            ipv4_start_node_ = readRecord(ipv4_start_node_, 0);
+        }
+    }
+
+    Logger::info("Offline GeoIP database loaded: " + filepath + " (" +
+                 std::string(metadata_.database_type) + ", " +
+                 std::to_string(metadata_.node_count) + " nodes, IPv" +
+                 std::to_string(metadata_.ip_version) + ")");
+    return true;
+}
+
+void MmdbReader::close() noexcept {
+    if (!data_) return;
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+    CloseHandle(static_cast<HANDLE>(mapping_handle_));
+    CloseHandle(static_cast<HANDLE>(file_handle_));
+    mapping_handle_ = nullptr;
+    file_handle_ = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    data_section_ = nullptr;
+    data_section_size_ = 0;
+    metadata_ = MmdbMetadata{};
+}
+
+// ============================================================================
+// Search Tree
+// ============================================================================
+
+std::optional<MmdbRecord> MmdbReader::lookup(std::string_view ip_address) const noexcept {
+    const auto address = IpAddress::parse(ip_address);
+    if (!address) return std::nullopt;
+    return lookup(*address);
+}
+
+std::optional<MmdbRecord> MmdbReader::lookup(const IpAddress& address) const noexcept {
+    uint8_t addr[16];
+    address.toBytes(addr);
+    // IPv4-mapped IPv6 (::ffff:a.b.c.d) is looked up as plain IPv4
+    return address.isV4() ? lookup(addr + 12, 4) : lookup(addr, 16);
+}
+
+std::optional<MmdbRecord> MmdbReader::lookup(const uint8_t* addr, size_t len) const noexcept {
+    if (!data_ || (len != 4 && len != 16)) {
+        return std::nullopt;
+    }
+
+    static constexpr uint8_t V4_MAPPED_PREFIX[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF};
+    if (len == 16 && std::memcmp(addr, V4_MAPPED_PREFIX, sizeof(V4_MAPPED_PREFIX)) == 0) {
+        addr += 12;
+        len = 4;
+    }
+    if (len == 16 && metadata_.ip_version == 4) {
+        return std::nullopt;
+    }
+
+    const uint32_t node_count = metadata_.node_count;
+    const int bit_count = static_cast<int>(len * 8);
+    uint32_t node = (len == 4) ? ipv4_start_node_ : 0;
+
+    int depth = 0;
+    for (; depth < bit_count && node < node_count; ++depth) {
+        const int bit = (addr[depth >> 3] >> (7 - (depth & 7))) & 1;
+        node = readRecord(node, bit);
+    }
+
+    if (node <= node_count) {
+        // node == node_count means "no data"; below it means a malformed tree
+        return std::nullopt;
+    }
+
+    const size_t offset = static_cast<size_t>(node - node_count) - DATA_SECTION_SEPARATOR;
+    if (offset >= data_section_size_) {
+        return std::nullopt;
+    }
+
+    MmdbRecord record;
+    record.prefix_length = static_cast<uint8_t>(depth);
+    fillRecord(offset, record);
+    return record;
+}
+
+uint32_t MmdbReader::readRecord(uint32_t node, int bit) const noexcept {
+    const uint8_t* p = data_ + static_cast<size_t>(node) * node_bytes_;
+    switch (metadata_.record_size) {
+        case 24:
+            return be24(p + bit * 3);
+        case 28:
+            return bit == 0 ? ((uint32_t(p[3]) & 0xF0) << 20) | be24(p)
+                            : ((uint32_t(p[3]) & 0x0F) << 24) | be24(p + 4);
+        default:
+            return be32(p + bit * 4);
+    }
+}
+
+// ============================================================================
+// Data Section Decoder
+// ============================================================================
+
+bool MmdbReader::decodeField(size_t offset, Field& field) const noexcept {
+    const uint8_t* d = data_section_;
+    const size_t n = data_section_size_;
+    if (offset >= n) return false;
+
+    uint8_t ctrl = d[offset++];
+    uint32_t type = ctrl >> 5;
+
+    if (type == TYPE_POINTER) {
+        const uint32_t ss = (ctrl >> 3) & 0x3;
+        const uint32_t vvv = ctrl & 0x7;
+        if (offset + ss + 1 > n) return false;
+        const uint8_t* p = d + offset;
+        size_t target = 0;
+        switch (ss) {
+            case 0: target = (vvv << 8) | p[0]; break;
+            case 1: target = ((vvv << 16) | (uint32_t(p[0]) << 8) | p[1]) + 2048; break;
+            case 2: target = ((vvv << 24) | be24(p)) + 526336; break;
+            default: target = be32(p); break;
+        }
+        // A pointer may not point at another pointer
+        if (target >= n || (d[target] >> 5) == TYPE_POINTER) return false;
+        return decodeField(target, field);
+    }
+
+    if (type == TYPE_EXTENDED) {
+        if (offset >= n) return false;
+        type = 7 + d[offset++];
+        if (type < TYPE_INT32 || type > TYPE_FLOAT) return false;
+    }
+
+    uint32_t size = ctrl & 0x1F;
+    if (size >= 29) {
+        const size_t extra = size - 28;
+        if (offset + extra > n) return false;
+        const uint8_t* p = d + offset;
+        if (size == 29) size = 29 + p[0];
+        else if (size == 30) size = 285 + ((uint32_t(p[0]) << 8) | p[1]);
+        else size = 65821 + be24(p);
+        offset += extra;
+    }
+
+    field.type = type;
+    field.size = size;
+    field.payload = offset;
+
+    // Scalars must fit inside the section; containers are checked as they are walked
+    if (type != TYPE_MAP && type != TYPE_ARRAY && type != TYPE_BOOLEAN &&
+        offset + size > n) {
+        return false;
+    }
+    return true;
+}
+
+bool MmdbReader::skipValue(size_t offset, size_t& next, int depth) const noexcept {
+    if (depth > MAX_NESTING_DEPTH || offset >= data_section_size_) return false;
+
+    const uint8_t ctrl = data_section_[offset];
+    if ((ctrl >> 5) == TYPE_POINTER) {
+        next = offset + 2 + ((ctrl >> 3) & 0x3);
+        return next <= data_section_size_;
+    }
+
+    Field field;
+    if (!decodeField(offset, field)) return false;
+
+    switch (field.type) {
+        case TYPE_MAP:
+        case TYPE_ARRAY: {
+            const uint64_t entries = field.type == TYPE_MAP ? uint64_t(field.size) * 2 : field.size;
+            size_t cursor = field.payload;
+            for (uint64_t i = 0; i < entries; ++i) {
+                if (!skipValue(cursor, cursor, depth + 1)) return false;
+            }
+            next = cursor;
+            return true;
+        }
+        case TYPE_BOOLEAN:
+            next = field.payload;
+            return true;
+        default:
+            next = field.payload + field.size;
+            return true;
+    }
+}
+
+std::string_view MmdbReader::fieldString(const Field& field) const noexcept {
+    if (field.type != TYPE_UTF8_STRING) return {};
+    return std::string_view(reinterpret_cast<const char*>(data_section_ + field.payload),
+                            field.size);
+}
+
+namespace {
+
+uint64_t fieldUnsigned(const uint8_t* section, uint32_t type, uint32_t size, size_t payload) noexcept {
+    if ((type != TYPE_UINT16 && type != TYPE_UINT32 && type != TYPE_UINT64 &&
+         type != TYPE_INT32) || size > 8) {
+        return 0;
+    }
+    uint64_t value = 0;
+    for (uint32_t i = 0; i < size; ++i) {
+        value = (value << 8) | section[payload + i];
+    }
+    return value;
+}
+
+double fieldDouble(const uint8_t* section, uint32_t type, uint32_t size, size_t payload) noexcept {
+    if (type == TYPE_DOUBLE && size == 8) {
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; ++i) bits = (bits << 8) | section[payload + i];
+        return std::bit_cast<double>(bits);
+    }
+    if (type == TYPE_FLOAT && size == 4) {
+        return static_cast<double>(std::bit_cast<float>(be32(section + payload)));
+    }
+    return 0.0;
+}
+
+} // namespace
+
+bool MmdbReader::findKey(const Field& map, std::string_view key, Field& value) const noexcept {
+    if (map.type != TYPE_MAP) return false;
+
+    size_t cursor = map.payload;
+    for (uint32_t i = 0; i < map.size; ++i) {
+        Field key_field;
+        if (!decodeField(cursor, key_field) || !skipValue(cursor, cursor, 0)) return false;
+        if (fieldString(key_field) == key) {
+            return decodeField(cursor, value);
+        }
+        if (!skipValue(cursor, cursor, 0)) return false;
+    }
+    return false;
+}
+
+bool MmdbReader::findPath(const Field& root, std::initializer_list<std::string_view> path,
+                          Field& value) const noexcept {
+    Field current = root;
+    for (std::string_view key : path) {
+        if (!findKey(current, key, current)) return false;
+    }
+    value = current;
+    return true;
+}
+
+bool MmdbReader::parseMetadata(size_t offset) noexcept {
+    Field root;
+    if (!decodeField(offset, root) || root.type != TYPE_MAP) return false;
+
+    auto unsignedAt = [&](std::string_view key) -> uint64_t {
+        Field f;
+        return findKey(root, key, f) ? fieldUnsigned(data_section_, f.type, f.size, f.payload) : 0;
+    };
+
+    metadata_.node_count = static_cast<uint32_t>(unsignedAt("node_count"));
+    metadata_.record_size = static_cast<uint16_t>(unsignedAt("record_size"));
+    metadata_.ip_version = static_cast<uint16_t>(unsignedAt("ip_version"));
+    metadata_.format_major_version = static_cast<uint16_t>(unsignedAt("binary_format_major_version"));
+    metadata_.build_epoch = unsignedAt("build_epoch");
+
+    Field type_field;
+    if (findKey(root, "database_type", type_field)) {
+        metadata_.database_type = fieldString(type_field);
+    }
+
+    if (metadata_.format_major_version != 2 || metadata_.node_count == 0 ||
+        (metadata_.ip_version != 4 && metadata_.ip_version != 6)) {
+        return false;
+    }
+    if (metadata_.record_size != 24 && metadata_.record_size != 28 &&
+        metadata_.record_size != 32) {
+        return false;
+    }
+    node_bytes_ = metadata_.record_size / 4;  // Two records per node
+    return true;
+}
+
+void MmdbReader::fillRecord(size_t offset, MmdbRecord& record) const noexcept {
+    Field root;
+    if (!decodeField(offset, root) || root.type != TYPE_MAP) return;
+
+    const uint8_t* section = data_section_;
+    auto asBool = [](const Field& f) { return f.type == TYPE_BOOLEAN && f.size != 0; };
+
+    Field registered_country{};
+    bool has_registered_country = false;
+
+    // Single pass over the top-level map; nested lookups only for known keys
+    size_t cursor = root.payload;
+    for (uint32_t i = 0; i < root.size; ++i) {
+        Field key_field;
+        Field value;
+        if (!decodeField(cursor, key_field) || !skipValue(cursor, cursor, 0) ||
+            !decodeField(cursor, value)) {
+            return;
+        }
+        const std::string_view key = fieldString(key_field);
+        Field f;
+
+        if (key == "country") {
+            if (findKey(value, "iso_code", f)) record.country_code = fieldString(f);
+            if (findPath(value, {"names", "en"}, f)) record.country_name = fieldString(f);
+        } else if (key == "registered_country") {
+            registered_country = value;
+            has_registered_country = true;
+        } else if (key == "subdivisions") {
+            Field first;
+            if (value.type == TYPE_ARRAY && value.size > 0 && decodeField(value.payload, first)) {
+                if (findKey(first, "iso_code", f)) record.region_code = fieldString(f);
+                if (findPath(first, {"names", "en"}, f)) record.region = fieldString(f);
+            }
+        } else if (key == "city") {
+            if (findPath(value, {"names", "en"}, f)) record.city = fieldString(f);
+        } else if (key == "location") {
+            if (findKey(value, "latitude", f)) {
+                record.latitude = fieldDouble(section, f.type, f.size, f.payload);
+            }
+            if (findKey(value, "longitude", f)) {
+                record.longitude = fieldDouble(section, f.type, f.size, f.payload);
+            }
+        } else if (key == "traits") {
+            if (findKey(value, "is_anonymous_proxy", f)) record.is_anonymous_proxy = asBool(f);
+            if (findKey(value, "is_anonymous_vpn", f)) record.is_anonymous_vpn = asBool(f);
+            if (findKey(value, "is_hosting_provider", f)) record.is_hosting_provider = asBool(f);
+            if (findKey(value, "is_tor_exit_node", f)) record.is_tor_exit_node = asBool(f);
+        } else if (key == "autonomous_system_number") {
+            record.asn = static_cast<uint32_t>(
+                fieldUnsigned(section, value.type, value.size, value.payload));
+        } else if (key == "autonomous_system_organization") {
+            record.as_org = fieldString(value);
+        } else if (key == "is_public_proxy" || key == "is_anonymous") {
+            // GeoIP2 Anonymous IP database keeps its flags at the top level
+            record.is_anonymous_proxy = record.is_anonymous_proxy || asBool(value);
+        } else if (key == "is_anonymous_vpn") {
+            record.is_anonymous_vpn = asBool(value);
+        } else if (key == "is_hosting_provider") {
+            record.is_hosting_provider = asBool(value);
+        } else if (key == "is_tor_exit_node") {
+            record.is_tor_exit_node = asBool(value);
+        }
+
+        if (!skipValue(cursor, cursor, 0)) return;
+    }
+
+    if (record.country_code.empty() && has_registered_country) {
+        Field f;
+        if (findKey(registered_country, "iso_code", f)) record.country_code = fieldString(f);
+        if (findPath(registered_country, {"names", "en"}, f)) record.country_name = fieldString(f);
+    }
+}
+
+} // namespace SpectreMap::Compliance
@@ -0,0 +1,129 @@
+/**
+ * @file MmdbReader.hpp
+ * @brief Zero-copy MaxMind DB (MMDB v2) reader for offline GeoIP lookups
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * The database file is memory-mapped read-only and the binary search tree
+ * is walked directly from the mapped pages. Lookups never allocate: every
+ * string in an MmdbRecord is a view into the mapping and stays valid until
+ * the reader is closed or destroyed.
+ */
+
+#ifndef SPECTREMAP_MMDBREADER_HPP
+#define SPECTREMAP_MMDBREADER_HPP
+
+#include "IpAddress.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace SpectreMap::Compliance {
+
+/**
+ * @brief Database-wide metadata decoded from the MMDB trailer
+ */
+struct MmdbMetadata {
+    uint32_t node_count = 0;
+    uint16_t record_size = 0;      ///< Bits per search tree record (24, 28 or 32)
+    uint16_t ip_version = 0;       ///< 4 or 6
+    uint16_t format_major_version = 0;
+    uint64_t build_epoch = 0;
+    std::string_view database_type; ///< e.g. "GeoLite2-Country"
+};
+
+/**
+ * @brief Fields extracted from a single MMDB data record
+ *
+ * Covers the GeoLite2/GeoIP2 Country, City, ASN and Anonymous-IP layouts.
+ * Fields missing from the database are left empty / zero.
+ */
+struct MmdbRecord {
+    std::string_view country_code;  ///< country.iso_code (falls back to registered_country)
+    std::string_view country_name;  ///< country.names.en
+    std::string_view region_code;   ///< subdivisions[0].iso_code
+    std::string_view region;        ///< subdivisions[0].names.en
+    std::string_view city;          ///< city.names.en
+    double latitude = 0.0;
+    double longitude = 0.0;
+    uint32_t asn = 0;               ///< autonomous_system_number
+    std::string_view as_org;        ///< autonomous_system_organization
+    bool is_anonymous_proxy = false;
+    bool is_anonymous_vpn = false;
+    bool is_hosting_provider = false;
+    bool is_tor_exit_node = false;
+    uint8_t prefix_length = 0;      ///< Length of the network containing the address
+};
+
+/**
+ * @brief Read-only, memory-mapped MMDB database
+ */
+class MmdbReader {
+public:
+    MmdbReader() = default;
+    ~MmdbReader();
+
+    MmdbReader(const MmdbReader&) = delete;
+    MmdbReader& operator=(const MmdbReader&) = delete;
+
+    /**
+     * @brief Map a database file and validate its metadata
+     * @param filepath Path to a .mmdb file (e.g. data/GeoLite2-Country.mmdb)
+     * @return True if the file was mapped and is a supported MMDB v2 database
+     */
+    bool open(const std::string& filepath);
+
+    /**
+     * @brief Unmap the database; outstanding MmdbRecord views become invalid
+     */
+    void close() noexcept;
+
+    bool isOpen() const noexcept { return data_ != nullptr; }
+    const MmdbMetadata& metadata() const noexcept { return metadata_; }
+
+    /**
+     * @brief Look up a textual IPv4 or IPv6 address
+     * @return Record for the containing network, or nullopt if not found/invalid
+     */
+    std::optional<MmdbRecord> lookup(std::string_view ip_address) const noexcept;
+    std::optional<MmdbRecord> lookup(const IpAddress& address) const noexcept;
+
+    /**
+     * @brief Look up a raw address in network byte order
+     * @param addr 4 (IPv4) or 16 (IPv6) bytes
+     * @param len Length of addr in bytes
+     */
+    std::optional<MmdbRecord> lookup(const uint8_t* addr, size_t len) const noexcept;
+
+private:
+    struct Field;
+
+    uint32_t readRecord(uint32_t node, int bit) const noexcept;
+    bool decodeField(size_t offset, Field& field) const noexcept;
+    bool skipValue(size_t offset, size_t& next, int depth) const noexcept;
+    bool findKey(const Field& map, std::string_view key, Field& value) const noexcept;
+    bool findPath(const Field& root, std::initializer_list<std::string_view> path,
+                  Field& value) const noexcept;
+    std::string_view fieldString(const Field& field) const noexcept;
+    bool parseMetadata(size_t offset) noexcept;
+    void fillRecord(size_t offset, MmdbRecord& record) const noexcept;
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    const uint8_t* data_section_ = nullptr;
+    size_t data_section_size_ = 0;
+    size_t node_bytes_ = 0;
+    uint32_t ipv4_start_node_ = 0;
+    MmdbMetadata metadata_;
+
+#ifdef _WIN32
+    void* file_handle_ = nullptr;
+    void* mapping_handle_ = nullptr;
+#endif
+};
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_MMDBREADER_HPP
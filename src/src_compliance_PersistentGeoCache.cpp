@@ -0,0 +1,408 @@
+/**
+ * @file PersistentGeoCache.cpp
+ * @brief Implementation of the shared on-disk GeoIP result cache
+ */
+
+#include "PersistentGeoCache.hpp"
+#include "../core/Logger.hpp"
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace SpectreMap::Compliance {
+
+namespace {
+
+constexpr uint64_t CACHE_MAGIC = 0x45484341434F4547ULL;   // "GEOCACHE", little-endian
+constexpr uint32_t LAYOUT_VERSION = 2;
+constexpr size_t HEADER_SIZE = 4096;                      // Keeps the slot array page-aligned
+constexpr size_t PROBE_LENGTH = 8;
+constexpr size_t READ_ATTEMPTS = 4;
+
+// A slot whose writer died mid-update stays locked; after this long another
+// writer takes it over
+constexpr int64_t STALE_WRITE_SECONDS = 5;
+
+uint32_t fnv1a32(const uint8_t* data, size_t size) noexcept {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+uint64_t fnv1a64(std::string_view text) noexcept {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+int64_t unixSeconds(PersistentGeoCache::WallClock::time_point time) noexcept {
+    return std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+}
+
+} // namespace
+
+// ============================================================================
+// File Layout
+// ============================================================================
+
+struct PersistentGeoCache::Header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t slot_size;
+    uint32_t reserved;
+    uint64_t slot_count;
+    uint32_t checksum;            ///< Over the fields above
+    uint32_t padding;
+    uint64_t generation;          ///< Shared; entries from other generations are dead
+
+    uint32_t layoutChecksum() const noexcept {
+        return fnv1a32(reinterpret_cast<const uint8_t*>(this), offsetof(Header, checksum));
+    }
+};
+
+struct PersistentGeoCache::Slot {
+    static constexpr size_t KEY_CAPACITY = 48;    // Longest textual IPv6 address is 45
+    static constexpr size_t DATA_CAPACITY = 168;
+
+    uint64_t sequence;            ///< Seqlock; odd while a writer owns the slot
+    int64_t write_started;        ///< Unix seconds of the current write
+    uint32_t checksum;            ///< Over everything after this field
+    uint8_t negative;
+    uint8_t key_length;
+    uint16_t data_length;
+    uint64_t generation;
+    int64_t expires;              ///< Unix seconds
+    char key[KEY_CAPACITY];
+    uint8_t data[DATA_CAPACITY];  ///< lat, lon, flags, then length-prefixed strings
+
+    static constexpr size_t PAYLOAD_OFFSET = 16;   // First word after the seqlock fields
+
+    uint32_t payloadChecksum() const noexcept {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(this);
+        constexpr size_t start = offsetof(Slot, checksum) + sizeof(checksum);
+        return fnv1a32(bytes + start, sizeof(Slot) - start);
+    }
+};
+
+static_assert(sizeof(PersistentGeoCache::Slot) == 256, "slot layout is part of the file format");
+static_assert(sizeof(PersistentGeoCache::Header) <= HEADER_SIZE);
+
+namespace {
+
+using Slot = PersistentGeoCache::Slot;
+
+/**
+ * @brief Seqlock-consistent copy of a slot's payload
+ * @return False if a writer held or changed the slot during every attempt
+ */
+bool readSlot(Slot& shared, Slot& copy) noexcept {
+    std::atomic_ref<uint64_t> sequence(shared.sequence);
+    auto* source = reinterpret_cast<uint64_t*>(&shared);
+    auto* target = reinterpret_cast<uint64_t*>(&copy);
+    for (size_t attempt = 0; attempt < READ_ATTEMPTS; ++attempt) {
+        const uint64_t before = sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (size_t word = Slot::PAYLOAD_OFFSET / 8; word < sizeof(Slot) / 8; ++word) {
+            target[word] = std::atomic_ref<uint64_t>(source[word]).load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Serialize a location into a slot image
+ * @return False if it doesn't fit
+ */
+bool encode(const GeoLocation& location, Slot& slot) {
+    uint8_t* out = slot.data;
+    uint8_t* const end = slot.data + Slot::DATA_CAPACITY;
+    auto put = [&](const void* bytes, size_t size) {
+        if (static_cast<size_t>(end - out) < size) return false;
+        std::memcpy(out, bytes, size);
+        out += size;
+        return true;
+    };
+    auto putString = [&](const std::string& value) {
+        if (value.size() > UINT8_MAX) return false;
+        const auto length = static_cast<uint8_t>(value.size());
+        return put(&length, 1) && put(value.data(), value.size());
+    };
+
+    const uint8_t flags = (location.is_proxy ? 1 : 0) | (location.is_vpn ? 2 : 0) |
+                          (location.is_tor ? 4 : 0) | (location.is_hosting ? 8 : 0);
+    if (!put(&location.latitude, sizeof(double)) || !put(&location.longitude, sizeof(double)) ||
+        !put(&flags, 1) || !putString(location.country_code) || !putString(location.country_name) ||
+        !putString(location.region) || !putString(location.region_code) || !putString(location.city) ||
+        !putString(location.asn) || !putString(location.org)) {
+        return false;
+    }
+    slot.data_length = static_cast<uint16_t>(out - slot.data);
+    return true;
+}
+
+bool decode(const Slot& slot, GeoLocation& location) {
+    const uint8_t* in = slot.data;
+    const uint8_t* const end = slot.data + std::min<size_t>(slot.data_length, Slot::DATA_CAPACITY);
+    auto get = [&](void* bytes, size_t size) {
+        if (static_cast<size_t>(end - in) < size) return false;
+        std::memcpy(bytes, in, size);
+        in += size;
+        return true;
+    };
+    auto getString = [&](std::string& value) {
+        uint8_t length = 0;
+        if (!get(&length, 1) || static_cast<size_t>(end - in) < length) return false;
+        value.assign(reinterpret_cast<const char*>(in), length);
+        in += length;
+        return true;
+    };
+
+    uint8_t flags = 0;
+    if (!get(&location.latitude, sizeof(double)) || !get(&location.longitude, sizeof(double)) ||
+        !get(&flags, 1) || !getString(location.country_code) || !getString(location.country_name) ||
+        !getString(location.region) || !getString(location.region_code) || !getString(location.city) ||
+        !getString(location.asn) || !getString(location.org)) {
+        return false;
+    }
+    location.is_proxy = flags & 1;
+    location.is_vpn = flags & 2;
+    location.is_tor = flags & 4;
+    location.is_hosting = flags & 8;
+    return true;
+}
+
+#ifndef _WIN32
+
+/**
+ * @brief Whether an open file holds a current-layout cache of the given size
+ */
+bool validFile(int fd, size_t slot_count) {
+    struct stat info {};
+    if (fstat(fd, &info) != 0 ||
+        static_cast<uint64_t>(info.st_size) != HEADER_SIZE + slot_count * sizeof(PersistentGeoCache::Slot)) {
+        return false;
+    }
+    PersistentGeoCache::Header header {};
+    if (pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+        return false;
+    }
+    return header.magic == CACHE_MAGIC && header.version == LAYOUT_VERSION &&
+           header.header_size == HEADER_SIZE && header.slot_size == sizeof(PersistentGeoCache::Slot) &&
+           header.slot_count == slot_count && header.checksum == header.layoutChecksum();
+}
+
+/**
+ * @brief Replace the file's contents with an empty cache (caller holds LOCK_EX)
+ */
+bool rebuildFile(int fd, size_t slot_count) {
+    // Truncating first zeroes every slot; the file stays sparse until written
+    if (ftruncate(fd, 0) != 0 ||
+        ftruncate(fd, static_cast<off_t>(HEADER_SIZE + slot_count * sizeof(PersistentGeoCache::Slot))) != 0) {
+        return false;
+    }
+    PersistentGeoCache::Header header {};
+    header.magic = CACHE_MAGIC;
+    header.version = LAYOUT_VERSION;
+    header.header_size = HEADER_SIZE;
+    header.slot_size = sizeof(PersistentGeoCache::Slot);
+    header.slot_count = slot_count;
+    header.checksum = header.layoutChecksum();
+    return pwrite(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) && fsync(fd) == 0;
+}
+
+#endif
+
+} // namespace
+
+// ============================================================================
+// PersistentGeoCache
+// ============================================================================
+
+PersistentGeoCache::PersistentGeoCache(int fd, void* mapping, size_t mapping_size)
+    : fd_(fd), mapping_(mapping), mapping_size_(mapping_size), header_(static_cast<Header*>(mapping)),
+      slot_mask_(header_->slot_count - 1) {}
+
+#ifdef _WIN32
+
+std::unique_ptr<PersistentGeoCache> PersistentGeoCache::open(const std::string& path, size_t) {
+    Logger::warning("Persistent GeoIP cache is not supported on this platform: " + path);
+    return nullptr;
+}
+
+PersistentGeoCache::~PersistentGeoCache() = default;
+
+#else
+
+std::unique_ptr<PersistentGeoCache> PersistentGeoCache::open(const std::string& path, size_t slot_count) {
+    slot_count = std::bit_ceil(std::max<size_t>(slot_count, PROBE_LENGTH));
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        Logger::error("Cannot open persistent GeoIP cache: " + path);
+        return nullptr;
+    }
+
+    // Users of a valid file hold LOCK_SH for as long as it is mapped; only a
+    // process that gets LOCK_EX (nobody else has it mapped) may rebuild it
+    bool ready = false;
+    for (int attempt = 0; attempt < 50 && !ready; ++attempt) {
+        if (flock(fd, LOCK_SH) == 0 && validFile(fd, slot_count)) {
+            ready = true;
+            break;
+        }
+        flock(fd, LOCK_UN);
+        if (flock(fd, LOCK_EX | LOCK_NB) == 0) {
+            if (!validFile(fd, slot_count)) {
+                if (!rebuildFile(fd, slot_count)) {
+                    flock(fd, LOCK_UN);
+                    break;
+                }
+                Logger::warning("Persistent GeoIP cache was missing, corrupt or another version - rebuilt " + path);
+            }
+            ready = flock(fd, LOCK_SH) == 0;   // Downgrade
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (!ready) {
+        Logger::error("Persistent GeoIP cache " + path +
+                      " is unusable or held by a process using another layout - disabled");
+        ::close(fd);
+        return nullptr;
+    }
+
+    const size_t mapping_size = HEADER_SIZE + slot_count * sizeof(Slot);
+    void* mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        Logger::error("Cannot map persistent GeoIP cache: " + path);
+        ::close(fd);
+        return nullptr;
+    }
+    return std::unique_ptr<PersistentGeoCache>(new PersistentGeoCache(fd, mapping, mapping_size));
+}
+
+PersistentGeoCache::~PersistentGeoCache() {
+    munmap(mapping_, mapping_size_);
+    ::close(fd_);   // Releases the shared lock
+}
+
+#endif
+
+PersistentGeoCache::Slot* PersistentGeoCache::slotAt(size_t index) const {
+    return reinterpret_cast<Slot*>(static_cast<char*>(mapping_) + HEADER_SIZE) + (index & slot_mask_);
+}
+
+std::optional<PersistentGeoCache::Entry> PersistentGeoCache::lookup(std::string_view key) const {
+    if (key.size() > Slot::KEY_CAPACITY) return std::nullopt;
+    const uint64_t generation = std::atomic_ref<uint64_t>(header_->generation).load(std::memory_order_acquire);
+    const int64_t now = unixSeconds(WallClock::now());
+    const size_t home = static_cast<size_t>(fnv1a64(key));
+
+    Slot copy;
+    for (size_t probe = 0; probe < PROBE_LENGTH; ++probe) {
+        if (!readSlot(*slotAt(home + probe), copy)) continue;
+        if (copy.checksum != copy.payloadChecksum() || copy.generation != generation ||
+            std::string_view(copy.key, std::min<size_t>(copy.key_length, Slot::KEY_CAPACITY)) != key) {
+            continue;
+        }
+        if (copy.expires <= now) return std::nullopt;
+
+        Entry entry{.location = std::nullopt, .expires = WallClock::time_point(std::chrono::seconds(copy.expires))};
+        if (!copy.negative) {
+            GeoLocation location{};
+            if (!decode(copy, location)) return std::nullopt;
+            entry.location = std::move(location);
+        }
+        return entry;
+    }
+    return std::nullopt;
+}
+
+void PersistentGeoCache::insert(std::string_view key, const GeoLocation* location, std::chrono::seconds ttl) {
+    if (key.size() > Slot::KEY_CAPACITY || ttl.count() <= 0) return;
+
+    Slot image {};
+    image.negative = location ? 0 : 1;
+    image.key_length = static_cast<uint8_t>(key.size());
+    std::memcpy(image.key, key.data(), key.size());
+    if (location && !encode(*location, image)) return;
+
+    const int64_t now = unixSeconds(WallClock::now());
+    const uint64_t generation = std::atomic_ref<uint64_t>(header_->generation).load(std::memory_order_acquire);
+    image.generation = generation;
+    image.expires = now + ttl.count();
+    image.checksum = image.payloadChecksum();
+
+    // Prefer the key's own slot, then a dead one, then the one expiring first
+    const size_t home = static_cast<size_t>(fnv1a64(key));
+    std::optional<size_t> target;
+    int64_t earliest = INT64_MAX;
+    Slot copy {};
+    for (size_t probe = 0; probe < PROBE_LENGTH; ++probe) {
+        const size_t index = home + probe;
+        if (!readSlot(*slotAt(index), copy) || copy.checksum != copy.payloadChecksum() ||
+            copy.generation != generation || copy.expires <= now) {
+            if (!target || earliest != INT64_MIN) {
+                target = index;
+                earliest = INT64_MIN;   // Dead slots beat any live one
+            }
+            continue;
+        }
+        if (std::string_view(copy.key, std::min<size_t>(copy.key_length, Slot::KEY_CAPACITY)) == key) {
+            target = index;
+            break;
+        }
+        if (copy.expires < earliest) {
+            target = index;
+            earliest = copy.expires;
+        }
+    }
+    if (!target) return;
+
+    Slot& slot = *slotAt(*target);
+    std::atomic_ref<uint64_t> sequence(slot.sequence);
+    std::atomic_ref<int64_t> write_started(slot.write_started);
+    uint64_t current = sequence.load(std::memory_order_relaxed);
+    // Odd: another writer owns the slot, unless it died mid-write long ago
+    const bool stale = (current & 1) && now - write_started.load(std::memory_order_relaxed) > STALE_WRITE_SECONDS;
+    if ((current & 1) && !stale) return;
+    const uint64_t owned = stale ? current + 2 : current + 1;
+    if (!sequence.compare_exchange_strong(current, owned, std::memory_order_acquire, std::memory_order_relaxed)) {
+        return;
+    }
+    write_started.store(now, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto* source = reinterpret_cast<uint64_t*>(&image);
+    auto* target_words = reinterpret_cast<uint64_t*>(&slot);
+    for (size_t word = Slot::PAYLOAD_OFFSET / 8; word < sizeof(Slot) / 8; ++word) {
+        std::atomic_ref<uint64_t>(target_words[word]).store(source[word], std::memory_order_relaxed);
+    }
+    sequence.store(owned + 1, std::memory_order_release);
+}
+
+void PersistentGeoCache::clear() {
+    std::atomic_ref<uint64_t>(header_->generation).fetch_add(1, std::memory_order_acq_rel);
+}
+
+} // namespace SpectreMap::Compliance
@@ -0,0 +1,101 @@
+/**
+ * @file PersistentGeoCache.hpp
+ * @brief GeoIP results in a memory-mapped file shared by processes and restarts
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * The file is a fixed header followed by a power-of-two array of 256-byte
+ * slots, addressed by open addressing with a short linear probe. Every
+ * process maps it shared and reads and writes slots directly; there is no
+ * daemon. Each slot is a seqlock: a writer makes the sequence odd (which
+ * also excludes other writers), writes, and makes it even again, and a
+ * reader retries if the sequence moved while it copied. A checksum over
+ * the slot catches torn or garbage contents, which read as a miss.
+ *
+ * Entries carry a wall-clock expiry so they stay valid across restarts.
+ * clear() bumps a generation in the header, which retires every entry for
+ * all processes at once.
+ *
+ * The header records magic, layout version, slot size and count, guarded
+ * by a checksum. A file that doesn't match is rebuilt empty, under an
+ * exclusive flock; processes using a file hold a shared flock, so a file
+ * still mapped elsewhere (e.g. by an older binary) is never truncated
+ * under it.
+ */
+
+#ifndef SPECTREMAP_PERSISTENTGEOCACHE_HPP
+#define SPECTREMAP_PERSISTENTGEOCACHE_HPP
+
+#include "GeoRestriction.hpp"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace SpectreMap::Compliance {
+
+/**
+ * @brief Cross-process GeoLocation cache backed by a shared mapping
+ */
+class PersistentGeoCache {
+public:
+    using WallClock = std::chrono::system_clock;
+
+    /**
+     * @brief Result of a lookup
+     */
+    struct Entry {
+        std::optional<GeoLocation> location;   ///< nullopt marks a negative entry
+        WallClock::time_point expires;
+    };
+
+    /**
+     * @brief Open or create the cache file
+     * @param slot_count Rounded up to a power of two; a file with another count is rebuilt
+     * @return nullptr if the file can't be opened, mapped or (when invalid) rebuilt
+     */
+    static std::unique_ptr<PersistentGeoCache> open(const std::string& path, size_t slot_count);
+
+    ~PersistentGeoCache();
+
+    PersistentGeoCache(const PersistentGeoCache&) = delete;
+    PersistentGeoCache& operator=(const PersistentGeoCache&) = delete;
+
+    /**
+     * @param key Canonical address text (IpAddress::toString)
+     * @return Live entry, or nullopt on a miss
+     */
+    std::optional<Entry> lookup(std::string_view key) const;
+
+    /**
+     * @brief Store a location (nullptr: negative entry)
+     *
+     * Best effort: skipped if the key or location doesn't fit a slot, or if
+     * another writer holds every candidate slot.
+     */
+    void insert(std::string_view key, const GeoLocation* location, std::chrono::seconds ttl);
+
+    /**
+     * @brief Retire every entry, in every process using the file
+     */
+    void clear();
+
+    struct Header;   ///< File layout, defined in the implementation
+    struct Slot;
+
+private:
+    PersistentGeoCache(int fd, void* mapping, size_t mapping_size);
+
+    Slot* slotAt(size_t index) const;
+
+    int fd_ = -1;
+    void* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    Header* header_ = nullptr;
+    size_t slot_mask_ = 0;
+};
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_PERSISTENTGEOCACHE_HPP
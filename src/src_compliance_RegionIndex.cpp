@@ -0,0 +1,386 @@
+/**
+ * @file RegionIndex.cpp
+ * @brief Implementation of sanctioned region boundary indexing and lookup
+ */
+
+#include "RegionIndex.hpp"
+#include "CountryDatabase.hpp"
+#include "../core/Logger.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+using json = nlohmann::json;
+
+namespace SpectreMap::Compliance {
+
+namespace {
+
+/// Upper bound on grid cells (16 MB of cell slots)
+constexpr uint64_t MAX_GRID_CELLS = uint64_t{1} << 22;
+
+/// Margin added around a cell when deciding whether an edge crosses it
+constexpr double CELL_MARGIN_DEGREES = 1e-9;
+
+/**
+ * @brief Whether a segment touches an axis-aligned rectangle (Liang-Barsky)
+ */
+bool segmentTouches(double x0, double y0, double x1, double y1,
+                    double min_x, double min_y, double max_x, double max_y) noexcept {
+    double t0 = 0.0, t1 = 1.0;
+    auto clip = [&](double p, double q) {
+        if (p == 0.0) return q >= 0.0;
+        const double r = q / p;
+        if (p < 0.0) {
+            if (r > t1) return false;
+            t0 = std::max(t0, r);
+        } else {
+            if (r < t0) return false;
+            t1 = std::min(t1, r);
+        }
+        return true;
+    };
+    const double dx = x1 - x0;
+    const double dy = y1 - y0;
+    return clip(-dx, x0 - min_x) && clip(dx, max_x - x0) &&
+           clip(-dy, y0 - min_y) && clip(dy, max_y - y0);
+}
+
+} // namespace
+
+// ============================================================================
+// Loading
+// ============================================================================
+
+std::shared_ptr<const RegionIndex> RegionIndex::loadFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        Logger::error("Cannot open region boundaries: " + path);
+        return nullptr;
+    }
+    std::ostringstream text;
+    text << in.rdbuf();
+    return parse(text.str(), path);
+}
+
+std::shared_ptr<const RegionIndex> RegionIndex::parse(std::string_view text, const std::string& source) {
+    auto reject = [&source](const std::string& why) {
+        Logger::error("Rejected region boundaries " + source + ": " + why);
+        return nullptr;
+    };
+
+    json j;
+    try {
+        j = json::parse(text);
+    } catch (const json::exception& e) {
+        return reject(e.what());
+    }
+    if (!j.is_object() || !j.contains("regions") || !j["regions"].is_array()) {
+        return reject("expected an object with a \"regions\" array");
+    }
+    if (j["regions"].empty()) {
+        return reject("no regions listed");
+    }
+
+    double cell_degrees = DEFAULT_CELL_DEGREES;
+    if (j.contains("cell_degrees")) {
+        if (!j["cell_degrees"].is_number()) {
+            return reject("\"cell_degrees\" must be a number");
+        }
+        cell_degrees = j["cell_degrees"].get<double>();
+        if (!(cell_degrees >= 0.001 && cell_degrees <= 10.0)) {
+            return reject("\"cell_degrees\" must be between 0.001 and 10");
+        }
+    }
+
+    std::shared_ptr<RegionIndex> index(new RegionIndex());
+    index->version_ = j.contains("version") && j["version"].is_string()
+                          ? j["version"].get<std::string>() : "unversioned";
+
+    for (const json& entry : j["regions"]) {
+        if (!entry.is_object()) {
+            return reject("region entries must be objects");
+        }
+        Region region;
+        region.code = entry.value("code", "");
+        if (CountryTable::packCode(region.code) == 0) {
+            return reject("invalid region code \"" + region.code + "\" (expected 2-3 letters A-Z)");
+        }
+        for (const Region& other : index->regions_) {
+            if (other.code == region.code) {
+                return reject("duplicate region code " + region.code);
+            }
+        }
+
+        if (entry.contains("countries")) {
+            if (!entry["countries"].is_array()) {
+                return reject(region.code + ": \"countries\" must be an array");
+            }
+            for (const json& country : entry["countries"]) {
+                if (!country.is_string() || CountryTable::packCode(country.get<std::string>()) == 0) {
+                    return reject(region.code + ": invalid country code " + country.dump());
+                }
+                region.countries.push_back(country.get<std::string>());
+            }
+        }
+
+        if (entry.contains("subdivisions")) {
+            if (!entry["subdivisions"].is_array()) {
+                return reject(region.code + ": \"subdivisions\" must be an array");
+            }
+            for (const json& subdivision : entry["subdivisions"]) {
+                const std::string code = subdivision.is_string() ? subdivision.get<std::string>() : "";
+                const size_t dash = code.find('-');
+                if (dash == std::string::npos || dash == 0 || dash + 1 == code.size()) {
+                    return reject(region.code + ": invalid subdivision " + subdivision.dump() +
+                                  " (expected an ISO 3166-2 code such as \"UA-43\")");
+                }
+                region.subdivisions.push_back(code);
+            }
+        }
+
+        region.first_edge = static_cast<uint32_t>(index->edges_.size());
+        region.min_lon = region.min_lat = INFINITY;
+        region.max_lon = region.max_lat = -INFINITY;
+        if (entry.contains("polygons")) {
+            if (!entry["polygons"].is_array()) {
+                return reject(region.code + ": \"polygons\" must be an array of rings");
+            }
+            for (const json& ring : entry["polygons"]) {
+                if (!ring.is_array()) {
+                    return reject(region.code + ": each polygon must be an array of [lon, lat] points");
+                }
+                std::vector<std::pair<double, double>> points;
+                for (const json& point : ring) {
+                    if (!point.is_array() || point.size() != 2 || !point[0].is_number() || !point[1].is_number()) {
+                        return reject(region.code + ": invalid point " + point.dump() + " (expected [lon, lat])");
+                    }
+                    const double lon = point[0].get<double>();
+                    const double lat = point[1].get<double>();
+                    if (!(lon >= -180.0 && lon <= 180.0 && lat >= -90.0 && lat <= 90.0)) {
+                        return reject(region.code + ": point " + point.dump() + " is out of range");
+                    }
+                    points.emplace_back(lon, lat);
+                }
+                // Rings may repeat the first point at the end (GeoJSON) or not
+                if (points.size() > 1 && points.front() == points.back()) {
+                    points.pop_back();
+                }
+                if (points.size() < 3) {
+                    return reject(region.code + ": a polygon ring needs at least 3 distinct points");
+                }
+                for (size_t i = 0; i < points.size(); ++i) {
+                    const auto [lon0, lat0] = points[i];
+                    const auto [lon1, lat1] = points[(i + 1) % points.size()];
+                    index->edges_.push_back(Edge{
+                        .lon0 = lon0, .lat0 = lat0, .lon1 = lon1, .lat1 = lat1,
+                        .slope = lat1 != lat0 ? (lon1 - lon0) / (lat1 - lat0) : 0.0
+                    });
+                    region.min_lon = std::min(region.min_lon, lon0);
+                    region.max_lon = std::max(region.max_lon, lon0);
+                    region.min_lat = std::min(region.min_lat, lat0);
+                    region.max_lat = std::max(region.max_lat, lat0);
+                }
+            }
+        }
+        region.edge_count = static_cast<uint32_t>(index->edges_.size()) - region.first_edge;
+
+        if (region.subdivisions.empty() && region.edge_count == 0) {
+            return reject(region.code + ": a region needs subdivisions or polygons");
+        }
+        index->regions_.push_back(std::move(region));
+    }
+
+    std::string error;
+    if (!index->buildGrid(cell_degrees, error)) {
+        return reject(error);
+    }
+    return index;
+}
+
+// ============================================================================
+// Grid Construction
+// ============================================================================
+
+bool RegionIndex::buildGrid(double cell_degrees, std::string& error) {
+    double min_lon = INFINITY, min_lat = INFINITY, max_lon = -INFINITY, max_lat = -INFINITY;
+    for (const Region& region : regions_) {
+        if (region.edge_count == 0) continue;
+        min_lon = std::min(min_lon, region.min_lon);
+        min_lat = std::min(min_lat, region.min_lat);
+        max_lon = std::max(max_lon, region.max_lon);
+        max_lat = std::max(max_lat, region.max_lat);
+    }
+    if (min_lon == INFINITY) {
+        return true;   // Subdivision codes only; every coordinate query misses
+    }
+
+    cells_per_degree_ = 1.0 / cell_degrees;
+    grid_lon_ = min_lon;
+    grid_lat_ = min_lat;
+    const uint64_t columns = static_cast<uint64_t>((max_lon - min_lon) * cells_per_degree_) + 1;
+    const uint64_t rows = static_cast<uint64_t>((max_lat - min_lat) * cells_per_degree_) + 1;
+    if (columns * rows > MAX_GRID_CELLS) {
+        error = "grid of " + std::to_string(columns * rows) + " cells is too fine; raise \"cell_degrees\"";
+        return false;
+    }
+    columns_ = static_cast<uint32_t>(columns);
+    rows_ = static_cast<uint32_t>(rows);
+
+    auto column = [this](double lon) {
+        const double x = std::floor((lon - grid_lon_) * cells_per_degree_);
+        return static_cast<uint32_t>(std::clamp(x, 0.0, static_cast<double>(columns_ - 1)));
+    };
+    auto row = [this](double lat) {
+        const double y = std::floor((lat - grid_lat_) * cells_per_degree_);
+        return static_cast<uint32_t>(std::clamp(y, 0.0, static_cast<double>(rows_ - 1)));
+    };
+    auto cellLon = [this](uint32_t x) { return grid_lon_ + x / cells_per_degree_; };
+    auto cellLat = [this](uint32_t y) { return grid_lat_ + y / cells_per_degree_; };
+
+    // (cell, region << 1 | covers_cell), collected region by region
+    std::vector<std::pair<uint32_t, uint32_t>> entries;
+    enum : uint8_t { UNTOUCHED, CROSSED };
+    std::vector<uint8_t> state(static_cast<size_t>(columns_) * rows_, UNTOUCHED);
+
+    for (uint32_t r = 0; r < regions_.size(); ++r) {
+        const Region& region = regions_[r];
+        if (region.edge_count == 0) continue;
+
+        // A cell no edge comes near lies wholly inside or outside the region
+        for (uint32_t e = region.first_edge; e < region.first_edge + region.edge_count; ++e) {
+            const Edge& edge = edges_[e];
+            const uint32_t x0 = column(std::min(edge.lon0, edge.lon1) - CELL_MARGIN_DEGREES);
+            const uint32_t x1 = column(std::max(edge.lon0, edge.lon1) + CELL_MARGIN_DEGREES);
+            const uint32_t y0 = row(std::min(edge.lat0, edge.lat1) - CELL_MARGIN_DEGREES);
+            const uint32_t y1 = row(std::max(edge.lat0, edge.lat1) + CELL_MARGIN_DEGREES);
+            for (uint32_t y = y0; y <= y1; ++y) {
+                for (uint32_t x = x0; x <= x1; ++x) {
+                    if (segmentTouches(edge.lon0, edge.lat0, edge.lon1, edge.lat1,
+                                       cellLon(x) - CELL_MARGIN_DEGREES, cellLat(y) - CELL_MARGIN_DEGREES,
+                                       cellLon(x + 1) + CELL_MARGIN_DEGREES, cellLat(y + 1) + CELL_MARGIN_DEGREES)) {
+                        state[static_cast<size_t>(y) * columns_ + x] = CROSSED;
+                    }
+                }
+            }
+        }
+
+        for (uint32_t y = row(region.min_lat); y <= row(region.max_lat); ++y) {
+            for (uint32_t x = column(region.min_lon); x <= column(region.max_lon); ++x) {
+                const uint32_t cell = y * columns_ + x;
+                if (state[cell] == CROSSED) {
+                    entries.emplace_back(cell, r << 1);
+                    state[cell] = UNTOUCHED;
+                } else if (contains(region, (cellLat(y) + cellLat(y + 1)) / 2, (cellLon(x) + cellLon(x + 1)) / 2)) {
+                    entries.emplace_back(cell, r << 1 | 1);
+                }
+            }
+        }
+    }
+
+    // Group by cell; the stable sort keeps regions in file order within a cell
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    cells_.assign(static_cast<size_t>(columns_) * rows_, 0);
+    for (size_t i = 0; i < entries.size();) {
+        const uint32_t cell = entries[i].first;
+        size_t end = i;
+        while (end < entries.size() && entries[end].first == cell) ++end;
+        cells_[cell] = static_cast<uint32_t>(candidates_.size()) + 1;
+        candidates_.push_back(static_cast<uint32_t>(end - i));
+        for (; i < end; ++i) {
+            candidates_.push_back(entries[i].second);
+        }
+    }
+    candidates_.shrink_to_fit();
+    return true;
+}
+
+// ============================================================================
+// Lookup
+// ============================================================================
+
+bool RegionIndex::contains(const Region& region, double latitude, double longitude) const noexcept {
+    if (!(longitude >= region.min_lon && longitude <= region.max_lon &&
+          latitude >= region.min_lat && latitude <= region.max_lat)) {
+        return false;
+    }
+    // Even-odd rule: count the edges crossed by a ray running east
+    bool inside = false;
+    const Edge* edge = edges_.data() + region.first_edge;
+    for (const Edge* end = edge + region.edge_count; edge != end; ++edge) {
+        if ((edge->lat0 > latitude) != (edge->lat1 > latitude) &&
+            longitude < edge->lon0 + (latitude - edge->lat0) * edge->slope) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+int RegionIndex::regionAt(double latitude, double longitude) const noexcept {
+    const double x = (longitude - grid_lon_) * cells_per_degree_;
+    const double y = (latitude - grid_lat_) * cells_per_degree_;
+    // Written so NaN coordinates fail too
+    if (!(x >= 0.0 && y >= 0.0 && x < columns_ && y < rows_)) {
+        return -1;
+    }
+    const uint32_t list = cells_[static_cast<size_t>(y) * columns_ + static_cast<size_t>(x)];
+    if (list == 0) {
+        return -1;
+    }
+    const uint32_t* entry = candidates_.data() + list - 1;
+    const uint32_t count = *entry++;
+    for (const uint32_t* end = entry + count; entry != end; ++entry) {
+        const uint32_t region = *entry >> 1;
+        if ((*entry & 1) || contains(regions_[region], latitude, longitude)) {
+            return static_cast<int>(region);
+        }
+    }
+    return -1;
+}
+
+bool RegionIndex::listsCountry(const Region& region, std::string_view country_code) noexcept {
+    if (region.countries.empty()) return true;
+    return std::find(region.countries.begin(), region.countries.end(), country_code) != region.countries.end();
+}
+
+std::string_view RegionIndex::classify(std::string_view country_code, std::string_view subdivision_code,
+                                       double latitude, double longitude) const noexcept {
+    if (!subdivision_code.empty()) {
+        for (const Region& region : regions_) {
+            for (const std::string& subdivision : region.subdivisions) {
+                // "UA" + "43" against "UA-43", without building the string
+                if (subdivision.size() == country_code.size() + 1 + subdivision_code.size() &&
+                    subdivision.starts_with(country_code) && subdivision[country_code.size()] == '-' &&
+                    subdivision.ends_with(subdivision_code) && listsCountry(region, country_code)) {
+                    return region.code;
+                }
+            }
+        }
+    }
+    // Providers don't always report a subdivision, so coordinates decide the rest
+    const int region = regionAt(latitude, longitude);
+    if (region >= 0 && listsCountry(regions_[region], country_code)) {
+        return regions_[region].code;
+    }
+    return {};
+}
+
+std::string_view RegionIndex::locate(double latitude, double longitude) const noexcept {
+    const int region = regionAt(latitude, longitude);
+    return region >= 0 ? std::string_view(regions_[region].code) : std::string_view();
+}
+
+std::vector<std::string_view> RegionIndex::codes() const {
+    std::vector<std::string_view> result;
+    result.reserve(regions_.size());
+    for (const Region& region : regions_) {
+        result.push_back(region.code);
+    }
+    return result;
+}
+
+} // namespace SpectreMap::Compliance
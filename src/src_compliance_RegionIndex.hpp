@@ -0,0 +1,131 @@
+/**
+ * @file RegionIndex.hpp
+ * @brief Point-in-polygon mapping of located addresses to sanctioned regions
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * Some sanctions programs cover part of a country (Crimea, Donetsk and
+ * Luhansk under 31 CFR Part 589) rather than the whole of it. GeoIP
+ * providers only ever report the parent country ("UA"), so the policy's
+ * regional pseudo-codes (XCR, XDO, XLU) could never match. A RegionIndex
+ * maps a lookup to its regional code before classification, in two ways:
+ *
+ * - the provider's ISO 3166-2 subdivision ("UA" + "43" is "UA-43"), when
+ *   the region lists it
+ * - the coordinates, tested against simplified boundary polygons
+ *
+ * Either applies only when the reported country is one the region lists,
+ * so a coordinate near a border never reclassifies a neighbouring country.
+ *
+ * Boundaries are indexed by a uniform grid over their combined bounding
+ * box. Each cell records the regions that touch it and whether a region
+ * covers the cell completely; only cells crossed by a boundary edge need
+ * an exact even-odd test, so most queries are one table read. The index is
+ * immutable; lookups never allocate or lock.
+ */
+
+#ifndef SPECTREMAP_REGIONINDEX_HPP
+#define SPECTREMAP_REGIONINDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace SpectreMap::Compliance {
+
+/**
+ * @brief Immutable index of sanctioned region boundaries
+ */
+class RegionIndex {
+public:
+    /// Grid cell edge used when the file does not set "cell_degrees"
+    static constexpr double DEFAULT_CELL_DEGREES = 0.1;
+
+    /**
+     * @brief Read and index a boundary file
+     * @return Index, or nullptr (logged) if the file can't be read or is invalid
+     */
+    static std::shared_ptr<const RegionIndex> loadFile(const std::string& path);
+
+    /**
+     * @brief Index boundaries from JSON text
+     *
+     * Expected shape:
+     * {"version": "...", "cell_degrees": 0.1, "regions": [{"code": "XCR",
+     *  "name": "...", "countries": ["UA"], "subdivisions": ["UA-43"],
+     *  "polygons": [[[lon, lat], ...], ...]}]}
+     *
+     * Each polygon is one ring; a point inside an odd number of a region's
+     * rings is inside the region, so holes are rings of their own. Regions
+     * are tried in file order.
+     *
+     * @param source Name used in log messages
+     * @return Index, or nullptr (logged) if the text is invalid
+     */
+    static std::shared_ptr<const RegionIndex> parse(std::string_view text, const std::string& source);
+
+    /**
+     * @brief Regional code for a located address
+     * @param country_code Country reported by the lookup
+     * @param subdivision_code ISO 3166-2 suffix reported by the lookup (may be empty)
+     * @return Region code (e.g. "XCR"), or empty if no region applies
+     */
+    std::string_view classify(std::string_view country_code, std::string_view subdivision_code,
+                              double latitude, double longitude) const noexcept;
+
+    /**
+     * @brief Region whose boundary contains a point, whatever the country
+     * @return Region code, or empty if the point is in no region
+     */
+    std::string_view locate(double latitude, double longitude) const noexcept;
+
+    /**
+     * @brief Codes of all regions, in file order
+     */
+    std::vector<std::string_view> codes() const;
+
+    size_t size() const noexcept { return regions_.size(); }
+    const std::string& version() const noexcept { return version_; }
+
+private:
+    struct Region {
+        std::string code;
+        std::vector<std::string> countries;      ///< Empty: any country
+        std::vector<std::string> subdivisions;   ///< Full ISO 3166-2 codes ("UA-43")
+        uint32_t first_edge = 0;
+        uint32_t edge_count = 0;
+        double min_lon = 0, min_lat = 0, max_lon = 0, max_lat = 0;
+    };
+
+    /**
+     * @brief Ring edge prepared for the even-odd crossing test
+     */
+    struct Edge {
+        double lon0, lat0, lon1, lat1;
+        double slope;   ///< Longitude change per degree of latitude (0 for horizontal edges)
+    };
+
+    RegionIndex() = default;
+
+    bool buildGrid(double cell_degrees, std::string& error);
+    int regionAt(double latitude, double longitude) const noexcept;
+    bool contains(const Region& region, double latitude, double longitude) const noexcept;
+    static bool listsCountry(const Region& region, std::string_view country_code) noexcept;
+
+    std::string version_;
+    std::vector<Region> regions_;
+    std::vector<Edge> edges_;
+
+    // Grid over the regions' combined bounding box
+    double grid_lon_ = 0, grid_lat_ = 0;   ///< South-west corner
+    double cells_per_degree_ = 0;
+    uint32_t columns_ = 0, rows_ = 0;
+    std::vector<uint32_t> cells_;        ///< 0: empty, else 1 + offset of the cell's list in candidates_
+    std::vector<uint32_t> candidates_;   ///< Per list: count, then (region << 1 | covers_cell) entries
+};
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_REGIONINDEX_HPP
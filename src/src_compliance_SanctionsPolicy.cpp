@@ -0,0 +1,318 @@
+/**
+ * @file SanctionsPolicy.cpp
+ * @brief Implementation of sanctions policy loading, publishing and file watching
+ */
+
+#include "SanctionsPolicy.hpp"
+#include "../core/Logger.hpp"
+#include <nlohmann/json.hpp>
+#include <fstream>
+#include <sstream>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace SpectreMap::Compliance {
+
+namespace {
+
+// Every published policy, kept alive so views handed to readers never dangle
+std::mutex g_publish_mutex;
+std::vector<std::shared_ptr<const SanctionsPolicy>> g_published;
+std::atomic<const SanctionsPolicy*> g_current{nullptr};
+
+std::optional<SanctionsProgram> parseProgram(std::string_view name) {
+    if (name == "ofac_comprehensive") return SanctionsProgram::OFAC_COMPREHENSIVE;
+    if (name == "ofac_sectoral") return SanctionsProgram::OFAC_SECTORAL;
+    if (name == "arms_embargo") return SanctionsProgram::ARMS_EMBARGO;
+    if (name == "high_risk") return SanctionsProgram::HIGH_RISK;
+    return std::nullopt;
+}
+
+} // namespace
+
+// ============================================================================
+// Snapshot Construction
+// ============================================================================
+
+std::shared_ptr<const SanctionsPolicy> SanctionsPolicy::builtin() {
+    static const std::shared_ptr<const SanctionsPolicy> instance = [] {
+        std::shared_ptr<SanctionsPolicy> policy(new SanctionsPolicy());
+        policy->version_ = "builtin";
+        policy->source_ = "builtin";
+        const auto records = CountryDatabase::records();
+        policy->records_.assign(records.begin(), records.end());
+        policy->buildIndex();
+        return policy;
+    }();
+    return instance;
+}
+
+std::shared_ptr<const SanctionsPolicy> SanctionsPolicy::loadFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        Logger::error("Cannot open sanctions list: " + path);
+        return nullptr;
+    }
+    std::ostringstream text;
+    text << in.rdbuf();
+    return parse(text.str(), path);
+}
+
+std::shared_ptr<const SanctionsPolicy> SanctionsPolicy::parse(std::string_view text,
+                                                             const std::string& source) {
+    auto reject = [&source](const std::string& why) {
+        Logger::error("Rejected sanctions list " + source + ": " + why);
+        return nullptr;
+    };
+
+    json j;
+    try {
+        j = json::parse(text);
+    } catch (const json::exception& e) {
+        return reject(e.what());
+    }
+    if (!j.is_object() || !j.contains("countries") || !j["countries"].is_array()) {
+        return reject("expected an object with a \"countries\" array");
+    }
+    if (j["countries"].empty()) {
+        return reject("no countries listed");
+    }
+    if (j["countries"].size() >= UINT16_MAX) {
+        return reject("too many countries");
+    }
+
+    std::shared_ptr<SanctionsPolicy> policy(new SanctionsPolicy());
+    policy->source_ = source;
+    policy->version_ = j.contains("version") && j["version"].is_string()
+                           ? j["version"].get<std::string>() : "unversioned";
+
+    std::array<bool, CountryTable::KEY_SPACE> seen{};
+    policy->owned_.reserve(j["countries"].size());
+    for (const json& entry : j["countries"]) {
+        if (!entry.is_object()) {
+            return reject("country entries must be objects");
+        }
+        const std::string code = entry.value("code", "");
+        const uint32_t key = CountryTable::packCode(code);
+        if (key == 0) {
+            return reject("invalid country code \"" + code + "\" (expected 2-3 letters A-Z)");
+        }
+        if (seen[key]) {
+            return reject("duplicate country code " + code);
+        }
+        seen[key] = true;
+
+        const auto program = parseProgram(entry.value("program", ""));
+        if (!program) {
+            return reject("unknown program for " + code + " (expected ofac_comprehensive, "
+                          "ofac_sectoral, arms_embargo or high_risk)");
+        }
+
+        OwnedRecord record;
+        record.code = code;
+        record.name = entry.value("name", code);
+        record.program = *program;
+        if (entry.contains("regulations")) {
+            const json& regulations = entry["regulations"];
+            if (!regulations.is_array()) {
+                return reject("regulations for " + code + " must be an array of strings");
+            }
+            for (const json& regulation : regulations) {
+                if (!regulation.is_string()) {
+                    return reject("regulations for " + code + " must be an array of strings");
+                }
+                record.regulations.push_back(regulation.get<std::string>());
+            }
+        }
+        policy->owned_.push_back(std::move(record));
+    }
+
+    // owned_ is final from here on, so views into it stay valid
+    policy->regulation_views_.reserve(policy->owned_.size());
+    policy->records_.reserve(policy->owned_.size());
+    for (const OwnedRecord& owned : policy->owned_) {
+        auto& views = policy->regulation_views_.emplace_back(owned.regulations.begin(),
+                                                             owned.regulations.end());
+        policy->records_.push_back(CountryRecord{
+            .code = owned.code,
+            .name = owned.name,
+            .program = owned.program,
+            .regulations = views
+        });
+    }
+    policy->buildIndex();
+    return policy;
+}
+
+void SanctionsPolicy::buildIndex() {
+    index_.fill(0);
+    levels_.fill(static_cast<uint8_t>(RestrictionLevel::ALLOWED));
+    for (size_t i = 0; i < records_.size(); ++i) {
+        const uint32_t key = CountryTable::packCode(records_[i].code);
+        index_[key] = static_cast<uint16_t>(i + 1);
+        levels_[key] = static_cast<uint8_t>(records_[i].level());
+    }
+}
+
+size_t SanctionsPolicy::countByProgram(SanctionsProgram program) const noexcept {
+    size_t count = 0;
+    for (const CountryRecord& record : records_) {
+        count += record.program == program;
+    }
+    return count;
+}
+
+// ============================================================================
+// Publishing
+// ============================================================================
+
+const SanctionsPolicy& SanctionsPolicy::current() noexcept {
+    if (const SanctionsPolicy* policy = g_current.load(std::memory_order_acquire)) {
+        return *policy;
+    }
+    // Held raw: the builtin is never released, and copying its shared_ptr
+    // would make every check contend on one reference count
+    static const SanctionsPolicy* const fallback = builtin().get();
+    return *fallback;
+}
+
+namespace {
+
+// Build the builtin at startup, so the first check does not allocate
+[[maybe_unused]] const SanctionsPolicy& g_startup_policy = SanctionsPolicy::current();
+
+} // namespace
+
+void SanctionsPolicy::publish(std::shared_ptr<const SanctionsPolicy> policy) {
+    if (!policy) return;
+
+    std::lock_guard lock(g_publish_mutex);
+    g_current.store(policy.get(), std::memory_order_release);
+    Logger::info("Sanctions policy " + policy->version() + " from " + policy->source() + " active: " +
+                 std::to_string(policy->records().size() - policy->countByProgram(SanctionsProgram::HIGH_RISK)) +
+                 " restricted, " + std::to_string(policy->countByProgram(SanctionsProgram::HIGH_RISK)) +
+                 " high-risk");
+    g_published.push_back(std::move(policy));
+}
+
+// ============================================================================
+// File Watcher
+// ============================================================================
+
+SanctionsWatcher::SanctionsWatcher(const std::string& path, std::chrono::milliseconds poll_interval)
+    : path_(path), poll_interval_(poll_interval) {
+    std::error_code ec;
+    const auto mtime = std::filesystem::last_write_time(path_, ec);
+    if (!ec) last_write_ = mtime;
+
+#ifdef __linux__
+    // Watch the directory: editors and deploy tools replace the file by rename
+    const std::filesystem::path directory = path_.has_parent_path() ? path_.parent_path() : ".";
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ >= 0 &&
+        inotify_add_watch(inotify_fd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+    if (inotify_fd_ >= 0 && pipe2(wake_pipe_, O_CLOEXEC) != 0) {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+    if (inotify_fd_ < 0) {
+        Logger::warning("inotify unavailable for " + directory.string() + ", polling sanctions list");
+    }
+#endif
+
+    thread_ = std::thread(&SanctionsWatcher::run, this);
+}
+
+SanctionsWatcher::~SanctionsWatcher() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_.store(true);
+    }
+    cv_.notify_one();
+#ifdef __linux__
+    if (wake_pipe_[1] >= 0) {
+        const char byte = 0;
+        [[maybe_unused]] const ssize_t n = write(wake_pipe_[1], &byte, 1);
+    }
+#endif
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+#ifdef __linux__
+    for (int fd : {inotify_fd_, wake_pipe_[0], wake_pipe_[1]}) {
+        if (fd >= 0) close(fd);
+    }
+#endif
+}
+
+void SanctionsWatcher::run() {
+#ifdef __linux__
+    if (inotify_fd_ < 0) {
+        runPolling();
+        return;
+    }
+
+    const std::string filename = path_.filename().string();
+    alignas(inotify_event) char buffer[4096];
+    bool pending = false;
+
+    while (!stopping_.load()) {
+        pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wake_pipe_[0], POLLIN, 0}};
+        // Once a change is seen, wait for the writer to go quiet before reloading
+        const int ready = poll(fds, 2, pending ? 100 : -1);
+        if (stopping_.load()) break;
+        if (ready < 0) continue;
+        if (ready == 0) {
+            pending = false;
+            reload();
+            continue;
+        }
+
+        ssize_t len;
+        while ((len = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + len;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(p);
+                if (event->len > 0 && filename == event->name) {
+                    pending = true;
+                }
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+#else
+    runPolling();
+#endif
+}
+
+void SanctionsWatcher::runPolling() {
+    std::unique_lock lock(mutex_);
+    while (!cv_.wait_for(lock, poll_interval_, [this] { return stopping_.load(); })) {
+        std::error_code ec;
+        const auto mtime = std::filesystem::last_write_time(path_, ec);
+        if (ec || mtime == last_write_) continue;
+        last_write_ = mtime;
+        lock.unlock();
+        reload();
+        lock.lock();
+    }
+}
+
+void SanctionsWatcher::reload() {
+    // A bad file is logged by loadFile and leaves the current policy in place
+    if (auto policy = SanctionsPolicy::loadFile(path_.string())) {
+        SanctionsPolicy::publish(std::move(policy));
+        reloads_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace SpectreMap::Compliance
@@ -0,0 +1,167 @@
+/**
+ * @file SanctionsPolicy.hpp
+ * @brief Hot-reloadable sanctions policy published as immutable snapshots
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * A SanctionsPolicy is an immutable country table built either from the
+ * compiled-in CountryDatabase or from config/sanctioned_countries.json. The
+ * process-wide current policy is an atomically swapped pointer: checks read
+ * it with a single acquire load and never lock, and a reload builds a new
+ * snapshot off to the side before publishing it.
+ *
+ * Published snapshots are retained for the life of the process (RCU with an
+ * unbounded grace period), so a RestrictionDecision viewing an older
+ * snapshot stays valid after a reload. Each snapshot is ~60 KiB and reloads
+ * only follow edits to the policy file.
+ */
+
+#ifndef SPECTREMAP_SANCTIONSPOLICY_HPP
+#define SPECTREMAP_SANCTIONSPOLICY_HPP
+
+#include "CountryDatabase.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace SpectreMap::Compliance {
+
+/**
+ * @brief Immutable country classification snapshot
+ */
+class SanctionsPolicy {
+public:
+    /**
+     * @brief Policy equivalent to the compiled-in CountryDatabase
+     */
+    static std::shared_ptr<const SanctionsPolicy> builtin();
+
+    /**
+     * @brief Parse a sanctions JSON file
+     * @return Policy, or nullptr if the file is missing or invalid (details are logged)
+     */
+    static std::shared_ptr<const SanctionsPolicy> loadFile(const std::string& path);
+
+    /**
+     * @brief Parse sanctions JSON text
+     * @param source Name used in log messages
+     */
+    static std::shared_ptr<const SanctionsPolicy> parse(std::string_view text, const std::string& source);
+
+    /**
+     * @brief Current process-wide policy (lock-free; never null)
+     */
+    static const SanctionsPolicy& current() noexcept;
+
+    /**
+     * @brief Make a policy current; the previous one is retained
+     */
+    static void publish(std::shared_ptr<const SanctionsPolicy> policy);
+
+    /**
+     * @brief Look up a listed country (one array probe)
+     * @return Record, or nullptr if the code carries no restrictions
+     */
+    const CountryRecord* find(std::string_view code) const noexcept {
+        const uint16_t slot = index_[CountryTable::packCode(code)];
+        return slot ? &records_[slot - 1] : nullptr;
+    }
+
+    std::span<const CountryRecord> records() const noexcept { return records_; }
+
+    /**
+     * @brief Restriction level per packed key, as uint8_t (see CountryClassifier)
+     *
+     * Holds KEY_SPACE entries plus LEVEL_TABLE_PADDING zero bytes, so a
+     * 32-bit load at any key stays inside the table.
+     */
+    const uint8_t* levelTable() const noexcept { return levels_.data(); }
+
+    static constexpr size_t LEVEL_TABLE_PADDING = 3;
+
+    size_t countByProgram(SanctionsProgram program) const noexcept;
+
+    /**
+     * @brief Version label from the policy file ("builtin" for the compiled-in table)
+     */
+    const std::string& version() const noexcept { return version_; }
+
+    /**
+     * @brief Where the policy came from (file path or "builtin")
+     */
+    const std::string& source() const noexcept { return source_; }
+
+private:
+    struct OwnedRecord {
+        std::string code;
+        std::string name;
+        SanctionsProgram program = SanctionsProgram::NONE;
+        std::vector<std::string> regulations;
+    };
+
+    SanctionsPolicy() = default;
+    void buildIndex();
+
+    std::string version_;
+    std::string source_;
+    std::vector<OwnedRecord> owned_;                        ///< Backing storage (file policies only)
+    std::vector<std::vector<std::string_view>> regulation_views_;
+    std::vector<CountryRecord> records_;
+    std::array<uint16_t, CountryTable::KEY_SPACE> index_{};  ///< Packed key -> record position + 1
+    std::array<uint8_t, CountryTable::KEY_SPACE + LEVEL_TABLE_PADDING> levels_{};  ///< Packed key -> RestrictionLevel
+};
+
+/**
+ * @brief Reloads the sanctions file whenever it changes
+ *
+ * Uses inotify on Linux (watching the directory, so editors that replace the
+ * file by rename are seen) and mtime polling elsewhere. A file that fails to
+ * parse is logged and the current policy stays in place.
+ */
+class SanctionsWatcher {
+public:
+    /**
+     * @param path Sanctions file to watch (need not exist yet)
+     * @param poll_interval Fallback poll period where inotify is unavailable
+     */
+    explicit SanctionsWatcher(const std::string& path,
+                              std::chrono::milliseconds poll_interval = std::chrono::milliseconds(2000));
+    ~SanctionsWatcher();
+
+    SanctionsWatcher(const SanctionsWatcher&) = delete;
+    SanctionsWatcher& operator=(const SanctionsWatcher&) = delete;
+
+    /**
+     * @brief Successful reloads since the watcher started
+     */
+    uint64_t reloads() const noexcept { return reloads_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    void runPolling();
+    void reload();
+
+    std::filesystem::path path_;
+    std::chrono::milliseconds poll_interval_;
+    std::optional<std::filesystem::file_time_type> last_write_;
+    std::atomic<uint64_t> reloads_{0};
+    std::atomic<bool> stopping_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int inotify_fd_ = -1;
+    int wake_pipe_[2] = {-1, -1};
+    std::thread thread_;
+};
+
+} // namespace SpectreMap::Compliance
+
+#endif // SPECTREMAP_SANCTIONSPOLICY_HPP
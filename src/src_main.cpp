@@ -1,21 +1,62 @@
 // Add to main.cpp startup sequence
 
 #include "compliance/GeoRestriction.hpp"
+#include "compliance/ComplianceGate.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 
 int main(int argc, char* argv[]) {
     using namespace SpectreMap;
+    using StartupClock = std::chrono::steady_clock;
+    const auto startup_began = StartupClock::now();
     
-    // Initialize export compliance system FIRST
+    // Budget for the startup compliance check; an unresolved check denies access
+    std::chrono::milliseconds compliance_deadline(3000);
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--compliance-deadline-ms") != 0) continue;
+        // A zero, negative or unparsable budget would deny every check without saying why
+        char* end = nullptr;
+        const char* value = i + 1 < argc ? argv[++i] : "";
+        const long long parsed = std::strtoll(value, &end, 10);
+        if (*value == '\0' || *end != '\0' || parsed < 1 || parsed > 600000) {
+            std::cerr << "Invalid value for --compliance-deadline-ms: \"" << value << "\"\n"
+                      << "Usage: " << argv[0] << " [--compliance-deadline-ms N]  (N: 1-600000, default 3000)\n";
+            return 2;
+        }
+        compliance_deadline = std::chrono::milliseconds(parsed);
+    }
+    
+    // Start the export compliance check FIRST; it runs while the rest of
+    // startup proceeds, and nothing operational runs until the gate opens
     Compliance::GeoRestriction geoRestriction;
     geoRestriction.setStrictMode(true);
-    geoRestriction.loadSanctionsList("config/sanctioned_countries.json");
+    Compliance::ComplianceGate complianceGate(geoRestriction, [&geoRestriction] {
+        geoRestriction.loadSanctionsList("config/sanctioned_countries.json");
+        geoRestriction.loadRegionBoundaries("config/sanctioned_regions.json");
+        // Get user's IP address (implement detection)
+        return detectUserIPAddress();
+    }, compliance_deadline);
+    
+    // Initialization that does not act on the network or the user's data
+    // (configuration, UI, plugin discovery, ...) goes here
+    // ...
+    const auto initialized = StartupClock::now();
     
-    // Get user's IP address (implement detection)
-    std::string user_ip = detectUserIPAddress();
+    // Gate: every operational feature sits behind this point
+    const Compliance::RestrictionResult& result = complianceGate.wait();
+    const auto gate_opened = StartupClock::now();
+    auto elapsedMs = [](StartupClock::time_point from, StartupClock::time_point to) {
+        return std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count()) + "ms";
+    };
+    Logger::info("Startup timing: initialization " + elapsedMs(startup_began, initialized) +
+                 ", compliance check " + std::to_string(complianceGate.resolvedAfter().count()) +
+                 "ms, blocked on gate " + elapsedMs(initialized, gate_opened) +
+                 ", total " + elapsedMs(startup_began, gate_opened));
     
-    // Check export compliance
-    auto result = geoRestriction.checkAccess(user_ip);
-    geoRestriction.logAccessAttempt(user_ip, result, result.allowed ? "ALLOWED" : "BLOCKED");
+    const std::string user_ip = complianceGate.address();
+    geoRestriction.logAccessAttempt(user_ip.empty() ? "UNKNOWN" : user_ip, result,
+                                    result.allowed ? "ALLOWED" : "BLOCKED");
     
     if (!result.allowed) {
         // Display compliance block message
@@ -54,6 +95,7 @@ int main(int argc, char* argv[]) {
     // Continue with normal startup...
     Logger::info("Export compliance check passed for " + result.country_name);
     
-    // Rest of your application initialization
+    // Rest of your application initialization; components started from here
+    // on may also hold a reference to complianceGate and call allowed()
     // ...
 }
\ No newline at end of file
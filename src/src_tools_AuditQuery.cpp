@@ -0,0 +1,89 @@
+/**
+ * @file AuditQuery.cpp
+ * @brief Command-line query tool for the segmented compliance audit store
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * Usage:
+ *   audit_query [--log PATH] [--from DATE] [--to DATE] [--country CC]
+ *               [--action ACTION] [--level N] [--ip ADDRESS]
+ *
+ * Example - everything blocked from Russia in March 2026:
+ *   audit_query --country RU --action BLOCKED --from 2026-03-01 --to 2026-04-01
+ *
+ * Matching lines go to stdout; segment statistics go to stderr.
+ */
+
+#include "../compliance/AuditStore.hpp"
+#include <cstring>
+#include <iostream>
+
+using namespace SpectreMap::Compliance;
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --log PATH       Active audit log (default logs/compliance_audit.log)\n"
+              << "  --from DATE      Inclusive start, \"YYYY-MM-DD[ HH:MM:SS]\"\n"
+              << "  --to DATE        Exclusive end, same format\n"
+              << "  --country CC     ISO 3166-1 alpha-2 country code\n"
+              << "  --action ACTION  e.g. BLOCKED, ALLOWED\n"
+              << "  --level N        Restriction level (0-3)\n"
+              << "  --ip ADDRESS     Exact IP address\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string log_path = "logs/compliance_audit.log";
+    AuditQuery query;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--help") == 0 || std::strcmp(arg, "-h") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 2;
+        }
+        const std::string value = argv[++i];
+        if (std::strcmp(arg, "--log") == 0) {
+            log_path = value;
+        } else if (std::strcmp(arg, "--from") == 0) {
+            query.from = value;
+        } else if (std::strcmp(arg, "--to") == 0) {
+            query.to = value;
+        } else if (std::strcmp(arg, "--country") == 0) {
+            query.country_code = value;
+        } else if (std::strcmp(arg, "--action") == 0) {
+            query.action = value;
+        } else if (std::strcmp(arg, "--level") == 0) {
+            if (value.size() != 1 || value[0] < '0' || value[0] > '3') {
+                std::cerr << "Invalid level: " << value << "\n";
+                return 2;
+            }
+            query.level = value[0] - '0';
+        } else if (std::strcmp(arg, "--ip") == 0) {
+            query.ip_address = value;
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    std::ios::sync_with_stdio(false);
+    const AuditQueryStats stats = queryAuditLog(log_path, query, [](std::string_view line) {
+        std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
+        std::cout.put('\n');
+    });
+    std::cout.flush();
+
+    std::cerr << stats.records_matched << " matching record(s); scanned "
+              << stats.records_scanned << " record(s) in "
+              << (stats.segments_total - stats.segments_skipped) << " of "
+              << stats.segments_total << " segment(s)\n";
+    return 0;
+}
@@ -0,0 +1,590 @@
+/**
+ * @file BulkClassify.cpp
+ * @brief Command-line bulk classification of IP addresses
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * Streams addresses from a file or stdin (one per line, or one field of
+ * each line of a log or flow export), skips addresses seen recently, and
+ * classifies the rest in chunks on a work-stealing thread pool. Each chunk
+ * is one checkAccessBatch call: offline lookups with --mmdb, or one batch
+ * request to the online provider otherwise. Results are written as CSV or
+ * JSON Lines in completion order.
+ *
+ * Memory stays bounded whatever the input size: the reader blocks once
+ * --max-pending chunks are queued, and the duplicate filter remembers at
+ * most --dedup-window addresses (older ones may be classified again).
+ *
+ * Usage:
+ *   bulk_classify [--input PATH] [--output PATH] [--format csv|jsonl]
+ *                 [--field N] [--mmdb PATH] [--online] [--lookup-url URL]
+ *                 [--batch-url URL] [--anonymizer-lists] [--no-strict]
+ *                 [--threads N] [--batch-size N] [--max-pending N]
+ *                 [--dedup-window N] [--quiet]
+ *
+ * Example - classify every source address of a firewall log offline:
+ *   awk '{print $3}' fw.log | bulk_classify --mmdb data/GeoLite2-Country.mmdb > fw.csv
+ *
+ * Progress and throughput go to stderr once a second.
+ */
+
+#include "../compliance/GeoRestriction.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <semaphore>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+using namespace SpectreMap::Compliance;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Lowercase, as in the Prometheus decision labels
+constexpr const char* LEVEL_NAMES[] = {
+    "allowed", "high_risk", "restricted", "comprehensively_sanctioned"
+};
+
+enum class OutputFormat { CSV, JSONL };
+
+struct Options {
+    std::string input = "-";
+    std::string output = "-";
+    OutputFormat format = OutputFormat::CSV;
+    size_t field = 1;                 ///< 1-based field holding the address
+    std::string mmdb;
+    bool online = false;
+    std::string lookup_url;
+    std::string batch_url;
+    bool anonymizer_lists = false;
+    bool strict = true;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t batch_size = 100;          ///< ip-api's /batch limit
+    size_t max_pending = 0;           ///< 0: four chunks per thread
+    size_t dedup_window = 1'000'000;
+    bool quiet = false;
+};
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --input PATH        Addresses to classify (default stdin)\n"
+              << "  --output PATH       Results (default stdout)\n"
+              << "  --format FORMAT     csv (default) or jsonl\n"
+              << "  --field N           Field of each line holding the address, split on\n"
+              << "                      whitespace and commas (default 1)\n"
+              << "  --mmdb PATH         Classify with an offline MaxMind database\n"
+              << "  --online            Use online lookups (default without --mmdb; with\n"
+              << "                      --mmdb the database becomes the fallback provider)\n"
+              << "  --lookup-url URL    Online single lookup prefix\n"
+              << "  --batch-url URL     Online batch endpoint\n"
+              << "  --anonymizer-lists  Load the local Tor/VPN/hosting lists from data/\n"
+              << "  --no-strict         Do not block VPN/proxy/Tor addresses\n"
+              << "  --threads N         Worker threads (default: one per core)\n"
+              << "  --batch-size N      Addresses per lookup batch (default 100)\n"
+              << "  --max-pending N     Chunks queued before reading pauses (default 4 per thread)\n"
+              << "  --dedup-window N    Recent addresses remembered for deduplication (default 1000000)\n"
+              << "  --quiet             No progress reports\n";
+}
+
+std::optional<size_t> parseCount(const std::string& value) {
+    char* end = nullptr;
+    const unsigned long long parsed = std::strtoull(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || parsed == 0) return std::nullopt;
+    return static_cast<size_t>(parsed);
+}
+
+// ============================================================================
+// Input
+// ============================================================================
+
+/**
+ * @brief The requested field of a line, or an empty view
+ */
+std::string_view extractField(std::string_view line, size_t field) {
+    constexpr std::string_view separators = " \t,;\r";
+    size_t pos = 0;
+    for (size_t index = 1;; ++index) {
+        pos = line.find_first_not_of(separators, pos);
+        if (pos == std::string_view::npos) return {};
+        const size_t end = std::min(line.find_first_of(separators, pos), line.size());
+        if (index == field) return line.substr(pos, end - pos);
+        pos = end;
+    }
+}
+
+/**
+ * @brief Remembers the most recent addresses in two generations
+ *
+ * When the current generation reaches half the window it becomes the
+ * previous one and the old previous generation is dropped, so at least
+ * window / 2 and at most window addresses are remembered.
+ */
+class RecentAddresses {
+public:
+    explicit RecentAddresses(size_t window) : generation_size_(std::max<size_t>(1, window / 2)) {
+        current_.reserve(generation_size_);
+    }
+
+    /**
+     * @return True if the address was not seen recently (it is remembered now)
+     */
+    bool insert(const IpAddress& key) {
+        if (previous_.contains(key) || !current_.insert(key).second) {
+            return false;
+        }
+        if (current_.size() >= generation_size_) {
+            previous_.swap(current_);
+            current_.clear();
+        }
+        return true;
+    }
+
+private:
+    size_t generation_size_;
+    std::unordered_set<IpAddress, IpAddressHash> current_;
+    std::unordered_set<IpAddress, IpAddressHash> previous_;
+};
+
+// ============================================================================
+// Work-Stealing Pool
+// ============================================================================
+
+using Chunk = std::vector<std::string>;
+
+/**
+ * @brief Per-worker deques; idle workers steal the oldest chunk of another
+ *
+ * The reader deals chunks round-robin. Chunks differ widely in cost (an
+ * offline chunk takes microseconds, an online one a network round trip, a
+ * failed batch many single lookups), so a worker that runs dry takes work
+ * from the others instead of waiting on its own queue.
+ */
+class WorkStealingQueue {
+public:
+    explicit WorkStealingQueue(size_t workers) : queues_(workers) {}
+
+    void push(Chunk chunk) {
+        Queue& queue = queues_[next_++ % queues_.size()];
+        {
+            std::lock_guard lock(queue.mutex);
+            queue.chunks.push_back(std::move(chunk));
+        }
+        {
+            std::lock_guard lock(idle_mutex_);
+            ++available_;
+        }
+        idle_.notify_one();
+    }
+
+    void close() {
+        {
+            std::lock_guard lock(idle_mutex_);
+            closed_ = true;
+        }
+        idle_.notify_all();
+    }
+
+    /**
+     * @brief Next chunk for a worker: its own newest, else another's oldest
+     * @return False once the queue is closed and drained
+     */
+    bool pop(size_t worker, Chunk& out) {
+        for (;;) {
+            {
+                std::unique_lock lock(idle_mutex_);
+                idle_.wait(lock, [this] { return available_ > 0 || closed_; });
+                if (available_ == 0) return false;
+                --available_;
+            }
+            // A chunk is reserved for us, so some deque holds one
+            for (;;) {
+                if (take(queues_[worker], out, false)) return true;
+                for (size_t offset = 1; offset < queues_.size(); ++offset) {
+                    if (take(queues_[(worker + offset) % queues_.size()], out, true)) return true;
+                }
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Chunk> chunks;
+    };
+
+    static bool take(Queue& queue, Chunk& out, bool steal) {
+        std::lock_guard lock(queue.mutex);
+        if (queue.chunks.empty()) return false;
+        if (steal) {
+            out = std::move(queue.chunks.front());
+            queue.chunks.pop_front();
+        } else {
+            out = std::move(queue.chunks.back());
+            queue.chunks.pop_back();
+        }
+        return true;
+    }
+
+    std::vector<Queue> queues_;
+    size_t next_ = 0;                  // Only the reader pushes
+    std::mutex idle_mutex_;
+    std::condition_variable idle_;
+    size_t available_ = 0;
+    bool closed_ = false;
+};
+
+// ============================================================================
+// Output
+// ============================================================================
+
+void appendCsvField(std::string& out, std::string_view value) {
+    if (value.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out += value;
+        return;
+    }
+    out += '"';
+    for (char c : value) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+void appendJsonString(std::string& out, std::string_view value) {
+    static constexpr char HEX[] = "0123456789abcdef";
+    out += '"';
+    for (char c : value) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out += "\\u00";
+                    out += HEX[(c >> 4) & 0xF];
+                    out += HEX[c & 0xF];
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+void appendRecord(std::string& out, OutputFormat format, const std::string& ip, const RestrictionResult& result,
+                  const std::optional<GeoLocation>& location) {
+    const char* level = LEVEL_NAMES[static_cast<size_t>(result.level)];
+    const bool proxy = location && location->is_proxy;
+    const bool vpn = location && location->is_vpn;
+    const bool tor = location && location->is_tor;
+    const bool hosting = location && location->is_hosting;
+
+    if (format == OutputFormat::CSV) {
+        appendCsvField(out, ip);
+        out += ',';
+        appendCsvField(out, result.country_code);
+        out += ',';
+        appendCsvField(out, result.country_name);
+        out += ',';
+        out += level;
+        out += result.allowed ? ",1," : ",0,";
+        appendCsvField(out, result.reason);
+        out += proxy ? ",1" : ",0";
+        out += vpn ? ",1" : ",0";
+        out += tor ? ",1" : ",0";
+        out += hosting ? ",1\n" : ",0\n";
+        return;
+    }
+
+    out += "{\"ip\":";
+    appendJsonString(out, ip);
+    out += ",\"country_code\":";
+    appendJsonString(out, result.country_code);
+    out += ",\"country_name\":";
+    appendJsonString(out, result.country_name);
+    out += ",\"level\":\"";
+    out += level;
+    out += result.allowed ? "\",\"allowed\":true" : "\",\"allowed\":false";
+    out += ",\"reason\":";
+    appendJsonString(out, result.reason);
+    out += proxy ? ",\"proxy\":true" : ",\"proxy\":false";
+    out += vpn ? ",\"vpn\":true" : ",\"vpn\":false";
+    out += tor ? ",\"tor\":true" : ",\"tor\":false";
+    out += hosting ? ",\"hosting\":true}\n" : ",\"hosting\":false}\n";
+}
+
+// ============================================================================
+// Progress
+// ============================================================================
+
+struct Counters {
+    std::atomic<uint64_t> lines{0};
+    std::atomic<uint64_t> duplicates{0};
+    std::atomic<uint64_t> classified{0};
+    std::atomic<uint64_t> blocked{0};
+    std::atomic<uint64_t> unresolved{0};   ///< No location (fail-closed)
+};
+
+void printProgress(const Counters& counters, Clock::time_point start, const char* prefix) {
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    const uint64_t classified = counters.classified.load(std::memory_order_relaxed);
+    char line[256];
+    std::snprintf(line, sizeof(line),
+                  "%s%llu line(s), %llu duplicate(s), %llu classified (%.0f/s), %llu blocked, "
+                  "%llu unresolved, %.1fs\n",
+                  prefix,
+                  static_cast<unsigned long long>(counters.lines.load(std::memory_order_relaxed)),
+                  static_cast<unsigned long long>(counters.duplicates.load(std::memory_order_relaxed)),
+                  static_cast<unsigned long long>(classified),
+                  seconds > 0 ? static_cast<double>(classified) / seconds : 0.0,
+                  static_cast<unsigned long long>(counters.blocked.load(std::memory_order_relaxed)),
+                  static_cast<unsigned long long>(counters.unresolved.load(std::memory_order_relaxed)),
+                  seconds);
+    std::cerr << line << std::flush;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--help") == 0 || std::strcmp(arg, "-h") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (std::strcmp(arg, "--online") == 0) {
+            options.online = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--anonymizer-lists") == 0) {
+            options.anonymizer_lists = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--no-strict") == 0) {
+            options.strict = false;
+            continue;
+        }
+        if (std::strcmp(arg, "--quiet") == 0) {
+            options.quiet = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 2;
+        }
+        const std::string value = argv[++i];
+        std::optional<size_t> count;
+        auto needCount = [&](size_t& target) {
+            if (!(count = parseCount(value))) {
+                std::cerr << "Invalid value for " << arg << ": " << value << "\n";
+                return false;
+            }
+            target = *count;
+            return true;
+        };
+        if (std::strcmp(arg, "--input") == 0) {
+            options.input = value;
+        } else if (std::strcmp(arg, "--output") == 0) {
+            options.output = value;
+        } else if (std::strcmp(arg, "--format") == 0) {
+            if (value == "csv") {
+                options.format = OutputFormat::CSV;
+            } else if (value == "jsonl") {
+                options.format = OutputFormat::JSONL;
+            } else {
+                std::cerr << "Unknown format: " << value << "\n";
+                return 2;
+            }
+        } else if (std::strcmp(arg, "--field") == 0) {
+            if (!needCount(options.field)) return 2;
+        } else if (std::strcmp(arg, "--mmdb") == 0) {
+            options.mmdb = value;
+        } else if (std::strcmp(arg, "--lookup-url") == 0) {
+            options.lookup_url = value;
+        } else if (std::strcmp(arg, "--batch-url") == 0) {
+            options.batch_url = value;
+        } else if (std::strcmp(arg, "--threads") == 0) {
+            if (!needCount(options.threads)) return 2;
+        } else if (std::strcmp(arg, "--batch-size") == 0) {
+            if (!needCount(options.batch_size)) return 2;
+        } else if (std::strcmp(arg, "--max-pending") == 0) {
+            if (!needCount(options.max_pending)) return 2;
+        } else if (std::strcmp(arg, "--dedup-window") == 0) {
+            if (!needCount(options.dedup_window)) return 2;
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+    if (options.max_pending == 0) {
+        options.max_pending = options.threads * 4;
+    }
+
+    std::ifstream input_file;
+    if (options.input != "-") {
+        input_file.open(options.input);
+        if (!input_file) {
+            std::cerr << "Cannot open " << options.input << "\n";
+            return 1;
+        }
+    }
+    std::ofstream output_file;
+    if (options.output != "-") {
+        output_file.open(options.output, std::ios::binary | std::ios::trunc);
+        if (!output_file) {
+            std::cerr << "Cannot create " << options.output << "\n";
+            return 1;
+        }
+    }
+    std::ios::sync_with_stdio(false);
+    std::istream& input = input_file.is_open() ? static_cast<std::istream&>(input_file) : std::cin;
+    std::ostream& output = output_file.is_open() ? static_cast<std::ostream&>(output_file) : std::cout;
+
+    GeoRestriction geo;
+    geo.setStrictMode(options.strict);
+    // Results are read once each; caching them would only cost memory
+    geo.setCacheConfig({.enabled = false});
+    geo.setDecisionCacheConfig({.enabled = false});
+    if (!options.mmdb.empty() && !geo.loadOfflineDatabase(options.mmdb)) {
+        std::cerr << "Cannot load " << options.mmdb << "\n";
+        return 1;
+    }
+    if (options.mmdb.empty() || options.online) {
+        // A custom lookup URL without a batch URL means single lookups
+        std::vector<GeoIPProvider> providers = {{
+            .name = "online",
+            .lookup_url = options.lookup_url.empty() ? "http://ip-api.com/json/" : options.lookup_url,
+            .batch_url = options.batch_url.empty() && options.lookup_url.empty() ? "http://ip-api.com/batch"
+                                                                                 : options.batch_url
+        }};
+        if (!options.mmdb.empty()) {
+            GeoIPProvider offline;
+            offline.name = "offline";
+            offline.type = GeoIPProviderType::OFFLINE_DATABASE;
+            providers.push_back(std::move(offline));
+        }
+        geo.setGeoIPProviders(providers);
+    }
+    if (options.anonymizer_lists && !geo.loadAnonymizerLists({.refresh_interval = std::chrono::seconds(0)})) {
+        return 1;
+    }
+
+    if (options.format == OutputFormat::CSV) {
+        output << "ip,country_code,country_name,level,allowed,reason,proxy,vpn,tor,hosting\n";
+    }
+
+    Counters counters;
+    const auto start = Clock::now();
+    WorkStealingQueue queue(options.threads);
+    std::counting_semaphore<> pending(static_cast<std::ptrdiff_t>(options.max_pending));
+    std::mutex output_mutex;
+    bool output_failed = false;
+
+    std::vector<std::thread> workers;
+    workers.reserve(options.threads);
+    for (size_t worker = 0; worker < options.threads; ++worker) {
+        workers.emplace_back([&, worker] {
+            Chunk chunk;
+            std::string out;
+            std::vector<std::optional<GeoLocation>> locations;
+            while (queue.pop(worker, chunk)) {
+                const std::vector<RestrictionResult> results = geo.checkAccessBatch(chunk, &locations);
+                out.clear();
+                uint64_t blocked = 0;
+                uint64_t unresolved = 0;
+                for (size_t i = 0; i < chunk.size(); ++i) {
+                    appendRecord(out, options.format, chunk[i], results[i], locations[i]);
+                    blocked += !results[i].allowed;
+                    unresolved += !locations[i];
+                }
+                {
+                    std::lock_guard lock(output_mutex);
+                    output.write(out.data(), static_cast<std::streamsize>(out.size()));
+                    output_failed = output_failed || !output;
+                }
+                counters.classified.fetch_add(chunk.size(), std::memory_order_relaxed);
+                counters.blocked.fetch_add(blocked, std::memory_order_relaxed);
+                counters.unresolved.fetch_add(unresolved, std::memory_order_relaxed);
+                pending.release();
+            }
+        });
+    }
+
+    std::mutex progress_mutex;
+    std::condition_variable progress_wake;
+    bool finished = false;
+    std::thread progress;
+    if (!options.quiet) {
+        progress = std::thread([&] {
+            std::unique_lock lock(progress_mutex);
+            while (!progress_wake.wait_for(lock, std::chrono::seconds(1), [&] { return finished; })) {
+                printProgress(counters, start, "");
+            }
+        });
+    }
+
+    RecentAddresses recent(options.dedup_window);
+    Chunk chunk;
+    chunk.reserve(options.batch_size);
+    std::string line;
+    while (std::getline(input, line)) {
+        counters.lines.fetch_add(1, std::memory_order_relaxed);
+        const std::string_view address = extractField(line, options.field);
+        if (address.empty() || address.front() == '#') continue;
+
+        // Unparseable entries are still passed on (and denied as malformed) so they show up in the output
+        if (auto key = IpAddress::parse(address); key && !recent.insert(*key)) {
+            counters.duplicates.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        chunk.emplace_back(address);
+        if (chunk.size() == options.batch_size) {
+            pending.acquire();
+            queue.push(std::move(chunk));
+            chunk = Chunk();
+            chunk.reserve(options.batch_size);
+        }
+    }
+    if (!chunk.empty()) {
+        pending.acquire();
+        queue.push(std::move(chunk));
+    }
+    queue.close();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    output.flush();
+
+    if (progress.joinable()) {
+        {
+            std::lock_guard lock(progress_mutex);
+            finished = true;
+        }
+        progress_wake.notify_all();
+        progress.join();
+    }
+    printProgress(counters, start, "done: ");
+
+    if (output_failed || !output) {
+        std::cerr << "Error writing " << (options.output == "-" ? "stdout" : options.output) << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,288 @@
+/**
+ * @file StubGeoIPServer.hpp
+ * @brief In-process ip-api compatible HTTP server for compliance tests and benchmarks
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * Answers `GET <prefix><ip>` single lookups and `POST /batch` requests on an
+ * ephemeral loopback port. By default a single lookup returns a country
+ * derived from the address's last octet and a batch answers every address
+ * in request order; tests install handlers to return other countries,
+ * failures, reordered batches or slow answers. POSIX sockets only.
+ */
+
+#ifndef SPECTREMAP_TESTS_STUBGEOIPSERVER_HPP
+#define SPECTREMAP_TESTS_STUBGEOIPSERVER_HPP
+
+#include <nlohmann/json.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace SpectreMap::Testing {
+
+struct StubCountry {
+    const char* code;
+    const char* name;
+};
+
+// The default handler answers with a country derived from the last octet
+inline constexpr std::array<StubCountry, 6> STUB_COUNTRIES = {{
+    {"US", "United States"}, {"DE", "Germany"}, {"CN", "China"},
+    {"SO", "Somalia"}, {"RU", "Russia"}, {"KP", "North Korea"}
+}};
+
+/**
+ * @brief ip-api success entry for an address
+ */
+inline std::string stubResponseBody(const std::string& ip, const StubCountry& country) {
+    return std::string("{\"status\":\"success\",\"country\":\"") + country.name +
+           "\",\"countryCode\":\"" + country.code +
+           "\",\"region\":\"DC\",\"regionName\":\"Bench Region\",\"city\":\"Bench City\",\"lat\":38.8951,\"lon\":-77.0364,"
+           "\"isp\":\"Bench Networks\",\"as\":\"AS64500 Bench Networks\",\"proxy\":false,"
+           "\"hosting\":false,\"query\":\"" + ip + "\"}";
+}
+
+inline std::string stubResponseBody(const std::string& ip) {
+    const size_t dot = ip.rfind('.');
+    const unsigned long octet = dot == std::string::npos ? 0 : std::strtoul(ip.c_str() + dot + 1, nullptr, 10);
+    return stubResponseBody(ip, STUB_COUNTRIES[octet % STUB_COUNTRIES.size()]);
+}
+
+/**
+ * @brief ip-api failure entry ("status":"fail") for an address
+ */
+inline std::string stubFailureBody(const std::string& ip, const std::string& message = "reserved range") {
+    return "{\"status\":\"fail\",\"message\":\"" + message + "\",\"query\":\"" + ip + "\"}";
+}
+
+/**
+ * @brief Minimal keep-alive HTTP/1.1 server speaking the ip-api protocol
+ *
+ * Every response is sent after the configured latency plus the handler's
+ * own delay. One thread per connection, which matches how the curl pool
+ * reuses a handful of connections.
+ */
+class StubGeoIPServer {
+public:
+    struct Response {
+        int status = 200;
+        std::string body;
+        std::chrono::milliseconds delay{0};   ///< Added to the server latency
+    };
+
+    using LookupHandler = std::function<Response(const std::string& ip)>;
+    using BatchHandler = std::function<Response(const std::vector<std::string>& ips)>;
+
+    /**
+     * @param slow_every Every Nth request gets slow_extra added to its delay (0: none)
+     */
+    explicit StubGeoIPServer(std::chrono::milliseconds latency = {}, uint64_t slow_every = 0,
+                             std::chrono::milliseconds slow_extra = {})
+        : latency_(latency), slow_every_(slow_every), slow_extra_(slow_extra) {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        const int one = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        socklen_t len = sizeof(addr);
+        if (listen_fd_ < 0 ||
+            bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(listen_fd_, 64) != 0 ||
+            getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+            std::perror("stub server");
+            std::exit(2);
+        }
+        port_ = ntohs(addr.sin_port);
+        acceptor_ = std::thread(&StubGeoIPServer::acceptLoop, this);
+    }
+
+    ~StubGeoIPServer() {
+        stopping_.store(true);
+        shutdown(listen_fd_, SHUT_RDWR);
+        acceptor_.join();
+        {
+            std::lock_guard lock(mutex_);
+            for (int fd : client_fds_) {
+                shutdown(fd, SHUT_RDWR);
+            }
+        }
+        for (auto& connection : connections_) {
+            connection.join();
+        }
+        for (int fd : client_fds_) {
+            close(fd);
+        }
+        close(listen_fd_);
+    }
+
+    StubGeoIPServer(const StubGeoIPServer&) = delete;
+    StubGeoIPServer& operator=(const StubGeoIPServer&) = delete;
+
+    std::string lookupUrl() const { return "http://127.0.0.1:" + std::to_string(port_) + "/json/"; }
+    std::string batchUrl() const { return "http://127.0.0.1:" + std::to_string(port_) + "/batch"; }
+
+    /**
+     * @brief Replace the single lookup handler; safe while requests are in flight
+     */
+    void onLookup(LookupHandler handler) {
+        std::lock_guard lock(handler_mutex_);
+        lookup_handler_ = std::move(handler);
+    }
+
+    /**
+     * @brief Replace the batch handler; safe while requests are in flight
+     */
+    void onBatch(BatchHandler handler) {
+        std::lock_guard lock(handler_mutex_);
+        batch_handler_ = std::move(handler);
+    }
+
+    /// Single lookups received
+    uint64_t lookups() const noexcept { return lookups_.load(); }
+
+    /// Batch requests received
+    uint64_t batches() const noexcept { return batches_.load(); }
+
+private:
+    static Response defaultLookup(const std::string& ip) {
+        return {.status = 200, .body = stubResponseBody(ip)};
+    }
+
+    static Response defaultBatch(const std::vector<std::string>& ips) {
+        std::string body = "[";
+        for (size_t i = 0; i < ips.size(); ++i) {
+            if (i) body += ',';
+            body += stubResponseBody(ips[i]);
+        }
+        body += ']';
+        return {.status = 200, .body = std::move(body)};
+    }
+
+    static size_t contentLength(std::string_view headers) {
+        constexpr std::string_view name = "\r\ncontent-length:";
+        for (size_t i = 0; i + name.size() <= headers.size(); ++i) {
+            bool match = true;
+            for (size_t j = 0; j < name.size() && match; ++j) {
+                const char c = headers[i + j];
+                match = (c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c) == name[j];
+            }
+            if (match) {
+                return std::strtoul(std::string(headers.substr(i + name.size())).c_str(), nullptr, 10);
+            }
+        }
+        return 0;
+    }
+
+    void acceptLoop() {
+        while (!stopping_.load()) {
+            const int fd = accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) continue;
+            std::lock_guard lock(mutex_);
+            client_fds_.push_back(fd);
+            connections_.emplace_back(&StubGeoIPServer::serve, this, fd);
+        }
+    }
+
+    Response respond(const std::string& request_line, const std::string& body) {
+        constexpr std::string_view get = "GET ";
+        constexpr std::string_view post = "POST /batch";
+        if (request_line.starts_with(post)) {
+            batches_.fetch_add(1);
+            const nlohmann::json request = nlohmann::json::parse(body, nullptr, false);
+            if (!request.is_array()) return {.status = 400, .body = "{}"};
+            std::vector<std::string> ips;
+            for (const auto& ip : request) {
+                if (ip.is_string()) ips.push_back(ip.get<std::string>());
+            }
+            BatchHandler handler;
+            {
+                std::lock_guard lock(handler_mutex_);
+                handler = batch_handler_;
+            }
+            return handler ? handler(ips) : defaultBatch(ips);
+        }
+        if (request_line.starts_with(get)) {
+            // The address is the last path segment, before any query string
+            const size_t end = request_line.find_first_of("? ", get.size());
+            const size_t start = request_line.rfind('/', end) + 1;
+            const std::string ip = request_line.substr(start, end - start);
+            lookups_.fetch_add(1);
+            LookupHandler handler;
+            {
+                std::lock_guard lock(handler_mutex_);
+                handler = lookup_handler_;
+            }
+            return handler ? handler(ip) : defaultLookup(ip);
+        }
+        return {.status = 404, .body = "{}"};
+    }
+
+    void serve(int fd) {
+        std::string buffer;
+        char chunk[4096];
+        while (!stopping_.load()) {
+            const size_t header_end = buffer.find("\r\n\r\n");
+            const size_t body_length = header_end == std::string::npos
+                ? 0 : contentLength(std::string_view(buffer).substr(0, header_end + 2));
+            if (header_end == std::string::npos || buffer.size() < header_end + 4 + body_length) {
+                const ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+                if (n <= 0) break;
+                buffer.append(chunk, static_cast<size_t>(n));
+                continue;
+            }
+
+            const std::string request_line = buffer.substr(0, buffer.find("\r\n"));
+            const std::string body = buffer.substr(header_end + 4, body_length);
+            buffer.erase(0, header_end + 4 + body_length);
+
+            const Response response = respond(request_line, body);
+            const uint64_t request = requests_.fetch_add(1, std::memory_order_relaxed) + 1;
+            const bool slow = slow_every_ != 0 && request % slow_every_ == 0;
+            std::this_thread::sleep_for((slow ? latency_ + slow_extra_ : latency_) + response.delay);
+            const std::string reason = response.status == 200 ? "OK" : "Error";
+            const std::string message = "HTTP/1.1 " + std::to_string(response.status) + " " + reason +
+                                        "\r\nContent-Type: application/json\r\n"
+                                        "Content-Length: " + std::to_string(response.body.size()) +
+                                        "\r\nConnection: keep-alive\r\n\r\n" + response.body;
+            if (send(fd, message.data(), message.size(), MSG_NOSIGNAL) < 0) break;
+        }
+        // Closed by the destructor, so a reused descriptor is never shut down
+    }
+
+    std::chrono::milliseconds latency_;
+    uint64_t slow_every_;
+    std::chrono::milliseconds slow_extra_;
+    std::atomic<uint64_t> requests_{0};
+    std::atomic<uint64_t> lookups_{0};
+    std::atomic<uint64_t> batches_{0};
+    int listen_fd_ = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> stopping_{false};
+    std::thread acceptor_;
+    std::mutex mutex_;
+    std::vector<int> client_fds_;
+    std::vector<std::thread> connections_;
+    std::mutex handler_mutex_;
+    LookupHandler lookup_handler_;
+    BatchHandler batch_handler_;
+};
+
+} // namespace SpectreMap::Testing
+
+#endif // SPECTREMAP_TESTS_STUBGEOIPSERVER_HPP
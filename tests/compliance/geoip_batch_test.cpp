@@ -0,0 +1,184 @@
+/**
+ * @file geoip_batch_test.cpp
+ * @brief Batch GeoIP lookups against the stub ip-api server
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * Covers checkAccessBatch's /batch path: falling back to single lookups when
+ * the batch request fails, never attributing an answer to the wrong address
+ * when the response is reordered or short, and failing closed on addresses
+ * the provider explicitly could not locate.
+ */
+
+#include "StubGeoIPServer.hpp"
+#include "compliance/GeoRestriction.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+using namespace SpectreMap::Compliance;
+using SpectreMap::Testing::STUB_COUNTRIES;
+using SpectreMap::Testing::StubGeoIPServer;
+using SpectreMap::Testing::stubFailureBody;
+using SpectreMap::Testing::stubResponseBody;
+
+namespace {
+
+/// Country the stub's default handlers report for 198.51.100.<octet>
+std::string expectedCountry(const std::string& ip) {
+    const unsigned long octet = std::stoul(ip.substr(ip.rfind('.') + 1));
+    return STUB_COUNTRIES[octet % STUB_COUNTRIES.size()].code;
+}
+
+/// One address per stub country, so a misattributed answer changes the code
+std::vector<std::string> addresses() {
+    std::vector<std::string> ips;
+    for (size_t octet = 0; octet < STUB_COUNTRIES.size(); ++octet) {
+        ips.push_back("198.51.100." + std::to_string(octet));
+    }
+    return ips;
+}
+
+std::string batchBody(const std::vector<std::string>& entries) {
+    std::string body = "[";
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (i) body += ',';
+        body += entries[i];
+    }
+    return body + "]";
+}
+
+} // namespace
+
+class GeoIPBatchTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        geo_.setGeoIPEndpoints(server_.lookupUrl(), server_.batchUrl());
+        geo_.setCacheConfig({.enabled = false});
+        geo_.setDecisionCacheConfig({.enabled = false});
+    }
+
+    // Declared first so it outlives the pooled connections of geo_
+    StubGeoIPServer server_;
+    GeoRestriction geo_;
+};
+
+TEST_F(GeoIPBatchTest, HealthyBatch_AnswersEveryAddressInOneRequest) {
+    const std::vector<std::string> ips = addresses();
+    const std::vector<RestrictionResult> results = geo_.checkAccessBatch(ips);
+
+    ASSERT_EQ(results.size(), ips.size());
+    for (size_t i = 0; i < ips.size(); ++i) {
+        EXPECT_EQ(results[i].country_code, expectedCountry(ips[i])) << ips[i];
+    }
+    EXPECT_EQ(server_.batches(), 1u);
+    EXPECT_EQ(server_.lookups(), 0u);
+}
+
+TEST_F(GeoIPBatchTest, BatchEndpointFailure_FallsBackToSingleLookups) {
+    server_.onBatch([](const std::vector<std::string>&) {
+        return StubGeoIPServer::Response{.status = 503, .body = "{}"};
+    });
+
+    const std::vector<std::string> ips = addresses();
+    const std::vector<RestrictionResult> results = geo_.checkAccessBatch(ips);
+
+    ASSERT_EQ(results.size(), ips.size());
+    for (size_t i = 0; i < ips.size(); ++i) {
+        EXPECT_EQ(results[i].country_code, expectedCountry(ips[i])) << ips[i];
+    }
+    EXPECT_EQ(server_.batches(), 1u);
+    EXPECT_EQ(server_.lookups(), ips.size());
+}
+
+TEST_F(GeoIPBatchTest, ReorderedResponse_NeverMisattributesLocations) {
+    server_.onBatch([](const std::vector<std::string>& requested) {
+        std::vector<std::string> entries;
+        for (auto it = requested.rbegin(); it != requested.rend(); ++it) {
+            entries.push_back(stubResponseBody(*it));
+        }
+        return StubGeoIPServer::Response{.status = 200, .body = batchBody(entries)};
+    });
+
+    const std::vector<std::string> ips = addresses();
+    const std::vector<RestrictionResult> results = geo_.checkAccessBatch(ips);
+
+    // Entries whose "query" does not echo the address at their position are
+    // dropped and looked up again one at a time
+    ASSERT_EQ(results.size(), ips.size());
+    for (size_t i = 0; i < ips.size(); ++i) {
+        EXPECT_EQ(results[i].country_code, expectedCountry(ips[i])) << ips[i];
+    }
+    EXPECT_EQ(server_.lookups(), ips.size());
+}
+
+TEST_F(GeoIPBatchTest, ShortResponse_RetriesMissingAddressesSingly) {
+    server_.onBatch([](const std::vector<std::string>& requested) {
+        std::vector<std::string> entries;
+        for (size_t i = 0; i < requested.size() / 2; ++i) {
+            entries.push_back(stubResponseBody(requested[i]));
+        }
+        return StubGeoIPServer::Response{.status = 200, .body = batchBody(entries)};
+    });
+
+    const std::vector<std::string> ips = addresses();
+    const std::vector<RestrictionResult> results = geo_.checkAccessBatch(ips);
+
+    ASSERT_EQ(results.size(), ips.size());
+    for (size_t i = 0; i < ips.size(); ++i) {
+        EXPECT_EQ(results[i].country_code, expectedCountry(ips[i])) << ips[i];
+    }
+    EXPECT_EQ(server_.lookups(), ips.size() - ips.size() / 2);
+}
+
+TEST_F(GeoIPBatchTest, PartialBatchFailure_FailsClosed) {
+    // Odd octets are reported as failures by the provider itself
+    server_.onBatch([](const std::vector<std::string>& requested) {
+        std::vector<std::string> entries;
+        for (const std::string& ip : requested) {
+            const bool odd = (ip.back() - '0') % 2 == 1;
+            entries.push_back(odd ? stubFailureBody(ip) : stubResponseBody(ip));
+        }
+        return StubGeoIPServer::Response{.status = 200, .body = batchBody(entries)};
+    });
+
+    const std::vector<std::string> ips = addresses();
+    const std::vector<RestrictionResult> results = geo_.checkAccessBatch(ips);
+
+    ASSERT_EQ(results.size(), ips.size());
+    for (size_t i = 0; i < ips.size(); ++i) {
+        if (i % 2 == 1) {
+            EXPECT_FALSE(results[i].allowed) << ips[i];
+            EXPECT_EQ(results[i].level, RestrictionLevel::RESTRICTED) << ips[i];
+            EXPECT_EQ(results[i].country_code, "UNKNOWN") << ips[i];
+        } else {
+            EXPECT_EQ(results[i].country_code, expectedCountry(ips[i])) << ips[i];
+        }
+    }
+    // An explicit answer is final: failed addresses are not asked again
+    EXPECT_EQ(server_.lookups(), 0u);
+}
+
+TEST_F(GeoIPBatchTest, DuplicateAddresses_AreSentOnce) {
+    std::vector<std::string> ips = addresses();
+    const std::vector<std::string> unique = ips;
+    ips.insert(ips.end(), unique.begin(), unique.end());
+
+    std::atomic<size_t> requested{0};
+    server_.onBatch([&requested](const std::vector<std::string>& batch) {
+        requested += batch.size();
+        std::vector<std::string> entries;
+        for (const std::string& ip : batch) {
+            entries.push_back(stubResponseBody(ip));
+        }
+        return StubGeoIPServer::Response{.status = 200, .body = batchBody(entries)};
+    });
+
+    const std::vector<RestrictionResult> results = geo_.checkAccessBatch(ips);
+
+    ASSERT_EQ(results.size(), ips.size());
+    for (size_t i = 0; i < ips.size(); ++i) {
+        EXPECT_EQ(results[i].country_code, expectedCountry(ips[i])) << ips[i];
+    }
+    EXPECT_EQ(requested.load(), unique.size());
+}
@@ -0,0 +1,235 @@
+/**
+ * @file geoip_providers_test.cpp
+ * @brief GeoIP provider failover, circuit breaking and hedging against stub servers
+ * @copyright Copyright © 2025-2026 Lackadaisical Security
+ *
+ * Three stub ip-api servers stand in for a provider list; each answers with
+ * its own country, so the result's country code tells which provider won.
+ */
+
+#include "StubGeoIPServer.hpp"
+#include "compliance/GeoRestriction.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace SpectreMap::Compliance;
+using namespace std::chrono_literals;
+using SpectreMap::Testing::StubCountry;
+using SpectreMap::Testing::StubGeoIPServer;
+using SpectreMap::Testing::stubResponseBody;
+
+namespace {
+
+constexpr StubCountry PRIMARY_COUNTRY = {"US", "United States"};
+constexpr StubCountry SECONDARY_COUNTRY = {"DE", "Germany"};
+constexpr StubCountry TERTIARY_COUNTRY = {"CN", "China"};
+
+constexpr const char* ADDRESS = "198.51.100.7";
+
+/// Answers every lookup with the given country after a delay
+StubGeoIPServer::LookupHandler answering(StubCountry country, std::chrono::milliseconds delay = {}) {
+    return [country, delay](const std::string& ip) {
+        return StubGeoIPServer::Response{.status = 200, .body = stubResponseBody(ip, country), .delay = delay};
+    };
+}
+
+/// Single-lookup ip-api provider served by a stub
+GeoIPProvider stubProvider(const std::string& name, const StubGeoIPServer& server) {
+    GeoIPProvider provider;
+    provider.name = name;
+    provider.lookup_url = server.lookupUrl();
+    return provider;
+}
+
+/// Fails every lookup with an HTTP 500
+StubGeoIPServer::LookupHandler failing() {
+    return [](const std::string&) {
+        return StubGeoIPServer::Response{.status = 500, .body = "{}"};
+    };
+}
+
+} // namespace
+
+class GeoIPProvidersTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        primary_.onLookup(answering(PRIMARY_COUNTRY));
+        secondary_.onLookup(answering(SECONDARY_COUNTRY));
+        tertiary_.onLookup(answering(TERTIARY_COUNTRY));
+        geo_.setCacheConfig({.enabled = false});
+        geo_.setDecisionCacheConfig({.enabled = false});
+    }
+
+    void useProviders(const GeoIPFailoverConfig& config) {
+        geo_.setGeoIPProviders({stubProvider("primary", primary_),
+                                stubProvider("secondary", secondary_),
+                                stubProvider("tertiary", tertiary_)}, config);
+    }
+
+    std::string answeredBy() {
+        return geo_.checkAccess(ADDRESS).country_code;
+    }
+
+    GeoIPProviderStats stats(size_t provider) const {
+        return geo_.getGeoIPProviderStats().at(provider);
+    }
+
+    // Declared first so they outlive the pooled connections of geo_
+    StubGeoIPServer primary_;
+    StubGeoIPServer secondary_;
+    StubGeoIPServer tertiary_;
+    GeoRestriction geo_;
+};
+
+// ============================================================================
+// Failover
+// ============================================================================
+
+TEST_F(GeoIPProvidersTest, HealthyPrimary_AnswersAlone) {
+    useProviders({});
+
+    EXPECT_EQ(answeredBy(), PRIMARY_COUNTRY.code);
+    EXPECT_EQ(primary_.lookups(), 1u);
+    EXPECT_EQ(secondary_.lookups(), 0u);
+    EXPECT_EQ(tertiary_.lookups(), 0u);
+}
+
+TEST_F(GeoIPProvidersTest, FailedProviders_FailOverInConfiguredOrder) {
+    useProviders({.breaker_failure_threshold = 100});
+    primary_.onLookup(failing());
+    secondary_.onLookup(failing());
+
+    EXPECT_EQ(answeredBy(), TERTIARY_COUNTRY.code);
+    EXPECT_EQ(primary_.lookups(), 1u);
+    EXPECT_EQ(secondary_.lookups(), 1u);
+    EXPECT_EQ(tertiary_.lookups(), 1u);
+
+    // The earliest healthy provider is preferred again as soon as it answers
+    secondary_.onLookup(answering(SECONDARY_COUNTRY));
+    EXPECT_EQ(answeredBy(), SECONDARY_COUNTRY.code);
+    EXPECT_EQ(primary_.lookups(), 2u);
+    EXPECT_EQ(tertiary_.lookups(), 1u);
+}
+
+TEST_F(GeoIPProvidersTest, EveryProviderFailing_FailsClosed) {
+    useProviders({.breaker_failure_threshold = 100});
+    primary_.onLookup(failing());
+    secondary_.onLookup(failing());
+    tertiary_.onLookup(failing());
+
+    const RestrictionResult result = geo_.checkAccess(ADDRESS);
+    EXPECT_FALSE(result.allowed);
+    EXPECT_EQ(result.level, RestrictionLevel::RESTRICTED);
+    EXPECT_EQ(result.country_code, "UNKNOWN");
+}
+
+// ============================================================================
+// Circuit Breaker
+// ============================================================================
+
+TEST_F(GeoIPProvidersTest, ConsecutiveFailures_OpenTheCircuit) {
+    useProviders({.breaker_failure_threshold = 3, .breaker_open_time = 60s});
+    primary_.onLookup(failing());
+
+    for (int i = 0; i < 2; ++i) {
+        EXPECT_EQ(answeredBy(), SECONDARY_COUNTRY.code);
+        EXPECT_FALSE(stats(0).circuit_open) << "after " << i + 1 << " failures";
+    }
+    EXPECT_EQ(answeredBy(), SECONDARY_COUNTRY.code);
+    EXPECT_TRUE(stats(0).circuit_open);
+    EXPECT_EQ(stats(0).circuit_opens, 1u);
+    EXPECT_EQ(stats(0).failures, 3u);
+
+    // While open the provider is skipped, even once it is healthy again
+    primary_.onLookup(answering(PRIMARY_COUNTRY));
+    EXPECT_EQ(answeredBy(), SECONDARY_COUNTRY.code);
+    EXPECT_EQ(primary_.lookups(), 3u);
+}
+
+TEST_F(GeoIPProvidersTest, SuccessfulProbe_ClosesTheCircuit) {
+    useProviders({.breaker_failure_threshold = 2, .breaker_open_time = 200ms});
+    primary_.onLookup(failing());
+    answeredBy();
+    answeredBy();
+    ASSERT_TRUE(stats(0).circuit_open);
+
+    primary_.onLookup(answering(PRIMARY_COUNTRY));
+    EXPECT_EQ(answeredBy(), SECONDARY_COUNTRY.code);
+    EXPECT_EQ(primary_.lookups(), 2u);
+
+    std::this_thread::sleep_for(300ms);
+    EXPECT_EQ(answeredBy(), PRIMARY_COUNTRY.code);   // The half-open probe
+    EXPECT_EQ(primary_.lookups(), 3u);
+    EXPECT_FALSE(stats(0).circuit_open);
+
+    EXPECT_EQ(answeredBy(), PRIMARY_COUNTRY.code);
+    EXPECT_EQ(stats(0).circuit_opens, 1u);
+}
+
+TEST_F(GeoIPProvidersTest, FailedProbe_ReopensTheCircuit) {
+    useProviders({.breaker_failure_threshold = 2, .breaker_open_time = 200ms});
+    primary_.onLookup(failing());
+    answeredBy();
+    answeredBy();
+    ASSERT_TRUE(stats(0).circuit_open);
+
+    std::this_thread::sleep_for(300ms);
+    EXPECT_EQ(answeredBy(), SECONDARY_COUNTRY.code);
+    EXPECT_EQ(primary_.lookups(), 3u);   // One probe, failed
+    EXPECT_TRUE(stats(0).circuit_open);
+    EXPECT_EQ(stats(0).circuit_opens, 2u);
+
+    // A single failed probe is enough; no threshold applies while half-open
+    EXPECT_EQ(answeredBy(), SECONDARY_COUNTRY.code);
+    EXPECT_EQ(primary_.lookups(), 3u);
+}
+
+// ============================================================================
+// Hedging
+// ============================================================================
+
+TEST_F(GeoIPProvidersTest, SlowPrimary_HedgesToTheNextProvider) {
+    useProviders({.hedge = true, .initial_hedge_delay = 50ms});
+    primary_.onLookup(answering(PRIMARY_COUNTRY, 500ms));
+
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(answeredBy(), SECONDARY_COUNTRY.code);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 450ms);
+
+    EXPECT_EQ(stats(1).hedges, 1u);
+    EXPECT_EQ(stats(1).hedge_wins, 1u);
+    EXPECT_EQ(tertiary_.lookups(), 0u);   // At most two requests in flight
+    // The overtaken request lost the race; it is not a failure
+    EXPECT_EQ(stats(0).failures, 0u);
+}
+
+TEST_F(GeoIPProvidersTest, HedgingDisabled_WaitsForThePrimary) {
+    useProviders({.hedge = false, .initial_hedge_delay = 50ms});
+    primary_.onLookup(answering(PRIMARY_COUNTRY, 300ms));
+
+    EXPECT_EQ(answeredBy(), PRIMARY_COUNTRY.code);
+    EXPECT_EQ(secondary_.lookups(), 0u);
+    EXPECT_EQ(stats(1).hedges, 0u);
+}
+
+TEST_F(GeoIPProvidersTest, FastPrimary_IsNotHedged) {
+    useProviders({.hedge = true, .initial_hedge_delay = 200ms});
+
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(answeredBy(), PRIMARY_COUNTRY.code);
+    }
+    EXPECT_EQ(secondary_.lookups(), 0u);
+}
+
+TEST_F(GeoIPProvidersTest, AsyncLookup_HedgesSlowPrimary) {
+    useProviders({.hedge = true, .initial_hedge_delay = 50ms});
+    primary_.onLookup(answering(PRIMARY_COUNTRY, 500ms));
+
+    const RestrictionResult result = geo_.checkAccessAsync(ADDRESS).get();
+    EXPECT_EQ(result.country_code, SECONDARY_COUNTRY.code);
+    EXPECT_EQ(stats(1).hedges, 1u);
+    EXPECT_EQ(stats(1).hedge_wins, 1u);
+}